@@ -313,6 +313,20 @@ int cfs_crypto_hash_update(struct ahash_request *req, const void *buf,
 			   unsigned int buf_len);
 int cfs_crypto_hash_final(struct ahash_request *req,
 			  unsigned char *hash, unsigned int *hash_len);
+
+/* one buffer of a multi-buffer checksum */
+struct cfs_crypto_mb_buf {
+	struct page	*cmb_page;
+	unsigned int	 cmb_offset;
+	unsigned int	 cmb_len;
+};
+
+/* buffers callers should gather per cfs_crypto_crc32c_mb() call */
+#define CFS_CRYPTO_MB_BATCH	16
+
+bool cfs_crypto_crc32c_mb_enabled(void);
+void cfs_crypto_crc32c_mb(__u32 *crc, const struct cfs_crypto_mb_buf *bufs,
+			  int nr);
 int cfs_crypto_register(void);
 void cfs_crypto_unregister(void);
 int cfs_crypto_hash_speed(enum cfs_crypto_hash_alg hash_alg);
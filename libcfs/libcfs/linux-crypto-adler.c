@@ -27,11 +27,20 @@
 
 /*
  * This is crypto api shash wrappers to zlib_adler32.
+ *
+ * On x86_64 CPUs with AVX2 a second "adler32" driver is registered with a
+ * higher priority.  It sums 32 bytes per iteration and falls back to
+ * zlib_adler32() for the tail and when the vector unit is unusable.
  */
 
 #include <linux/module.h>
 #include <linux/zutil.h>
 #include <crypto/internal/hash.h>
+#ifdef CONFIG_X86_64
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include <asm/simd.h>
+#endif
 #include "linux-crypto.h"
 
 #define CHKSUM_BLOCK_SIZE	1
@@ -126,12 +135,182 @@ static struct shash_alg alg = {
 	}
 };
 
+#ifdef CONFIG_X86_64
+#define ADLER32_BASE		65521U
+/* largest n such that 255n(n+1)/2 + (n+1)(BASE-1) fits in 32 bits */
+#define ADLER32_NMAX		5552
+/* bytes summed per AVX2 iteration */
+#define ADLER32_AVX2_BLOCK	32
+
+/* weight of each byte of a block in the s2 sum */
+static const u8 adler32_avx2_taps[32] __aligned(32) = {
+	32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+	16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1
+};
+
+static const u16 adler32_avx2_ones[16] __aligned(32) = {
+	[0 ... 15] = 1
+};
+
+/*
+ * Add \a nblocks blocks of 32 bytes to \a adler.  Per-lane byte sums are
+ * kept in ymm0, weighted sums in ymm1 and the running total of ymm0 in
+ * ymm2, which accounts for the shift of s2 by s1 after each block.  The
+ * lanes are folded and reduced every ADLER32_NMAX bytes, like zlib does.
+ * Must be called between kernel_fpu_begin() and kernel_fpu_end().
+ */
+static u32 adler32_avx2_blocks(u32 adler, const u8 *data,
+			       unsigned int nblocks)
+{
+	u32 v1[8] __aligned(32);
+	u32 v2[8] __aligned(32);
+	u64 s1 = adler & 0xffff;
+	u64 s2 = adler >> 16;
+	unsigned int n;
+	unsigned int i;
+
+	asm volatile("vmovdqa %0, %%ymm3\n\t"
+		     "vmovdqa %1, %%ymm4\n\t"
+		     "vpxor %%ymm5, %%ymm5, %%ymm5"
+		     : : "m" (adler32_avx2_taps[0]),
+			 "m" (adler32_avx2_ones[0]));
+
+	while (nblocks) {
+		n = min_t(unsigned int, nblocks,
+			  ADLER32_NMAX / ADLER32_AVX2_BLOCK);
+		nblocks -= n;
+
+		asm volatile("vpxor %ymm0, %ymm0, %ymm0\n\t"
+			     "vpxor %ymm1, %ymm1, %ymm1\n\t"
+			     "vpxor %ymm2, %ymm2, %ymm2");
+		for (i = 0; i < n; i++, data += ADLER32_AVX2_BLOCK)
+			asm volatile("vmovdqu %0, %%ymm6\n\t"
+				     "vpaddd %%ymm0, %%ymm2, %%ymm2\n\t"
+				     "vpsadbw %%ymm5, %%ymm6, %%ymm7\n\t"
+				     "vpaddd %%ymm7, %%ymm0, %%ymm0\n\t"
+				     "vpmaddubsw %%ymm3, %%ymm6, %%ymm6\n\t"
+				     "vpmaddwd %%ymm4, %%ymm6, %%ymm6\n\t"
+				     "vpaddd %%ymm6, %%ymm1, %%ymm1"
+				     : : "m" (data[0]));
+		asm volatile("vpslld $5, %%ymm2, %%ymm2\n\t"
+			     "vpaddd %%ymm2, %%ymm1, %%ymm1\n\t"
+			     "vmovdqa %%ymm0, %0\n\t"
+			     "vmovdqa %%ymm1, %1"
+			     : "=m" (v1), "=m" (v2));
+
+		s2 += s1 * n * ADLER32_AVX2_BLOCK;
+		for (i = 0; i < 8; i++) {
+			s1 += v1[i];
+			s2 += v2[i];
+		}
+		s1 %= ADLER32_BASE;
+		s2 %= ADLER32_BASE;
+	}
+
+	return (s2 << 16) | s1;
+}
+
+static u32 adler32_avx2(u32 adler, const u8 *data, unsigned int len)
+{
+	unsigned int nblocks = len / ADLER32_AVX2_BLOCK;
+	unsigned int n;
+
+	if (!may_use_simd())
+		nblocks = 0;
+
+	/* keep preemption disabled for at most ADLER32_NMAX bytes at once */
+	while (nblocks) {
+		n = min_t(unsigned int, nblocks,
+			  ADLER32_NMAX / ADLER32_AVX2_BLOCK);
+		kernel_fpu_begin();
+		adler = adler32_avx2_blocks(adler, data, n);
+		kernel_fpu_end();
+		data += n * ADLER32_AVX2_BLOCK;
+		len -= n * ADLER32_AVX2_BLOCK;
+		nblocks -= n;
+	}
+
+	return zlib_adler32(adler, data, len);
+}
+
+static int adler32_avx2_update(struct shash_desc *desc, const u8 *data,
+			       unsigned int len)
+{
+	u32 *cksump = shash_desc_ctx(desc);
+
+	*cksump = adler32_avx2(*cksump, data, len);
+	return 0;
+}
+
+static int adler32_avx2_finup(struct shash_desc *desc, const u8 *data,
+			      unsigned int len, u8 *out)
+{
+	*(u32 *)out = adler32_avx2(*(u32 *)shash_desc_ctx(desc), data, len);
+	return 0;
+}
+
+static int adler32_avx2_digest(struct shash_desc *desc, const u8 *data,
+			       unsigned int len, u8 *out)
+{
+	*(u32 *)out = adler32_avx2(*(u32 *)crypto_shash_ctx(desc->tfm),
+				   data, len);
+	return 0;
+}
+
+static struct shash_alg alg_avx2 = {
+	.setkey		= adler32_setkey,
+	.init		= adler32_init,
+	.update		= adler32_avx2_update,
+	.final		= adler32_final,
+	.finup		= adler32_avx2_finup,
+	.digest		= adler32_avx2_digest,
+	.descsize	= sizeof(u32),
+	.digestsize	= CHKSUM_DIGEST_SIZE,
+	.base		= {
+		.cra_name		= "adler32",
+		.cra_driver_name	= "adler32-avx2",
+		.cra_priority		= 200,
+#ifdef CRYPTO_ALG_OPTIONAL_KEY
+		.cra_flags		= CRYPTO_ALG_OPTIONAL_KEY,
+#endif
+		.cra_blocksize		= CHKSUM_BLOCK_SIZE,
+		.cra_ctxsize		= sizeof(u32),
+		.cra_module		= NULL,
+		.cra_init		= adler32_cra_init,
+	}
+};
+
+static bool adler32_avx2_registered;
+
+static bool adler32_avx2_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX) &&
+	       boot_cpu_has(X86_FEATURE_AVX2);
+}
+#endif /* CONFIG_X86_64 */
+
 int cfs_crypto_adler32_register(void)
 {
-	return crypto_register_shash(&alg);
+	int rc;
+
+	rc = crypto_register_shash(&alg);
+	if (rc)
+		return rc;
+
+#ifdef CONFIG_X86_64
+	/* the zlib version stays usable if this fails */
+	if (adler32_avx2_usable())
+		adler32_avx2_registered = !crypto_register_shash(&alg_avx2);
+#endif
+	return 0;
 }
 
 void cfs_crypto_adler32_unregister(void)
 {
+#ifdef CONFIG_X86_64
+	if (adler32_avx2_registered)
+		crypto_unregister_shash(&alg_avx2);
+	adler32_avx2_registered = false;
+#endif
 	crypto_unregister_shash(&alg);
 }
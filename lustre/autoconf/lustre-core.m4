@@ -3178,6 +3178,32 @@ AC_DEFUN([LC_HAVE_USER_NAMESPACE_ARG], [
 	])
 ]) # LC_HAVE_USER_NAMESPACE_ARG
 
+#
+# LC_HAVE_MAP_PAGES_VM_FAULT_T
+#
+# kernel 5.12 commit f9ce0be71d1fbb038ada15ced83474b0e63f264d
+# mm: Cleanup faultaround and finish_fault() codepaths
+# vm_operations_struct::map_pages() returns vm_fault_t.
+#
+AC_DEFUN([LC_SRC_HAVE_MAP_PAGES_VM_FAULT_T], [
+	LB2_LINUX_TEST_SRC([map_pages_returns_vm_fault_t], [
+		#include <linux/mm.h>
+	],[
+		struct vm_fault vmf = { };
+		vm_fault_t ret;
+
+		ret = ((struct vm_operations_struct *)0)->map_pages(&vmf, 0, 0);
+		(void)ret;
+	],[-Werror])
+])
+AC_DEFUN([LC_HAVE_MAP_PAGES_VM_FAULT_T], [
+	LB2_MSG_LINUX_TEST_RESULT([if 'map_pages' returns vm_fault_t],
+	[map_pages_returns_vm_fault_t], [
+		AC_DEFINE(HAVE_MAP_PAGES_VM_FAULT_T, 1,
+			['map_pages' returns vm_fault_t])
+	])
+]) # LC_HAVE_MAP_PAGES_VM_FAULT_T
+
 #
 # LC_HAVE_FILEATTR_GET
 #
@@ -3350,6 +3376,30 @@ AC_DEFUN([LC_HAVE_KIOCB_COMPLETE_2ARGS], [
 	])
 ]) # LC_HAVE_KIOCB_COMPLETE_2ARGS
 
+#
+# LC_HAVE_FILEMAP_ADD_FOLIO
+#
+# Linux commit v5.15-rc1-70-g9dd3d069406c
+#   mm/filemap: Add filemap_add_folio()
+#
+AC_DEFUN([LC_SRC_HAVE_FILEMAP_ADD_FOLIO], [
+	LB2_LINUX_TEST_SRC([filemap_add_folio], [
+		#include <linux/pagemap.h>
+	],[
+		struct address_space *m = NULL;
+		struct folio *folio = filemap_alloc_folio(GFP_KERNEL, 1);
+
+		(void)filemap_add_folio(m, folio, 0, GFP_KERNEL);
+	],[-Werror])
+])
+AC_DEFUN([LC_HAVE_FILEMAP_ADD_FOLIO], [
+	LB2_MSG_LINUX_TEST_RESULT([if filemap_add_folio() is available],
+	[filemap_add_folio], [
+		AC_DEFINE(HAVE_FILEMAP_ADD_FOLIO, 1,
+			[filemap_add_folio() is available])
+	])
+]) # LC_HAVE_FILEMAP_ADD_FOLIO
+
 #
 # LC_EXPORTS_DELETE_FROM_PAGE_CACHE
 #
@@ -4192,6 +4242,7 @@ AC_DEFUN([LC_PROG_LINUX_SRC], [
 
 	# 5.12
 	LC_SRC_HAVE_USER_NAMESPACE_ARG
+	LC_SRC_HAVE_MAP_PAGES_VM_FAULT_T
 
 	# 5.13
 	LC_SRC_HAVE_COPY_PAGE_FROM_ITER_ATOMIC
@@ -4204,6 +4255,7 @@ AC_DEFUN([LC_PROG_LINUX_SRC], [
 	# 5.16
 	LC_SRC_HAVE_SECURITY_DENTRY_INIT_WITH_XATTR_NAME_ARG
 	LC_SRC_HAVE_KIOCB_COMPLETE_2ARGS
+	LC_SRC_HAVE_FILEMAP_ADD_FOLIO
 
 	# 5.17
 	LC_SRC_HAVE_INVALIDATE_FOLIO
@@ -4465,6 +4517,7 @@ AC_DEFUN([LC_PROG_LINUX_RESULTS], [
 
 	# 5.12
 	LC_HAVE_USER_NAMESPACE_ARG
+	LC_HAVE_MAP_PAGES_VM_FAULT_T
 
 	# 5.13
 	LC_HAVE_FILEATTR_GET
@@ -4481,6 +4534,7 @@ AC_DEFUN([LC_PROG_LINUX_RESULTS], [
 	# 5.16
 	LC_HAVE_SECURITY_DENTRY_INIT_WITH_XATTR_NAME_ARG
 	LC_HAVE_KIOCB_COMPLETE_2ARGS
+	LC_HAVE_FILEMAP_ADD_FOLIO
 	LC_EXPORTS_DELETE_FROM_PAGE_CACHE
 	LC_HAVE_WB_STAT_MOD
 
@@ -4919,6 +4973,7 @@ AM_CONDITIONAL(SELINUX, test "$SELINUX" = "-lselinux")
 AM_CONDITIONAL(GETSEPOL, test x$enable_getsepol = xyes)
 AM_CONDITIONAL(LLCRYPT, test x$enable_llcrypt = xyes)
 AM_CONDITIONAL(LIBAIO, test x$enable_libaio = xyes)
+AM_CONDITIONAL(X86_64, test x$target_cpu = xx86_64)
 ]) # LC_CONDITIONALS
 
 #
@@ -28,10 +28,8 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <linux/limits.h>
-#include <linux/string.h>	/* for memset */
-#include <libcfs/libcfs.h>
 #include "erasure_code.h"
+#include "ec_internal.h"
 
 /* Global GF(256) tables */
 static const unsigned char gff_base[] = {
@@ -199,6 +197,72 @@ int gf_invert_matrix(unsigned char *in_mat, unsigned char *out_mat, const int n)
 }
 EXPORT_SYMBOL(gf_invert_matrix);
 
+int ec_gen_decode_matrix(const unsigned char *encode_matrix, int k, int m,
+			 const unsigned char *err_list, int nerrs,
+			 unsigned char *src_index, unsigned char *decode_matrix)
+{
+	unsigned char in_err[EC_MAX_FRAGS] = { 0 };
+	unsigned char *invert_matrix;
+	unsigned char *b;
+	unsigned char s;
+	int i, j, p, r;
+	int rc = 0;
+
+	if (k + m > EC_MAX_FRAGS || nerrs > m)
+		return -EINVAL;
+
+	for (i = 0; i < nerrs; i++) {
+		if (err_list[i] >= k + m || in_err[err_list[i]])
+			return -EINVAL;
+		in_err[err_list[i]] = 1;
+	}
+
+	LIBCFS_ALLOC(b, 2 * k * k);
+	if (!b)
+		return -ENOMEM;
+	invert_matrix = b + k * k;
+
+	/* Construct b from the rows of the first k surviving fragments */
+	for (i = 0, r = 0; i < k; i++, r++) {
+		while (in_err[r])
+			r++;
+		for (j = 0; j < k; j++)
+			b[k * i + j] = encode_matrix[k * r + j];
+		src_index[i] = r;
+	}
+
+	/* Invert it to get the recovery matrix */
+	if (gf_invert_matrix(b, invert_matrix, k) < 0) {
+		rc = -EIO;
+		goto out;
+	}
+
+	for (p = 0; p < nerrs; p++) {
+		if (err_list[p] < k) {
+			/* A lost source is a row of the recovery matrix */
+			for (j = 0; j < k; j++)
+				decode_matrix[k * p + j] =
+					invert_matrix[k * err_list[p] + j];
+		} else {
+			/* A lost parity is its encode row times the recovery
+			 * matrix
+			 */
+			for (i = 0; i < k; i++) {
+				s = 0;
+				for (j = 0; j < k; j++)
+					s ^= gf_mul(invert_matrix[j * k + i],
+						    encode_matrix[k * err_list[p] +
+								  j]);
+				decode_matrix[k * p + i] = s;
+			}
+		}
+	}
+out:
+	LIBCFS_FREE(b, 2 * k * k);
+	return rc;
+}
+EXPORT_SYMBOL(ec_gen_decode_matrix);
+
 /* Calculates const table gftbl in GF(2^8) from single input A
  * gftbl(A) = {A{00}, A{01}, A{02}, ... , A{0f} }, {A{00}, A{10}, A{20}, ... ,
  * A{f0} }
@@ -315,8 +379,8 @@ void gf_vect_mul_init(unsigned char c, unsigned char *tbl)
 #endif /* BITS_PER_LONG == 64 */
 }
 
-void ec_encode_data(int len, int srcs, int dests, unsigned char *v,
-		    unsigned char **src, unsigned char **dest)
+void ec_encode_data_base(int len, int srcs, int dests, unsigned char *v,
+			 unsigned char **src, unsigned char **dest)
 {
 	int i, j, l;
 	unsigned char s;
@@ -331,10 +395,247 @@ void ec_encode_data(int len, int srcs, int dests, unsigned char *v,
 		}
 	}
 }
+
+void ec_encode_data_update_base(int len, int k, int rows, int vec_i,
+				unsigned char *v, unsigned char *data,
+				unsigned char **dest)
+{
+	int i, l;
+	unsigned char s;
+
+	for (l = 0; l < rows; l++) {
+		s = v[vec_i * 32 + l * k * 32 + 1];
+		for (i = 0; i < len; i++)
+			dest[l][i] ^= gf_mul(data[i], s);
+	}
+}
+
+static const struct ec_simd_ops ec_base_ops = {
+	.eso_name	= "base",
+	.eso_usable	= NULL,
+	.eso_encode	= ec_encode_data_base,
+	.eso_update	= ec_encode_data_update_base,
+};
+
+/* Candidate kernels, the scalar reference must stay first */
+static const struct ec_simd_ops *ec_simd_candidates[] = {
+	&ec_base_ops,
+#ifdef CONFIG_X86_64
+	&ec_sse_ops,
+	&ec_avx2_ops,
+	&ec_avx512_ops,
+	&ec_gfni_ops,
+#endif
+};
+
+/* Kernel selected by ec_init(), and its encode speed in MB/s */
+static const struct ec_simd_ops *ec_simd = &ec_base_ops;
+static int ec_simd_speed;
+
+void ec_encode_data(int len, int srcs, int dests, unsigned char *v,
+		    unsigned char **src, unsigned char **dest)
+{
+	ec_simd->eso_encode(len, srcs, dests, v, src, dest);
+}
 EXPORT_SYMBOL(ec_encode_data);
 
+void ec_encode_data_update(int len, int k, int rows, int vec_i,
+			   unsigned char *v, unsigned char *data,
+			   unsigned char **dest)
+{
+	ec_simd->eso_update(len, k, rows, vec_i, v, data, dest);
+}
+EXPORT_SYMBOL(ec_encode_data_update);
+
+const char *ec_encode_name(void)
+{
+	return ec_simd->eso_name;
+}
+EXPORT_SYMBOL(ec_encode_name);
+
+int ec_encode_speed(void)
+{
+	return ec_simd_speed;
+}
+EXPORT_SYMBOL(ec_encode_speed);
+
+/*
+ * Self-test geometry.  More than EC_X86_ROWS parity rows and more than
+ * EC_GFNI_SRCS sources are used so that every grouping path in the vector
+ * kernels is exercised, and the lengths cover vector tails.
+ */
+#define EC_TEST_SRCS	20
+#define EC_TEST_ROWS	6
+#define EC_TEST_LEN	65536
+/* encode geometry used for the speed report, 10+4 */
+#define EC_SPEED_SRCS	10
+#define EC_SPEED_ROWS	4
+
+struct ec_test_buf {
+	unsigned char	*etb_mem;
+	unsigned char	*etb_data[EC_TEST_SRCS];
+	unsigned char	*etb_coding[EC_TEST_ROWS];
+	unsigned char	*etb_ref[EC_TEST_ROWS];
+	unsigned char	 etb_matrix[(EC_TEST_SRCS + EC_TEST_ROWS) *
+				    EC_TEST_SRCS];
+	unsigned char	 etb_tbls[EC_TEST_SRCS * EC_TEST_ROWS * 32];
+};
+
+static int ec_test_buf_init(struct ec_test_buf *etb)
+{
+	int nvect = EC_TEST_SRCS + 2 * EC_TEST_ROWS;
+	int i;
+
+	LIBCFS_ALLOC(etb->etb_mem, nvect * EC_TEST_LEN);
+	if (!etb->etb_mem)
+		return -ENOMEM;
+
+	for (i = 0; i < EC_TEST_SRCS; i++)
+		etb->etb_data[i] = etb->etb_mem + i * EC_TEST_LEN;
+	for (i = 0; i < EC_TEST_ROWS; i++) {
+		etb->etb_coding[i] = etb->etb_mem +
+				     (EC_TEST_SRCS + i) * EC_TEST_LEN;
+		etb->etb_ref[i] = etb->etb_mem +
+			(EC_TEST_SRCS + EC_TEST_ROWS + i) * EC_TEST_LEN;
+	}
+	get_random_bytes(etb->etb_mem, EC_TEST_SRCS * EC_TEST_LEN);
+
+	return 0;
+}
+
+static void ec_test_buf_fini(struct ec_test_buf *etb)
+{
+	LIBCFS_FREE(etb->etb_mem,
+		    (EC_TEST_SRCS + 2 * EC_TEST_ROWS) * EC_TEST_LEN);
+}
+
+/*
+ * Compare \a ops against the scalar reference for several lengths, both
+ * for a full encode and for parity built up one source at a time with
+ * the update function.
+ */
+static int ec_simd_self_test(const struct ec_simd_ops *ops,
+			     struct ec_test_buf *etb)
+{
+	static const int lens[] = { EC_TEST_LEN, EC_TEST_LEN - 1, 4159, 64,
+				    33, 1 };
+	int i;
+	int j;
+	int l;
+
+	gf_gen_cauchy1_matrix(etb->etb_matrix, EC_TEST_SRCS + EC_TEST_ROWS,
+			      EC_TEST_SRCS);
+	ec_init_tables(EC_TEST_SRCS, EC_TEST_ROWS,
+		       &etb->etb_matrix[EC_TEST_SRCS * EC_TEST_SRCS],
+		       etb->etb_tbls);
+
+	for (i = 0; i < ARRAY_SIZE(lens); i++) {
+		ec_encode_data_base(lens[i], EC_TEST_SRCS, EC_TEST_ROWS,
+				    etb->etb_tbls, etb->etb_data,
+				    etb->etb_ref);
+		ops->eso_encode(lens[i], EC_TEST_SRCS, EC_TEST_ROWS,
+				etb->etb_tbls, etb->etb_data,
+				etb->etb_coding);
+		for (l = 0; l < EC_TEST_ROWS; l++)
+			if (memcmp(etb->etb_coding[l], etb->etb_ref[l],
+				   lens[i]) != 0)
+				return -EIO;
+
+		for (l = 0; l < EC_TEST_ROWS; l++)
+			memset(etb->etb_coding[l], 0, lens[i]);
+		for (j = 0; j < EC_TEST_SRCS; j++)
+			ops->eso_update(lens[i], EC_TEST_SRCS, EC_TEST_ROWS, j,
+					etb->etb_tbls, etb->etb_data[j],
+					etb->etb_coding);
+		for (l = 0; l < EC_TEST_ROWS; l++)
+			if (memcmp(etb->etb_coding[l], etb->etb_ref[l],
+				   lens[i]) != 0)
+				return -EIO;
+	}
+
+	return 0;
+}
+
+/*
+ * Measure the encode speed of \a ops in MB/s of source data, using the
+ * same time base as obd_t10_performance_test() so the numbers can be
+ * compared with the checksum speeds.
+ */
+static int ec_simd_performance_test(const struct ec_simd_ops *ops,
+				    struct ec_test_buf *etb)
+{
+	unsigned long bcount;
+	unsigned long start;
+	unsigned long end;
+
+	gf_gen_cauchy1_matrix(etb->etb_matrix, EC_SPEED_SRCS + EC_SPEED_ROWS,
+			      EC_SPEED_SRCS);
+	ec_init_tables(EC_SPEED_SRCS, EC_SPEED_ROWS,
+		       &etb->etb_matrix[EC_SPEED_SRCS * EC_SPEED_SRCS],
+		       etb->etb_tbls);
+
+	for (start = jiffies, end = start + cfs_time_seconds(1) / 16,
+	     bcount = 0; time_before(jiffies, end); bcount++)
+		ops->eso_encode(EC_TEST_LEN, EC_SPEED_SRCS, EC_SPEED_ROWS,
+				etb->etb_tbls, etb->etb_data,
+				etb->etb_coding);
+	end = jiffies;
+
+	return ((bcount * EC_SPEED_SRCS * EC_TEST_LEN /
+		 jiffies_to_msecs(end - start)) * 1000) / (1024 * 1024);
+}
+
+/*
+ * Pick the fastest encode kernel supported by this CPU.  A kernel that
+ * does not produce the same parity as the scalar code is never used.
+ */
+static void ec_simd_select(void)
+{
+	const struct ec_simd_ops *ops;
+	struct ec_test_buf *etb;
+	int speed;
+	int rc;
+	int i;
+
+	LIBCFS_ALLOC(etb, sizeof(*etb));
+	if (!etb)
+		return;
+
+	rc = ec_test_buf_init(etb);
+	if (rc)
+		goto out;
+
+	for (i = 0; i < ARRAY_SIZE(ec_simd_candidates); i++) {
+		ops = ec_simd_candidates[i];
+		if (ops->eso_usable && !ops->eso_usable())
+			continue;
+
+		rc = ec_simd_self_test(ops, etb);
+		if (rc) {
+			CWARN("ec: %s encode self-test failed, not used: rc = %d\n",
+			      ops->eso_name, rc);
+			continue;
+		}
+
+		speed = ec_simd_performance_test(ops, etb);
+		CDEBUG(D_CONFIG, "ec: %s encode speed = %d MB/s\n",
+		       ops->eso_name, speed);
+		if (speed > ec_simd_speed) {
+			ec_simd = ops;
+			ec_simd_speed = speed;
+		}
+	}
+	ec_test_buf_fini(etb);
+out:
+	LIBCFS_FREE(etb, sizeof(*etb));
+	LCONSOLE_INFO("ec: using %s encode, %d MB/s\n",
+		      ec_simd->eso_name, ec_simd_speed);
+}
+
 static int __init ec_init(void)
 {
+	ec_simd_select();
+
 	return 0;
 }
 
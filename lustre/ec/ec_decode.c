@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/ec/ec_decode.c
+ *
+ * Reconstruction of erased fragments, with a per-geometry cache of the
+ * decode tables for recently seen erasure patterns.
+ */
+
+#include "erasure_code.h"
+#include "ec_internal.h"
+
+/* erasure patterns kept per decode context */
+#define EC_DECODE_CACHE_MAX	32
+
+struct ec_decode_entry {
+	/* linkage on ecd_lru, most recently used first */
+	struct list_head	ede_lru;
+	/* bitmap of the erased fragments, the cache key */
+	u64			ede_erasures;
+	atomic_t		ede_ref;
+	int			ede_nerrs;
+	int			ede_size;
+	/* fragments used as decode sources, k entries */
+	unsigned char		ede_src_index[EC_MAX_FRAGS];
+	/* expanded decode tables, 32 * k * ede_nerrs bytes */
+	unsigned char		ede_tbls[];
+};
+
+struct ec_decoder {
+	int			ecd_k;
+	int			ecd_m;
+	spinlock_t		ecd_lock;
+	struct list_head	ecd_lru;
+	int			ecd_count;
+	/* (k + m) x k encode matrix */
+	unsigned char		ecd_matrix[];
+};
+
+struct ec_decoder *ec_decoder_create(int k, int m,
+				     const unsigned char *encode_matrix)
+{
+	struct ec_decoder *dec;
+
+	if (k <= 0 || m <= 0 || k + m > EC_MAX_FRAGS)
+		return NULL;
+
+	LIBCFS_ALLOC(dec, sizeof(*dec) + (k + m) * k);
+	if (!dec)
+		return NULL;
+
+	dec->ecd_k = k;
+	dec->ecd_m = m;
+	spin_lock_init(&dec->ecd_lock);
+	INIT_LIST_HEAD(&dec->ecd_lru);
+	memcpy(dec->ecd_matrix, encode_matrix, (k + m) * k);
+
+	return dec;
+}
+EXPORT_SYMBOL(ec_decoder_create);
+
+static void ec_decode_entry_put(struct ec_decode_entry *ede)
+{
+	if (atomic_dec_and_test(&ede->ede_ref))
+		LIBCFS_FREE(ede, ede->ede_size);
+}
+
+void ec_decoder_destroy(struct ec_decoder *dec)
+{
+	struct ec_decode_entry *ede;
+	struct ec_decode_entry *tmp;
+
+	list_for_each_entry_safe(ede, tmp, &dec->ecd_lru, ede_lru) {
+		list_del(&ede->ede_lru);
+		ec_decode_entry_put(ede);
+	}
+	LIBCFS_FREE(dec, sizeof(*dec) +
+		    (dec->ecd_k + dec->ecd_m) * dec->ecd_k);
+}
+EXPORT_SYMBOL(ec_decoder_destroy);
+
+/* Build the decode tables for \a erasures, fragments in ascending order */
+static int ec_decode_entry_new(struct ec_decoder *dec, u64 erasures,
+			       int nerrs, struct ec_decode_entry **edep)
+{
+	unsigned char err_list[EC_MAX_FRAGS];
+	struct ec_decode_entry *ede;
+	unsigned char *decode_matrix;
+	int k = dec->ecd_k;
+	int size;
+	int rc;
+	int i;
+	int n;
+
+	for (i = 0, n = 0; i < k + dec->ecd_m; i++)
+		if (erasures & (1ULL << i))
+			err_list[n++] = i;
+
+	LIBCFS_ALLOC(decode_matrix, nerrs * k);
+	if (!decode_matrix)
+		return -ENOMEM;
+
+	size = sizeof(*ede) + 32 * k * nerrs;
+	LIBCFS_ALLOC(ede, size);
+	if (!ede) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	rc = ec_gen_decode_matrix(dec->ecd_matrix, k, dec->ecd_m, err_list,
+				  nerrs, ede->ede_src_index, decode_matrix);
+	if (rc) {
+		CERROR("ec: cannot build %d+%d decode matrix for erasures %#llx: rc = %d\n",
+		       k, dec->ecd_m, (unsigned long long)erasures, rc);
+		LIBCFS_FREE(ede, size);
+		goto out;
+	}
+	ec_init_tables(k, nerrs, decode_matrix, ede->ede_tbls);
+
+	INIT_LIST_HEAD(&ede->ede_lru);
+	ede->ede_erasures = erasures;
+	ede->ede_nerrs = nerrs;
+	ede->ede_size = size;
+	atomic_set(&ede->ede_ref, 1);
+	*edep = ede;
+out:
+	LIBCFS_FREE(decode_matrix, nerrs * k);
+	return rc;
+}
+
+/*
+ * Find the decode tables for \a erasures, building and caching them on a
+ * miss.  The least recently used pattern is dropped once the cache is full;
+ * users hold a reference so it is only freed after they are done.
+ */
+static int ec_decode_entry_get(struct ec_decoder *dec, u64 erasures,
+			       int nerrs, struct ec_decode_entry **edep)
+{
+	struct ec_decode_entry *victim = NULL;
+	struct ec_decode_entry *ede;
+	struct ec_decode_entry *new;
+	int rc;
+
+	spin_lock(&dec->ecd_lock);
+	list_for_each_entry(ede, &dec->ecd_lru, ede_lru) {
+		if (ede->ede_erasures == erasures)
+			goto found;
+	}
+	spin_unlock(&dec->ecd_lock);
+
+	rc = ec_decode_entry_new(dec, erasures, nerrs, &new);
+	if (rc)
+		return rc;
+
+	spin_lock(&dec->ecd_lock);
+	/* another thread may have added the same pattern meanwhile */
+	list_for_each_entry(ede, &dec->ecd_lru, ede_lru) {
+		if (ede->ede_erasures == erasures) {
+			ec_decode_entry_put(new);
+			goto found;
+		}
+	}
+	ede = new;
+	list_add(&ede->ede_lru, &dec->ecd_lru);
+	if (++dec->ecd_count > EC_DECODE_CACHE_MAX) {
+		victim = list_last_entry(&dec->ecd_lru, struct ec_decode_entry,
+					 ede_lru);
+		list_del(&victim->ede_lru);
+		dec->ecd_count--;
+	}
+found:
+	list_move(&ede->ede_lru, &dec->ecd_lru);
+	atomic_inc(&ede->ede_ref);
+	spin_unlock(&dec->ecd_lock);
+
+	if (victim)
+		ec_decode_entry_put(victim);
+
+	*edep = ede;
+	return 0;
+}
+
+int ec_decode_data(struct ec_decoder *dec, int len,
+		   const unsigned char *err_list, int nerrs,
+		   unsigned char **frags)
+{
+	/* k decode sources followed by nerrs outputs */
+	unsigned char *vects[EC_MAX_FRAGS];
+	struct ec_decode_entry *ede;
+	u64 erasures = 0;
+	int k = dec->ecd_k;
+	int rc;
+	int i;
+	int n;
+
+	if (nerrs == 0)
+		return 0;
+	if (nerrs > dec->ecd_m)
+		return -EINVAL;
+
+	for (i = 0; i < nerrs; i++) {
+		if (err_list[i] >= k + dec->ecd_m ||
+		    erasures & (1ULL << err_list[i]))
+			return -EINVAL;
+		erasures |= 1ULL << err_list[i];
+	}
+
+	rc = ec_decode_entry_get(dec, erasures, nerrs, &ede);
+	if (rc)
+		return rc;
+
+	for (i = 0; i < k; i++)
+		vects[i] = frags[ede->ede_src_index[i]];
+	for (i = 0, n = k; i < k + dec->ecd_m; i++)
+		if (erasures & (1ULL << i))
+			vects[n++] = frags[i];
+
+	ec_encode_data(len, k, nerrs, ede->ede_tbls, vects, vects + k);
+	ec_decode_entry_put(ede);
+
+	return 0;
+}
+EXPORT_SYMBOL(ec_decode_data);
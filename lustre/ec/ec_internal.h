@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/**********************************************************************
+ * Copyright(c) 2011-2015 Intel Corporation All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *    Neither the name of Intel Corporation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EC_INTERNAL_H_
+#define _EC_INTERNAL_H_
+
+#ifdef __KERNEL__
+#include <linux/limits.h>
+#include <linux/random.h>
+#include <linux/string.h>
+#include <libcfs/libcfs.h>
+#ifdef CONFIG_X86_64
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include <asm/simd.h>
+#endif
+#else /* !__KERNEL__ */
+/*
+ * Userspace build of the library, used by lustre/tests/ec_bench.  Only the
+ * kernel interfaces used by lustre/ec are provided, mapped onto libc.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <libcfs/util/list.h>
+
+#if defined(__x86_64__) && !defined(CONFIG_X86_64)
+#define CONFIG_X86_64	1
+#endif
+#define BITS_PER_LONG	(__SIZEOF_LONG__ * 8)
+
+typedef uint8_t		u8;
+typedef uint64_t	u64;
+
+#define __init
+#define __exit
+#define __aligned(x)	__attribute__((aligned(x)))
+#define EXPORT_SYMBOL(sym)
+#define MODULE_AUTHOR(s)
+#define MODULE_DESCRIPTION(s)
+#define MODULE_VERSION(s)
+#define MODULE_LICENSE(s)
+/* run the module init/exit hooks around main() */
+#define module_init(fn)							\
+	static void __attribute__((constructor)) ec_user_init(void)	\
+	{ fn(); }
+#define module_exit(fn)							\
+	static void __attribute__((destructor)) ec_user_exit(void)	\
+	{ fn(); }
+
+#define ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+#define min(a, b)	((a) < (b) ? (a) : (b))
+#define unlikely(x)	__builtin_expect(!!(x), 0)
+
+#define CDEBUG(mask, fmt, ...)	do {} while (0)
+#define CWARN(fmt, ...)		fprintf(stderr, fmt, ##__VA_ARGS__)
+#define CERROR(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define LCONSOLE_INFO(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+
+#define LIBCFS_ALLOC(ptr, size)	((ptr) = calloc(1, (size)))
+#define LIBCFS_FREE(ptr, size)	free(ptr)
+#define CFS_ALLOC_PTR(ptr)	LIBCFS_ALLOC(ptr, sizeof(*(ptr)))
+#define CFS_FREE_PTR(ptr)	LIBCFS_FREE(ptr, sizeof(*(ptr)))
+
+typedef pthread_mutex_t spinlock_t;
+#define spin_lock_init(lock)	pthread_mutex_init(lock, NULL)
+#define spin_lock(lock)		pthread_mutex_lock(lock)
+#define spin_unlock(lock)	pthread_mutex_unlock(lock)
+
+typedef struct { int counter; } atomic_t;
+#define atomic_set(a, v)	__atomic_store_n(&(a)->counter, v, __ATOMIC_SEQ_CST)
+#define atomic_read(a)		__atomic_load_n(&(a)->counter, __ATOMIC_SEQ_CST)
+#define atomic_inc(a)		__atomic_add_fetch(&(a)->counter, 1, __ATOMIC_SEQ_CST)
+#define atomic_dec_and_test(a)	\
+	(__atomic_sub_fetch(&(a)->counter, 1, __ATOMIC_SEQ_CST) == 0)
+
+/* time base for the speed tests, in milliseconds */
+static inline unsigned long ec_user_msecs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+#define jiffies			ec_user_msecs()
+#define cfs_time_seconds(s)	((s) * 1000)
+#define jiffies_to_msecs(j)	(j)
+#define time_before(a, b)	((long)((a) - (b)) < 0)
+
+static inline void get_random_bytes(void *buf, int nbytes)
+{
+	int i;
+
+	for (i = 0; i < nbytes; i++)
+		((u8 *)buf)[i] = random();
+}
+
+#ifdef CONFIG_X86_64
+/* the vector kernels are built with -mgeneral-regs-only instead */
+#define kernel_fpu_begin()	do {} while (0)
+#define kernel_fpu_end()	do {} while (0)
+#define may_use_simd()		true
+#define boot_cpu_has(feature)	__builtin_cpu_supports(feature)
+#define X86_FEATURE_SSSE3	"ssse3"
+#define X86_FEATURE_AVX		"avx"
+#define X86_FEATURE_AVX2	"avx2"
+#define X86_FEATURE_AVX512F	"avx512f"
+#define X86_FEATURE_AVX512BW	"avx512bw"
+#define X86_FEATURE_GFNI	"gfni"
+#endif
+#endif /* __KERNEL__ */
+
+/**
+ * Erasure code kernel implementation.
+ *
+ * Each instruction set provides one of these; ec_init() picks the fastest
+ * one that is supported by the CPU and passes the self-test against the
+ * scalar ec_encode_data_base() reference.
+ */
+struct ec_simd_ops {
+	/* short name used in the speed report, e.g. "avx2" */
+	const char	*eso_name;
+	/* whether the running CPU implements the required instructions */
+	bool		(*eso_usable)(void);
+	/* same arguments and semantics as ec_encode_data() */
+	void		(*eso_encode)(int len, int k, int rows,
+				      unsigned char *gftbls,
+				      unsigned char **data,
+				      unsigned char **coding);
+	/* same arguments and semantics as ec_encode_data_update() */
+	void		(*eso_update)(int len, int k, int rows, int vec_i,
+				      unsigned char *gftbls,
+				      unsigned char *data,
+				      unsigned char **coding);
+};
+
+void ec_encode_data_base(int len, int k, int rows, unsigned char *gftbls,
+			 unsigned char **data, unsigned char **coding);
+void ec_encode_data_update_base(int len, int k, int rows, int vec_i,
+				unsigned char *gftbls, unsigned char *data,
+				unsigned char **coding);
+
+#ifdef CONFIG_X86_64
+extern const struct ec_simd_ops ec_sse_ops;
+extern const struct ec_simd_ops ec_avx2_ops;
+extern const struct ec_simd_ops ec_avx512_ops;
+extern const struct ec_simd_ops ec_gfni_ops;
+#endif
+
+#endif /* _EC_INTERNAL_H_ */
@@ -0,0 +1,559 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/**********************************************************************
+ * Copyright(c) 2011-2015 Intel Corporation All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *    Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *    Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *    Neither the name of Intel Corporation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * x86_64 vector kernels for ec_encode_data() and ec_encode_data_update().
+ *
+ * The SSE, AVX2 and AVX-512 kernels use the split-nibble tables built by
+ * gf_vect_mul_init(): every source byte is split into its low and high
+ * nibble, each nibble indexes a 16-entry table with PSHUFB, and the two
+ * lookups are XORed into the parity accumulator.  The GFNI kernel instead
+ * multiplies each byte by a constant with a single GF2P8AFFINEQB, using an
+ * 8x8 bit matrix derived from the same tables.
+ *
+ * Like lib/raid6, the kernels are written as inline assembly on fixed
+ * vector registers inside kernel_fpu_begin()/kernel_fpu_end(), so the
+ * module does not need to be built with vector instructions enabled.
+ * Up to EC_X86_ROWS parity rows are computed per pass over the sources,
+ * and any tail shorter than the vector width is done with the scalar
+ * tables.
+ */
+
+#include "erasure_code.h"
+#include "ec_internal.h"
+
+/* number of parity rows accumulated in registers per pass */
+#define EC_X86_ROWS	4
+/* bytes of each vector processed per kernel_fpu_begin() section */
+#define EC_FPU_CHUNK	4096
+/* sources handled per pass by the GFNI kernel, bounds the matrix cache */
+#define EC_GFNI_SRCS	16
+
+static const u8 ec_x86_nibble_mask[64] __aligned(64) = {
+	[0 ... 63] = 0x0f
+};
+
+/*
+ * Compute \a rows parity rows over bytes [off, off + len) of \a srcs
+ * sources.  The table for row l and source j is at tbls + (l * stride + j)
+ * * 32.  If \a xor_dst is set the result is added to \a coding instead of
+ * replacing it, which is how ec_encode_data_update() is implemented.
+ */
+typedef void (*ec_x86_dot_prod_t)(int off, int len, int srcs, int stride,
+				  int rows, const u8 *tbls, u8 **data,
+				  u8 **coding, bool xor_dst);
+
+/* multiply one byte by the coefficient behind a 32-byte split table */
+static inline u8 ec_tbl_mul(const u8 *tbl, u8 s)
+{
+	return tbl[s & 0x0f] ^ tbl[16 + (s >> 4)];
+}
+
+/* scalar version of ec_x86_dot_prod_t, for tails and when SIMD is unusable */
+static void ec_x86_dot_prod_tail(int off, int len, int srcs, int stride,
+				 int rows, const u8 *tbls, u8 **data,
+				 u8 **coding, bool xor_dst)
+{
+	int i, j, l;
+	u8 s;
+
+	for (l = 0; l < rows; l++) {
+		for (i = off; i < off + len; i++) {
+			s = xor_dst ? coding[l][i] : 0;
+			for (j = 0; j < srcs; j++)
+				s ^= ec_tbl_mul(&tbls[(l * stride + j) * 32],
+						data[j][i]);
+			coding[l][i] = s;
+		}
+	}
+}
+
+/*
+ * Run \a dot_prod over the largest multiple of \a width bytes of each
+ * vector, EC_X86_ROWS parity rows at a time, and finish the remainder
+ * with the scalar tables.  Preemption is only disabled for one
+ * EC_FPU_CHUNK at a time so that large stripes do not hurt latency.
+ */
+static void ec_x86_run(int len, int srcs, int stride, int rows,
+		       const u8 *tbls, u8 **data, u8 **coding, bool xor_dst,
+		       int width, ec_x86_dot_prod_t dot_prod)
+{
+	int vlen = len & ~(width - 1);
+	int off;
+	int n;
+	int l;
+
+	if (!may_use_simd())
+		vlen = 0;
+
+	for (off = 0; off < vlen; off += n) {
+		n = min(vlen - off, EC_FPU_CHUNK);
+		kernel_fpu_begin();
+		for (l = 0; l < rows; l += EC_X86_ROWS)
+			dot_prod(off, n, srcs, stride,
+				 min(rows - l, EC_X86_ROWS),
+				 tbls + l * stride * 32, data, coding + l,
+				 xor_dst);
+		kernel_fpu_end();
+	}
+
+	if (vlen < len)
+		ec_x86_dot_prod_tail(vlen, len - vlen, srcs, stride, rows,
+				     tbls, data, coding, xor_dst);
+}
+
+/* SSSE3: 16 bytes per iteration, accumulators in xmm0-xmm3 */
+#define EC_SSE_MAD(acc, tbl)						\
+	asm volatile("movdqu %0, %%xmm6\n\t"				\
+		     "movdqu %1, %%xmm7\n\t"				\
+		     "pshufb %%xmm4, %%xmm6\n\t"			\
+		     "pshufb %%xmm5, %%xmm7\n\t"			\
+		     "pxor %%xmm6, %%xmm" #acc "\n\t"			\
+		     "pxor %%xmm7, %%xmm" #acc				\
+		     : : "m" ((tbl)[0]), "m" ((tbl)[16]))
+
+#define EC_SSE_XOR(acc, dst)						\
+	asm volatile("movdqu %0, %%xmm6\n\t"				\
+		     "pxor %%xmm6, %%xmm" #acc : : "m" (dst))
+
+#define EC_SSE_STORE(acc, dst)						\
+	asm volatile("movdqu %%xmm" #acc ", %0" : "=m" (dst) : : "memory")
+
+static void ec_sse_dot_prod(int off, int len, int srcs, int stride,
+			    int rows, const u8 *tbls, u8 **data, u8 **coding,
+			    bool xor_dst)
+{
+	const u8 *tbl;
+	int i;
+	int j;
+
+	asm volatile("movdqa %0, %%xmm15" : : "m" (ec_x86_nibble_mask[0]));
+
+	for (i = off; i < off + len; i += 16) {
+		asm volatile("pxor %xmm0, %xmm0\n\t"
+			     "pxor %xmm1, %xmm1\n\t"
+			     "pxor %xmm2, %xmm2\n\t"
+			     "pxor %xmm3, %xmm3");
+		for (j = 0; j < srcs; j++) {
+			asm volatile("movdqu %0, %%xmm4\n\t"
+				     "movdqa %%xmm4, %%xmm5\n\t"
+				     "psrlw $4, %%xmm5\n\t"
+				     "pand %%xmm15, %%xmm4\n\t"
+				     "pand %%xmm15, %%xmm5"
+				     : : "m" (data[j][i]));
+			tbl = tbls + j * 32;
+			EC_SSE_MAD(0, tbl);
+			if (rows > 1)
+				EC_SSE_MAD(1, tbl + stride * 32);
+			if (rows > 2)
+				EC_SSE_MAD(2, tbl + 2 * stride * 32);
+			if (rows > 3)
+				EC_SSE_MAD(3, tbl + 3 * stride * 32);
+		}
+		if (xor_dst) {
+			EC_SSE_XOR(0, coding[0][i]);
+			if (rows > 1)
+				EC_SSE_XOR(1, coding[1][i]);
+			if (rows > 2)
+				EC_SSE_XOR(2, coding[2][i]);
+			if (rows > 3)
+				EC_SSE_XOR(3, coding[3][i]);
+		}
+		EC_SSE_STORE(0, coding[0][i]);
+		if (rows > 1)
+			EC_SSE_STORE(1, coding[1][i]);
+		if (rows > 2)
+			EC_SSE_STORE(2, coding[2][i]);
+		if (rows > 3)
+			EC_SSE_STORE(3, coding[3][i]);
+	}
+}
+
+static bool ec_sse_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_SSSE3);
+}
+
+static void ec_sse_encode(int len, int k, int rows, u8 *gftbls,
+			  u8 **data, u8 **coding)
+{
+	ec_x86_run(len, k, k, rows, gftbls, data, coding, false, 16,
+		   ec_sse_dot_prod);
+}
+
+static void ec_sse_update(int len, int k, int rows, int vec_i, u8 *gftbls,
+			  u8 *data, u8 **coding)
+{
+	ec_x86_run(len, 1, k, rows, gftbls + vec_i * 32, &data, coding, true,
+		   16, ec_sse_dot_prod);
+}
+
+const struct ec_simd_ops ec_sse_ops = {
+	.eso_name	= "sse",
+	.eso_usable	= ec_sse_usable,
+	.eso_encode	= ec_sse_encode,
+	.eso_update	= ec_sse_update,
+};
+
+/* AVX2: 32 bytes per iteration, accumulators in ymm0-ymm3 */
+#define EC_AVX2_MAD(acc, tbl)						\
+	asm volatile("vbroadcasti128 %0, %%ymm6\n\t"			\
+		     "vbroadcasti128 %1, %%ymm7\n\t"			\
+		     "vpshufb %%ymm4, %%ymm6, %%ymm6\n\t"		\
+		     "vpshufb %%ymm5, %%ymm7, %%ymm7\n\t"		\
+		     "vpxor %%ymm6, %%ymm" #acc ", %%ymm" #acc "\n\t"	\
+		     "vpxor %%ymm7, %%ymm" #acc ", %%ymm" #acc		\
+		     : : "m" ((tbl)[0]), "m" ((tbl)[16]))
+
+#define EC_AVX2_XOR(acc, dst)						\
+	asm volatile("vpxor %0, %%ymm" #acc ", %%ymm" #acc : : "m" (dst))
+
+#define EC_AVX2_STORE(acc, dst)						\
+	asm volatile("vmovdqu %%ymm" #acc ", %0" : "=m" (dst) : : "memory")
+
+static void ec_avx2_dot_prod(int off, int len, int srcs, int stride,
+			     int rows, const u8 *tbls, u8 **data, u8 **coding,
+			     bool xor_dst)
+{
+	const u8 *tbl;
+	int i;
+	int j;
+
+	asm volatile("vmovdqa %0, %%ymm15" : : "m" (ec_x86_nibble_mask[0]));
+
+	for (i = off; i < off + len; i += 32) {
+		asm volatile("vpxor %ymm0, %ymm0, %ymm0\n\t"
+			     "vpxor %ymm1, %ymm1, %ymm1\n\t"
+			     "vpxor %ymm2, %ymm2, %ymm2\n\t"
+			     "vpxor %ymm3, %ymm3, %ymm3");
+		for (j = 0; j < srcs; j++) {
+			asm volatile("vmovdqu %0, %%ymm4\n\t"
+				     "vpsrlw $4, %%ymm4, %%ymm5\n\t"
+				     "vpand %%ymm15, %%ymm4, %%ymm4\n\t"
+				     "vpand %%ymm15, %%ymm5, %%ymm5"
+				     : : "m" (data[j][i]));
+			tbl = tbls + j * 32;
+			EC_AVX2_MAD(0, tbl);
+			if (rows > 1)
+				EC_AVX2_MAD(1, tbl + stride * 32);
+			if (rows > 2)
+				EC_AVX2_MAD(2, tbl + 2 * stride * 32);
+			if (rows > 3)
+				EC_AVX2_MAD(3, tbl + 3 * stride * 32);
+		}
+		if (xor_dst) {
+			EC_AVX2_XOR(0, coding[0][i]);
+			if (rows > 1)
+				EC_AVX2_XOR(1, coding[1][i]);
+			if (rows > 2)
+				EC_AVX2_XOR(2, coding[2][i]);
+			if (rows > 3)
+				EC_AVX2_XOR(3, coding[3][i]);
+		}
+		EC_AVX2_STORE(0, coding[0][i]);
+		if (rows > 1)
+			EC_AVX2_STORE(1, coding[1][i]);
+		if (rows > 2)
+			EC_AVX2_STORE(2, coding[2][i]);
+		if (rows > 3)
+			EC_AVX2_STORE(3, coding[3][i]);
+	}
+}
+
+static bool ec_avx2_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX) &&
+	       boot_cpu_has(X86_FEATURE_AVX2);
+}
+
+static void ec_avx2_encode(int len, int k, int rows, u8 *gftbls,
+			   u8 **data, u8 **coding)
+{
+	ec_x86_run(len, k, k, rows, gftbls, data, coding, false, 32,
+		   ec_avx2_dot_prod);
+}
+
+static void ec_avx2_update(int len, int k, int rows, int vec_i, u8 *gftbls,
+			   u8 *data, u8 **coding)
+{
+	ec_x86_run(len, 1, k, rows, gftbls + vec_i * 32, &data, coding, true,
+		   32, ec_avx2_dot_prod);
+}
+
+const struct ec_simd_ops ec_avx2_ops = {
+	.eso_name	= "avx2",
+	.eso_usable	= ec_avx2_usable,
+	.eso_encode	= ec_avx2_encode,
+	.eso_update	= ec_avx2_update,
+};
+
+/* AVX-512BW: 64 bytes per iteration, accumulators in zmm0-zmm3 */
+#define EC_AVX512_MAD(acc, tbl)						\
+	asm volatile("vbroadcasti32x4 %0, %%zmm6\n\t"			\
+		     "vbroadcasti32x4 %1, %%zmm7\n\t"			\
+		     "vpshufb %%zmm4, %%zmm6, %%zmm6\n\t"		\
+		     "vpshufb %%zmm5, %%zmm7, %%zmm7\n\t"		\
+		     "vpternlogq $0x96, %%zmm6, %%zmm7, %%zmm" #acc	\
+		     : : "m" ((tbl)[0]), "m" ((tbl)[16]))
+
+#define EC_AVX512_XOR(acc, dst)						\
+	asm volatile("vpxorq %0, %%zmm" #acc ", %%zmm" #acc : : "m" (dst))
+
+#define EC_AVX512_STORE(acc, dst)					\
+	asm volatile("vmovdqu64 %%zmm" #acc ", %0" : "=m" (dst) : : "memory")
+
+static void ec_avx512_dot_prod(int off, int len, int srcs, int stride,
+			       int rows, const u8 *tbls, u8 **data,
+			       u8 **coding, bool xor_dst)
+{
+	const u8 *tbl;
+	int i;
+	int j;
+
+	asm volatile("vmovdqa64 %0, %%zmm15" : : "m" (ec_x86_nibble_mask[0]));
+
+	for (i = off; i < off + len; i += 64) {
+		asm volatile("vpxorq %zmm0, %zmm0, %zmm0\n\t"
+			     "vpxorq %zmm1, %zmm1, %zmm1\n\t"
+			     "vpxorq %zmm2, %zmm2, %zmm2\n\t"
+			     "vpxorq %zmm3, %zmm3, %zmm3");
+		for (j = 0; j < srcs; j++) {
+			asm volatile("vmovdqu64 %0, %%zmm4\n\t"
+				     "vpsrlw $4, %%zmm4, %%zmm5\n\t"
+				     "vpandq %%zmm15, %%zmm4, %%zmm4\n\t"
+				     "vpandq %%zmm15, %%zmm5, %%zmm5"
+				     : : "m" (data[j][i]));
+			tbl = tbls + j * 32;
+			EC_AVX512_MAD(0, tbl);
+			if (rows > 1)
+				EC_AVX512_MAD(1, tbl + stride * 32);
+			if (rows > 2)
+				EC_AVX512_MAD(2, tbl + 2 * stride * 32);
+			if (rows > 3)
+				EC_AVX512_MAD(3, tbl + 3 * stride * 32);
+		}
+		if (xor_dst) {
+			EC_AVX512_XOR(0, coding[0][i]);
+			if (rows > 1)
+				EC_AVX512_XOR(1, coding[1][i]);
+			if (rows > 2)
+				EC_AVX512_XOR(2, coding[2][i]);
+			if (rows > 3)
+				EC_AVX512_XOR(3, coding[3][i]);
+		}
+		EC_AVX512_STORE(0, coding[0][i]);
+		if (rows > 1)
+			EC_AVX512_STORE(1, coding[1][i]);
+		if (rows > 2)
+			EC_AVX512_STORE(2, coding[2][i]);
+		if (rows > 3)
+			EC_AVX512_STORE(3, coding[3][i]);
+	}
+}
+
+static bool ec_avx512_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX512F) &&
+	       boot_cpu_has(X86_FEATURE_AVX512BW);
+}
+
+static void ec_avx512_encode(int len, int k, int rows, u8 *gftbls,
+			     u8 **data, u8 **coding)
+{
+	ec_x86_run(len, k, k, rows, gftbls, data, coding, false, 64,
+		   ec_avx512_dot_prod);
+}
+
+static void ec_avx512_update(int len, int k, int rows, int vec_i,
+			     u8 *gftbls, u8 *data, u8 **coding)
+{
+	ec_x86_run(len, 1, k, rows, gftbls + vec_i * 32, &data, coding, true,
+		   64, ec_avx512_dot_prod);
+}
+
+const struct ec_simd_ops ec_avx512_ops = {
+	.eso_name	= "avx512",
+	.eso_usable	= ec_avx512_usable,
+	.eso_encode	= ec_avx512_encode,
+	.eso_update	= ec_avx512_update,
+};
+
+/*
+ * GFNI: multiplication by a constant is linear over GF(2), so it can be
+ * expressed as the 8x8 bit matrix taken by GF2P8AFFINEQB.  Column j of
+ * the matrix is c * x^j, which the split table already holds at
+ * tbl[1 << j] for the low nibble and tbl[16 + (1 << (j - 4))] for the
+ * high nibble.  Row i of the result (bit i of the product) lives in
+ * byte 7 - i of the matrix operand.
+ */
+static u64 ec_gfni_matrix(const u8 *tbl)
+{
+	static const u8 col[8] = { 1, 2, 4, 8, 17, 18, 20, 24 };
+	u64 matrix = 0;
+	u8 row;
+	int i;
+	int j;
+
+	for (i = 0; i < 8; i++) {
+		row = 0;
+		for (j = 0; j < 8; j++)
+			row |= ((tbl[col[j]] >> i) & 1) << j;
+		matrix |= (u64)row << (8 * (7 - i));
+	}
+
+	return matrix;
+}
+
+#define EC_GFNI_MAD(acc, mat)						\
+	asm volatile("vpbroadcastq %0, %%ymm6\n\t"			\
+		     "vgf2p8affineqb $0, %%ymm6, %%ymm4, %%ymm6\n\t"	\
+		     "vpxor %%ymm6, %%ymm" #acc ", %%ymm" #acc		\
+		     : : "m" (mat))
+
+/*
+ * Same as ec_x86_dot_prod_t, with the coefficient matrices for each row
+ * and source in \a mat instead of the split tables.
+ */
+static void ec_gfni_dot_prod(int off, int len, int srcs, int rows,
+			     u64 mat[][EC_GFNI_SRCS], u8 **data,
+			     u8 **coding, bool xor_dst)
+{
+	int i;
+	int j;
+
+	for (i = off; i < off + len; i += 32) {
+		asm volatile("vpxor %ymm0, %ymm0, %ymm0\n\t"
+			     "vpxor %ymm1, %ymm1, %ymm1\n\t"
+			     "vpxor %ymm2, %ymm2, %ymm2\n\t"
+			     "vpxor %ymm3, %ymm3, %ymm3");
+		for (j = 0; j < srcs; j++) {
+			asm volatile("vmovdqu %0, %%ymm4" : : "m" (data[j][i]));
+			EC_GFNI_MAD(0, mat[0][j]);
+			if (rows > 1)
+				EC_GFNI_MAD(1, mat[1][j]);
+			if (rows > 2)
+				EC_GFNI_MAD(2, mat[2][j]);
+			if (rows > 3)
+				EC_GFNI_MAD(3, mat[3][j]);
+		}
+		if (xor_dst) {
+			EC_AVX2_XOR(0, coding[0][i]);
+			if (rows > 1)
+				EC_AVX2_XOR(1, coding[1][i]);
+			if (rows > 2)
+				EC_AVX2_XOR(2, coding[2][i]);
+			if (rows > 3)
+				EC_AVX2_XOR(3, coding[3][i]);
+		}
+		EC_AVX2_STORE(0, coding[0][i]);
+		if (rows > 1)
+			EC_AVX2_STORE(1, coding[1][i]);
+		if (rows > 2)
+			EC_AVX2_STORE(2, coding[2][i]);
+		if (rows > 3)
+			EC_AVX2_STORE(3, coding[3][i]);
+	}
+}
+
+static bool ec_gfni_usable(void)
+{
+#ifdef X86_FEATURE_GFNI
+	return boot_cpu_has(X86_FEATURE_GFNI) && ec_avx2_usable();
+#else
+	return false;
+#endif
+}
+
+/*
+ * GFNI version of ec_x86_run().  The matrices are computed once per
+ * group of EC_X86_ROWS rows and EC_GFNI_SRCS sources; groups of sources
+ * after the first are added to the partial parity already stored.
+ */
+static void ec_gfni_run(int len, int srcs, int stride, int rows,
+			const u8 *tbls, u8 **data, u8 **coding, bool xor_dst)
+{
+	u64 mat[EC_X86_ROWS][EC_GFNI_SRCS];
+	int vlen = len & ~31;
+	int nrows;
+	int nsrcs;
+	int off;
+	int n;
+	int l;
+	int r;
+	int j;
+	int i;
+
+	if (!may_use_simd())
+		vlen = 0;
+
+	for (l = 0; vlen > 0 && l < rows; l += EC_X86_ROWS) {
+		nrows = min(rows - l, EC_X86_ROWS);
+		for (j = 0; j < srcs; j += EC_GFNI_SRCS) {
+			nsrcs = min(srcs - j, EC_GFNI_SRCS);
+			for (r = 0; r < nrows; r++)
+				for (i = 0; i < nsrcs; i++)
+					mat[r][i] = ec_gfni_matrix(
+						&tbls[((l + r) * stride + j +
+						       i) * 32]);
+
+			for (off = 0; off < vlen; off += n) {
+				n = min(vlen - off, EC_FPU_CHUNK);
+				kernel_fpu_begin();
+				ec_gfni_dot_prod(off, n, nsrcs, nrows, mat,
+						 data + j, coding + l,
+						 xor_dst || j > 0);
+				kernel_fpu_end();
+			}
+		}
+	}
+
+	if (vlen < len)
+		ec_x86_dot_prod_tail(vlen, len - vlen, srcs, stride, rows,
+				     tbls, data, coding, xor_dst);
+}
+
+static void ec_gfni_encode(int len, int k, int rows, u8 *gftbls,
+			   u8 **data, u8 **coding)
+{
+	ec_gfni_run(len, k, k, rows, gftbls, data, coding, false);
+}
+
+static void ec_gfni_update(int len, int k, int rows, int vec_i, u8 *gftbls,
+			   u8 *data, u8 **coding)
+{
+	ec_gfni_run(len, 1, k, rows, gftbls + vec_i * 32, &data, coding, true);
+}
+
+const struct ec_simd_ops ec_gfni_ops = {
+	.eso_name	= "gfni",
+	.eso_usable	= ec_gfni_usable,
+	.eso_encode	= ec_gfni_encode,
+	.eso_update	= ec_gfni_update,
+};
@@ -746,6 +746,14 @@ enum cl_page_type {
 #define	CP_STATE_BITS	4
 #define	CP_TYPE_BITS	2
 #define	CP_MAX_LAYER	2
+#define	CP_ORDER_BITS	4
+
+/**
+ * Largest folio a single cacheable cl_page may cover. 64KiB is the minimum
+ * stripe size, so a folio never straddles a stripe (and so a sub-object).
+ */
+#define CL_PAGE_MAX_ORDER	(PAGE_SHIFT < 16 ? 16 - PAGE_SHIFT : 0)
+#define CL_PAGE_MAX_NR		(1UL << CL_PAGE_MAX_ORDER)
 
 /**
  * Fields are protected by the lock on struct page, except for atomics and
@@ -792,6 +800,11 @@ struct cl_page {
 	unsigned		cp_defer_uptodate:1,
 				cp_ra_updated:1,
 				cp_ra_used:1;
+	/**
+	 * Order of the folio behind a cacheable page, 0 for a single page.
+	 * cp_vmpage is always the head page. Immutable after creation.
+	 */
+	unsigned		cp_order:CP_ORDER_BITS;
 	/* which slab kmem index this memory allocated from */
 	short int		cp_kmem_index;
 
@@ -990,6 +1003,18 @@ static inline pgoff_t cl_page_index(const struct cl_page *cp)
 	return cl_page_vmpage(cp)->index;
 }
 
+/** Number of PAGE_SIZE pages covered by \a cp */
+static inline unsigned int cl_page_nr(const struct cl_page *cp)
+{
+	return 1U << cp->cp_order;
+}
+
+/** Number of bytes covered by \a cp */
+static inline unsigned int cl_page_size(const struct cl_page *cp)
+{
+	return PAGE_SIZE << cp->cp_order;
+}
+
 /**
  * Check if a cl_page is in use.
  *
@@ -1834,6 +1859,8 @@ struct cl_io {
 			int		ft_executable;
 			/** page_mkwrite() */
 			int		ft_mkwrite;
+			/** page index past the end of the faulting VMA */
+			pgoff_t		ft_vma_end;
 			/** resulting page */
 			struct cl_page *ft_page;
 		} ci_fault;
@@ -2566,8 +2593,19 @@ struct ll_dio_pages {
 	size_t			ldp_count;
 	/* the file offset of the first page. */
 	loff_t			ldp_file_offset;
+	/*
+	 * unaligned writes: T10 guard tags of each page, generated while the
+	 * data is copied in so the OSC does not read it all again
+	 */
+	__be16			*ldp_guards;
+	enum cksum_types	ldp_cksum_type;
+	/* unaligned i/o: CPT of the bounce page pool of the buffer */
+	int			ldp_cpt;
 };
 
+/* room for the guards of one page in ll_dio_pages::ldp_guards */
+#define LL_DIO_GUARDS_PER_PAGE	(PAGE_SIZE / 512)
+
 /* Top level struct used for AIO and DIO */
 struct cl_dio_aio {
 	struct cl_sync_io	cda_sync;
@@ -2601,6 +2639,8 @@ struct cl_sub_dio {
 void ll_release_user_pages(struct page **pages, int npages);
 int ll_allocate_dio_buffer(struct ll_dio_pages *pvec, size_t io_size);
 void ll_free_dio_buffer(struct ll_dio_pages *pvec);
+void ll_dio_alloc_guards(struct ll_dio_pages *pvec,
+			 enum cksum_types cksum_type);
 ssize_t ll_dio_user_copy(struct cl_sub_dio *sdio, struct iov_iter *write_iov);
 
 #ifndef HAVE_KTHREAD_USE_MM
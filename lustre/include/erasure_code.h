@@ -106,6 +106,51 @@ void ec_init_tables(int k, int rows, unsigned char *a, unsigned char *gftbls);
 void ec_encode_data(int len, int k, int rows, unsigned char *gftbls,
 		    unsigned char **data, unsigned char **coding);
 
+/**
+ * @brief Apply one source vector to existing parity, runs appropriate version.
+ *
+ * Adds the contribution of source \a vec_i to the \a rows coded outputs,
+ * i.e. coding[l] ^= a[l][vec_i] * data for every row l of the coefficient
+ * matrix the tables were built from.  Starting from zeroed outputs and
+ * calling it once for each source gives the same result as
+ * ec_encode_data().
+ *
+ * Because the code is linear, a partial-stripe overwrite of source vec_i
+ * can refresh parity without reading the other sources: pass the delta
+ * (old data XOR new data) of the changed range as \a data, with \a coding
+ * pointing at the same range of the current parity.
+ *
+ * @param len    Length of each block of data (vector) of source or dest data.
+ * @param k      The number of vector sources or rows in the generator matrix
+ *		 for coding.
+ * @param rows   The number of output vectors to concurrently encode/decode.
+ * @param vec_i  The index of the vector in \a data, 0 <= vec_i < k.
+ * @param gftbls Pointer to array of input tables generated from coding
+ *		 coefficients in ec_init_tables(). Must be of size 32*k*rows
+ * @param data   Pointer to the single source (or delta) input buffer.
+ * @param coding Array of pointers to coded output buffers, updated in place.
+ * @returns none
+ */
+void ec_encode_data_update(int len, int k, int rows, int vec_i,
+			   unsigned char *gftbls, unsigned char *data,
+			   unsigned char **coding);
+
+/**
+ * @brief Name of the encode implementation selected at module load.
+ *
+ * @returns short name of the instruction set used, e.g. "avx2" or "base".
+ */
+const char *ec_encode_name(void);
+
+/**
+ * @brief Speed of the selected encode implementation.
+ *
+ * Measured on a 10+4 geometry when the module is loaded.
+ *
+ * @returns encode speed in MB/s of source data, 0 if unknown.
+ */
+int ec_encode_speed(void);
+
 /**
  * @brief Generate a Cauchy matrix of coefficients to be used for encoding.
  *
@@ -133,6 +178,74 @@ void gf_gen_cauchy1_matrix(unsigned char *a, int m, int k);
  */
 int gf_invert_matrix(unsigned char *in, unsigned char *out, const int n);
 
+/**
+ * Largest k + m supported by the decode interfaces below.
+ */
+#define EC_MAX_FRAGS	32
+
+/**
+ * @brief Generate the decode matrix for a set of erased fragments.
+ *
+ * The first k surviving fragments are used as decode sources, their
+ * indices are returned in \a src_index.  Row p of \a decode_matrix rebuilds
+ * fragment err_list[p] from those sources, and can be expanded with
+ * ec_init_tables() and applied with ec_encode_data().
+ *
+ * @param encode_matrix [(k + m) x k] matrix used to encode the stripe
+ * @param k             number of data fragments
+ * @param m             number of parity fragments
+ * @param err_list      indices (0 .. k + m - 1) of the erased fragments
+ * @param nerrs         number of erased fragments, at most m
+ * @param src_index     output, k indices of the fragments to decode from
+ * @param decode_matrix output, [nerrs x k] decode coefficients
+ * @returns 0 on success, -EINVAL for a bad erasure list or geometry,
+ *          -ENOMEM, or -EIO if the sources can not be inverted
+ */
+int ec_gen_decode_matrix(const unsigned char *encode_matrix, int k, int m,
+			 const unsigned char *err_list, int nerrs,
+			 unsigned char *src_index, unsigned char *decode_matrix);
+
+/**
+ * Decode context for one k + m geometry.
+ *
+ * Inverting the surviving rows of the encode matrix costs O(k^3), which is
+ * significant next to decoding a small fragment, so the expanded decode
+ * tables are cached for the most recently used erasure patterns.  The
+ * context may be shared between threads.
+ */
+struct ec_decoder;
+
+/**
+ * @brief Create a decode context.
+ *
+ * @param k             number of data fragments
+ * @param m             number of parity fragments, k + m <= EC_MAX_FRAGS
+ * @param encode_matrix [(k + m) x k] matrix used to encode, copied
+ * @returns new context, or NULL on bad geometry or allocation failure
+ */
+struct ec_decoder *ec_decoder_create(int k, int m,
+				     const unsigned char *encode_matrix);
+
+/**
+ * @brief Free a decode context and its cached decode tables.
+ */
+void ec_decoder_destroy(struct ec_decoder *dec);
+
+/**
+ * @brief Rebuild erased fragments of a stripe.
+ *
+ * @param dec      decode context for the stripe geometry
+ * @param len      length of each fragment
+ * @param err_list indices of the erased fragments, in any order
+ * @param nerrs    number of erased fragments, at most m
+ * @param frags    k + m fragment buffers in encode order, data first.  The
+ *                 surviving ones are read and the erased ones rebuilt.
+ * @returns 0 on success, or negative errno as for ec_gen_decode_matrix()
+ */
+int ec_decode_data(struct ec_decoder *dec, int len,
+		   const unsigned char *err_list, int nerrs,
+		   unsigned char **frags);
+
 /*************************************************************/
 
 #ifdef __cplusplus
@@ -268,6 +268,8 @@ struct tgt_session_info {
 
 	const struct mdt_body	*tsi_mdt_body;
 	struct ost_body		*tsi_ost_body;
+	/* one body per object of a multi-object OST_WRITE, in the reply */
+	struct ost_body		*tsi_ioobj_bodies;
 	struct lu_object	*tsi_corpus;
 
 	struct lu_fid		 tsi_fid;
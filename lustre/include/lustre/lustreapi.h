@@ -1142,6 +1142,7 @@ static const struct comp_flag_name {
 	{ LCME_FL_COMPRESS,	"compress" },
 	{ LCME_FL_PARTIAL,	"partial" },
 	{ LCME_FL_NOCOMPR,	"nocompr" },
+	{ LCME_FL_SPARSE,	"sparse" },
 };
 
 /* HSM component flags table */
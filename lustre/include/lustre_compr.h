@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/include/lustre_compr.h
+ *
+ * Chunk compression helpers shared by the client and the OST.  A chunk is
+ * stored either raw or as a struct ll_compr_hdr followed by the compressed
+ * data, see LCME_FL_COMPRESS and OBD_BRW_COMPRESSED.
+ */
+
+#ifndef _LUSTRE_COMPR_H
+#define _LUSTRE_COMPR_H
+
+#include <linux/types.h>
+#include <uapi/linux/lustre/lustre_idl.h>
+#include <uapi/linux/lustre/lustre_user.h>
+
+struct page;
+
+/* largest chunk handled, 4MiB, so that whole chunks fit in one bulk */
+#define COMPR_CHUNK_MAX_BITS	6
+
+/* bitmask of the enum ll_compr_type values usable on this node */
+u64 ll_compr_supported_mask(void);
+const char *ll_compr_type_name(enum ll_compr_type type);
+enum ll_compr_type ll_compr_type_resolve(enum ll_compr_type type);
+
+static inline bool ll_compr_type_supported(enum ll_compr_type type)
+{
+	type = ll_compr_type_resolve(type);
+
+	return type != LL_COMPR_TYPE_NONE &&
+	       (ll_compr_supported_mask() & BIT_ULL(type));
+}
+
+bool ll_compr_hdr_valid(const struct ll_compr_hdr *llch,
+			unsigned int chunk_size);
+
+int ll_compress_pages(enum ll_compr_type type, unsigned int level,
+		      unsigned int chunk_bits, struct page **src,
+		      struct page **dst, unsigned int *dst_pages);
+int ll_decompress_pages(struct page **pages, unsigned int chunk_bits);
+int ll_decompress_chunk(const void *src, void *dst, unsigned int chunk_size);
+
+int ll_compr_init(void);
+void ll_compr_fini(void);
+
+#endif /* _LUSTRE_COMPR_H */
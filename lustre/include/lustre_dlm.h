@@ -353,10 +353,6 @@ struct ldlm_ns_bucket {
 	 * fact the network or overall system load is at fault
 	 */
 	struct adaptive_timeout     nsb_at_estimate;
-	/**
-	 * Which res in the bucket should we start with the reclaim.
-	 */
-	int			    nsb_reclaim_start;
 	/* counter of entries in this bucket */
 	atomic_t		nsb_count;
 };
@@ -416,8 +412,11 @@ struct ldlm_namespace {
 	/** name of this namespace */
 	char			*ns_name;
 
-	/** Resource hash table for namespace. */
-	struct cfs_hash		*ns_rs_hash;
+	/**
+	 * Resource hash table for namespace, looked up under RCU.  A
+	 * resource found with a zero lr_refcount is being removed.
+	 */
+	struct rhashtable	ns_rs_hash;
 	struct ldlm_ns_bucket	*ns_rs_buckets;
 	unsigned int		ns_bucket_bits;
 
@@ -581,9 +580,10 @@ struct ldlm_namespace {
 				ns_rpc_recalc:1;
 
 	/**
-	 * Which bucket should we start with the lock reclaim.
+	 * Where the lock reclaim stopped in ns_rs_hash, the next one resumes
+	 * from there.
 	 */
-	int			ns_reclaim_start;
+	struct rhashtable_iter	ns_reclaim_iter;
 
 	struct kobject		ns_kobj; /* sysfs object */
 	struct completion	ns_kobj_unregister;
@@ -1072,15 +1072,13 @@ struct lustre_handle_array {
 struct ldlm_resource {
 	struct ldlm_ns_bucket	*lr_ns_bucket;
 
+	/** Linkage in ldlm_namespace::ns_rs_hash */
+	struct rhash_head	lr_hash;
 	/**
-	 * List item for list in namespace hash.
-	 * protected by ns_lock.
-	 * Shared with linkage for RCU-delayed free.
+	 * RCU-delayed free, lockless lookups may still walk lr_hash so the
+	 * two cannot share storage.
 	 */
-	union {
-		struct hlist_node	lr_hash;
-		struct rcu_head		lr_rcu;
-	};
+	struct rcu_head		lr_rcu;
 
 	/** Reference count for this resource */
 	atomic_t		lr_refcount;
@@ -1401,6 +1399,8 @@ int ldlm_resource_foreach(struct ldlm_resource *res, ldlm_iterator_t iter,
 			  void *closure);
 void ldlm_namespace_foreach(struct ldlm_namespace *ns, ldlm_iterator_t iter,
 			    void *closure);
+int ldlm_namespace_res_foreach(struct ldlm_namespace *ns,
+			       ldlm_res_iterator_t iter, void *closure);
 int ldlm_resource_iterate(struct ldlm_namespace *, const struct ldlm_res_id *,
 			  ldlm_iterator_t iter, void *data);
 /** @} ldlm_iterator */
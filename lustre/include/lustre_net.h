@@ -108,6 +108,9 @@
 #define DT_DEF_BRW_SIZE		(4 * ONE_MB_BRW_SIZE)
 #define DT_MAX_BRW_PAGES	(DT_MAX_BRW_SIZE >> PAGE_SHIFT)
 #define OFD_MAX_BRW_SIZE	(1U << LNET_MTU_BITS)
+/* objects in one OST_WRITE, see OBD_CONNECT2_MULTI_OBJ_BRW */
+#define PTLRPC_MAX_BRW_OBJS	32
+#define OBD_DEF_BRW_OBJS	16
 
 /* When PAGE_SIZE is a constant, we can check our arithmetic here with cpp! */
 #if ((PTLRPC_MAX_BRW_PAGES & (PTLRPC_MAX_BRW_PAGES - 1)) != 0)
@@ -70,11 +70,13 @@ enum oap_async_flags {
  * which is needed to pack with following field in osc_page */
 #define OAP_PAD_BITS (16 - OBD_BRW_WRITE - OAP_ASYNC_BITS)
 struct osc_async_page {
+	/* offset and length of the transfer within the (possibly large)
+	 * page, oap_brw_page only describes its first PAGE_SIZE part */
 	unsigned short		oap_page_off /* :PAGE_SHIFT */;
 	unsigned int		oap_cmd:OBD_BRW_WRITE;
 	enum oap_async_flags	oap_async_flags:OAP_ASYNC_BITS;
 	unsigned int		oap_padding1:OAP_PAD_BITS;	/* unused */
-	unsigned int		oap_padding2;			/* unused */
+	unsigned int		oap_count;
 
 	struct list_head	oap_pending_item;
 	struct list_head	oap_rpc_item;
@@ -88,7 +90,6 @@ struct osc_async_page {
 } __attribute__((packed));
 
 #define oap_page	oap_brw_page.bp_page
-#define oap_count	oap_brw_page.bp_count
 #define oap_brw_flags	oap_brw_page.bp_flag
 
 static inline struct osc_async_page *brw_page2oap(struct brw_page *pga)
@@ -106,6 +107,9 @@ struct osc_device {
 		ktime_t		os_init;
 		uint64_t	os_lockless_writes;    /* by bytes */
 		uint64_t	os_lockless_reads;     /* by bytes */
+		uint64_t	os_zero_writes;        /* by bytes */
+		uint64_t	os_multi_obj_writes;   /* by RPCs */
+		uint64_t	os_multi_obj_objs;     /* by objects */
 	} osc_stats;
 
 	/* configuration item(s) */
@@ -113,6 +117,7 @@ struct osc_device {
 };
 
 struct osc_extent;
+struct osc_compr_rpc;
 
 /**
  * State maintained by osc layer for each IO context.
@@ -137,6 +142,14 @@ struct osc_io {
 	/** partially truncated extent, we need to hold this extent to prevent
 	 * page writeback from happening. */
 	struct osc_extent *oi_trunc;
+	/** dirty page credits and grant taken in advance by this writer,
+	 * see osc_io_stage_fill() */
+	struct osc_io_stage {
+		struct client_obd *ois_cli;
+		unsigned int	  ois_pages;	/* dirty pages left */
+		unsigned int	  ois_grant;	/* reserved grant left */
+		unsigned int	  ois_grant_used; /* grant given to extents */
+	} oi_stage;
 	/** write osc_lock for this IO, used by osc_extent_find(). */
 	struct osc_lock   *oi_write_osclock;
 	struct osc_lock   *oi_read_osclock;
@@ -504,13 +517,13 @@ struct osc_page {
 	 * An offset within page from which next transfer starts. This is used
 	 * by cl_page_clip() to submit partial page transfers.
 	 */
-	unsigned int		ops_from:PAGE_SHIFT,
+	unsigned int		ops_from:PAGE_SHIFT + CL_PAGE_MAX_ORDER,
 	/**
 	 * An offset within page at which next transfer ends(inclusive).
 	 *
 	 * \see osc_page::ops_from.
 	 */
-				ops_to:PAGE_SHIFT,
+				ops_to:PAGE_SHIFT + CL_PAGE_MAX_ORDER,
 	/**
 	 * Boolean, true iff page is under transfer. Used for sanity checking.
 	 */
@@ -527,10 +540,48 @@ struct osc_page {
 	 * If the page is in osc_object::oo_tree.
 	 */
 				ops_intree:1;
+	/**
+	 * CPT of the LRU shard the page is kept on, see osc_lru_shard().
+	 */
+	unsigned short		ops_lru_cpt;
 	/**
 	 * lru page list. See osc_lru_{del|use}() in osc_page.c for usage.
 	 */
 	struct list_head	ops_lru;
+	/**
+	 * Transfer descriptors of pages 1..N-1 of a large folio, the first
+	 * page is described by ops_oap. NULL for a single page.
+	 */
+	struct osc_page_tail	*ops_tails;
+};
+
+/**
+ * Per-PAGE_SIZE view of a tail page of a large folio, filled by
+ * osc_build_rpc(). It starts like struct osc_page so that brw_page2oap() and
+ * oap2cl_page() work on its oap as they do on osc_page::ops_oap.
+ */
+struct osc_page_tail {
+	struct cl_page_slice	opt_cl;
+	struct osc_async_page	opt_oap;
+};
+
+/**
+ * Objects of a multi-object write, see OBD_CONNECT2_MULTI_OBJ_BRW.
+ *
+ * The pages of each object are contiguous in the page array of the RPC,
+ * object 0 is the one described by the ost_body of the request.
+ */
+struct osc_brw_objs {
+	int			 ob_count;
+	struct osc_brw_obj {
+		struct osc_object	*obo_obj;
+		/* first cl_page, for the request attributes */
+		struct cl_page		*obo_page;
+		struct obdo		 obo_oa;
+		u32			 obo_first;
+		u32			 obo_count;
+		u32			 obo_niocount;
+	} ob_objs[PTLRPC_MAX_BRW_OBJS];
 };
 
 struct osc_brw_async_args {
@@ -543,6 +594,10 @@ struct osc_brw_async_args {
 	struct client_obd	*aa_cli;
 	struct list_head	 aa_oaps;
 	struct list_head	 aa_exts;
+	/* compressed or whole-chunk view of aa_ppga, see osc_compress.c */
+	struct osc_compr_rpc	*aa_compr;
+	/* NULL unless several objects are written */
+	struct osc_brw_objs	*aa_objs;
 };
 
 extern struct kmem_cache *osc_lock_kmem;
@@ -574,6 +629,7 @@ int osc_set_async_flags(struct osc_object *obj, struct osc_page *opg,
 			u32 async_flags);
 int osc_prep_async_page(struct osc_object *osc, struct osc_page *ops,
 			struct cl_page *page, loff_t offset);
+void osc_io_stage_flush(struct osc_io *oio, enum cl_stage_flush reason);
 int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 		       struct osc_page *ops, cl_commit_cbt cb);
 int osc_page_cache_add(const struct lu_env *env, struct osc_page *opg,
@@ -656,8 +712,7 @@ int osc_cleanup_common(struct obd_device *obd);
 int osc_set_info_async(const struct lu_env *env, struct obd_export *exp,
 		       u32 keylen, void *key, u32 vallen, void *val,
 		       struct ptlrpc_request_set *set);
-int osc_ldlm_resource_invalidate(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				 struct hlist_node *hnode, void *arg);
+int osc_ldlm_resource_invalidate(struct ldlm_resource *res, void *arg);
 int osc_reconnect(const struct lu_env *env, struct obd_export *exp,
 		  struct obd_device *obd, struct obd_uuid *cluuid,
 		  struct obd_connect_data *data, void *localdata);
@@ -842,6 +897,12 @@ static inline pgoff_t osc_index(struct osc_page *opg)
 	return opg->ops_oap.oap_obj_off >> PAGE_SHIFT;
 }
 
+/** Number of PAGE_SIZE pages covered by \a opg */
+static inline unsigned int osc_page_nr(struct osc_page *opg)
+{
+	return cl_page_nr(opg->ops_cl.cpl_page);
+}
+
 static inline struct osc_object *osc_page_object(struct osc_page *ops)
 {
 	return ops->ops_oap.oap_obj;
@@ -849,6 +910,10 @@ static inline struct osc_object *osc_page_object(struct osc_page *ops)
 
 static inline struct cl_page *oap2cl_page(struct osc_async_page *oap)
 {
+	BUILD_BUG_ON(offsetof(struct osc_page, ops_oap) -
+		     offsetof(struct osc_page, ops_cl) !=
+		     offsetof(struct osc_page_tail, opt_oap) -
+		     offsetof(struct osc_page_tail, opt_cl));
 	return oap2osc(oap)->ops_cl.cpl_page;
 }
 
@@ -64,6 +64,11 @@ struct lov_oinfo {                 /* per-stripe data structure */
 	__u64 loi_kms;             /* known minimum size */
 	struct ost_lvb loi_lvb;
 	struct osc_async_rc     loi_ar;
+	/* chunk compression of the component, see LCME_FL_COMPRESS */
+	__u8 loi_compr_type;       /* enum ll_compr_type, NONE if disabled */
+	__u8 loi_compr_level;
+	__u8 loi_compr_chunk_bits; /* lcme_compr_chunk_log_bits */
+	__u8 loi_sparse;           /* LCME_FL_SPARSE, elide zero pages */
 };
 
 void lov_fix_ea_for_replay(void *lovea);
@@ -133,6 +138,8 @@ struct timeout_item {
 #define OBD_MAX_RIF_MAX		512
 #define OSC_MAX_RIF_MAX		256
 #define OSC_MAX_DIRTY_DEFAULT	2000	 /* Arbitrary large value */
+#define OSC_STAGE_PAGES_DEFAULT	32
+#define OSC_STAGE_PAGES_MAX	1024
 #define OSC_MAX_DIRTY_MB_MAX	2048     /* arbitrary, but < MAX_LONG bytes */
 #define OSC_DEFAULT_RESENDS	10
 
@@ -167,6 +174,84 @@ enum obd_cl_sem_lock_class {
 };
 
 struct obd_import;
+/* decisions of the OSC RPC autotuning kept for lproc_osc.c */
+#define CL_RPC_TUNE_TRACE	32
+
+struct cl_rpc_tune_event {
+	time64_t		crte_time;
+	u32			crte_latency_us;	/* window average */
+	u32			crte_rate_kbps;		/* window throughput */
+	u32			crte_rpcs;		/* new depth */
+	u32			crte_pages;		/* new RPC size */
+	const char		*crte_action;
+};
+
+/*
+ * Latency-driven tuning of the RPC depth and size of an OSC, see
+ * osc_rpc_tune_update().  The configured max_rpcs_in_flight and
+ * max_pages_per_rpc are the upper bounds.  Protected by cl_loi_list_lock.
+ */
+struct cl_rpc_tune {
+	u32			crt_target_us;	/* 0 = disabled */
+	u32			crt_min_rpcs;
+	u32			crt_min_pages;
+	u32			crt_rpcs;	/* depth in use */
+	u32			crt_pages;	/* RPC size in use */
+	/* current window */
+	ktime_t			crt_start;
+	u32			crt_nr;
+	u64			crt_bytes;
+	u64			crt_latency_us;
+	/* previous window */
+	u64			crt_last_rate;	/* bytes per second */
+	int			crt_last_step;	/* > 0 grown, < 0 shrunk */
+	u32			crt_undo;	/* value before growing */
+	u32			crt_hold;	/* windows left without growing */
+	/* decision trace, crt_trace_nr % CL_RPC_TUNE_TRACE is next */
+	struct cl_rpc_tune_event crt_trace[CL_RPC_TUNE_TRACE];
+	u32			crt_trace_nr;
+};
+
+/* why a writer gave back the dirty pages and grant it had staged */
+enum cl_stage_flush {
+	CL_STAGE_FLUSH_IO_END,		/* write done */
+	CL_STAGE_FLUSH_EXTENT,		/* active extent could not grow */
+	CL_STAGE_FLUSH_NO_SPACE,	/* dirty or grant limit hit */
+	CL_STAGE_FLUSH_NR,
+};
+
+/* instrumentation of the OSC writer staging, see osc_io_stage_fill() */
+struct cl_stage_stats {
+	u64			css_fills;
+	u64			css_fill_pages;
+	u64			css_fill_grant;		/* bytes */
+	u64			css_flushes[CL_STAGE_FLUSH_NR];
+	u64			css_flush_pages;	/* unused pages */
+	u64			css_flush_grant;	/* unused bytes */
+	/* cl_loi_list_lock taken for the staging, and for how long */
+	u64			css_locked;
+	u64			css_hold_ns;
+	u64			css_hold_max_ns;
+	struct obd_histogram	css_batch_hist;		/* pages per fill */
+	ktime_t			css_init;
+};
+
+/*
+ * One LRU list of clean pages per CPT, a page is kept on the shard of the
+ * NUMA node holding it, see osc_lru_shard().
+ */
+struct cl_lru_shard {
+	spinlock_t		cls_lock;
+	struct list_head	cls_list;
+	long			cls_count;		/* pages in cls_list */
+	/* shrink passes over this shard, pages freed, and their latency */
+	u64			cls_shrinks;
+	u64			cls_shrink_pages;
+	u64			cls_shrink_ns;
+	u64			cls_shrink_max_ns;
+	ktime_t			cls_init;
+};
+
 struct client_obd {
 	struct rw_semaphore	 cl_sem;
 	struct obd_uuid		 cl_target_uuid;
@@ -210,7 +295,9 @@ struct client_obd {
 				 cl_lsom_update:1, /* send LSOM updates */
 				 cl_root_squash:1, /* if root squash enabled*/
 				 /* check prj quota for root */
-				 cl_root_prjquota:1;
+				 cl_root_prjquota:1,
+				 /* elide zero pages of LCME_FL_SPARSE */
+				 cl_zero_write:1;
 	enum lustre_sec_part	 cl_sp_me;
 	enum lustre_sec_part	 cl_sp_to;
 	struct sptlrpc_flavor	 cl_flvr_mgc; /* fixed flavor of mgc->mgs */
@@ -272,6 +359,12 @@ struct client_obd {
 	u32			cl_max_pages_per_rpc;
 	u32			cl_max_rpcs_in_flight;
 	u32			cl_max_short_io_bytes;
+	/* objects sharing one write RPC, see OBD_CONNECT2_MULTI_OBJ_BRW */
+	u32			cl_max_objs_per_rpc;
+	struct cl_rpc_tune	cl_rpc_tune;
+	/* dirty pages a writer stages at once, protected by loi_list_lock */
+	u32			cl_stage_pages;
+	struct cl_stage_stats	cl_stage_stats;
 	ktime_t			cl_stats_init;
 	struct obd_histogram	cl_read_rpc_hist;
 	struct obd_histogram	cl_write_rpc_hist;
@@ -305,11 +398,9 @@ struct client_obd {
 	 * reclaim and shrink - shrink is async, voluntarily rebalancing;
 	 * reclaim is sync, initiated by IO thread when the LRU slots are
 	 * in shortage. */
-	__u64                    cl_lru_reclaim;
-	/** List of LRU pages for this client_obd */
-	struct list_head         cl_lru_list;
-	/** Lock for LRU page list */
-	spinlock_t		 cl_lru_list_lock;
+	atomic64_t		 cl_lru_reclaim;
+	/** Per-CPT lists of LRU pages for this client_obd */
+	struct cl_lru_shard	**cl_lru_shards;
 	/** # of unstable pages in this client_obd.
 	 * An unstable page is a page state that WRITE RPC has finished but
 	 * the transaction has NOT yet committed. */
@@ -820,6 +911,7 @@ static inline bool obd_mdt_recovery_abort(struct obd_device *obd)
 #define KEY_CHANGELOG_CLEAR     "changelog_clear"
 #define KEY_FID2PATH            "fid2path"
 #define KEY_CHECKSUM            "checksum"
+#define KEY_CHECKSUM_TYPE       "checksum_type"
 #define KEY_CLEAR_FS            "clear_fs"
 #define KEY_CONN_DATA           "conn_data"
 #define KEY_EVICT_BY_NID        "evict_by_nid"
@@ -895,6 +987,7 @@ enum md_cli_flags {
 	CLI_MIGRATE	= BIT(4),
 	CLI_DIRTY_DATA	= BIT(5),
 	CLI_NO_SLOT     = BIT(6),
+	CLI_READDIR_PLUS = BIT(7),
 };
 
 enum md_op_code {
@@ -417,6 +417,8 @@ enum lu_dirent_attrs {
 	LUDA_FID		= 0x0001,
 	LUDA_TYPE		= 0x0002,
 	LUDA_64BITHASH		= 0x0004,
+	/* struct luda_attr, with OBD_CONNECT2_READDIR_PLUS */
+	LUDA_ATTR		= 0x0008,
 
 	/* The following attrs are used for MDT internal only,
 	 * not visible to client */
@@ -488,6 +490,29 @@ struct luda_type {
         __u16 lt_type;
 };
 
+/**
+ * Inode attributes of the entry, so that "ls -l" does not need a getattr
+ * per entry.  They are not protected by any lock.  lda_valid holds the
+ * OBD_MD_FL* flags of the fields set, the size is the strict or lazy size
+ * on MDT of regular files (OBD_MD_FLSIZE or OBD_MD_FLLAZYSIZE).
+ *
+ * Aligned to 8 bytes.
+ */
+struct luda_attr {
+	__u64	lda_valid;
+	__u64	lda_size;
+	__u64	lda_blocks;
+	__s64	lda_mtime;
+	__s64	lda_atime;
+	__s64	lda_ctime;
+	__u32	lda_mode;
+	__u32	lda_uid;
+	__u32	lda_gid;
+	__u32	lda_nlink;
+	__u32	lda_flags;
+	__u32	lda_padding;
+};
+
 struct lu_dirpage {
         __u64            ldp_hash_start;
         __u64            ldp_hash_end;
@@ -527,10 +552,29 @@ static inline struct lu_dirent *lu_dirent_next(struct lu_dirent *ent)
 	return next;
 }
 
-static inline __kernel_size_t lu_dirent_calc_size(size_t namelen, __u16 attr)
+/* offset of struct luda_attr in an entry, after the name and luda_type */
+static inline __kernel_size_t lu_dirent_attr_offset(size_t namelen, __u32 attr)
+{
+	__kernel_size_t size = sizeof(struct lu_dirent) + namelen + 1;
+
+	if (attr & LUDA_TYPE) {
+		const __kernel_size_t align = sizeof(struct luda_type) - 1;
+
+		size = (size + align) & ~align;
+		size += sizeof(struct luda_type);
+	}
+
+	return (size + 7) & ~7;
+}
+
+static inline __kernel_size_t lu_dirent_calc_size(size_t namelen, __u32 attr)
 {
 	__kernel_size_t size;
 
+	if (attr & LUDA_ATTR)
+		return lu_dirent_attr_offset(namelen, attr) +
+		       sizeof(struct luda_attr);
+
 	if (attr & LUDA_TYPE) {
 		const __kernel_size_t align = sizeof(struct luda_type) - 1;
 
@@ -562,6 +606,17 @@ static inline __u16 lu_dirent_type_get(struct lu_dirent *ent)
 	return type;
 }
 
+static inline struct luda_attr *lu_dirent_attr_get(struct lu_dirent *ent)
+{
+	__u32 attr = __le32_to_cpu(ent->lde_attrs);
+
+	if (!(attr & LUDA_ATTR))
+		return NULL;
+
+	return (void *)ent +
+	       lu_dirent_attr_offset(__le16_to_cpu(ent->lde_namelen), attr);
+}
+
 #define MDS_DIR_END_OFF 0xfffffffffffffffeULL
 
 /**
@@ -875,6 +930,9 @@ struct ptlrpc_body_v2 {
 /* only ZFS servers require a change to support unaligned DIO, so this flag is
  * ignored for ldiskfs servers */
 #define OBD_CONNECT2_UNALIGNED_DIO	0x400000000ULL /* unaligned DIO */
+#define OBD_CONNECT2_READDIR_PLUS	0x800000000ULL /* LUDA_ATTR dirents */
+#define OBD_CONNECT2_ZERO_WRITE	       0x1000000000ULL /* OBD_BRW_ZERO */
+#define OBD_CONNECT2_MULTI_OBJ_BRW     0x2000000000ULL /* multi-obj write */
 /* XXX README XXX README XXX README XXX README XXX README XXX README XXX
  * Please DO NOT add OBD_CONNECT flags before first ensuring that this value
  * is not in use by some other branch/patch.  Email adilger@whamcloud.com
@@ -943,7 +1001,8 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT2_BATCH_RPC | \
 				OBD_CONNECT2_ENCRYPT_NAME | \
 				OBD_CONNECT2_ENCRYPT_FID2PATH | \
-				OBD_CONNECT2_DMV_IMP_INHERIT)
+				OBD_CONNECT2_DMV_IMP_INHERIT | \
+				OBD_CONNECT2_READDIR_PLUS)
 
 #define OST_CONNECT_SUPPORTED  (OBD_CONNECT_SRVLOCK | OBD_CONNECT_GRANT | \
 				OBD_CONNECT_REQPORTAL | OBD_CONNECT_VERSION | \
@@ -967,7 +1026,10 @@ struct ptlrpc_body_v2 {
 #define OST_CONNECT_SUPPORTED2 (OBD_CONNECT2_LOCKAHEAD | OBD_CONNECT2_INC_XID |\
 				OBD_CONNECT2_ENCRYPT | OBD_CONNECT2_LSEEK |\
 				OBD_CONNECT2_REP_MBITS |\
-				OBD_CONNECT2_REPLAY_CREATE)
+				OBD_CONNECT2_REPLAY_CREATE |\
+				OBD_CONNECT2_COMPRESS |\
+				OBD_CONNECT2_ZERO_WRITE |\
+				OBD_CONNECT2_MULTI_OBJ_BRW)
 
 #define ECHO_CONNECT_SUPPORTED (OBD_CONNECT_FID | OBD_CONNECT_FLAGS2)
 #define ECHO_CONNECT_SUPPORTED2 OBD_CONNECT2_REP_MBITS
@@ -1251,6 +1313,7 @@ struct lov_mds_md_v1 {            /* LOV EA mds/wire data (little-endian) */
 #define XATTR_NAME_DUMMY	"trusted.dummy"
 #define XATTR_NAME_PROJID	"trusted.projid"
 #define XATTR_NAME_DATAVER	"trusted.dataver"
+#define XATTR_NAME_COMPR	"trusted.compr"
 
 #define LL_XATTR_NAME_ENCRYPTION_CONTEXT_OLD XATTR_SECURITY_PREFIX"c"
 #define LL_XATTR_NAME_ENCRYPTION_CONTEXT XATTR_ENCRYPTION_PREFIX"c"
@@ -1442,6 +1505,9 @@ struct hsm_state_set {
 #define OBD_BRW_RDMA_ONLY    0x20000 /* RPC contains RDMA-only pages*/
 #define OBD_BRW_SYS_RESOURCE 0x40000 /* page has CAP_SYS_RESOURCE */
 #define OBD_BRW_COMPRESSED   0x80000 /* data compressed on client */
+#define OBD_BRW_ZERO        0x100000 /* range is all zeroes and its data is
+				      * not part of the bulk
+				      */
 
 #define OBD_BRW_OVER_ALLQUOTA (OBD_BRW_OVER_USRQUOTA | \
 			       OBD_BRW_OVER_GRPQUOTA | \
@@ -1460,6 +1526,37 @@ struct hsm_state_set {
 
 #define OBD_MAX_GRANT 0x7fffffffUL /* Max grant allowed to one client: 2 GiB */
 
+/*
+ * Header at the start of every chunk written with OBD_BRW_COMPRESSED.  The
+ * compressed data follows the header, the rest of the chunk is a hole.
+ * Fields are little-endian.
+ */
+#define LLCH_MAGIC		0x4C4C4348	/* "LLCH" */
+
+struct ll_compr_hdr {
+	__u32	llch_magic;		/* LLCH_MAGIC */
+	__u8	llch_header_size;	/* sizeof(struct ll_compr_hdr) */
+	__u8	llch_compr_type;	/* enum ll_compr_type, never FAST/BEST */
+	__u8	llch_compr_level:4,	/* level requested by the layout */
+		llch_chunk_log_bits:4;	/* as lcme_compr_chunk_log_bits */
+	__u8	llch_flags;		/* unused, zero */
+	__u32	llch_compr_size;	/* bytes of compressed data */
+	__u32	llch_hdr_csum;		/* crc32 of the header with this zero */
+	__u64	llch_reserved;		/* zero */
+};
+
+/*
+ * XATTR_NAME_COMPR of an OST object, set by the first write storing a
+ * compressed chunk in it.  Objects without it hold no chunk headers.
+ * Fields are little-endian.
+ */
+struct ll_compr_attr {
+	__u32	lca_types;		/* BIT(enum ll_compr_type) stored */
+	__u8	lca_chunk_log_bits;	/* as llch_chunk_log_bits */
+	__u8	lca_padding1;
+	__u16	lca_padding2;
+};
+
 #define OBD_OBJECT_EOF LUSTRE_EOF
 
 #define OST_MIN_PRECREATE 32
@@ -901,6 +901,9 @@ enum lov_comp_md_entry_flags {
 	LCME_FL_NOCOMPR   = 0x00000400, /* the component should not be
 					 * compressed
 					 */
+	LCME_FL_SPARSE	  = 0x00000800, /* zero pages are not sent on write,
+					 * see OBD_BRW_ZERO
+					 */
 	LCME_FL_NEG	  = 0x80000000	/* used to indicate a negative flag,
 					 * won't be stored on disk
 					 */
@@ -918,7 +921,9 @@ enum lov_comp_md_entry_flags {
 #define LCME_USER_MIRROR_FLAGS	(LCME_FL_PREF_RW)
 
 /* The allowed flags obtained from the client at component creation time. */
-#define LCME_CL_COMP_FLAGS	(LCME_USER_MIRROR_FLAGS | LCME_FL_EXTENSION)
+#define LCME_CL_COMP_FLAGS	(LCME_USER_MIRROR_FLAGS | LCME_FL_EXTENSION | \
+				 LCME_FL_COMPRESS | LCME_FL_NOCOMPR | \
+				 LCME_FL_SPARSE)
 
 /* The mirror flags sent by client */
 #define LCME_MIRROR_FLAGS	(LCME_FL_NOSYNC)
@@ -927,7 +932,8 @@ enum lov_comp_md_entry_flags {
  * from the default/template layout set on a directory.
  */
 #define LCME_TEMPLATE_FLAGS	(LCME_FL_PREF_RW | LCME_FL_NOSYNC | \
-				 LCME_FL_EXTENSION)
+				 LCME_FL_EXTENSION | LCME_FL_COMPRESS | \
+				 LCME_FL_NOCOMPR | LCME_FL_SPARSE)
 
 /* lcme_id can be specified as certain flags, and the the first
  * bit of lcme_id is used to indicate that the ID is representing
@@ -978,6 +984,23 @@ struct lov_comp_md_entry_v1 {
 				      * i.e. power-of-two multiple of 64KiB */
 } __attribute__((packed));
 
+/* lcme_compr_type values, also used as bit numbers in ocd_compr_type */
+enum ll_compr_type {
+	LL_COMPR_TYPE_NONE	= 0,
+	LL_COMPR_TYPE_FAST	= 1,	/* resolved to lz4 when written */
+	LL_COMPR_TYPE_BEST	= 2,	/* resolved to zstd when written */
+	LL_COMPR_TYPE_GZIP	= 3,
+	LL_COMPR_TYPE_LZ4FC	= 4,
+	LL_COMPR_TYPE_LZ4HC	= 5,
+	LL_COMPR_TYPE_LZO	= 6,
+	LL_COMPR_TYPE_ZSTD	= 7,
+	LL_COMPR_TYPE_MAX
+};
+
+#define COMPR_CHUNK_MIN_BITS	16
+#define COMPR_GET_CHUNK_SIZE(log_bits) \
+	(1UL << ((log_bits) + COMPR_CHUNK_MIN_BITS))
+
 #define SEQ_ID_MAX		0x0000FFFF
 #define SEQ_ID_MASK		SEQ_ID_MAX
 /* bit 30:16 of lcme_id is used to store mirror id */
@@ -91,6 +91,9 @@ void ldlm_namespace_move_to_active_locked(struct ldlm_namespace *,
 void ldlm_namespace_move_to_inactive_locked(struct ldlm_namespace *,
 					    enum ldlm_side);
 struct ldlm_namespace *ldlm_namespace_first_locked(enum ldlm_side);
+int ldlm_namespace_res_walk(struct ldlm_namespace *ns,
+			    struct rhashtable_iter *hiter,
+			    ldlm_res_iterator_t iter, void *closure);
 
 /* ldlm_request.c */
 int ldlm_cancel_lru(struct ldlm_namespace *ns, int min,
@@ -305,7 +305,9 @@ int client_obd_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 	const char *name = obd->obd_type->typ_name;
 	enum ldlm_ns_type ns_type = LDLM_NS_TYPE_UNKNOWN;
 	char *cli_name = lustre_cfg_buf(lcfg, 0);
+	struct cl_lru_shard *shard;
 	int rc;
+	int i;
 
 	ENTRY;
 
@@ -420,14 +422,16 @@ int client_obd_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 	spin_lock_init(&cli->cl_read_offset_hist.oh_lock);
 	spin_lock_init(&cli->cl_write_offset_hist.oh_lock);
 	spin_lock_init(&cli->cl_batch_rpc_hist.oh_lock);
+	cli->cl_stage_pages = OSC_STAGE_PAGES_DEFAULT;
+	cli->cl_stage_stats.css_init = ktime_get_real();
+	spin_lock_init(&cli->cl_stage_stats.css_batch_hist.oh_lock);
 
 	/* lru for osc. */
 	INIT_LIST_HEAD(&cli->cl_lru_osc);
 	atomic_set(&cli->cl_lru_shrinkers, 0);
 	atomic_long_set(&cli->cl_lru_busy, 0);
 	atomic_long_set(&cli->cl_lru_in_list, 0);
-	INIT_LIST_HEAD(&cli->cl_lru_list);
-	spin_lock_init(&cli->cl_lru_list_lock);
+	atomic64_set(&cli->cl_lru_reclaim, 0);
 	atomic_long_set(&cli->cl_unstable_count, 0);
 	INIT_LIST_HEAD(&cli->cl_shrink_list);
 	INIT_LIST_HEAD(&cli->cl_grant_chain);
@@ -460,6 +464,8 @@ int client_obd_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 	cli->cl_max_pages_per_rpc = PTLRPC_MAX_BRW_PAGES;
 
 	cli->cl_max_short_io_bytes = OBD_DEF_SHORT_IO_BYTES;
+	cli->cl_max_objs_per_rpc = OBD_DEF_BRW_OBJS;
+	cli->cl_zero_write = 1;
 
 	/*
 	 * set cl_chunkbits default value to PAGE_SHIFT,
@@ -492,6 +498,17 @@ int client_obd_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 
 	INIT_LIST_HEAD(&cli->cl_chg_dev_linkage);
 
+	cli->cl_lru_shards = cfs_percpt_alloc(cfs_cpt_tab,
+					      sizeof(struct cl_lru_shard));
+	if (cli->cl_lru_shards == NULL)
+		GOTO(err, rc = -ENOMEM);
+
+	cfs_percpt_for_each(shard, i, cli->cl_lru_shards) {
+		spin_lock_init(&shard->cls_lock);
+		INIT_LIST_HEAD(&shard->cls_list);
+		shard->cls_init = ktime_get_real();
+	}
+
 	if (connect_op == MDS_CONNECT) {
 		cli->cl_max_mod_rpcs_in_flight = cli->cl_max_rpcs_in_flight - 1;
 		OBD_ALLOC(cli->cl_mod_tag_bitmap,
@@ -574,6 +591,9 @@ err_import:
 err_ldlm:
 	ldlm_put_ref();
 err:
+	if (cli->cl_lru_shards != NULL)
+		cfs_percpt_free(cli->cl_lru_shards);
+	cli->cl_lru_shards = NULL;
 	if (cli->cl_mod_tag_bitmap != NULL)
 		OBD_FREE(cli->cl_mod_tag_bitmap,
 			 BITS_TO_LONGS(OBD_MAX_RIF_MAX) * sizeof(long));
@@ -597,6 +617,9 @@ int client_obd_cleanup(struct obd_device *obd)
 
 	ldlm_put_ref();
 
+	if (cli->cl_lru_shards != NULL)
+		cfs_percpt_free(cli->cl_lru_shards);
+	cli->cl_lru_shards = NULL;
 	if (cli->cl_mod_tag_bitmap != NULL)
 		OBD_FREE(cli->cl_mod_tag_bitmap,
 			 BITS_TO_LONGS(OBD_MAX_RIF_MAX) * sizeof(long));
@@ -2448,11 +2448,8 @@ void ldlm_reprocess_all(struct ldlm_resource *res, __u64 hint)
 }
 EXPORT_SYMBOL(ldlm_reprocess_all);
 
-static int ldlm_reprocess_res(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-			      struct hlist_node *hnode, void *arg)
+static int ldlm_reprocess_res(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource *res = cfs_hash_object(hs, hnode);
-
 	/* This is only called once after recovery done. LU-8306. */
 	__ldlm_reprocess_all(res, LDLM_PROCESS_RECOVERY, 0);
 	return 0;
@@ -2466,10 +2463,8 @@ void ldlm_reprocess_recovery_done(struct ldlm_namespace *ns)
 {
 	ENTRY;
 
-	if (ns != NULL) {
-		cfs_hash_for_each_nolock(ns->ns_rs_hash,
-					 ldlm_reprocess_res, NULL, 0);
-	}
+	if (ns != NULL)
+		ldlm_namespace_res_foreach(ns, ldlm_reprocess_res, NULL);
 	EXIT;
 }
 
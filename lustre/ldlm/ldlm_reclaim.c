@@ -70,11 +70,9 @@ struct ldlm_reclaim_cb_data {
 	struct list_head	 rcd_rpc_list;
 	int			 rcd_added;
 	int			 rcd_total;
-	int			 rcd_cursor;
-	int			 rcd_start;
-	bool			 rcd_skip;
+	/* resources left to scan, each is scanned once per reclaim */
+	int			 rcd_left;
 	s64			 rcd_age_ns;
-	struct cfs_hash_bd	*rcd_prev_bd;
 };
 
 static inline bool ldlm_lock_reclaimable(struct ldlm_lock *lock)
@@ -95,22 +93,16 @@ static inline bool ldlm_lock_reclaimable(struct ldlm_lock *lock)
 /**
  * Callback function for revoking locks from certain resource.
  *
- * \param [in] hs	ns_rs_hash
- * \param [in] bd	current bucket of ns_rsh_hash
- * \param [in] hnode	hnode of the resource
+ * \param [in] res	the resource
  * \param [in] arg	opaque data
  *
  * \retval 0		continue the scan
  * \retval 1		stop the iteration
  */
-static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				struct hlist_node *hnode, void *arg)
-
+static int ldlm_reclaim_lock_cb(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource		*res;
 	struct ldlm_reclaim_cb_data	*data;
 	struct ldlm_lock		*lock;
-	struct ldlm_ns_bucket		*nsb;
 	int				 rc = 0;
 
 	data = (struct ldlm_reclaim_cb_data *)arg;
@@ -118,25 +110,6 @@ static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 	LASSERTF(data->rcd_added < data->rcd_total, "added:%d >= total:%d\n",
 		 data->rcd_added, data->rcd_total);
 
-	nsb = cfs_hash_bd_extra_get(hs, bd);
-	res = cfs_hash_object(hs, hnode);
-
-	if (data->rcd_prev_bd != bd) {
-		if (data->rcd_prev_bd != NULL)
-			ldlm_res_to_ns(res)->ns_reclaim_start++;
-		data->rcd_prev_bd = bd;
-		data->rcd_cursor = 0;
-		data->rcd_start = nsb->nsb_reclaim_start %
-				  cfs_hash_bd_count_get(bd);
-	}
-
-	if (data->rcd_skip && data->rcd_cursor < data->rcd_start) {
-		data->rcd_cursor++;
-		return 0;
-	}
-
-	nsb->nsb_reclaim_start++;
-
 	lock_res(res);
 	list_for_each_entry(lock, &res->lr_granted, l_res_link) {
 		if (!ldlm_lock_reclaimable(lock))
@@ -161,9 +134,22 @@ static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 	}
 	unlock_res(res);
 
+	if (--data->rcd_left <= 0)
+		rc = 1;
+
 	return rc;
 }
 
+/*
+ * Start the next reclaim walk of \a ns over from the first resource. Only
+ * the reclaim thread uses ns_reclaim_iter, see ldlm_nr_reclaimer.
+ */
+static void ldlm_reclaim_rewind(struct ldlm_namespace *ns)
+{
+	rhashtable_walk_exit(&ns->ns_reclaim_iter);
+	rhashtable_walk_enter(&ns->ns_rs_hash, &ns->ns_reclaim_iter);
+}
+
 /**
  * Revoke locks from the resources of a namespace in a roundrobin
  * manner.
@@ -171,7 +157,7 @@ static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
  * \param[in] ns	namespace to do the lock revoke on
  * \param[in] count	count of lock to be revoked
  * \param[in] age	only revoke locks older than the 'age'
- * \param[in] skip	scan from the first lock on resource if the
+ * \param[in] skip	scan from the first resource of the namespace if the
  *			'skip' is false, otherwise, continue scan
  *			from the last scanned position
  * \param[out] count	count of lock still to be revoked
@@ -180,7 +166,7 @@ static void ldlm_reclaim_res(struct ldlm_namespace *ns, int *count,
 			     s64 age_ns, bool skip)
 {
 	struct ldlm_reclaim_cb_data	data;
-	int				idx, type, start;
+	int				idx, type, pass;
 	int				rc;
 	ENTRY;
 
@@ -203,12 +189,21 @@ static void ldlm_reclaim_res(struct ldlm_namespace *ns, int *count,
 	data.rcd_added = 0;
 	data.rcd_total = *count;
 	data.rcd_age_ns = age_ns;
-	data.rcd_skip = skip;
-	data.rcd_prev_bd = NULL;
-	start = ns->ns_reclaim_start % CFS_HASH_NBKT(ns->ns_rs_hash);
 
-	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_reclaim_lock_cb, &data,
-				 start);
+	/*
+	 * Resume where the last reclaim of this namespace stopped and wrap
+	 * around once, scanning each resource at most once.
+	 */
+	data.rcd_left = atomic_read(&ns->ns_rs_hash.nelems);
+	if (!skip)
+		ldlm_reclaim_rewind(ns);
+	for (pass = 0; pass < 2 && data.rcd_left > 0; pass++) {
+		if (ldlm_namespace_res_walk(ns, &ns->ns_reclaim_iter,
+					    ldlm_reclaim_lock_cb, &data))
+			break;
+		/* the end of the table was reached */
+		ldlm_reclaim_rewind(ns);
+	}
 
 	CDEBUG(D_DLMTRACE, "NS(%s): %d locks to be reclaimed, found %d/%d "
 	       "locks.\n", ldlm_ns_name(ns), *count, data.rcd_added,
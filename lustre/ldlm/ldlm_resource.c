@@ -35,6 +35,7 @@
  */
 
 #define DEBUG_SUBSYSTEM S_LDLM
+#include <linux/delay.h>
 #include <lustre_dlm.h>
 #include <lustre_fid.h>
 #include <obd_class.h>
@@ -768,18 +769,6 @@ static int ldlm_namespace_debugfs_register(struct ldlm_namespace *ns)
 }
 #undef MAX_STRING_SIZE
 
-static unsigned ldlm_res_hop_hash(struct cfs_hash *hs,
-				  const void *key, unsigned int mask)
-{
-	const struct ldlm_res_id *id = key;
-	unsigned int val = 0;
-	unsigned int i;
-
-	for (i = 0; i < RES_NAME_SIZE; i++)
-		val += id->name[i];
-	return val & mask;
-}
-
 static unsigned int ldlm_res_hop_fid_hash(const struct ldlm_res_id *id, unsigned int bits)
 {
 	struct lu_fid       fid;
@@ -801,85 +790,21 @@ static unsigned int ldlm_res_hop_fid_hash(const struct ldlm_res_id *id, unsigned
 	return cfs_hash_32(hash, bits);
 }
 
-static void *ldlm_res_hop_key(struct hlist_node *hnode)
-{
-	struct ldlm_resource   *res;
-
-	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-	return &res->lr_name;
-}
-
-static int ldlm_res_hop_keycmp(const void *key, struct hlist_node *hnode)
-{
-	struct ldlm_resource   *res;
-
-	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-	return ldlm_res_eq((const struct ldlm_res_id *)key,
-			   (const struct ldlm_res_id *)&res->lr_name);
-}
-
-static void *ldlm_res_hop_object(struct hlist_node *hnode)
-{
-	return hlist_entry(hnode, struct ldlm_resource, lr_hash);
-}
-
-static void
-ldlm_res_hop_get_locked(struct cfs_hash *hs, struct hlist_node *hnode)
-{
-	struct ldlm_resource *res;
-
-	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-	ldlm_resource_getref(res);
-}
-
-static void ldlm_res_hop_put(struct cfs_hash *hs, struct hlist_node *hnode)
-{
-	struct ldlm_resource *res;
-
-	res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-	ldlm_resource_putref(res);
-}
-
-static struct cfs_hash_ops ldlm_ns_hash_ops = {
-	.hs_hash        = ldlm_res_hop_hash,
-	.hs_key         = ldlm_res_hop_key,
-	.hs_keycmp      = ldlm_res_hop_keycmp,
-	.hs_keycpy      = NULL,
-	.hs_object      = ldlm_res_hop_object,
-	.hs_get         = ldlm_res_hop_get_locked,
-	.hs_put         = ldlm_res_hop_put
+static const struct rhashtable_params ldlm_res_hash_params = {
+	.key_len	= sizeof(struct ldlm_res_id),
+	.key_offset	= offsetof(struct ldlm_resource, lr_name),
+	.head_offset	= offsetof(struct ldlm_resource, lr_hash),
+	.automatic_shrinking = true,
 };
 
-static struct {
-	/** hash bucket bits */
-	unsigned		nsd_bkt_bits;
-	/** hash bits */
-	unsigned		nsd_all_bits;
-} ldlm_ns_hash_defs[] = {
-	[LDLM_NS_TYPE_MDC] = {
-		.nsd_bkt_bits   = 11,
-		.nsd_all_bits   = 16,
-	},
-	[LDLM_NS_TYPE_MDT] = {
-		.nsd_bkt_bits   = 14,
-		.nsd_all_bits   = 21,
-	},
-	[LDLM_NS_TYPE_OSC] = {
-		.nsd_bkt_bits   = 8,
-		.nsd_all_bits   = 12,
-	},
-	[LDLM_NS_TYPE_OST] = {
-		.nsd_bkt_bits   = 11,
-		.nsd_all_bits   = 17,
-	},
-	[LDLM_NS_TYPE_MGC] = {
-		.nsd_bkt_bits   = 3,
-		.nsd_all_bits   = 4,
-	},
-	[LDLM_NS_TYPE_MGT] = {
-		.nsd_bkt_bits   = 3,
-		.nsd_all_bits   = 4,
-	},
+/* bits of the ldlm_ns_bucket array, buckets hold the AT estimates */
+static const unsigned int ldlm_ns_bucket_bits[] = {
+	[LDLM_NS_TYPE_MDC] = 5,
+	[LDLM_NS_TYPE_MDT] = 7,
+	[LDLM_NS_TYPE_OSC] = 4,
+	[LDLM_NS_TYPE_OST] = 6,
+	[LDLM_NS_TYPE_MGC] = 1,
+	[LDLM_NS_TYPE_MGT] = 1,
 };
 
 /**
@@ -903,8 +828,8 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 		RETURN(ERR_PTR(rc));
 	}
 
-	if (ns_type >= ARRAY_SIZE(ldlm_ns_hash_defs) ||
-	    ldlm_ns_hash_defs[ns_type].nsd_bkt_bits == 0) {
+	if (ns_type >= ARRAY_SIZE(ldlm_ns_bucket_bits) ||
+	    ldlm_ns_bucket_bits[ns_type] == 0) {
 		rc = -EINVAL;
 		CERROR("%s: unknown namespace type %d: rc = %d\n",
 		       name, ns_type, rc);
@@ -915,23 +840,11 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	if (!ns)
 		GOTO(out_ref, rc = -ENOMEM);
 
-	ns->ns_rs_hash = cfs_hash_create(name,
-					 ldlm_ns_hash_defs[ns_type].nsd_all_bits,
-					 ldlm_ns_hash_defs[ns_type].nsd_all_bits,
-					 ldlm_ns_hash_defs[ns_type].nsd_bkt_bits,
-					 0,
-					 CFS_HASH_MIN_THETA,
-					 CFS_HASH_MAX_THETA,
-					 &ldlm_ns_hash_ops,
-					 CFS_HASH_DEPTH |
-					 CFS_HASH_BIGNAME |
-					 CFS_HASH_SPIN_BKTLOCK |
-					 CFS_HASH_NO_ITEMREF);
-	if (!ns->ns_rs_hash)
-		GOTO(out_ns, rc = -ENOMEM);
-
-	ns->ns_bucket_bits = ldlm_ns_hash_defs[ns_type].nsd_all_bits -
-			     ldlm_ns_hash_defs[ns_type].nsd_bkt_bits;
+	rc = rhashtable_init(&ns->ns_rs_hash, &ldlm_res_hash_params);
+	if (rc)
+		GOTO(out_ns, rc);
+
+	ns->ns_bucket_bits = ldlm_ns_bucket_bits[ns_type];
 
 	OBD_ALLOC_PTR_ARRAY_LARGE(ns->ns_rs_buckets, 1 << ns->ns_bucket_bits);
 	if (!ns->ns_rs_buckets)
@@ -942,7 +855,6 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 
 		at_init(&nsb->nsb_at_estimate, obd_get_ldlm_enqueue_min(obd), 0);
 		nsb->nsb_namespace = ns;
-		nsb->nsb_reclaim_start = 0;
 		atomic_set(&nsb->nsb_count, 0);
 	}
 
@@ -975,7 +887,6 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	ns->ns_orig_connect_flags = 0;
 	ns->ns_connect_flags      = 0;
 	ns->ns_stopping           = 0;
-	ns->ns_reclaim_start	  = 0;
 	ns->ns_last_pos		  = &ns->ns_unused_list;
 	ns->ns_flags		  = 0;
 
@@ -997,6 +908,7 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 		CERROR("%s: cannot initialize lock pool, rc = %d\n", name, rc);
 		GOTO(out_proc, rc);
 	}
+	rhashtable_walk_enter(&ns->ns_rs_hash, &ns->ns_reclaim_iter);
 
 	ldlm_namespace_register(ns, client);
 	RETURN(ns);
@@ -1008,7 +920,7 @@ out_sysfs:
 out_hash:
 	OBD_FREE_PTR_ARRAY_LARGE(ns->ns_rs_buckets, 1 << ns->ns_bucket_bits);
 	kfree(ns->ns_name);
-	cfs_hash_putref(ns->ns_rs_hash);
+	rhashtable_destroy(&ns->ns_rs_hash);
 out_ns:
         OBD_FREE_PTR(ns);
 out_ref:
@@ -1101,10 +1013,81 @@ static void cleanup_resource(struct ldlm_resource *res, struct list_head *q,
 	} while (1);
 }
 
-static int ldlm_resource_clean(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-			       struct hlist_node *hnode, void *arg)
+/**
+ * Call \a iter for the resources of \a ns from where \a hiter stands until
+ * it returns non-zero or the end of the table is reached.
+ *
+ * A reference on the resource is held across the call and the RCU read
+ * lock is not, so \a iter may sleep.  The resource referenced is the one
+ * \a hiter stopped at, so it stays hashed and rhashtable_walk_start()
+ * resumes right after it.  The reference is dropped once the walk has
+ * moved on to the next resource.  Resources added during the walk, or
+ * seen while the table is resized, may be missed or visited twice.
+ *
+ * \retval 0		the end of the table was reached
+ * \retval other	value returned by \a iter to stop the walk
+ */
+int ldlm_namespace_res_walk(struct ldlm_namespace *ns,
+			    struct rhashtable_iter *hiter,
+			    ldlm_res_iterator_t iter, void *closure)
+{
+	struct ldlm_resource *prev = NULL;
+	struct ldlm_resource *res;
+	int rc = 0;
+
+	rhashtable_walk_start(hiter);
+	while ((res = rhashtable_walk_next(hiter)) != NULL) {
+		if (IS_ERR(res)) {
+			/* -EAGAIN, the table was resized */
+			continue;
+		}
+		/* being freed */
+		if (!atomic_inc_not_zero(&res->lr_refcount))
+			continue;
+
+		rhashtable_walk_stop(hiter);
+		if (prev)
+			ldlm_resource_putref(prev);
+		prev = res;
+
+		rc = iter(res, closure);
+		if (rc)
+			break;
+		cond_resched();
+		rhashtable_walk_start(hiter);
+	}
+	if (!rc)
+		rhashtable_walk_stop(hiter);
+	if (prev)
+		ldlm_resource_putref(prev);
+
+	return rc;
+}
+
+/**
+ * Call \a iter for every resource of \a ns until it returns non-zero.
+ *
+ * \see ldlm_namespace_res_walk()
+ *
+ * \retval 0		all resources were visited
+ * \retval other	value returned by \a iter to stop the walk
+ */
+int ldlm_namespace_res_foreach(struct ldlm_namespace *ns,
+			       ldlm_res_iterator_t iter, void *closure)
+{
+	struct rhashtable_iter hiter;
+	int rc;
+
+	rhashtable_walk_enter(&ns->ns_rs_hash, &hiter);
+	rc = ldlm_namespace_res_walk(ns, &hiter, iter, closure);
+	rhashtable_walk_exit(&hiter);
+
+	return rc;
+}
+EXPORT_SYMBOL(ldlm_namespace_res_foreach);
+
+static int ldlm_resource_clean(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource *res = cfs_hash_object(hs, hnode);
 	__u64 flags = *(__u64 *)arg;
 
 	cleanup_resource(res, &res->lr_granted, flags);
@@ -1113,11 +1096,8 @@ static int ldlm_resource_clean(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 	return 0;
 }
 
-static int ldlm_resource_complain(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				  struct hlist_node *hnode, void *arg)
+static int ldlm_resource_complain(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource  *res = cfs_hash_object(hs, hnode);
-
 	lock_res(res);
 	CERROR("%s: namespace resource "DLDLMRES" (%p) refcount nonzero "
 	       "(%d) after lock cleanup; forcing cleanup.\n",
@@ -1144,10 +1124,8 @@ int ldlm_namespace_cleanup(struct ldlm_namespace *ns, __u64 flags)
 		return ELDLM_OK;
 	}
 
-	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_resource_clean,
-				 &flags, 0);
-	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_resource_complain,
-				 NULL, 0);
+	ldlm_namespace_res_foreach(ns, ldlm_resource_clean, &flags);
+	ldlm_namespace_res_foreach(ns, ldlm_resource_complain, NULL);
 	return ELDLM_OK;
 }
 EXPORT_SYMBOL(ldlm_namespace_cleanup);
@@ -1272,7 +1250,8 @@ void ldlm_namespace_free_post(struct ldlm_namespace *ns)
 
 	ldlm_namespace_debugfs_unregister(ns);
 	ldlm_namespace_sysfs_unregister(ns);
-	cfs_hash_putref(ns->ns_rs_hash);
+	rhashtable_walk_exit(&ns->ns_reclaim_iter);
+	rhashtable_destroy(&ns->ns_rs_hash);
 	OBD_FREE_PTR_ARRAY_LARGE(ns->ns_rs_buckets, 1 << ns->ns_bucket_bits);
 	kfree(ns->ns_name);
 	/* Namespace \a ns should be not on list at this time, otherwise
@@ -1486,36 +1465,43 @@ static void ldlm_resource_free(struct ldlm_resource *res)
 	call_rcu(&res->lr_rcu, __ldlm_resource_free);
 }
 
+/* a reference on the resource named \a name, NULL if there is none */
+static struct ldlm_resource *ldlm_resource_find(struct ldlm_namespace *ns,
+						const struct ldlm_res_id *name)
+{
+	struct ldlm_resource *res;
+
+	rcu_read_lock();
+	res = rhashtable_lookup(&ns->ns_rs_hash, name, ldlm_res_hash_params);
+	/* a zero refcount means the resource is being removed */
+	if (res && !atomic_inc_not_zero(&res->lr_refcount))
+		res = NULL;
+	rcu_read_unlock();
+
+	return res;
+}
+
 /**
  * Return a reference to resource with given name, creating it if necessary.
  * Args: namespace with ns_lock unlocked
- * Locks: takes and releases NS hash-lock and res->lr_lock
+ * Locks: lockless lookup under RCU, takes and releases res->lr_lock
  * Returns: referenced, unlocked ldlm_resource or ERR_PTR
  */
 struct ldlm_resource *
 ldlm_resource_get(struct ldlm_namespace *ns, const struct ldlm_res_id *name,
 		  enum ldlm_type type, int create)
 {
-	struct hlist_node	*hnode;
-	struct ldlm_resource	*res = NULL;
-	struct cfs_hash_bd		bd;
-	__u64			version;
+	struct ldlm_resource	*res;
+	struct ldlm_resource	*old;
 	int			ns_refcount = 0;
 	int hash;
 
 	LASSERT(ns != NULL);
-	LASSERT(ns->ns_rs_hash != NULL);
 	LASSERT(name->name[0] != 0);
 
-	cfs_hash_bd_get_and_lock(ns->ns_rs_hash, (void *)name, &bd, 0);
-	hnode = cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
-	if (hnode != NULL) {
-		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 0);
-		GOTO(found, res);
-	}
-
-	version = cfs_hash_bd_version_get(&bd);
-	cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 0);
+	res = ldlm_resource_find(ns, name);
+	if (res)
+		return res;
 
 	if (create == 0)
 		return ERR_PTR(-ENOENT);
@@ -1531,27 +1517,43 @@ ldlm_resource_get(struct ldlm_namespace *ns, const struct ldlm_res_id *name,
 	res->lr_name = *name;
 	res->lr_type = type;
 
-	cfs_hash_bd_lock(ns->ns_rs_hash, &bd, 1);
-	hnode = (version == cfs_hash_bd_version_get(&bd)) ? NULL :
-		cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
+	while (1) {
+		rcu_read_lock();
+		old = rhashtable_lookup_get_insert_fast(&ns->ns_rs_hash,
+							&res->lr_hash,
+							ldlm_res_hash_params);
+		if (!old || (!IS_ERR(old) &&
+			     atomic_inc_not_zero(&old->lr_refcount))) {
+			rcu_read_unlock();
+			break;
+		}
+		rcu_read_unlock();
+
+		if (!IS_ERR(old)) {
+			/* the old resource is about to leave the hash */
+			cond_resched();
+		} else if (PTR_ERR(old) == -ENOMEM || PTR_ERR(old) == -EBUSY) {
+			/* hash table could be resizing */
+			msleep(5);
+		} else {
+			break;
+		}
+	}
 
-	if (hnode != NULL) {
-		/* Someone won the race and already added the resource. */
-		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
+	if (old) {
+		/* Someone won the race and already added the resource,
+		 * or the insertion failed.
+		 */
 		/* Clean lu_ref for failed resource. */
 		lu_ref_fini(&res->lr_reference);
 		ldlm_resource_free(res);
-found:
-		res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
-		return res;
+		return old;
 	}
-	/* We won! Let's add the resource. */
-	cfs_hash_bd_add_locked(ns->ns_rs_hash, &bd, &res->lr_hash);
+
+	/* We won! The resource is in the hash. */
 	if (atomic_inc_return(&res->lr_ns_bucket->nsb_count) == 1)
 		ns_refcount = ldlm_namespace_get_return(ns);
 
-	cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
-
 	CFS_FAIL_TIMEOUT(OBD_FAIL_LDLM_CREATE_RESOURCE, 2);
 
 	/* Let's see if we happened to be the very first resource in this
@@ -1578,8 +1580,8 @@ struct ldlm_resource *ldlm_resource_getref(struct ldlm_resource *res)
 	return res;
 }
 
-static void __ldlm_resource_putref_final(struct cfs_hash_bd *bd,
-                                         struct ldlm_resource *res)
+static void __ldlm_resource_putref_final(struct ldlm_namespace *ns,
+					 struct ldlm_resource *res)
 {
 	struct ldlm_ns_bucket *nsb = res->lr_ns_bucket;
 
@@ -1593,18 +1595,17 @@ static void __ldlm_resource_putref_final(struct cfs_hash_bd *bd,
 		LBUG();
 	}
 
-	cfs_hash_bd_del_locked(nsb->nsb_namespace->ns_rs_hash,
-			       bd, &res->lr_hash);
+	rhashtable_remove_fast(&ns->ns_rs_hash, &res->lr_hash,
+			       ldlm_res_hash_params);
 	lu_ref_fini(&res->lr_reference);
 	if (atomic_dec_and_test(&nsb->nsb_count))
-		ldlm_namespace_put(nsb->nsb_namespace);
+		ldlm_namespace_put(ns);
 }
 
 /* Returns 1 if the resource was freed, 0 if it remains. */
 int ldlm_resource_putref(struct ldlm_resource *res)
 {
 	struct ldlm_namespace *ns = ldlm_res_to_ns(res);
-	struct cfs_hash_bd bd;
 	int refcount;
 
 	refcount = atomic_read(&res->lr_refcount);
@@ -1613,10 +1614,11 @@ int ldlm_resource_putref(struct ldlm_resource *res)
 	CDEBUG(D_INFO, "putref res: %p count: %d\n",
 	       res, atomic_read(&res->lr_refcount) - 1);
 
-	cfs_hash_bd_get(ns->ns_rs_hash, &res->lr_name, &bd);
-	if (cfs_hash_bd_dec_and_lock(ns->ns_rs_hash, &bd, &res->lr_refcount)) {
-		__ldlm_resource_putref_final(&bd, res);
-		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
+	/* lookups do not take a reference from zero, so nobody can find
+	 * the resource again once it drops to zero
+	 */
+	if (atomic_dec_and_test(&res->lr_refcount)) {
+		__ldlm_resource_putref_final(ns, res);
 		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
 			ns->ns_lvbo->lvbo_free(res);
 		ldlm_resource_free(res);
@@ -1739,10 +1741,8 @@ void ldlm_dump_all_namespaces(enum ldlm_side client, int level)
 	mutex_unlock(ldlm_namespace_lock(client));
 }
 
-static int ldlm_res_hash_dump(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-			      struct hlist_node *hnode, void *arg)
+static int ldlm_res_hash_dump(struct ldlm_resource *res, void *arg)
 {
-	struct ldlm_resource *res = cfs_hash_object(hs, hnode);
 	int    level = (int)(unsigned long)arg;
 
 	lock_res(res);
@@ -1768,9 +1768,8 @@ void ldlm_namespace_dump(int level, struct ldlm_namespace *ns)
 	if (ktime_get_seconds() < ns->ns_next_dump)
 		return;
 
-	cfs_hash_for_each_nolock(ns->ns_rs_hash,
-				 ldlm_res_hash_dump,
-				 (void *)(unsigned long)level, 0);
+	ldlm_namespace_res_foreach(ns, ldlm_res_hash_dump,
+				   (void *)(unsigned long)level);
 	spin_lock(&ns->ns_lock);
 	ns->ns_next_dump = ktime_get_seconds() + 10;
 	spin_unlock(&ns->ns_lock);
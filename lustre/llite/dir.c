@@ -180,6 +180,45 @@ void ll_release_page(struct inode *inode, struct page *page,
 	put_page(page);
 }
 
+/*
+ * Refresh the lazy size of the cached inode of \a ent from the attributes the
+ * MDT packed inline (LUDA_ATTR).  They are not protected by a lock, so they
+ * are used the same way as lazy SOM: only for AT_STATX_DONT_SYNC.  Pages can
+ * stay cached longer than the attributes are valid, so older ones are skipped.
+ */
+static void ll_dirent_attr_update(struct inode *dir, struct lu_dirent *ent,
+				  bool is_api32)
+{
+	struct luda_attr *lda = lu_dirent_attr_get(ent);
+	struct ll_inode_info *lli;
+	struct inode *inode;
+	struct lu_fid fid;
+	__u64 valid;
+
+	if (lda == NULL || !S_ISREG(le32_to_cpu(lda->lda_mode)))
+		return;
+
+	valid = le64_to_cpu(lda->lda_valid);
+	if (!(valid & (OBD_MD_FLSIZE | OBD_MD_FLLAZYSIZE)))
+		return;
+
+	fid_le_to_cpu(&fid, &ent->lde_fid);
+	inode = ilookup5_nowait(dir->i_sb, cl_fid_build_ino(&fid, is_api32),
+				ll_test_inode_by_fid, &fid);
+	if (inode == NULL)
+		return;
+
+	/* lli_lazysize holds the clear text size of encrypted files */
+	if (!IS_ENCRYPTED(inode) && S_ISREG(inode->i_mode) &&
+	    (s64)le64_to_cpu(lda->lda_ctime) >= inode->i_ctime.tv_sec) {
+		lli = ll_i2info(inode);
+		lli->lli_lazysize = le64_to_cpu(lda->lda_size);
+		lli->lli_lazyblocks = le64_to_cpu(lda->lda_blocks);
+		lli->lli_attr_valid |= OBD_MD_FLLAZYSIZE | OBD_MD_FLLAZYBLOCKS;
+	}
+	iput(inode);
+}
+
 #ifdef HAVE_DIR_CONTEXT
 int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
 		struct dir_context *ctx, int *partial_readdir_rc)
@@ -243,6 +282,7 @@ int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
 			fid_le_to_cpu(&fid, &ent->lde_fid);
 			ino = cl_fid_build_ino(&fid, is_api32);
 			type = S_DT(lu_dirent_type_get(ent));
+			ll_dirent_attr_update(inode, ent, is_api32);
 			/* For ll_nfs_get_name_filldir(), it will try to access
 			 * 'ent' through 'lde_name', so the parameter 'name'
 			 * for 'filldir()' must be part of the 'ent'. */
@@ -81,6 +81,9 @@ static struct ll_file_data *ll_file_data_get(void)
 		return NULL;
 
 	fd->fd_write_failed = false;
+	fd->fd_ras_streams = NULL;
+	fd->fd_ras_nr_streams = 0;
+	spin_lock_init(&fd->fd_ras_streams_lock);
 	pcc_file_init(&fd->fd_pcc_file);
 
 	return fd;
@@ -88,8 +91,10 @@ static struct ll_file_data *ll_file_data_get(void)
 
 static void ll_file_data_put(struct ll_file_data *fd)
 {
-        if (fd != NULL)
-                OBD_SLAB_FREE_PTR(fd, ll_file_data_slab);
+	if (fd != NULL) {
+		ll_readahead_fini(fd);
+		OBD_SLAB_FREE_PTR(fd, ll_file_data_slab);
+	}
 }
 
 /**
@@ -852,6 +857,10 @@ int ll_file_open(struct inode *inode, struct file *file)
 				ll_release_openhandle(file_dentry(file), it);
 			GOTO(out_nofiledata, rc);
 		}
+#ifdef FMODE_NOWAIT
+		/* cached reads don't block, see ll_file_read_iter() */
+		file->f_mode |= FMODE_NOWAIT;
+#endif
 	}
 
 	fd = ll_file_data_get();
@@ -2003,7 +2012,18 @@ ll_do_fast_read(struct kiocb *iocb, struct iov_iter *iter)
 	if (ll_layout_version_get(lli) == CL_LAYOUT_GEN_NONE)
 		return 0;
 
+#ifdef IOCB_NOIO
+	/* ll_readpage() must not be called to start readahead either */
+	if (ll_iocb_nowait(iocb)) {
+		iocb->ki_flags |= IOCB_NOIO;
+		result = generic_file_read_iter(iocb, iter);
+		iocb->ki_flags &= ~IOCB_NOIO;
+	} else {
+		result = generic_file_read_iter(iocb, iter);
+	}
+#else
 	result = generic_file_read_iter(iocb, iter);
+#endif
 
 	/* If the first page is not in cache, generic_file_aio_read() will be
 	 * returned with -ENODATA.  Fall back to full read path.
@@ -2013,7 +2033,7 @@ ll_do_fast_read(struct kiocb *iocb, struct iov_iter *iter)
 	 * locking to the fast path for this rare case, fall back to the full
 	 * read path.  (See vvp_io_read_start() for rest of handling.
 	 */
-	if (result == -ENODATA || result == -EIO)
+	if (result == -ENODATA || result == -EIO || result == -EAGAIN)
 		result = 0;
 
 	if (result > 0) {
@@ -2056,6 +2076,10 @@ static int file_read_confine_iter(struct lu_env *env, struct kiocb *iocb,
 	kms = attr->cat_kms;
 	/* if read beyond end-of-file, adjust read count */
 	if (kms > 0 && (iocb->ki_pos >= kms || read_end > kms)) {
+		/* glimpse may need an RPC */
+		if (ll_iocb_nowait(iocb))
+			return -EAGAIN;
+
 		rc = ll_glimpse_size(inode);
 		if (rc != 0)
 			return rc;
@@ -2129,6 +2153,23 @@ static ssize_t ll_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 	if (cached)
 		GOTO(out, result);
 
+	/*
+	 * Only pages cached under a DLM lock can be read without blocking,
+	 * anything else is retried by the caller from a context that can
+	 * block (io_uring punts it to a worker thread), which also feeds
+	 * read-ahead then.
+	 */
+	if (ll_iocb_nowait(iocb)) {
+		loff_t pos = iocb->ki_pos;
+
+		result = ll_do_fast_read(iocb, to);
+		if (result > 0)
+			ll_ras_enter(file, pos, result);
+		else if (result == 0)
+			result = -EAGAIN;
+		GOTO(out, result);
+	}
+
 	ll_ras_enter(file, iocb->ki_pos, iov_iter_count(to));
 
 	result = ll_do_fast_read(iocb, to);
@@ -2164,6 +2205,7 @@ out:
 				  READ);
 		ll_stats_ops_tally(ll_i2sbi(file_inode(file)), LPROC_LL_READ,
 				   ktime_us_delta(ktime_get(), kstart));
+		pcc_file_heat_check(file);
 	}
 
 	CDEBUG(D_IOTRACE,
@@ -2257,6 +2299,10 @@ static ssize_t ll_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	if (!iov_iter_count(from))
 		GOTO(out, rc_normal = 0);
 
+	/* buffered writes may always need a DLM lock or grant */
+	if (ll_iocb_nowait(iocb))
+		GOTO(out, rc_normal = -EAGAIN);
+
 	/**
 	 * When PCC write failed, we usually do not fall back to the normal
 	 * write path, just return the error. But there is a special case when
@@ -4222,6 +4268,23 @@ static void ll_heat_get(struct inode *inode, struct lu_heat *heat)
 	spin_unlock(&lli->lli_heat_lock);
 }
 
+/* read heat of the file, as used by the "heat" PCC rule condition */
+__u64 ll_read_heat_get(struct inode *inode)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	__u64 now = ktime_get_real_seconds();
+	__u64 heat;
+
+	spin_lock(&lli->lli_heat_lock);
+	heat = obd_heat_get(&lli->lli_heat_instances[OBD_HEAT_READSAMPLE],
+			    now, sbi->ll_heat_decay_weight,
+			    sbi->ll_heat_period_second);
+	spin_unlock(&lli->lli_heat_lock);
+
+	return heat;
+}
+
 static int ll_heat_set(struct inode *inode, enum lu_heat_flag flags)
 {
 	struct ll_inode_info *lli = ll_i2info(inode);
@@ -5376,7 +5439,7 @@ static int ll_inode_revalidate_fini(struct inode *inode, int rc)
 	return rc;
 }
 
-static int ll_inode_revalidate(struct dentry *dentry, enum ldlm_intent_flags op)
+int ll_inode_revalidate(struct dentry *dentry, enum ldlm_intent_flags op)
 {
 	struct inode *parent;
 	struct inode *inode = dentry->d_inode;
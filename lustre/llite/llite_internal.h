@@ -205,12 +205,25 @@ struct ll_inode_info {
 			unsigned int			lli_sa_generation;
 			/* access pattern for statahead */
 			enum ll_sa_pattern		lli_sa_pattern;
+			/* on ll_sb_info::ll_sa_tree_list with an inode
+			 * reference while a tree walk is predicted to descend
+			 * here, see ll_statahead_tree_hint()
+			 */
+			struct list_head		lli_sa_tree_list;
+			/* first directory page was read ahead */
+			bool				lli_sa_tree_fetched;
+			/* parent statahead ran AGL */
+			bool				lli_sa_tree_agl;
 			/* rw lock protects lli_lsm_md */
 			struct rw_semaphore		lli_lsm_sem;
 			/* directory stripe information */
 			struct lmv_stripe_object	*lli_lsm_obj;
 			/* directory default LMV */
 			struct lmv_stripe_object	*lli_def_lsm_obj;
+			/* names known to be missing, see neg_cache.c */
+			struct ll_neg_cache		*lli_neg_cache;
+			/* negative lookups without the UPDATE lock cached */
+			unsigned int			lli_neg_unlocked;
 		};
 
 		/* for non-directory */
@@ -266,6 +279,8 @@ struct ll_inode_info {
 			__u64			 lli_pcc_generation;
 			enum pcc_dataset_flags	 lli_pcc_dsflags;
 			struct pcc_inode	*lli_pcc_inode;
+			/* last check of the read heat for PCC attach */
+			time64_t		 lli_pcc_heat_checked;
 
 			struct mutex		 lli_group_mutex;
 			__u64			 lli_group_users;
@@ -300,7 +315,7 @@ struct ll_inode_info {
 
 	struct rw_semaphore		lli_xattrs_list_rwsem;
 	struct mutex			lli_xattrs_enq_lock;
-	struct list_head		lli_xattrs; /* ll_xattr_entry->xe_list */
+	struct ll_xattr_cache		*lli_xattrs; /* see xattr_cache.c */
 	struct list_head		lli_lccs; /* list of ll_cl_context */
 	seqlock_t			lli_page_inv_lock;
 
@@ -464,9 +479,21 @@ enum ll_inode_flags {
 	/* 6 is not used for now */
 	/* Xattr cache is filled */
 	LLIF_XATTR_CACHE_FILLED	= 7,
+	/* page cache may hold large folios, see ll_sb_info::ll_folio_order */
+	LLIF_LARGE_FOLIO	= 8,
 
 };
 
+/* cached xattrs of all inodes of a mount, see ll_sb_info::ll_xattr_lru */
+#define LL_XATTR_CACHE_MAX_DEF	(256UL << 20)
+
+/* largest ll_sb_info::ll_folio_order, page cache folios need THP support */
+#if defined(HAVE_FILEMAP_ADD_FOLIO) && defined(CONFIG_TRANSPARENT_HUGEPAGE)
+#define LL_FOLIO_ORDER_MAX	CL_PAGE_MAX_ORDER
+#else
+#define LL_FOLIO_ORDER_MAX	0
+#endif
+
 int ll_xattr_cache_destroy(struct inode *inode);
 int ll_xattr_cache_empty(struct inode *inode);
 
@@ -481,6 +508,16 @@ int ll_xattr_cache_insert(struct inode *inode,
 			  char *buffer,
 			  size_t size);
 
+/* negative names cached per directory by default */
+#define LL_NEG_CACHE_MAX_DEF		256
+/* negative lookups without a cached UPDATE lock before one is fetched */
+#define LL_NEG_CACHE_FETCH_MISSES	4
+
+bool ll_neg_cache_lookup(struct inode *dir, const struct qstr *name);
+void ll_neg_cache_add(struct inode *dir, const struct qstr *name);
+void ll_neg_cache_purge(struct inode *dir);
+void ll_neg_cache_fini(struct inode *dir);
+
 static inline bool obd_connect_has_secctx(struct obd_connect_data *data)
 {
 #ifdef CONFIG_SECURITY
@@ -650,6 +687,10 @@ static inline void ll_inode_unlock(struct inode *inode)
 /* Min range pages */
 #define RA_MIN_MMAP_RANGE_PAGES			16UL
 
+/* concurrent read-ahead streams tracked per file descriptor */
+#define SBI_DEFAULT_RA_STREAMS			4
+#define RA_STREAMS_MAX				16
+
 enum ra_stat {
         RA_STAT_HIT = 0,
         RA_STAT_MISS,
@@ -668,6 +709,9 @@ enum ra_stat {
 	RA_STAT_FAILED_FAST_READ,
 	RA_STAT_MMAP_RANGE_READ,
 	RA_STAT_READAHEAD_PAGES,
+	RA_STAT_STREAM_NEW,
+	RA_STAT_STREAM_MERGED,
+	RA_STAT_STREAM_EVICTED,
 	_NR_RA_STAT,
 };
 
@@ -687,6 +731,8 @@ struct ll_ra_info {
 	atomic_t ra_async_inflight;
 	/* Threshold to control when to trigger async readahead */
 	unsigned long ra_async_pages_per_file_threshold;
+	/* max read-ahead streams per file descriptor, see ll_ras_stream() */
+	unsigned int ra_streams_max;
 };
 
 /* ra_io_arg will be filled in the beginning of ll_readahead with
@@ -779,6 +825,7 @@ enum ll_sbi_flags {
 	LL_SBI_FILE_HEAT,		/* file heat support */
 	LL_SBI_PARALLEL_DIO,		/* parallel (async) O_DIRECT RPCs */
 	LL_SBI_ENCRYPT_NAME,		/* name encryption */
+	LL_SBI_READDIR_PLUS,		/* attributes in readdir pages */
 	LL_SBI_NUM_FLAGS
 };
 
@@ -866,6 +913,30 @@ struct ll_sb_info {
 	atomic_t		  ll_agl_total;  /* AGL thread started count */
 	atomic_t		  ll_sa_hit_total;  /* total hit count */
 	atomic_t		  ll_sa_miss_total; /* total miss count */
+	/* statahead tree walk mode, see ll_statahead_tree_hint() */
+	unsigned int		  ll_sa_tree_window; /* max predicted dirs */
+	unsigned int		  ll_sa_tree_count;
+	spinlock_t		  ll_sa_tree_lock;
+	struct list_head	  ll_sa_tree_list; /* lli_sa_tree_list */
+	atomic_t		  ll_sa_tree_total; /* started at opendir */
+	atomic_t		  ll_sa_tree_hit_total;  /* predicted dir opened */
+	atomic_t		  ll_sa_tree_miss_total; /* prediction dropped */
+
+	/* xattr cache, see xattr_cache.c */
+	spinlock_t		  ll_xattr_lru_lock;
+	struct list_head	  ll_xattr_lru;	/* ll_xattr_cache::xc_lru */
+	atomic_long_t		  ll_xattr_cache_bytes;
+	unsigned long		  ll_xattr_cache_max; /* in bytes */
+	atomic_t		  ll_xattr_cache_hit;
+	atomic_t		  ll_xattr_cache_miss;
+	atomic_t		  ll_xattr_cache_evict;
+
+	/* negative lookup cache, see neg_cache.c */
+	unsigned int		  ll_neg_cache_max; /* per directory */
+	atomic_t		  ll_neg_cache_hit;
+	atomic_t		  ll_neg_cache_insert;
+	atomic_t		  ll_neg_cache_purge;
+	atomic_t		  ll_neg_cache_fetch; /* UPDATE locks fetched */
 
 	dev_t			  ll_sdev_orig; /* save s_dev before assign for
 						 * clustred nfs */
@@ -876,6 +947,9 @@ struct ll_sb_info {
 	/* st_blksize returned by stat(2), when non-zero */
 	unsigned int		  ll_stat_blksize;
 
+	/* order of the folios allocated for full-folio buffered writes */
+	unsigned int		  ll_folio_order;
+
 	/* maximum relative age of cached statfs results */
 	unsigned int		  ll_statfs_max_age;
 
@@ -1017,11 +1091,21 @@ struct ll_readahead_state {
 	bool		ras_need_increase_window;
 	/* whether ra miss check should be skipped */
 	bool		ras_no_miss_check;
+	/* stream slot is tracking reads, see ll_ras_stream() */
+	bool		ras_stream_active;
+	/* start byte of the last read(2) of this stream */
+	loff_t		ras_last_read_start_bytes;
+	/* ll_file_data::fd_ras_clock at the last access, for LRU */
+	unsigned long	ras_stream_stamp;
+	/* gap to the stream this one was started after, a stride candidate */
+	loff_t		ras_stream_gap;
 };
 
 struct ll_readahead_work {
 	/** File to readahead */
 	struct file			*lrw_file;
+	/* stream of lrw_file that triggered it */
+	struct ll_readahead_state	*lrw_ras;
 	pgoff_t				 lrw_start_idx;
 	pgoff_t				 lrw_end_idx;
 	pid_t				 lrw_user_pid;
@@ -1035,6 +1119,11 @@ extern struct kmem_cache *ll_file_data_slab;
 struct lustre_handle;
 struct ll_file_data {
 	struct ll_readahead_state fd_ras;
+	/* streams besides fd_ras, allocated on the first concurrent stream */
+	struct ll_readahead_state *fd_ras_streams;
+	unsigned int fd_ras_nr_streams;
+	unsigned long fd_ras_clock;
+	spinlock_t fd_ras_streams_lock;
 	struct ll_grouplock fd_grouplock;
 	__u64 lfd_pos;
 	__u32 fd_flags;
@@ -1103,6 +1192,20 @@ static inline bool ll_sbi_has_fast_read(struct ll_sb_info *sbi)
 	return test_bit(LL_SBI_FAST_READ, sbi->ll_flags);
 }
 
+/*
+ * Buffered IO from io_uring or with RWF_NOWAIT, which must not block on a DLM
+ * lock or an RPC.  Direct IO handles IOCB_NOWAIT itself, see ci_iocb_nowait.
+ */
+static inline bool ll_iocb_nowait(struct kiocb *iocb)
+{
+#ifdef IOCB_NOWAIT
+	return (iocb->ki_flags & IOCB_NOWAIT) &&
+	       !(iocb->ki_filp->f_flags & O_DIRECT);
+#else
+	return false;
+#endif
+}
+
 static inline bool ll_sbi_has_tiny_write(struct ll_sb_info *sbi)
 {
 	return test_bit(LL_SBI_TINY_WRITE, sbi->ll_flags);
@@ -1220,6 +1323,7 @@ int ll_read_folio(struct file *file, struct folio *folio);
 int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 			   struct cl_page *page, struct file *file);
 void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras);
+void ll_readahead_fini(struct ll_file_data *fd);
 int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io);
 
 enum lcc_type;
@@ -1255,6 +1359,7 @@ int ll_getattr(struct vfsmount *mnt, struct dentry *de, struct kstat *stat);
 #endif /* HAVE_USER_NAMESPACE_ARG */
 int ll_getattr_dentry(struct dentry *de, struct kstat *stat, u32 request_mask,
 		      unsigned int flags, bool foreign);
+int ll_inode_revalidate(struct dentry *dentry, enum ldlm_intent_flags op);
 #ifdef CONFIG_LUSTRE_FS_POSIX_ACL
 struct posix_acl *ll_get_acl(
  #ifdef HAVE_ACL_WITH_DENTRY
@@ -1332,6 +1437,7 @@ int ll_fid2path(struct inode *inode, void __user *arg);
 int __ll_fid2path(struct inode *inode, struct getinfo_fid2path *gfout,
 		  size_t outsize, __u32 pathlen_orig);
 int ll_data_version(struct inode *inode, __u64 *data_version, int flags);
+__u64 ll_read_heat_get(struct inode *inode);
 int ll_hsm_release(struct inode *inode);
 int ll_hsm_state_set(struct inode *inode, struct hsm_state_set *hss);
 void ll_io_set_mirror(struct cl_io *io, const struct file *file);
@@ -1631,6 +1737,10 @@ void ll_ra_stats_inc(struct inode *inode, enum ra_stat which);
 #define LL_SA_BATCH_MAX		1024
 #define LL_SA_BATCH_DEF		64
 
+/* subdirectories predicted ahead of a tree walk */
+#define LL_SA_TREE_WINDOW_MAX	256
+#define LL_SA_TREE_WINDOW_DEF	8
+
 #define LL_SA_CACHE_BIT         6
 #define LL_SA_CACHE_SIZE        (1 << LL_SA_CACHE_BIT)
 #define LL_SA_CACHE_MASK        (LL_SA_CACHE_SIZE - 1)
@@ -1661,8 +1771,10 @@ struct ll_statahead_info {
 						 * is not a hidden one */
 	unsigned int            sai_skip_hidden;/* skipped hidden dentry count
 						 */
-	unsigned int            sai_ls_all:1;   /* "ls -al", do stat-ahead for
+	unsigned int            sai_ls_all:1,   /* "ls -al", do stat-ahead for
 						 * hidden entries */
+				sai_tree:1;	/* started at opendir in tree
+						 * walk mode */
 	wait_queue_head_t	sai_waitq;	/* stat-ahead wait queue */
 	struct task_struct	*sai_task;	/* stat-ahead thread */
 	struct task_struct	*sai_agl_task;	/* AGL thread */
@@ -1692,6 +1804,7 @@ int ll_revalidate_statahead(struct inode *dir, struct dentry **dentry,
 int ll_start_statahead(struct inode *dir, struct dentry *dentry, bool agl);
 void ll_authorize_statahead(struct inode *dir, void *key);
 void ll_deauthorize_statahead(struct inode *dir, void *key);
+void ll_statahead_tree_fini(struct ll_sb_info *sbi);
 
 /* glimpse.c */
 blkcnt_t dirty_cnt(struct inode *inode);
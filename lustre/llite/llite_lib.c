@@ -72,6 +72,7 @@
 #include <lustre_log.h>
 #include <cl_object.h>
 #include <obd_cksum.h>
+#include <lustre_compr.h>
 #include "llite_internal.h"
 
 struct kmem_cache *ll_file_data_slab;
@@ -164,6 +165,7 @@ static struct ll_sb_info *ll_init_sbi(struct lustre_sb_info *lsi)
 	sbi->ll_ra_info.ra_async_pages_per_file_threshold =
 				sbi->ll_ra_info.ra_max_pages_per_file;
 	sbi->ll_ra_info.ra_range_pages = SBI_DEFAULT_RA_RANGE_PAGES;
+	sbi->ll_ra_info.ra_streams_max = SBI_DEFAULT_RA_STREAMS;
 	sbi->ll_ra_info.ra_max_read_ahead_whole_pages = -1;
 	atomic_set(&sbi->ll_ra_info.ra_async_inflight, 0);
 
@@ -190,6 +192,27 @@ static struct ll_sb_info *ll_init_sbi(struct lustre_sb_info *lsi)
 	atomic_set(&sbi->ll_agl_total, 0);
 	atomic_set(&sbi->ll_sa_hit_total, 0);
 	atomic_set(&sbi->ll_sa_miss_total, 0);
+	sbi->ll_sa_tree_window = LL_SA_TREE_WINDOW_DEF;
+	sbi->ll_sa_tree_count = 0;
+	spin_lock_init(&sbi->ll_sa_tree_lock);
+	INIT_LIST_HEAD(&sbi->ll_sa_tree_list);
+	atomic_set(&sbi->ll_sa_tree_total, 0);
+	atomic_set(&sbi->ll_sa_tree_hit_total, 0);
+	atomic_set(&sbi->ll_sa_tree_miss_total, 0);
+	spin_lock_init(&sbi->ll_xattr_lru_lock);
+	INIT_LIST_HEAD(&sbi->ll_xattr_lru);
+	atomic_long_set(&sbi->ll_xattr_cache_bytes, 0);
+	sbi->ll_xattr_cache_max = min_t(unsigned long, pages / 128,
+					LL_XATTR_CACHE_MAX_DEF >> PAGE_SHIFT)
+				  << PAGE_SHIFT;
+	atomic_set(&sbi->ll_xattr_cache_hit, 0);
+	atomic_set(&sbi->ll_xattr_cache_miss, 0);
+	atomic_set(&sbi->ll_xattr_cache_evict, 0);
+	sbi->ll_neg_cache_max = LL_NEG_CACHE_MAX_DEF;
+	atomic_set(&sbi->ll_neg_cache_hit, 0);
+	atomic_set(&sbi->ll_neg_cache_insert, 0);
+	atomic_set(&sbi->ll_neg_cache_purge, 0);
+	atomic_set(&sbi->ll_neg_cache_fetch, 0);
 	set_bit(LL_SBI_AGL_ENABLED, sbi->ll_flags);
 	set_bit(LL_SBI_FAST_READ, sbi->ll_flags);
 	set_bit(LL_SBI_TINY_WRITE, sbi->ll_flags);
@@ -355,7 +378,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt)
 				   OBD_CONNECT2_REP_MBITS |
 				   OBD_CONNECT2_ATOMIC_OPEN_LOCK |
 				   OBD_CONNECT2_BATCH_RPC |
-				   OBD_CONNECT2_DMV_IMP_INHERIT;
+				   OBD_CONNECT2_DMV_IMP_INHERIT |
+				   OBD_CONNECT2_READDIR_PLUS;
 
 #ifdef HAVE_LRU_RESIZE_SUPPORT
 	if (test_bit(LL_SBI_LRU_RESIZE, sbi->ll_flags))
@@ -597,6 +621,16 @@ retry_connect:
 	else
 		data->ocd_cksum_types = obd_cksum_types_supported_client();
 
+	/* compressed components are only written compressed and read back
+	 * as whole chunks if the OSTs know about it
+	 */
+	if (ll_compr_supported_mask()) {
+		data->ocd_connect_flags2 |= OBD_CONNECT2_COMPRESS;
+		data->ocd_compr_type = ll_compr_supported_mask();
+	}
+	data->ocd_connect_flags2 |= OBD_CONNECT2_ZERO_WRITE |
+				    OBD_CONNECT2_MULTI_OBJ_BRW;
+
 #ifdef HAVE_LRU_RESIZE_SUPPORT
 	data->ocd_connect_flags |= OBD_CONNECT_LRU_RESIZE;
 #endif
@@ -961,6 +995,7 @@ void ll_kill_super(struct super_block *sb)
 		while (atomic_read(&sbi->ll_sa_running) > 0)
 			schedule_timeout_uninterruptible(
 				cfs_time_seconds(1) >> 3);
+		ll_statahead_tree_fini(sbi);
 	}
 
 	EXIT;
@@ -1010,6 +1045,7 @@ static const match_table_t ll_sbi_flags_name = {
 	{LL_SBI_FILE_HEAT,		"file_heat"},
 	{LL_SBI_PARALLEL_DIO,		"parallel_dio"},
 	{LL_SBI_ENCRYPT_NAME,		"name_encrypt"},
+	{LL_SBI_READDIR_PLUS,		"readdir_plus"},
 };
 
 int ll_sbi_flags_seq_show(struct seq_file *m, void *v)
@@ -1246,7 +1282,10 @@ void ll_lli_init(struct ll_inode_info *lli)
 		spin_lock_init(&lli->lli_sa_lock);
 		lli->lli_opendir_pid = 0;
 		lli->lli_sa_enabled = 0;
+		INIT_LIST_HEAD(&lli->lli_sa_tree_list);
 		init_rwsem(&lli->lli_lsm_sem);
+		lli->lli_neg_cache = NULL;
+		lli->lli_neg_unlocked = 0;
 	} else {
 		mutex_init(&lli->lli_size_mutex);
 		mutex_init(&lli->lli_setattr_mutex);
@@ -1924,10 +1963,12 @@ void ll_clear_inode(struct inode *inode)
 	lli_clear_acl(lli);
 	lli->lli_inode_magic = LLI_INODE_DEAD;
 
-	if (S_ISDIR(inode->i_mode))
+	if (S_ISDIR(inode->i_mode)) {
 		ll_dir_clear_lsm_md(inode);
-	else if (S_ISREG(inode->i_mode) && !is_bad_inode(inode))
+		ll_neg_cache_fini(inode);
+	} else if (S_ISREG(inode->i_mode) && !is_bad_inode(inode)) {
 		LASSERT(list_empty(&lli->lli_agl_list));
+	}
 
 	/*
 	 * XXX This has to be done before lsm is freed below, because
@@ -3791,6 +3832,9 @@ struct md_op_data *ll_prep_md_op_data(struct md_op_data *op_data,
 	if (ll_need_32bit_api(ll_i2sbi(i1)))
 		op_data->op_cli_flags |= CLI_API32;
 
+	if (test_bit(LL_SBI_READDIR_PLUS, ll_i2sbi(i1)->ll_flags))
+		op_data->op_cli_flags |= CLI_READDIR_PLUS;
+
 	if ((i2 && is_root_inode(i2)) ||
 	    opc == LUSTRE_OPC_LOOKUP || opc == LUSTRE_OPC_CREATE) {
 		/* In case of lookup, ll_setup_filename() has already been
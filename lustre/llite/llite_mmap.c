@@ -117,6 +117,7 @@ restart:
 	fio = &io->u.ci_fault;
 	fio->ft_index = index;
 	fio->ft_executable = vma->vm_flags & VM_EXEC;
+	fio->ft_vma_end = vma->vm_pgoff + vma_pages(vma);
 
 	if (mkwrite) {
 		fio->ft_mkwrite = 1;
@@ -169,7 +170,7 @@ static int ll_page_mkwrite0(struct vm_area_struct *vma, struct page *vmpage,
 	if (IS_ERR(env))
 		RETURN(PTR_ERR(env));
 
-	io = ll_fault_io_init(env, vma, vmpage->index, true);
+	io = ll_fault_io_init(env, vma, page_to_pgoff(vmpage), true);
 	if (IS_ERR(io))
 		GOTO(out, result = PTR_ERR(io));
 
@@ -193,7 +194,7 @@ static int ll_page_mkwrite0(struct vm_area_struct *vma, struct page *vmpage,
 
         if (result == 0) {
                 lock_page(vmpage);
-                if (vmpage->mapping == NULL) {
+                if (compound_head(vmpage)->mapping == NULL) {
                         unlock_page(vmpage);
 
                         /* page was truncated and lock was cancelled, return
@@ -425,8 +426,9 @@ restart:
 		 * or deleted from Lustre and retry if so
 		 */
 		lock_page(vmpage);
-		if (unlikely(vmpage->mapping == NULL) ||
-		    vmpage->private == 0) { /* unlucky */
+		/* a large folio keeps its state in the head page */
+		if (unlikely(compound_head(vmpage)->mapping == NULL) ||
+		    compound_head(vmpage)->private == 0) { /* unlucky */
 			unlock_page(vmpage);
 			put_page(vmpage);
 			vmf->page = NULL;
@@ -468,6 +470,44 @@ out:
 }
 
 #ifdef HAVE_VM_OPS_USE_VM_FAULT_ONLY
+/**
+ * Lustre implementation of a vm_operations_struct::map_pages() method, called
+ * by VM before ->fault() to map the cached pages around the faulting address.
+ *
+ * Only pages already uptodate in the page cache are mapped, so they are
+ * covered by the DLM lock the same way as for the fast fault path in
+ * ll_fault0(). This runs under RCU and must not sleep: read-ahead pages not
+ * yet consumed are not uptodate and are left to ll_fault(), which updates
+ * the read-ahead state and kicks off more read-ahead.
+ */
+#ifdef HAVE_MAP_PAGES_VM_FAULT_T
+static vm_fault_t ll_map_pages(struct vm_fault *vmf, pgoff_t start_pgoff,
+			       pgoff_t end_pgoff)
+#else
+static void ll_map_pages(struct vm_fault *vmf, pgoff_t start_pgoff,
+			 pgoff_t end_pgoff)
+#endif
+{
+	struct file *file = vmf->vma->vm_file;
+	struct inode *inode = file_inode(file);
+	struct ll_file_data *fd = file->private_data;
+
+	/* without fast read every fault has to go through the cl_io, PCC
+	 * files are mapped from the PCC copy by pcc_fault()
+	 */
+	if (ll_sbi_has_fast_read(ll_i2sbi(inode)) &&
+	    !fd->fd_pcc_file.pccf_file) {
+#ifdef HAVE_MAP_PAGES_VM_FAULT_T
+		return filemap_map_pages(vmf, start_pgoff, end_pgoff);
+#else
+		filemap_map_pages(vmf, start_pgoff, end_pgoff);
+#endif
+	}
+#ifdef HAVE_MAP_PAGES_VM_FAULT_T
+	return 0;
+#endif
+}
+
 static vm_fault_t ll_page_mkwrite(struct vm_fault *vmf)
 {
 	struct vm_area_struct *vma = vmf->vma;
@@ -580,6 +620,9 @@ static void ll_vm_close(struct vm_area_struct *vma)
 
 static const struct vm_operations_struct ll_file_vm_ops = {
 	.fault			= ll_fault,
+#ifdef HAVE_VM_OPS_USE_VM_FAULT_ONLY
+	.map_pages		= ll_map_pages,
+#endif
 	.page_mkwrite		= ll_page_mkwrite,
 	.open			= ll_vm_open,
 	.close			= ll_vm_close,
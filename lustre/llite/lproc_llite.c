@@ -178,6 +178,38 @@ static ssize_t stat_blocksize_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(stat_blocksize);
 
+static ssize_t max_folio_order_show(struct kobject *kobj,
+				    struct attribute *attr, char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return sprintf(buf, "%u\n", sbi->ll_folio_order);
+}
+
+static ssize_t max_folio_order_store(struct kobject *kobj,
+				     struct attribute *attr,
+				     const char *buffer,
+				     size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	if (val > LL_FOLIO_ORDER_MAX)
+		return -ERANGE;
+
+	sbi->ll_folio_order = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(max_folio_order);
+
 static ssize_t kbytestotal_show(struct kobject *kobj, struct attribute *attr,
 				char *buf)
 {
@@ -845,6 +877,44 @@ static ssize_t statahead_max_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(statahead_max);
 
+static ssize_t statahead_tree_window_show(struct kobject *kobj,
+					  struct attribute *attr,
+					  char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return sprintf(buf, "%u\n", sbi->ll_sa_tree_window);
+}
+
+static ssize_t statahead_tree_window_store(struct kobject *kobj,
+					   struct attribute *attr,
+					   const char *buffer,
+					   size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > LL_SA_TREE_WINDOW_MAX) {
+		CWARN("%s: statahead_tree_window value %u limited to maximum %d\n",
+		      sbi->ll_fsname, val, LL_SA_TREE_WINDOW_MAX);
+		val = LL_SA_TREE_WINDOW_MAX;
+	}
+
+	sbi->ll_sa_tree_window = val;
+	/* the current predictions are dropped, new ones fill the window */
+	ll_statahead_tree_fini(sbi);
+
+	return count;
+}
+LUSTRE_RW_ATTR(statahead_tree_window);
+
 static ssize_t statahead_agl_show(struct kobject *kobj,
 				  struct attribute *attr,
 				  char *buf)
@@ -888,12 +958,18 @@ static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 		      "statahead wrong: %u\n"
 		      "agl total: %u\n"
 		      "hit_total: %u\n"
-		      "miss_total: %u\n",
+		      "miss_total: %u\n"
+		      "tree_walks: %u\n"
+		      "tree_hits: %u\n"
+		      "tree_misses: %u\n",
 		   atomic_read(&sbi->ll_sa_total),
 		   atomic_read(&sbi->ll_sa_wrong),
 		   atomic_read(&sbi->ll_agl_total),
 		   atomic_read(&sbi->ll_sa_hit_total),
-		   atomic_read(&sbi->ll_sa_miss_total));
+		   atomic_read(&sbi->ll_sa_miss_total),
+		   atomic_read(&sbi->ll_sa_tree_total),
+		   atomic_read(&sbi->ll_sa_tree_hit_total),
+		   atomic_read(&sbi->ll_sa_tree_miss_total));
 	return 0;
 }
 
@@ -910,6 +986,9 @@ static ssize_t ll_statahead_stats_seq_write(struct file *file,
 	atomic_set(&sbi->ll_agl_total, 0);
 	atomic_set(&sbi->ll_sa_hit_total, 0);
 	atomic_set(&sbi->ll_sa_miss_total, 0);
+	atomic_set(&sbi->ll_sa_tree_total, 0);
+	atomic_set(&sbi->ll_sa_tree_hit_total, 0);
+	atomic_set(&sbi->ll_sa_tree_miss_total, 0);
 
 	return count;
 }
@@ -1104,6 +1183,141 @@ static ssize_t xattr_cache_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(xattr_cache);
 
+static ssize_t xattr_cache_max_mb_show(struct kobject *kobj,
+				       struct attribute *attr,
+				       char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%lu\n",
+			 sbi->ll_xattr_cache_max >> 20);
+}
+
+static ssize_t xattr_cache_max_mb_store(struct kobject *kobj,
+					struct attribute *attr,
+					const char *buffer,
+					size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	u64 val;
+	int rc;
+
+	rc = sysfs_memparse(buffer, count, &val, "MiB");
+	if (rc)
+		return rc;
+
+	if (val > (u64)cfs_totalram_pages() << (PAGE_SHIFT - 1)) {
+		/* 1/2 of RAM */
+		CERROR("%s: cannot set xattr_cache_max_mb=%llu > totalram/2=%luMB\n",
+		       sbi->ll_fsname, val >> 20,
+		       PAGES_TO_MiB(cfs_totalram_pages() / 2));
+		return -ERANGE;
+	}
+
+	sbi->ll_xattr_cache_max = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(xattr_cache_max_mb);
+
+static int ll_xattr_cache_stats_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	seq_printf(m, "cache_bytes: %ld\n"
+		      "hit_total: %u\n"
+		      "miss_total: %u\n"
+		      "evict_total: %u\n",
+		   atomic_long_read(&sbi->ll_xattr_cache_bytes),
+		   atomic_read(&sbi->ll_xattr_cache_hit),
+		   atomic_read(&sbi->ll_xattr_cache_miss),
+		   atomic_read(&sbi->ll_xattr_cache_evict));
+	return 0;
+}
+
+static ssize_t ll_xattr_cache_stats_seq_write(struct file *file,
+					      const char __user *buffer,
+					      size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	atomic_set(&sbi->ll_xattr_cache_hit, 0);
+	atomic_set(&sbi->ll_xattr_cache_miss, 0);
+	atomic_set(&sbi->ll_xattr_cache_evict, 0);
+
+	return count;
+}
+LDEBUGFS_SEQ_FOPS(ll_xattr_cache_stats);
+
+static ssize_t neg_cache_max_entries_show(struct kobject *kobj,
+					  struct attribute *attr,
+					  char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", sbi->ll_neg_cache_max);
+}
+
+static ssize_t neg_cache_max_entries_store(struct kobject *kobj,
+					   struct attribute *attr,
+					   const char *buffer,
+					   size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	/* 0 disables the negative lookup cache */
+	WRITE_ONCE(sbi->ll_neg_cache_max, val);
+
+	return count;
+}
+LUSTRE_RW_ATTR(neg_cache_max_entries);
+
+static int ll_neg_cache_stats_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	seq_printf(m, "hit_total: %u\n"
+		      "insert_total: %u\n"
+		      "purge_total: %u\n"
+		      "lock_fetch_total: %u\n",
+		   atomic_read(&sbi->ll_neg_cache_hit),
+		   atomic_read(&sbi->ll_neg_cache_insert),
+		   atomic_read(&sbi->ll_neg_cache_purge),
+		   atomic_read(&sbi->ll_neg_cache_fetch));
+	return 0;
+}
+
+static ssize_t ll_neg_cache_stats_seq_write(struct file *file,
+					    const char __user *buffer,
+					    size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	atomic_set(&sbi->ll_neg_cache_hit, 0);
+	atomic_set(&sbi->ll_neg_cache_insert, 0);
+	atomic_set(&sbi->ll_neg_cache_purge, 0);
+	atomic_set(&sbi->ll_neg_cache_fetch, 0);
+
+	return count;
+}
+LDEBUGFS_SEQ_FOPS(ll_neg_cache_stats);
+
 static ssize_t tiny_write_show(struct kobject *kobj,
 			       struct attribute *attr,
 			       char *buf)
@@ -1176,6 +1390,42 @@ static ssize_t parallel_dio_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(parallel_dio);
 
+static ssize_t readdir_plus_show(struct kobject *kobj,
+				 struct attribute *attr,
+				 char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n",
+			test_bit(LL_SBI_READDIR_PLUS, sbi->ll_flags));
+}
+
+static ssize_t readdir_plus_store(struct kobject *kobj,
+				  struct attribute *attr,
+				  const char *buffer,
+				  size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&sbi->ll_lock);
+	if (val)
+		set_bit(LL_SBI_READDIR_PLUS, sbi->ll_flags);
+	else
+		clear_bit(LL_SBI_READDIR_PLUS, sbi->ll_flags);
+	spin_unlock(&sbi->ll_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(readdir_plus);
+
 static ssize_t max_read_ahead_async_active_show(struct kobject *kobj,
 					       struct attribute *attr,
 					       char *buf)
@@ -1307,6 +1557,44 @@ out:
 }
 LUSTRE_RW_ATTR(read_ahead_range_kb);
 
+static ssize_t read_ahead_streams_show(struct kobject *kobj,
+				       struct attribute *attr, char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 sbi->ll_ra_info.ra_streams_max);
+}
+
+static ssize_t read_ahead_streams_store(struct kobject *kobj,
+					struct attribute *attr,
+					const char *buffer, size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	/* 0 and 1 both track a single stream per file descriptor */
+	if (val > RA_STREAMS_MAX) {
+		CERROR("%s: cannot set read_ahead_streams=%u larger than %u\n",
+		       sbi->ll_fsname, val, RA_STREAMS_MAX);
+		return -ERANGE;
+	}
+
+	spin_lock(&sbi->ll_lock);
+	sbi->ll_ra_info.ra_streams_max = val;
+	spin_unlock(&sbi->ll_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(read_ahead_streams);
+
 static ssize_t fast_read_show(struct kobject *kobj,
 			      struct attribute *attr,
 			      char *buf)
@@ -1832,6 +2120,75 @@ out_free_kernbuff:
 }
 LDEBUGFS_SEQ_FOPS(ll_pcc);
 
+static int ll_pcc_attach_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	return pcc_attach_dump(&sbi->ll_pcc_super, m);
+}
+LDEBUGFS_SEQ_FOPS_RO(ll_pcc_attach);
+
+static ssize_t pcc_attach_max_active_show(struct kobject *kobj,
+					  struct attribute *attr, char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return sprintf(buf, "%u\n",
+		       sbi->ll_pcc_super.pccs_attach_max_active);
+}
+
+static ssize_t pcc_attach_max_active_store(struct kobject *kobj,
+					   struct attribute *attr,
+					   const char *buffer,
+					   size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	rc = pcc_attach_max_active_set(&sbi->ll_pcc_super, val);
+
+	return rc ? rc : count;
+}
+LUSTRE_RW_ATTR(pcc_attach_max_active);
+
+static ssize_t pcc_attach_max_mbps_show(struct kobject *kobj,
+					struct attribute *attr, char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return sprintf(buf, "%u\n", sbi->ll_pcc_super.pccs_attach_max_mbps);
+}
+
+static ssize_t pcc_attach_max_mbps_store(struct kobject *kobj,
+					 struct attribute *attr,
+					 const char *buffer,
+					 size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	/* 0 removes the bandwidth cap */
+	WRITE_ONCE(sbi->ll_pcc_super.pccs_attach_max_mbps, val);
+
+	return count;
+}
+LUSTRE_RW_ATTR(pcc_attach_max_mbps);
+
 struct ldebugfs_vars lprocfs_llite_obd_vars[] = {
 	{ .name	=	"site",
 	  .fops	=	&ll_site_stats_fops			},
@@ -1839,6 +2196,10 @@ struct ldebugfs_vars lprocfs_llite_obd_vars[] = {
 	  .fops	=	&ll_max_cached_mb_fops			},
 	{ .name	=	"statahead_stats",
 	  .fops	=	&ll_statahead_stats_fops		},
+	{ .name	=	"xattr_cache_stats",
+	  .fops	=	&ll_xattr_cache_stats_fops		},
+	{ .name	=	"neg_cache_stats",
+	  .fops	=	&ll_neg_cache_stats_fops		},
 	{ .name	=	"unstable_stats",
 	  .fops	=	&ll_unstable_stats_fops			},
 	{ .name =	"sbi_flags",
@@ -1849,6 +2210,8 @@ struct ldebugfs_vars lprocfs_llite_obd_vars[] = {
 	  .fops	=	&ll_nosquash_nids_fops			},
 	{ .name =	"pcc",
 	  .fops =	&ll_pcc_fops,				},
+	{ .name =	"pcc_attach",
+	  .fops =	&ll_pcc_attach_fops,			},
 	{ NULL }
 };
 
@@ -1857,6 +2220,7 @@ struct ldebugfs_vars lprocfs_llite_obd_vars[] = {
 static struct attribute *llite_attrs[] = {
 	&lustre_attr_blocksize.attr,
 	&lustre_attr_stat_blocksize.attr,
+	&lustre_attr_max_folio_order.attr,
 	&lustre_attr_kbytestotal.attr,
 	&lustre_attr_kbytesfree.attr,
 	&lustre_attr_kbytesavail.attr,
@@ -1877,21 +2241,26 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_max_read_ahead_async_active.attr,
 	&lustre_attr_read_ahead_async_file_threshold_mb.attr,
 	&lustre_attr_read_ahead_range_kb.attr,
+	&lustre_attr_read_ahead_streams.attr,
 	&lustre_attr_stats_track_pid.attr,
 	&lustre_attr_stats_track_ppid.attr,
 	&lustre_attr_stats_track_gid.attr,
 	&lustre_attr_statahead_running_max.attr,
 	&lustre_attr_statahead_batch_max.attr,
 	&lustre_attr_statahead_max.attr,
+	&lustre_attr_statahead_tree_window.attr,
 	&lustre_attr_statahead_agl.attr,
 	&lustre_attr_lazystatfs.attr,
 	&lustre_attr_statfs_max_age.attr,
 	&lustre_attr_max_easize.attr,
 	&lustre_attr_default_easize.attr,
 	&lustre_attr_xattr_cache.attr,
+	&lustre_attr_xattr_cache_max_mb.attr,
+	&lustre_attr_neg_cache_max_entries.attr,
 	&lustre_attr_fast_read.attr,
 	&lustre_attr_tiny_write.attr,
 	&lustre_attr_parallel_dio.attr,
+	&lustre_attr_readdir_plus.attr,
 	&lustre_attr_file_heat.attr,
 	&lustre_attr_heat_decay_percentage.attr,
 	&lustre_attr_heat_period_second.attr,
@@ -1899,6 +2268,8 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_opencache_threshold_ms.attr,
 	&lustre_attr_opencache_max_ms.attr,
 	&lustre_attr_inode_cache.attr,
+	&lustre_attr_pcc_attach_max_active.attr,
+	&lustre_attr_pcc_attach_max_mbps.attr,
 #ifdef CONFIG_LL_ENCRYPTION
 	&lustre_attr_enable_filename_encryption.attr,
 #endif
@@ -2007,7 +2378,10 @@ static const char *const ra_stat_string[] = {
 	[RA_STAT_ASYNC]			= "async_readahead",
 	[RA_STAT_FAILED_FAST_READ]	= "failed_to_fast_read",
 	[RA_STAT_MMAP_RANGE_READ]	= "mmap_range_read",
-	[RA_STAT_READAHEAD_PAGES]	= "readahead_pages"
+	[RA_STAT_READAHEAD_PAGES]	= "readahead_pages",
+	[RA_STAT_STREAM_NEW]		= "streams_created",
+	[RA_STAT_STREAM_MERGED]		= "streams_merged",
+	[RA_STAT_STREAM_EVICTED]	= "streams_evicted",
 };
 
 int ll_debugfs_register_super(struct super_block *sb, const char *name)
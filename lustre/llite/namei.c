@@ -377,10 +377,12 @@ static void ll_lock_cancel_bits(struct ldlm_lock *lock, __u64 to_cancel)
 							ll_test_inode_by_fid,
 							(void *)&lli->lli_pfid);
 			if (master_inode) {
+				ll_neg_cache_purge(master_inode);
 				ll_prune_negative_children(master_inode);
 				iput(master_inode);
 			}
 		} else {
+			ll_neg_cache_purge(inode);
 			ll_prune_negative_children(inode);
 		}
 	}
@@ -648,6 +650,100 @@ struct dentry *ll_splice_alias(struct inode *inode, struct dentry *de)
         return de;
 }
 
+/*
+ * Take a reference on the UPDATE lock of \a parent, or of its stripe holding
+ * \a name, into \a parent_it. Return 1 if the lock is cached, 0 if not, or
+ * a negative error.
+ */
+static int ll_parent_lock_match(struct inode *parent, const struct qstr *name,
+				struct lookup_intent *parent_it)
+{
+	struct lu_fid fid = ll_i2info(parent)->lli_fid;
+	int rc;
+
+	/* If it is striped directory, get the real stripe parent */
+	if (unlikely(ll_dir_striped(parent))) {
+		down_read(&ll_i2info(parent)->lli_lsm_sem);
+		rc = md_get_fid_from_lsm(ll_i2mdexp(parent),
+					 ll_i2info(parent)->lli_lsm_obj,
+					 name->name, name->len, &fid);
+		up_read(&ll_i2info(parent)->lli_lsm_sem);
+		if (rc != 0)
+			return rc;
+	}
+
+	return md_revalidate_lock(ll_i2mdexp(parent), parent_it, &fid,
+				  NULL) > 0;
+}
+
+/*
+ * The MDT reported \a dentry missing from \a parent. The negative dentry and
+ * the negative lookup cache are valid as long as the UPDATE lock of the
+ * parent is cached. The MDT does not grant it with negative replies, so it
+ * is fetched once a few names were looked up in vain without it.
+ */
+static int ll_lookup_neg_finish(struct inode *parent, struct dentry *dentry)
+{
+	struct lookup_intent parent_it = { .it_op = IT_GETATTR };
+	struct ll_inode_info *plli = ll_i2info(parent);
+	struct ll_sb_info *sbi = ll_i2sbi(parent);
+	int rc;
+
+	rc = ll_parent_lock_match(parent, &dentry->d_name, &parent_it);
+	if (rc == 0 && READ_ONCE(sbi->ll_neg_cache_max) &&
+	    !ll_dir_striped(parent) &&
+	    ++plli->lli_neg_unlocked >= LL_NEG_CACHE_FETCH_MISSES) {
+		plli->lli_neg_unlocked = 0;
+		if (ll_inode_revalidate(dentry->d_parent, IT_GETATTR) == 0) {
+			atomic_inc(&sbi->ll_neg_cache_fetch);
+			rc = ll_parent_lock_match(parent, &dentry->d_name,
+						  &parent_it);
+		}
+	}
+	if (rc <= 0)
+		return rc;
+
+	d_lustre_revalidate(dentry);
+	if (!IS_ENCRYPTED(parent))
+		ll_neg_cache_add(parent, &dentry->d_name);
+	ll_intent_release(&parent_it);
+
+	return 0;
+}
+
+/*
+ * Instantiate \a dentry as negative without an RPC if its name is in the
+ * negative lookup cache of \a parent and the UPDATE lock is still cached.
+ */
+static bool ll_lookup_neg_cached(struct inode *parent, struct dentry *dentry)
+{
+	struct lookup_intent parent_it = { .it_op = IT_GETATTR };
+	struct dentry *alias;
+
+	if (IS_ENCRYPTED(parent) ||
+	    !ll_neg_cache_lookup(parent, &dentry->d_name))
+		return false;
+
+	if (ll_parent_lock_match(parent, &dentry->d_name, &parent_it) <= 0) {
+		/* the lock is being cancelled */
+		ll_neg_cache_purge(parent);
+		return false;
+	}
+
+	alias = ll_splice_alias(NULL, dentry);
+	if (!IS_ERR(alias))
+		d_lustre_revalidate(dentry);
+	ll_intent_release(&parent_it);
+	if (IS_ERR(alias))
+		return false;
+
+	CDEBUG(D_DENTRY, "negative cache hit %pd in "DFID"\n",
+	       dentry, PFID(ll_inode2fid(parent)));
+	atomic_inc(&ll_i2sbi(parent)->ll_neg_cache_hit);
+
+	return true;
+}
+
 static int ll_lookup_it_finish(struct ptlrpc_request *request,
 			       struct lookup_intent *it,
 			       struct inode *parent, struct dentry **de,
@@ -769,29 +865,9 @@ static int ll_lookup_it_finish(struct ptlrpc_request *request,
 		 * If file was created on the server, the dentry is revalidated
 		 * in ll_create_it if the lock allows for it.
 		 */
-		/* Check that parent has UPDATE lock. */
-		struct lookup_intent parent_it = {
-					.it_op = IT_GETATTR,
-					.it_lock_handle = 0 };
-		struct lu_fid	fid = ll_i2info(parent)->lli_fid;
-
-		/* If it is striped directory, get the real stripe parent */
-		if (unlikely(ll_dir_striped(parent))) {
-			down_read(&ll_i2info(parent)->lli_lsm_sem);
-			rc = md_get_fid_from_lsm(ll_i2mdexp(parent),
-						 ll_i2info(parent)->lli_lsm_obj,
-						 (*de)->d_name.name,
-						 (*de)->d_name.len, &fid);
-			up_read(&ll_i2info(parent)->lli_lsm_sem);
-			if (rc != 0)
-				GOTO(out, rc);
-		}
-
-		if (md_revalidate_lock(ll_i2mdexp(parent), &parent_it, &fid,
-				       NULL)) {
-			d_lustre_revalidate(*de);
-			ll_intent_release(&parent_it);
-		}
+		rc = ll_lookup_neg_finish(parent, *de);
+		if (rc != 0)
+			GOTO(out, rc);
 	}
 
 	if (it_disposition(it, DISP_OPEN_CREATE)) {
@@ -843,6 +919,10 @@ static struct dentry *ll_lookup_it(struct inode *parent, struct dentry *dentry,
 	if (it == NULL || it->it_op == IT_GETXATTR)
 		it = &lookup_it;
 
+	if (it->it_op & (IT_LOOKUP | IT_GETATTR) &&
+	    ll_lookup_neg_cached(parent, dentry))
+		RETURN(NULL);
+
 	if (it->it_op == IT_GETATTR && dentry_may_statahead(parent, dentry)) {
 		rc = ll_revalidate_statahead(parent, &dentry, 0);
 		if (rc == 1)
@@ -1223,6 +1303,7 @@ static int ll_atomic_open(struct inode *dir, struct dentry *dentry,
 			item.pm_gid = from_kgid(&init_user_ns, current_gid());
 			item.pm_projid = ll_i2info(dir)->lli_projid;
 			item.pm_name = &dentry->d_name;
+			item.pm_heat = 0;
 			dataset = pcc_dataset_match_get(&sbi->ll_pcc_super,
 							&item);
 			pca.pca_dataset = dataset;
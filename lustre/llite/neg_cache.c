@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/llite/neg_cache.c
+ *
+ * Negative lookup cache.  Names the MDT reported missing from a directory
+ * are kept in a small cache of the directory while the client holds its
+ * UPDATE lock, which the MDT revokes before any name is added.  Negative
+ * dentries give the same guarantee but are reclaimed with the rest of the
+ * dcache; this cache keeps up to ll_sb_info::ll_neg_cache_max names per
+ * directory until the lock is cancelled, so that path searches probing the
+ * same missing names over and over (interpreter imports, $PATH lookups) are
+ * answered without an RPC.
+ */
+
+#define DEBUG_SUBSYSTEM S_LLITE
+
+#include <linux/fs.h>
+#include <linux/hash.h>
+#include <obd_support.h>
+#include "llite_internal.h"
+
+#define LL_NEG_CACHE_HASH_BITS	5
+
+struct ll_neg_entry {
+	struct hlist_node	lne_hash;
+	struct list_head	lne_lru;
+	unsigned int		lne_hashval;	/* qstr::hash */
+	unsigned int		lne_namelen;
+	char			lne_name[];
+};
+
+struct ll_neg_cache {
+	spinlock_t		lnc_lock;
+	struct list_head	lnc_lru;	/* least recently hit first */
+	unsigned int		lnc_count;
+	struct hlist_head	lnc_hash[1 << LL_NEG_CACHE_HASH_BITS];
+};
+
+static struct ll_neg_cache *ll_neg_cache_get(struct inode *dir, bool create)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_neg_cache *cache;
+	int i;
+
+	cache = smp_load_acquire(&lli->lli_neg_cache);
+	if (cache || !create)
+		return cache;
+
+	OBD_ALLOC_PTR(cache);
+	if (!cache)
+		return NULL;
+
+	spin_lock_init(&cache->lnc_lock);
+	INIT_LIST_HEAD(&cache->lnc_lru);
+	for (i = 0; i < ARRAY_SIZE(cache->lnc_hash); i++)
+		INIT_HLIST_HEAD(&cache->lnc_hash[i]);
+
+	if (cmpxchg(&lli->lli_neg_cache, NULL, cache)) {
+		OBD_FREE_PTR(cache);
+		cache = smp_load_acquire(&lli->lli_neg_cache);
+	}
+
+	return cache;
+}
+
+static struct hlist_head *ll_neg_cache_bucket(struct ll_neg_cache *cache,
+					      const struct qstr *name)
+{
+	return &cache->lnc_hash[hash_32(name->hash, LL_NEG_CACHE_HASH_BITS)];
+}
+
+static struct ll_neg_entry *ll_neg_cache_find(struct ll_neg_cache *cache,
+					      const struct qstr *name)
+{
+	struct ll_neg_entry *lne;
+
+	hlist_for_each_entry(lne, ll_neg_cache_bucket(cache, name), lne_hash) {
+		if (lne->lne_hashval == name->hash &&
+		    lne->lne_namelen == name->len &&
+		    memcmp(lne->lne_name, name->name, name->len) == 0)
+			return lne;
+	}
+
+	return NULL;
+}
+
+static void ll_neg_entry_del(struct ll_neg_cache *cache,
+			     struct ll_neg_entry *lne)
+{
+	hlist_del(&lne->lne_hash);
+	list_del(&lne->lne_lru);
+	cache->lnc_count--;
+	OBD_FREE(lne, sizeof(*lne) + lne->lne_namelen);
+}
+
+/* Whether \a name is cached as missing from \a dir */
+bool ll_neg_cache_lookup(struct inode *dir, const struct qstr *name)
+{
+	struct ll_neg_cache *cache = ll_neg_cache_get(dir, false);
+	struct ll_neg_entry *lne;
+
+	if (!cache || !READ_ONCE(cache->lnc_count) ||
+	    !READ_ONCE(ll_i2sbi(dir)->ll_neg_cache_max))
+		return false;
+
+	spin_lock(&cache->lnc_lock);
+	lne = ll_neg_cache_find(cache, name);
+	if (lne)
+		list_move_tail(&lne->lne_lru, &cache->lnc_lru);
+	spin_unlock(&cache->lnc_lock);
+
+	return lne != NULL;
+}
+
+/*
+ * Remember that \a name is missing from \a dir. The caller holds a reference
+ * on the UPDATE lock of the directory, so the name cannot be added before
+ * ll_neg_cache_purge() is called for the lock cancel.
+ */
+void ll_neg_cache_add(struct inode *dir, const struct qstr *name)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	unsigned int max = READ_ONCE(sbi->ll_neg_cache_max);
+	struct ll_neg_cache *cache;
+	struct ll_neg_entry *lne;
+
+	if (!max)
+		return;
+
+	cache = ll_neg_cache_get(dir, true);
+	if (!cache)
+		return;
+
+	OBD_ALLOC(lne, sizeof(*lne) + name->len);
+	if (!lne)
+		return;
+
+	lne->lne_hashval = name->hash;
+	lne->lne_namelen = name->len;
+	memcpy(lne->lne_name, name->name, name->len);
+
+	spin_lock(&cache->lnc_lock);
+	if (ll_neg_cache_find(cache, name)) {
+		spin_unlock(&cache->lnc_lock);
+		OBD_FREE(lne, sizeof(*lne) + name->len);
+		return;
+	}
+
+	while (cache->lnc_count >= max)
+		ll_neg_entry_del(cache, list_first_entry(&cache->lnc_lru,
+							 struct ll_neg_entry,
+							 lne_lru));
+	hlist_add_head(&lne->lne_hash, ll_neg_cache_bucket(cache, name));
+	list_add_tail(&lne->lne_lru, &cache->lnc_lru);
+	cache->lnc_count++;
+	spin_unlock(&cache->lnc_lock);
+
+	atomic_inc(&sbi->ll_neg_cache_insert);
+}
+
+static unsigned int __ll_neg_cache_purge(struct ll_neg_cache *cache)
+{
+	struct ll_neg_entry *lne, *tmp;
+	unsigned int count;
+
+	spin_lock(&cache->lnc_lock);
+	count = cache->lnc_count;
+	list_for_each_entry_safe(lne, tmp, &cache->lnc_lru, lne_lru)
+		ll_neg_entry_del(cache, lne);
+	spin_unlock(&cache->lnc_lock);
+
+	return count;
+}
+
+/* Forget the names cached for \a dir, its UPDATE lock is being cancelled */
+void ll_neg_cache_purge(struct inode *dir)
+{
+	struct ll_neg_cache *cache = ll_neg_cache_get(dir, false);
+	unsigned int count;
+
+	if (!cache)
+		return;
+
+	count = __ll_neg_cache_purge(cache);
+	if (count) {
+		CDEBUG(D_DENTRY, "purge %u negative names of "DFID"\n",
+		       count, PFID(ll_inode2fid(dir)));
+		atomic_add(count, &ll_i2sbi(dir)->ll_neg_cache_purge);
+	}
+}
+
+void ll_neg_cache_fini(struct inode *dir)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_neg_cache *cache = lli->lli_neg_cache;
+
+	if (!cache)
+		return;
+
+	__ll_neg_cache_purge(cache);
+	lli->lli_neg_cache = NULL;
+	OBD_FREE_PTR(cache);
+}
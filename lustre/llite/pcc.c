@@ -107,11 +107,22 @@
 #include "pcc.h"
 #include <linux/namei.h>
 #include <linux/file.h>
+#include <linux/bvec.h>
+#include <linux/highmem.h>
+#include <linux/uio.h>
 #include <lustre_compat.h>
 #include "llite_internal.h"
 
 struct kmem_cache *pcc_inode_slab;
 
+static void pcc_readonly_detach_all(struct pcc_dataset *dataset);
+static void pcc_readonly_detach(struct inode *inode, bool evict);
+static void __pcc_readonly_detach(struct inode *inode, struct pcc_inode *pcci,
+				  bool evict);
+static bool pcc_readonly_open(struct inode *inode, struct pcc_inode *pcci,
+			      struct file *file);
+static bool pcc_readonly_switch(struct inode *inode, struct file *file);
+
 int pcc_super_init(struct pcc_super *super)
 {
 	struct cred *cred;
@@ -125,6 +136,22 @@ int pcc_super_init(struct pcc_super *super)
 	init_rwsem(&super->pccs_rw_sem);
 	INIT_LIST_HEAD(&super->pccs_datasets);
 	super->pccs_generation = 1;
+	super->pccs_heat_datasets = 0;
+
+	spin_lock_init(&super->pccs_attach_lock);
+	INIT_LIST_HEAD(&super->pccs_attach_list);
+	super->pccs_attach_queued = 0;
+	super->pccs_attach_max_active = PCC_ATTACH_MAX_ACTIVE_DEF;
+	super->pccs_attach_max_mbps = 0;
+	super->pccs_attach_next = 0;
+	super->pccs_attach_done = 0;
+	super->pccs_attach_failed = 0;
+	super->pccs_attach_wq = alloc_workqueue("pcc_attach", WQ_UNBOUND,
+						PCC_ATTACH_MAX_ACTIVE_DEF);
+	if (!super->pccs_attach_wq) {
+		put_cred(super->pccs_cred);
+		return -ENOMEM;
+	}
 
 	return 0;
 }
@@ -159,6 +186,7 @@ static void pcc_expression_free(struct pcc_expression *expr)
 	case PCC_FIELD_UID:
 	case PCC_FIELD_GID:
 	case PCC_FIELD_PROJID:
+	case PCC_FIELD_HEAT:
 		pcc_id_list_free(&expr->pe_cond);
 		break;
 	case PCC_FIELD_FNAME:
@@ -259,7 +287,7 @@ pcc_id_list_parse(char *str, struct list_head *id_list,
 	ENTRY;
 
 	if (type != PCC_FIELD_UID && type != PCC_FIELD_GID &&
-	    type != PCC_FIELD_PROJID)
+	    type != PCC_FIELD_PROJID && type != PCC_FIELD_HEAT)
 		RETURN(-EINVAL);
 
 	INIT_LIST_HEAD(id_list);
@@ -337,6 +365,12 @@ pcc_expression_parse(char *str, struct list_head *cond_list)
 		if (pcc_fname_list_parse(str, &expr->pe_cond) < 0)
 			GOTO(out, rc = -EINVAL);
 		expr->pe_field = PCC_FIELD_FNAME;
+	} else if (strcmp(field, "heat") == 0) {
+		if (pcc_id_list_parse(str,
+				      &expr->pe_cond,
+				      PCC_FIELD_HEAT) < 0)
+			GOTO(out, rc = -EINVAL);
+		expr->pe_field = PCC_FIELD_HEAT;
 	} else {
 		GOTO(out, rc = -EINVAL);
 	}
@@ -470,6 +504,13 @@ pcc_parse_value_pair(struct pcc_cmd *cmd, char *buffer)
 			return rc;
 		if (id > 0)
 			cmd->u.pccc_add.pccc_flags |= PCC_DATASET_ROPCC;
+	} else if (strcmp(key, "ro_cache_mb") == 0) {
+		rc = kstrtoul(val, 10, &id);
+		if (rc)
+			return rc;
+		if (id > U32_MAX)
+			return -ERANGE;
+		cmd->u.pccc_add.pccc_ro_cache_mb = id;
 	} else {
 		return -EINVAL;
 	}
@@ -579,6 +620,19 @@ pcc_id_list_match(struct list_head *id_list, __u32 id_val)
 	return 0;
 }
 
+/* heat={N} matches once the heat of the file reaches any threshold N */
+static int
+pcc_heat_list_match(struct list_head *id_list, __u64 heat)
+{
+	struct pcc_match_id *id;
+
+	list_for_each_entry(id, id_list, pmi_linkage) {
+		if (heat >= id->pmi_id)
+			return 1;
+	}
+	return 0;
+}
+
 static bool
 cfs_match_wildcard(const char *pattern, const char *content)
 {
@@ -631,6 +685,8 @@ pcc_expression_match(struct pcc_expression *expr, struct pcc_matcher *matcher)
 	case PCC_FIELD_FNAME:
 		return pcc_fname_list_match(&expr->pe_cond,
 					    matcher->pm_name->name);
+	case PCC_FIELD_HEAT:
+		return pcc_heat_list_match(&expr->pe_cond, matcher->pm_heat);
 	default:
 		return 0;
 	}
@@ -667,6 +723,23 @@ pcc_cond_match(struct pcc_match_rule *rule, struct pcc_matcher *matcher)
 	return 0;
 }
 
+static bool
+pcc_rule_has_heat(struct pcc_match_rule *rule)
+{
+	struct pcc_conjunction *conjunction;
+	struct pcc_expression *expr;
+
+	list_for_each_entry(conjunction, &rule->pmr_conds, pc_linkage) {
+		list_for_each_entry(expr, &conjunction->pc_expressions,
+				    pe_linkage) {
+			if (expr->pe_field == PCC_FIELD_HEAT)
+				return true;
+		}
+	}
+
+	return false;
+}
+
 struct pcc_dataset*
 pcc_dataset_match_get(struct pcc_super *super, struct pcc_matcher *matcher)
 {
@@ -724,6 +797,13 @@ pcc_dataset_add(struct pcc_super *super, struct pcc_cmd *cmd)
 	dataset->pccd_roid = cmd->u.pccc_add.pccc_roid;
 	dataset->pccd_flags = cmd->u.pccc_add.pccc_flags;
 	atomic_set(&dataset->pccd_refcount, 1);
+	spin_lock_init(&dataset->pccd_ro_lock);
+	INIT_LIST_HEAD(&dataset->pccd_ro_lru);
+	atomic_set(&dataset->pccd_ro_attached, 0);
+	atomic_set(&dataset->pccd_ro_stale, 0);
+	atomic_set(&dataset->pccd_ro_hits, 0);
+	dataset->pccd_ro_max_bytes =
+		(__u64)cmd->u.pccc_add.pccc_ro_cache_mb << 20;
 
 	rc = pcc_dataset_rule_init(&dataset->pccd_rule, cmd);
 	if (rc) {
@@ -731,6 +811,10 @@ pcc_dataset_add(struct pcc_super *super, struct pcc_cmd *cmd)
 		return rc;
 	}
 
+	if (dataset->pccd_flags & PCC_DATASET_ROPCC &&
+	    pcc_rule_has_heat(&dataset->pccd_rule))
+		dataset->pccd_flags |= PCC_DATASET_HEAT_ATTACH;
+
 	down_write(&super->pccs_rw_sem);
 	list_for_each_entry(tmp, &super->pccs_datasets, pccd_linkage) {
 		if (strcmp(tmp->pccd_pathname, pathname) == 0 ||
@@ -742,8 +826,11 @@ pcc_dataset_add(struct pcc_super *super, struct pcc_cmd *cmd)
 			break;
 		}
 	}
-	if (!found)
+	if (!found) {
 		list_add(&dataset->pccd_linkage, &super->pccs_datasets);
+		if (dataset->pccd_flags & PCC_DATASET_HEAT_ATTACH)
+			super->pccs_heat_datasets++;
+	}
 	up_write(&super->pccs_rw_sem);
 
 	if (found) {
@@ -793,26 +880,40 @@ pcc_dataset_put(struct pcc_dataset *dataset)
 	}
 }
 
+/* Must be called with pccs_rw_sem held for write */
+static void
+pcc_dataset_unlink(struct pcc_super *super, struct pcc_dataset *dataset)
+{
+	list_del_init(&dataset->pccd_linkage);
+	if (dataset->pccd_flags & PCC_DATASET_HEAT_ATTACH)
+		super->pccs_heat_datasets--;
+}
+
 static int
 pcc_dataset_del(struct pcc_super *super, char *pathname)
 {
 	struct list_head *l, *tmp;
 	struct pcc_dataset *dataset;
-	int rc = -ENOENT;
+	struct pcc_dataset *found = NULL;
 
 	down_write(&super->pccs_rw_sem);
 	list_for_each_safe(l, tmp, &super->pccs_datasets) {
 		dataset = list_entry(l, struct pcc_dataset, pccd_linkage);
 		if (strcmp(dataset->pccd_pathname, pathname) == 0) {
-			list_del_init(&dataset->pccd_linkage);
-			pcc_dataset_put(dataset);
+			pcc_dataset_unlink(super, dataset);
 			super->pccs_generation++;
-			rc = 0;
+			found = dataset;
 			break;
 		}
 	}
 	up_write(&super->pccs_rw_sem);
-	return rc;
+	if (!found)
+		return -ENOENT;
+
+	/* RO-PCC copies are not kept once their dataset is gone */
+	pcc_readonly_detach_all(found);
+	pcc_dataset_put(found);
+	return 0;
 }
 
 static void
@@ -822,6 +923,17 @@ pcc_dataset_dump(struct pcc_dataset *dataset, struct seq_file *m)
 	seq_printf(m, "  rwid: %u\n", dataset->pccd_rwid);
 	seq_printf(m, "  flags: %x\n", dataset->pccd_flags);
 	seq_printf(m, "  autocache: %s\n", dataset->pccd_rule.pmr_conds_str);
+	if (dataset->pccd_flags & PCC_DATASET_HEAT_ATTACH) {
+		seq_printf(m, "  ro_cache: %llu/%llu MiB\n",
+			   dataset->pccd_ro_bytes >> 20,
+			   dataset->pccd_ro_max_bytes >> 20);
+		seq_printf(m, "  ro_attached: %u\n",
+			   atomic_read(&dataset->pccd_ro_attached));
+		seq_printf(m, "  ro_stale: %u\n",
+			   atomic_read(&dataset->pccd_ro_stale));
+		seq_printf(m, "  ro_hits: %u\n",
+			   atomic_read(&dataset->pccd_ro_hits));
+	}
 }
 
 int
@@ -840,19 +952,27 @@ pcc_super_dump(struct pcc_super *super, struct seq_file *m)
 static void pcc_remove_datasets(struct pcc_super *super)
 {
 	struct pcc_dataset *dataset, *tmp;
+	LIST_HEAD(removed);
 
 	down_write(&super->pccs_rw_sem);
 	list_for_each_entry_safe(dataset, tmp,
 				 &super->pccs_datasets, pccd_linkage) {
-		list_del(&dataset->pccd_linkage);
-		pcc_dataset_put(dataset);
+		pcc_dataset_unlink(super, dataset);
+		list_add_tail(&dataset->pccd_linkage, &removed);
 	}
 	super->pccs_generation++;
 	up_write(&super->pccs_rw_sem);
+
+	list_for_each_entry_safe(dataset, tmp, &removed, pccd_linkage) {
+		list_del_init(&dataset->pccd_linkage);
+		pcc_readonly_detach_all(dataset);
+		pcc_dataset_put(dataset);
+	}
 }
 
 void pcc_super_fini(struct pcc_super *super)
 {
+	destroy_workqueue(super->pccs_attach_wq);
 	pcc_remove_datasets(super);
 	put_cred(super->pccs_cred);
 }
@@ -991,6 +1111,8 @@ static void pcc_inode_init(struct pcc_inode *pcci, struct ll_inode_info *lli)
 	pcci->pcci_layout_gen = CL_LAYOUT_GEN_NONE;
 	atomic_set(&pcci->pcci_active_ios, 0);
 	init_waitqueue_head(&pcci->pcci_waitq);
+	INIT_LIST_HEAD(&pcci->pcci_ro_lru);
+	pcci->pcci_ro_dataset = NULL;
 }
 
 static void pcc_inode_fini(struct pcc_inode *pcci)
@@ -1016,8 +1138,12 @@ static void pcc_inode_put(struct pcc_inode *pcci)
 
 void pcc_inode_free(struct inode *inode)
 {
-	struct pcc_inode *pcci = ll_i2pcci(inode);
+	struct pcc_inode *pcci;
+
+	/* RO-PCC state is not kept once the inode is gone */
+	pcc_readonly_detach(inode, true);
 
+	pcci = ll_i2pcci(inode);
 	if (pcci) {
 		WARN_ON(atomic_read(&pcci->pcci_refcount) > 1);
 		pcc_inode_put(pcci);
@@ -1483,6 +1609,10 @@ int pcc_file_open(struct inode *inode, struct file *file)
 	if (lli->lli_pcc_state & PCC_STATE_FL_ATTACHING)
 		GOTO(out_unlock, rc = 0);
 
+	if (pcci && pcci->pcci_ro_dataset && !pcc_readonly_open(inode, pcci,
+								file))
+		GOTO(out_unlock, rc = 0);
+
 	if (!pcci || !pcc_inode_has_layout(pcci)) {
 		if (pcc_may_auto_attach(inode, PIT_OPEN))
 			rc = pcc_try_auto_attach(inode, &cached, PIT_OPEN);
@@ -1544,16 +1674,31 @@ out:
 	RETURN_EXIT;
 }
 
+static inline bool pcc_io_is_splice_read(enum pcc_io_type iot)
+{
+#ifdef HAVE_DEFAULT_FILE_SPLICE_READ_EXPORT
+	return iot == PIT_SPLICE_READ;
+#else
+	return false;
+#endif
+}
+
 static void pcc_io_init(struct inode *inode, enum pcc_io_type iot, bool *cached)
 {
 	struct pcc_inode *pcci;
 
 	pcc_inode_lock(inode);
 	pcci = ll_i2pcci(inode);
-	if (pcci && pcc_inode_has_layout(pcci)) {
+	if (pcci && pcci->pcci_ro_dataset && iot != PIT_READ &&
+	    iot != PIT_FAULT && !pcc_io_is_splice_read(iot)) {
+		/* RO-PCC copy only serves reads */
+		*cached = false;
+	} else if (pcci && pcc_inode_has_layout(pcci)) {
 		LASSERT(atomic_read(&pcci->pcci_refcount) > 0);
 		atomic_inc(&pcci->pcci_active_ios);
 		*cached = true;
+		if (pcci->pcci_ro_dataset)
+			atomic_inc(&pcci->pcci_ro_dataset->pccd_ro_hits);
 	} else {
 		*cached = false;
 		if (pcc_may_auto_attach(inode, iot)) {
@@ -1624,7 +1769,7 @@ ssize_t pcc_file_read_iter(struct kiocb *iocb,
 
 	ENTRY;
 
-	if (pccf->pccf_file == NULL) {
+	if (pccf->pccf_file == NULL && !pcc_readonly_switch(inode, file)) {
 		*cached = false;
 		RETURN(0);
 	}
@@ -1737,6 +1882,10 @@ int pcc_inode_setattr(struct inode *inode, struct iattr *attr,
 		RETURN(0);
 	}
 
+	/* truncate makes a RO-PCC copy stale */
+	if (attr->ia_valid & ATTR_SIZE)
+		pcc_readonly_detach(inode, false);
+
 	pcc_io_init(inode, PIT_SETATTR, cached);
 	if (!*cached)
 		RETURN(0);
@@ -2096,7 +2245,8 @@ void pcc_layout_invalidate(struct inode *inode)
 
 	pcc_inode_lock(inode);
 	pcci = ll_i2pcci(inode);
-	if (pcci && pcc_inode_has_layout(pcci)) {
+	/* RO-PCC copies are checked against the data version at open */
+	if (pcci && pcc_inode_has_layout(pcci) && !pcci->pcci_ro_dataset) {
 		LASSERT(atomic_read(&pcci->pcci_refcount) > 0);
 		__pcc_layout_invalidate(pcci);
 
@@ -2365,56 +2515,173 @@ void pcc_create_attach_cleanup(struct super_block *sb,
 	pcc_dataset_put(pca->pca_dataset);
 }
 
-static int pcc_filp_write(struct file *filp, const void *buf, ssize_t count,
-			  loff_t *offset)
+/* Register \a pap of \a inode, queued if \a queued or started otherwise */
+static bool pcc_attach_progress_add(struct pcc_super *super,
+				    struct pcc_attach_progress *pap,
+				    struct inode *inode, bool queued)
 {
-	while (count > 0) {
-		ssize_t size;
+	pap->pap_fid = ll_i2info(inode)->lli_fid;
+	pap->pap_size = i_size_read(inode);
+	pap->pap_copied = 0;
+	pap->pap_start = queued ? 0 : ktime_get_real_seconds();
 
-		size = cfs_kernel_write(filp, buf, count, offset);
-		if (size < 0)
-			return size;
-		count -= size;
-		buf += size;
+	spin_lock(&super->pccs_attach_lock);
+	if (queued) {
+		if (super->pccs_attach_queued >= PCC_ATTACH_QUEUE_MAX) {
+			spin_unlock(&super->pccs_attach_lock);
+			return false;
+		}
+		super->pccs_attach_queued++;
 	}
-	return 0;
+	list_add_tail(&pap->pap_linkage, &super->pccs_attach_list);
+	spin_unlock(&super->pccs_attach_lock);
+
+	return true;
+}
+
+static void pcc_attach_progress_del(struct pcc_super *super,
+				    struct pcc_attach_progress *pap,
+				    bool queued, int rc)
+{
+	spin_lock(&super->pccs_attach_lock);
+	list_del_init(&pap->pap_linkage);
+	if (queued)
+		super->pccs_attach_queued--;
+	if (rc)
+		super->pccs_attach_failed++;
+	else
+		super->pccs_attach_done++;
+	spin_unlock(&super->pccs_attach_lock);
 }
 
-static ssize_t pcc_copy_data(struct file *src, struct file *dst)
+/*
+ * Wait until \a bytes more can be copied by attaches without exceeding the
+ * bandwidth cap. Every chunk is given the next time slot, so the cap holds
+ * whatever the number of attaches running.
+ */
+static void pcc_attach_throttle(struct pcc_super *super, size_t bytes)
 {
+	unsigned int mbps = READ_ONCE(super->pccs_attach_max_mbps);
+	ktime_t now, start;
+
+	if (!mbps)
+		return;
+
+	now = ktime_get();
+	spin_lock(&super->pccs_attach_lock);
+	start = ktime_after(super->pccs_attach_next, now) ?
+		super->pccs_attach_next : now;
+	super->pccs_attach_next = ktime_add_ns(start,
+		div_u64((u64)bytes * NSEC_PER_SEC, (u64)mbps << 20));
+	spin_unlock(&super->pccs_attach_lock);
+
+	if (ktime_after(start, now))
+		schedule_timeout_interruptible(
+			nsecs_to_jiffies(ktime_to_ns(ktime_sub(start, now))));
+}
+
+/* Open the PCC copy for the attach, bypassing the page cache if possible */
+static struct file *pcc_attach_open_copy(struct path *path)
+{
+	struct file *filp;
+
+	filp = dentry_open(path, O_WRONLY | O_LARGEFILE | O_DIRECT,
+			   current_cred());
+	if (filp == ERR_PTR(-EINVAL))
+		filp = dentry_open(path, O_WRONLY | O_LARGEFILE,
+				   current_cred());
+	return filp;
+}
+
+/*
+ * Copy \a src into \a dst by chunks of PCC_ATTACH_CHUNK_SIZE, no faster than
+ * the attach bandwidth cap, updating \a pap as the copy goes. Either file may
+ * be opened with O_DIRECT: every chunk but the last is full, the last one is
+ * written up to the end of its page and the caller truncates the copy to the
+ * returned size.
+ */
+static ssize_t pcc_copy_data(struct pcc_super *super, struct file *src,
+			     struct file *dst, struct pcc_attach_progress *pap)
+{
+	unsigned int npages = PCC_ATTACH_CHUNK_SIZE >> PAGE_SHIFT;
+	struct bio_vec *bvec;
+	struct iov_iter iter;
+	loff_t pos, offset = 0;
 	ssize_t rc = 0;
 	ssize_t rc2;
-	loff_t pos, offset = 0;
-	size_t buf_len = 1048576;
-	void *buf;
+	size_t written;
+	size_t count;
+	size_t len;
+	int i;
 
 	ENTRY;
 
-	OBD_ALLOC_LARGE(buf, buf_len);
-	if (buf == NULL)
+	OBD_ALLOC_PTR_ARRAY_LARGE(bvec, npages);
+	if (bvec == NULL)
 		RETURN(-ENOMEM);
 
+	for (i = 0; i < npages; i++) {
+		bvec[i].bv_page = alloc_page(GFP_NOFS);
+		if (bvec[i].bv_page == NULL)
+			GOTO(out_free, rc = -ENOMEM);
+		bvec[i].bv_len = PAGE_SIZE;
+		bvec[i].bv_offset = 0;
+	}
+
 	while (1) {
 		if (signal_pending(current))
 			GOTO(out_free, rc = -EINTR);
 
-		pos = offset;
-		rc2 = cfs_kernel_read(src, buf, buf_len, &pos);
-		if (rc2 < 0)
-			GOTO(out_free, rc = rc2);
-		else if (rc2 == 0)
+		pcc_attach_throttle(super, PCC_ATTACH_CHUNK_SIZE);
+
+		/*
+		 * Fill the whole chunk, a short read is only accepted at EOF:
+		 * with an O_DIRECT copy the next chunk would not be aligned.
+		 */
+		iov_iter_bvec(&iter, READ, bvec, npages, PCC_ATTACH_CHUNK_SIZE);
+		for (count = 0; count < PCC_ATTACH_CHUNK_SIZE; count += rc2) {
+			pos = offset + count;
+			rc2 = vfs_iter_read(src, &iter, &pos, 0);
+			if (rc2 < 0)
+				GOTO(out_free, rc = rc2);
+			if (rc2 == 0)
+				break;
+		}
+		if (count == 0)
 			break;
 
-		pos = offset;
-		rc = pcc_filp_write(dst, buf, rc2, &pos);
-		if (rc < 0)
-			GOTO(out_free, rc);
-		offset += rc2;
+		len = count;
+		if (dst->f_flags & O_DIRECT && count & ~PAGE_MASK) {
+			len = round_up(count, PAGE_SIZE);
+			zero_user(bvec[count >> PAGE_SHIFT].bv_page,
+				  count & ~PAGE_MASK, len - count);
+		}
+
+		for (written = 0; written < len; written += rc) {
+			iov_iter_bvec(&iter, WRITE, bvec, npages, len);
+			iov_iter_advance(&iter, written);
+			pos = offset + written;
+			file_start_write(dst);
+			rc = vfs_iter_write(dst, &iter, &pos, 0);
+			file_end_write(dst);
+			if (rc == 0)
+				rc = -EIO;
+			if (rc < 0)
+				GOTO(out_free, rc);
+		}
+		offset += count;
+		if (pap)
+			WRITE_ONCE(pap->pap_copied, offset);
+		/* EOF */
+		if (count < PCC_ATTACH_CHUNK_SIZE)
+			break;
 	}
 
 	rc = offset;
 out_free:
-	OBD_FREE_LARGE(buf, buf_len);
+	for (i = 0; i < npages && bvec[i].bv_page; i++)
+		__free_page(bvec[i].bv_page);
+	OBD_FREE_PTR_ARRAY_LARGE(bvec, npages);
 	RETURN(rc);
 }
 
@@ -2446,6 +2713,7 @@ int pcc_readwrite_attach(struct file *file, struct inode *inode,
 	struct pcc_dataset *dataset;
 	struct ll_inode_info *lli = ll_i2info(inode);
 	struct pcc_super *super = ll_i2pccs(inode);
+	struct pcc_attach_progress pap;
 	struct pcc_inode *pcci;
 	const struct cred *old_cred;
 	struct dentry *dentry;
@@ -2472,7 +2740,7 @@ int pcc_readwrite_attach(struct file *file, struct inode *inode,
 
 	path.mnt = dataset->pccd_path.mnt;
 	path.dentry = dentry;
-	pcc_filp = dentry_open(&path, O_WRONLY | O_LARGEFILE, current_cred());
+	pcc_filp = pcc_attach_open_copy(&path);
 	if (IS_ERR_OR_NULL(pcc_filp)) {
 		rc = pcc_filp == NULL ? -EINVAL : PTR_ERR(pcc_filp);
 		GOTO(out_dentry, rc);
@@ -2483,7 +2751,9 @@ int pcc_readwrite_attach(struct file *file, struct inode *inode,
 	if (rc)
 		GOTO(out_fput, rc);
 
-	ret = pcc_copy_data(file, pcc_filp);
+	pcc_attach_progress_add(super, &pap, inode, false);
+	ret = pcc_copy_data(super, file, pcc_filp, &pap);
+	pcc_attach_progress_del(super, &pap, false, ret < 0 ? ret : 0);
 	if (ret < 0)
 		GOTO(out_fput, rc = ret);
 
@@ -2652,6 +2922,8 @@ int pcc_ioctl_detach(struct inode *inode, __u32 opt)
 
 		__pcc_layout_invalidate(pcci);
 		pcc_inode_put(pcci);
+	} else if (pcci->pcci_ro_dataset) {
+		__pcc_readonly_detach(inode, pcci, false);
 	}
 
 out_unlock:
@@ -2667,6 +2939,537 @@ out_unlock:
 	RETURN(rc);
 }
 
+/*
+ * Heat driven RO-PCC
+ *
+ * A dataset whose rule has a "heat" condition gets read-hot files copied in
+ * asynchronously as read-only cache. The copy is not tracked by the MDT, it
+ * is only used by opens for read after the data version of the file has been
+ * checked against the one copied, so it gives close-to-open consistency. It
+ * is detached when the file is opened for write or truncated, when the inode
+ * is evicted, or when the capacity of the dataset is needed for another file,
+ * least recently opened first.
+ */
+struct pcc_attach_work {
+	struct work_struct	 paw_work;
+	/* Lustre file to copy */
+	struct path		 paw_path;
+	struct pcc_dataset	*paw_dataset;
+	struct pcc_attach_progress paw_progress;
+};
+
+/* removal of the RO-PCC copy of an evicted inode */
+struct pcc_remove_work {
+	struct work_struct	 prw_work;
+	struct path		 prw_path;
+	const struct cred	*prw_cred;
+};
+
+static void pcc_readonly_remove_work(struct work_struct *work)
+{
+	struct pcc_remove_work *prw = container_of(work, struct pcc_remove_work,
+						   prw_work);
+	struct dentry *dentry = prw->prw_path.dentry;
+	const struct cred *old_cred;
+	int rc;
+
+	old_cred = override_creds(prw->prw_cred);
+	rc = vfs_unlink(&nop_mnt_idmap, dentry->d_parent->d_inode, dentry);
+	if (rc)
+		CWARN("failed to unlink PCC file %pd, rc = %d\n", dentry, rc);
+	revert_creds(old_cred);
+
+	put_cred(prw->prw_cred);
+	path_put(&prw->prw_path);
+	OBD_FREE_PTR(prw);
+}
+
+/* Must be called with pcc_inode_lock held */
+static void pcc_readonly_lru_del(struct pcc_inode *pcci)
+{
+	struct pcc_dataset *dataset = pcci->pcci_ro_dataset;
+
+	spin_lock(&dataset->pccd_ro_lock);
+	list_del_init(&pcci->pcci_ro_lru);
+	dataset->pccd_ro_bytes -= pcci->pcci_ro_bytes;
+	spin_unlock(&dataset->pccd_ro_lock);
+	pcci->pcci_ro_dataset = NULL;
+	pcc_dataset_put(dataset);
+}
+
+/*
+ * Detach the RO-PCC copy of \a inode and remove it. When the inode is being
+ * evicted, possibly from memory reclaim, the copy is removed by a worker.
+ * Must be called with pcc_inode_lock held.
+ */
+static void __pcc_readonly_detach(struct inode *inode, struct pcc_inode *pcci,
+				  bool evict)
+{
+	struct pcc_super *super = ll_i2pccs(inode);
+	struct pcc_remove_work *prw = NULL;
+	const struct cred *old_cred;
+
+	CDEBUG(D_CACHE, "detach RO-PCC copy of "DFID"\n",
+	       PFID(&ll_i2info(inode)->lli_fid));
+
+	pcc_readonly_lru_del(pcci);
+	__pcc_layout_invalidate(pcci);
+	if (evict)
+		OBD_ALLOC_GFP(prw, sizeof(*prw), GFP_NOFS);
+	if (prw) {
+		INIT_WORK(&prw->prw_work, pcc_readonly_remove_work);
+		prw->prw_path = pcci->pcci_path;
+		path_get(&prw->prw_path);
+		prw->prw_cred = get_cred(super->pccs_cred);
+		queue_work(super->pccs_attach_wq, &prw->prw_work);
+	} else {
+		old_cred = override_creds(super->pccs_cred);
+		(void) pcc_inode_remove(inode, pcci->pcci_path.dentry);
+		revert_creds(old_cred);
+	}
+	pcc_inode_put(pcci);
+}
+
+static void pcc_readonly_detach(struct inode *inode, bool evict)
+{
+	struct pcc_inode *pcci;
+
+	pcc_inode_lock(inode);
+	pcci = ll_i2pcci(inode);
+	if (pcci && pcci->pcci_ro_dataset)
+		__pcc_readonly_detach(inode, pcci, evict);
+	pcc_inode_unlock(inode);
+}
+
+/*
+ * Reserve \a bytes of the capacity of \a dataset, detaching the least
+ * recently opened files if needed.
+ */
+static int pcc_readonly_reserve(struct pcc_dataset *dataset, __u64 bytes)
+{
+	struct pcc_inode *pcci;
+	struct inode *inode;
+
+	if (dataset->pccd_ro_max_bytes && bytes > dataset->pccd_ro_max_bytes)
+		return -EFBIG;
+
+	spin_lock(&dataset->pccd_ro_lock);
+	while (dataset->pccd_ro_max_bytes &&
+	       dataset->pccd_ro_bytes + bytes > dataset->pccd_ro_max_bytes) {
+		inode = NULL;
+		list_for_each_entry(pcci, &dataset->pccd_ro_lru, pcci_ro_lru) {
+			/* skip the inodes being freed */
+			inode = igrab(&pcci->pcci_lli->lli_vfs_inode);
+			if (inode)
+				break;
+		}
+		if (!inode) {
+			spin_unlock(&dataset->pccd_ro_lock);
+			return -ENOSPC;
+		}
+		spin_unlock(&dataset->pccd_ro_lock);
+
+		pcc_readonly_detach(inode, false);
+		iput(inode);
+		spin_lock(&dataset->pccd_ro_lock);
+	}
+	dataset->pccd_ro_bytes += bytes;
+	spin_unlock(&dataset->pccd_ro_lock);
+
+	return 0;
+}
+
+static void pcc_readonly_unreserve(struct pcc_dataset *dataset, __u64 bytes)
+{
+	spin_lock(&dataset->pccd_ro_lock);
+	dataset->pccd_ro_bytes -= bytes;
+	spin_unlock(&dataset->pccd_ro_lock);
+}
+
+static void pcc_readonly_detach_all(struct pcc_dataset *dataset)
+{
+	struct pcc_inode *pcci;
+	struct inode *inode;
+
+	spin_lock(&dataset->pccd_ro_lock);
+	while (!list_empty(&dataset->pccd_ro_lru)) {
+		inode = NULL;
+		list_for_each_entry(pcci, &dataset->pccd_ro_lru, pcci_ro_lru) {
+			inode = igrab(&pcci->pcci_lli->lli_vfs_inode);
+			if (inode)
+				break;
+		}
+		spin_unlock(&dataset->pccd_ro_lock);
+		if (!inode) {
+			/* the inodes left are being freed, which detaches */
+			schedule_timeout_uninterruptible(1);
+		} else {
+			pcc_readonly_detach(inode, false);
+			iput(inode);
+		}
+		spin_lock(&dataset->pccd_ro_lock);
+	}
+	spin_unlock(&dataset->pccd_ro_lock);
+}
+
+/*
+ * Check whether the RO-PCC copy of \a inode can be used by the open \a file,
+ * detaching it if the file is opened for write or the data changed.
+ * Must be called with pcc_inode_lock held.
+ */
+static bool pcc_readonly_open(struct inode *inode, struct pcc_inode *pcci,
+			      struct file *file)
+{
+	struct pcc_dataset *dataset = pcci->pcci_ro_dataset;
+	__u64 data_version;
+	int rc;
+
+	if (file->f_mode & FMODE_WRITE || file->f_flags & O_TRUNC) {
+		__pcc_readonly_detach(inode, pcci, false);
+		return false;
+	}
+
+	rc = ll_data_version(inode, &data_version, LL_DV_RD_FLUSH);
+	if (rc) {
+		CDEBUG(D_CACHE, DFID" cannot get data version: rc = %d\n",
+		       PFID(&ll_i2info(inode)->lli_fid), rc);
+		return false;
+	}
+
+	if (data_version != pcci->pcci_data_version) {
+		CDEBUG(D_CACHE, DFID" data version changed %llu/%llu\n",
+		       PFID(&ll_i2info(inode)->lli_fid),
+		       pcci->pcci_data_version, data_version);
+		atomic_inc(&dataset->pccd_ro_stale);
+		__pcc_readonly_detach(inode, pcci, false);
+		return false;
+	}
+
+	spin_lock(&dataset->pccd_ro_lock);
+	list_move_tail(&pcci->pcci_ro_lru, &dataset->pccd_ro_lru);
+	spin_unlock(&dataset->pccd_ro_lock);
+
+	return true;
+}
+
+static int pcc_readonly_attach(struct path *path, struct pcc_dataset *dataset,
+			       struct pcc_attach_progress *pap)
+{
+	struct inode *inode = d_inode(path->dentry);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct pcc_super *super = ll_i2pccs(inode);
+	__u64 data_version, data_version2;
+	struct pcc_inode *pcci;
+	const struct cred *old_cred;
+	struct dentry *dentry;
+	struct file *pcc_filp;
+	struct file *file;
+	struct path pcc_path;
+	__u64 bytes;
+	ssize_t ret;
+	__u32 gen;
+	int rc;
+
+	ENTRY;
+
+	old_cred = override_creds(super->pccs_cred);
+	/* large DIO reads do not fill the page cache with the whole file */
+	file = dentry_open(path, O_RDONLY | O_LARGEFILE | O_NOATIME | O_DIRECT,
+			   current_cred());
+	if (IS_ERR(file))
+		GOTO(out_cred, rc = PTR_ERR(file));
+
+	rc = ll_layout_refresh(inode, &gen);
+	if (rc)
+		GOTO(out_file, rc);
+
+	rc = ll_data_version(inode, &data_version, LL_DV_RD_FLUSH);
+	if (rc)
+		GOTO(out_file, rc);
+
+	bytes = i_size_read(inode);
+	rc = pcc_readonly_reserve(dataset, bytes);
+	if (rc)
+		GOTO(out_file, rc);
+
+	rc = __pcc_inode_create(dataset, &lli->lli_fid, &dentry);
+	if (rc)
+		GOTO(out_unreserve, rc);
+
+	pcc_path.mnt = dataset->pccd_path.mnt;
+	pcc_path.dentry = dentry;
+	pcc_filp = pcc_attach_open_copy(&pcc_path);
+	if (IS_ERR_OR_NULL(pcc_filp)) {
+		rc = pcc_filp == NULL ? -EINVAL : PTR_ERR(pcc_filp);
+		GOTO(out_dentry, rc);
+	}
+
+	WRITE_ONCE(pap->pap_size, bytes);
+	ret = pcc_copy_data(super, file, pcc_filp, pap);
+	fput(pcc_filp);
+	if (ret < 0)
+		GOTO(out_dentry, rc = ret);
+
+	rc = pcc_inode_reset_iattr(dentry, ATTR_SIZE, KUIDT_INIT(0),
+				   KGIDT_INIT(0), ret);
+	if (rc)
+		GOTO(out_dentry, rc);
+
+	/* the file changed while being copied */
+	rc = ll_data_version(inode, &data_version2, LL_DV_RD_FLUSH);
+	if (rc)
+		GOTO(out_dentry, rc);
+	if (data_version2 != data_version) {
+		atomic_inc(&dataset->pccd_ro_stale);
+		GOTO(out_dentry, rc = -ESTALE);
+	}
+
+	pcc_inode_lock(inode);
+	/* opened for write meanwhile, or the dataset was removed */
+	if (atomic_read(&inode->i_writecount) > 0)
+		GOTO(out_unlock, rc = -EBUSY);
+	if (list_empty(&dataset->pccd_linkage))
+		GOTO(out_unlock, rc = -ENOENT);
+
+	LASSERT(!ll_i2pcci(inode));
+	OBD_SLAB_ALLOC_PTR_GFP(pcci, pcc_inode_slab, GFP_NOFS);
+	if (pcci == NULL)
+		GOTO(out_unlock, rc = -ENOMEM);
+
+	pcc_inode_attach_set(super, dataset, lli, pcci, dentry,
+			     LU_PCC_READONLY);
+	pcc_layout_gen_set(pcci, gen);
+	pcci->pcci_data_version = data_version;
+	pcci->pcci_ro_bytes = bytes;
+	atomic_inc(&dataset->pccd_refcount);
+	pcci->pcci_ro_dataset = dataset;
+	spin_lock(&dataset->pccd_ro_lock);
+	list_add_tail(&pcci->pcci_ro_lru, &dataset->pccd_ro_lru);
+	spin_unlock(&dataset->pccd_ro_lock);
+	atomic_inc(&dataset->pccd_ro_attached);
+out_unlock:
+	pcc_inode_unlock(inode);
+out_dentry:
+	if (rc) {
+		(void) pcc_inode_remove(inode, dentry);
+		dput(dentry);
+	}
+out_unreserve:
+	if (rc)
+		pcc_readonly_unreserve(dataset, bytes);
+out_file:
+	fput(file);
+out_cred:
+	revert_creds(old_cred);
+
+	RETURN(rc);
+}
+
+static void pcc_readonly_attach_work(struct work_struct *work)
+{
+	struct pcc_attach_work *paw = container_of(work, struct pcc_attach_work,
+						   paw_work);
+	struct inode *inode = d_inode(paw->paw_path.dentry);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct pcc_super *super = ll_i2pccs(inode);
+	int rc;
+
+	WRITE_ONCE(paw->paw_progress.pap_start, ktime_get_real_seconds());
+	rc = pcc_readonly_attach(&paw->paw_path, paw->paw_dataset,
+				 &paw->paw_progress);
+	CDEBUG(D_CACHE, "%s: RO-PCC attach "DFID" into %s: rc = %d\n",
+	       ll_i2sbi(inode)->ll_fsname, PFID(&lli->lli_fid),
+	       paw->paw_dataset->pccd_pathname, rc);
+	pcc_attach_progress_del(super, &paw->paw_progress, true, rc);
+
+	pcc_inode_lock(inode);
+	lli->lli_pcc_state &= ~PCC_STATE_FL_ATTACHING;
+	pcc_inode_unlock(inode);
+
+	pcc_dataset_put(paw->paw_dataset);
+	path_put(&paw->paw_path);
+	OBD_FREE_PTR(paw);
+}
+
+/**
+ * Queue the RO-PCC attach of \a file once its read heat matches the rule of
+ * a dataset with a "heat" condition. Called after each read, so the checks
+ * are kept cheap and done at most once a second for each file.
+ */
+void pcc_file_heat_check(struct file *file)
+{
+	struct inode *inode = file_inode(file);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct pcc_super *super = ll_i2pccs(inode);
+	struct dentry *dentry = file_dentry(file);
+	struct pcc_dataset *dataset, *selected = NULL;
+	struct pcc_attach_work *paw;
+	struct pcc_matcher item;
+	char name[NAME_MAX + 1];
+	struct qstr qstr;
+	time64_t now;
+
+	if (!READ_ONCE(super->pccs_heat_datasets) ||
+	    !ll_sbi_has_file_heat(ll_i2sbi(inode)))
+		return;
+
+	now = ktime_get_seconds();
+	if (READ_ONCE(lli->lli_pcc_heat_checked) == now)
+		return;
+	WRITE_ONCE(lli->lli_pcc_heat_checked, now);
+
+	if (!S_ISREG(inode->i_mode) || IS_ENCRYPTED(inode) ||
+	    file->f_mode & FMODE_WRITE ||
+	    atomic_read(&inode->i_writecount) > 0 ||
+	    lli->lli_pcc_inode ||
+	    lli->lli_pcc_state & PCC_STATE_FL_ATTACHING ||
+	    READ_ONCE(super->pccs_attach_queued) >= PCC_ATTACH_QUEUE_MAX)
+		return;
+
+	spin_lock(&dentry->d_lock);
+	qstr.len = dentry->d_name.len;
+	memcpy(name, dentry->d_name.name, qstr.len);
+	spin_unlock(&dentry->d_lock);
+	name[qstr.len] = '\0';
+	qstr.name = name;
+
+	item.pm_uid = from_kuid(&init_user_ns, inode->i_uid);
+	item.pm_gid = from_kgid(&init_user_ns, inode->i_gid);
+	item.pm_projid = lli->lli_projid;
+	item.pm_name = &qstr;
+	item.pm_heat = ll_read_heat_get(inode);
+
+	down_read(&super->pccs_rw_sem);
+	list_for_each_entry(dataset, &super->pccs_datasets, pccd_linkage) {
+		if (!(dataset->pccd_flags & PCC_DATASET_HEAT_ATTACH))
+			continue;
+
+		if (pcc_cond_match(&dataset->pccd_rule, &item)) {
+			atomic_inc(&dataset->pccd_refcount);
+			selected = dataset;
+			break;
+		}
+	}
+	up_read(&super->pccs_rw_sem);
+	if (!selected)
+		return;
+
+	pcc_inode_lock(inode);
+	if (lli->lli_pcc_inode ||
+	    lli->lli_pcc_state & PCC_STATE_FL_ATTACHING) {
+		pcc_inode_unlock(inode);
+		GOTO(out_put, 0);
+	}
+	lli->lli_pcc_state |= PCC_STATE_FL_ATTACHING;
+	pcc_inode_unlock(inode);
+
+	OBD_ALLOC_PTR(paw);
+	if (!paw)
+		GOTO(out_attaching, 0);
+
+	/* the queue is full */
+	if (!pcc_attach_progress_add(super, &paw->paw_progress, inode, true)) {
+		OBD_FREE_PTR(paw);
+		GOTO(out_attaching, 0);
+	}
+
+	CDEBUG(D_CACHE, "%s: queue RO-PCC attach "DFID", heat %llu, %s\n",
+	       ll_i2sbi(inode)->ll_fsname, PFID(&lli->lli_fid),
+	       item.pm_heat, selected->pccd_rule.pmr_conds_str);
+
+	INIT_WORK(&paw->paw_work, pcc_readonly_attach_work);
+	paw->paw_path = file->f_path;
+	path_get(&paw->paw_path);
+	paw->paw_dataset = selected;
+	queue_work(super->pccs_attach_wq, &paw->paw_work);
+	return;
+
+out_attaching:
+	pcc_inode_lock(inode);
+	lli->lli_pcc_state &= ~PCC_STATE_FL_ATTACHING;
+	pcc_inode_unlock(inode);
+out_put:
+	pcc_dataset_put(selected);
+}
+
+/*
+ * Use the RO-PCC copy attached after \a file was opened, so that readers
+ * which opened the file while it was being attached switch to the cache.
+ */
+static bool pcc_readonly_switch(struct inode *inode, struct file *file)
+{
+	struct ll_file_data *fd = file->private_data;
+	struct pcc_file *pccf = &fd->fd_pcc_file;
+	struct pcc_inode *pcci;
+	struct file *pcc_file;
+	bool switched = false;
+
+	if (!READ_ONCE(ll_i2info(inode)->lli_pcc_inode) ||
+	    file->f_mode & FMODE_WRITE)
+		return false;
+
+	pcc_inode_lock(inode);
+	pcci = ll_i2pcci(inode);
+	if (pccf->pccf_file)
+		GOTO(out_unlock, switched = true);
+	if (!pcci || !pcci->pcci_ro_dataset ||
+	    !pcc_readonly_open(inode, pcci, file))
+		GOTO(out_unlock, switched = false);
+
+	pcc_file = dentry_open(&pcci->pcci_path, file->f_flags,
+			       pcc_super_cred(inode->i_sb));
+	if (IS_ERR_OR_NULL(pcc_file))
+		GOTO(out_unlock, switched = false);
+
+	CDEBUG(D_CACHE, "switch "DFID" to pcc file '%pd'\n",
+	       PFID(&ll_i2info(inode)->lli_fid), pcci->pcci_path.dentry);
+	pcc_inode_get(pcci);
+	pccf->pccf_file = pcc_file;
+	pccf->pccf_type = pcci->pcci_type;
+	switched = true;
+out_unlock:
+	pcc_inode_unlock(inode);
+	return switched;
+}
+
+int pcc_attach_max_active_set(struct pcc_super *super, unsigned int val)
+{
+	if (val < 1 || val > PCC_ATTACH_MAX_ACTIVE_MAX)
+		return -ERANGE;
+
+	super->pccs_attach_max_active = val;
+	workqueue_set_max_active(super->pccs_attach_wq, val);
+
+	return 0;
+}
+
+int pcc_attach_dump(struct pcc_super *super, struct seq_file *m)
+{
+	struct pcc_attach_progress *pap;
+	time64_t now = ktime_get_real_seconds();
+
+	spin_lock(&super->pccs_attach_lock);
+	seq_printf(m, "max_active: %u\n", super->pccs_attach_max_active);
+	seq_printf(m, "max_mbps: %u\n", super->pccs_attach_max_mbps);
+	seq_printf(m, "queued: %u\n", super->pccs_attach_queued);
+	seq_printf(m, "attached: %llu\n", super->pccs_attach_done);
+	seq_printf(m, "failed: %llu\n", super->pccs_attach_failed);
+	seq_puts(m, "attaching:\n");
+	list_for_each_entry(pap, &super->pccs_attach_list, pap_linkage) {
+		seq_printf(m, "  - fid: "DFID"\n", PFID(&pap->pap_fid));
+		seq_printf(m, "    size: %llu\n", READ_ONCE(pap->pap_size));
+		seq_printf(m, "    copied: %llu\n", READ_ONCE(pap->pap_copied));
+		if (pap->pap_start)
+			seq_printf(m, "    seconds: %lld\n",
+				   now - READ_ONCE(pap->pap_start));
+		else
+			seq_puts(m, "    seconds: queued\n");
+	}
+	spin_unlock(&super->pccs_attach_lock);
+
+	return 0;
+}
+
 int pcc_ioctl_state(struct file *file, struct inode *inode,
 		    struct lu_pcc_state *state)
 {
@@ -59,6 +59,7 @@ enum pcc_field {
 	PCC_FIELD_GID,
 	PCC_FIELD_PROJID,
 	PCC_FIELD_FNAME,
+	PCC_FIELD_HEAT,
 	PCC_FIELD_MAX
 };
 
@@ -88,6 +89,8 @@ struct pcc_matcher {
 	__u32		 pm_gid;
 	__u32		 pm_projid;
 	struct qstr	*pm_name;
+	/* read heat of the file, see ll_read_heat_get() */
+	__u64		 pm_heat;
 };
 
 enum pcc_dataset_flags {
@@ -109,6 +112,8 @@ enum pcc_dataset_flags {
 	PCC_DATASET_ROPCC	= 0x20,
 	/* PCC backend provides caching services for both RW-PCC and RO-PCC */
 	PCC_DATASET_PCC_ALL	= PCC_DATASET_RWPCC | PCC_DATASET_ROPCC,
+	/* Rule has a heat condition, attach read-hot files into RO-PCC */
+	PCC_DATASET_HEAT_ATTACH	= 0x40,
 };
 
 struct pcc_dataset {
@@ -120,6 +125,35 @@ struct pcc_dataset {
 	struct path		pccd_path;	 /* Root path */
 	struct list_head	pccd_linkage;  /* Linked to pccs_datasets */
 	atomic_t		pccd_refcount; /* Reference count */
+	/* Protect the RO-PCC LRU list and usage below */
+	spinlock_t		pccd_ro_lock;
+	/* RO-PCC attached inodes, least recently opened first */
+	struct list_head	pccd_ro_lru;
+	/* Bytes cached and capacity cap (0 if unlimited) for RO-PCC */
+	__u64			pccd_ro_bytes;
+	__u64			pccd_ro_max_bytes;
+	/* RO-PCC copies attached, found stale and reads served from them */
+	atomic_t		pccd_ro_attached;
+	atomic_t		pccd_ro_stale;
+	atomic_t		pccd_ro_hits;
+};
+
+/* Default and largest number of attaches copying data at the same time */
+#define PCC_ATTACH_MAX_ACTIVE_DEF	2
+#define PCC_ATTACH_MAX_ACTIVE_MAX	32
+/* Asynchronous attaches queued at most, read-hot files are skipped then */
+#define PCC_ATTACH_QUEUE_MAX		256
+/* Attach copies the data by chunks of this size */
+#define PCC_ATTACH_CHUNK_SIZE		(4 << 20)
+
+/* Progress of an attach, shown in the "pcc_attach" debugfs file */
+struct pcc_attach_progress {
+	struct list_head	pap_linkage;  /* Linked to pccs_attach_list */
+	struct lu_fid		pap_fid;
+	__u64			pap_size;
+	__u64			pap_copied;
+	/* Time the copy started, 0 while queued */
+	time64_t		pap_start;
 };
 
 struct pcc_super {
@@ -135,6 +169,23 @@ struct pcc_super {
 	 * parameters for PCC.
 	 */
 	__u64			 pccs_generation;
+	/* Number of datasets with PCC_DATASET_HEAT_ATTACH */
+	int			 pccs_heat_datasets;
+	/* Asynchronous attach of read-hot files */
+	struct workqueue_struct	*pccs_attach_wq;
+	/* Protect pccs_attach_list, the counters and the pacing below */
+	spinlock_t		 pccs_attach_lock;
+	/* Attaches queued or copying data */
+	struct list_head	 pccs_attach_list;
+	unsigned int		 pccs_attach_queued;
+	/* Concurrent asynchronous attaches */
+	unsigned int		 pccs_attach_max_active;
+	/* Attach copy bandwidth in MiB/s, 0 if unlimited */
+	unsigned int		 pccs_attach_max_mbps;
+	/* Time the next chunk may be copied without exceeding the bandwidth */
+	ktime_t			 pccs_attach_next;
+	__u64			 pccs_attach_done;
+	__u64			 pccs_attach_failed;
 };
 
 struct pcc_inode {
@@ -159,6 +210,13 @@ struct pcc_inode {
 	atomic_t		 pcci_active_ios;
 	/* Waitq - wait for PCC I/O completion. */
 	wait_queue_head_t	 pcci_waitq;
+	/* RO-PCC: dataset LRU linkage and dataset, NULL if not RO-PCC */
+	struct list_head	 pcci_ro_lru;
+	struct pcc_dataset	*pcci_ro_dataset;
+	/* RO-PCC: bytes accounted to the dataset */
+	__u64			 pcci_ro_bytes;
+	/* RO-PCC: data version of the Lustre file that was copied */
+	__u64			 pcci_data_version;
 };
 
 struct pcc_file {
@@ -207,6 +265,7 @@ struct pcc_cmd {
 			struct list_head	 pccc_conds;
 			char			*pccc_conds_str;
 			enum pcc_dataset_flags	 pccc_flags;
+			__u32			 pccc_ro_cache_mb;
 		} pccc_add;
 		struct pcc_cmd_del {
 			__u32			 pccc_pad;
@@ -224,6 +283,8 @@ void pcc_super_fini(struct pcc_super *super);
 int pcc_cmd_handle(char *buffer, unsigned long count,
 		   struct pcc_super *super);
 int pcc_super_dump(struct pcc_super *super, struct seq_file *m);
+int pcc_attach_dump(struct pcc_super *super, struct seq_file *m);
+int pcc_attach_max_active_set(struct pcc_super *super, unsigned int val);
 int pcc_readwrite_attach(struct file *file, struct inode *inode,
 			 __u32 arch_id);
 int pcc_readwrite_attach_fini(struct file *file, struct inode *inode,
@@ -235,6 +296,7 @@ int pcc_ioctl_state(struct file *file, struct inode *inode,
 void pcc_file_init(struct pcc_file *pccf);
 int pcc_file_open(struct inode *inode, struct file *file);
 void pcc_file_release(struct inode *inode, struct file *file);
+void pcc_file_heat_check(struct file *file);
 ssize_t pcc_file_read_iter(struct kiocb *iocb, struct iov_iter *iter,
 			   bool *cached);
 ssize_t pcc_file_write_iter(struct kiocb *iocb, struct iov_iter *iter,
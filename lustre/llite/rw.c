@@ -213,6 +213,14 @@ static int ll_read_ahead_page(const struct lu_env *env, struct cl_io *io,
 
 	ENTRY;
 
+	/* the rest of a large folio queued and locked already */
+	if (queue->pl_nr > 0) {
+		cp = cl_page_list_last(queue);
+		if (index > cl_page_index(cp) &&
+		    index < cl_page_index(cp) + cl_page_nr(cp))
+			RETURN(1);
+	}
+
 	switch (hint) {
 	case MAYNEED:
 		/*
@@ -242,6 +250,9 @@ static int ll_read_ahead_page(const struct lu_env *env, struct cl_io *io,
 		GOTO(out, rc = -EINVAL);
 	}
 
+	/* a large folio is read as a whole through its head page */
+	vmpage = compound_head(vmpage);
+
 	/* Check if vmpage was truncated or reclaimed */
 	if (vmpage->mapping != inode->i_mapping) {
 		which = RA_STAT_WRONG_GRAB_PAGE;
@@ -608,7 +619,7 @@ static void ll_readahead_handle_work(struct work_struct *wq)
 	work = container_of(wq, struct ll_readahead_work,
 			    lrw_readahead_work);
 	fd = work->lrw_file->private_data;
-	ras = &fd->fd_ras;
+	ras = work->lrw_ras;
 	file = work->lrw_file;
 	inode = file_inode(file);
 	sbi = ll_i2sbi(inode);
@@ -965,6 +976,19 @@ void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras)
 	ras->ras_range_max_end_idx = 0;
 	ras->ras_range_requests = 0;
 	ras->ras_last_range_pages = 0;
+	ras->ras_last_read_start_bytes = 0;
+	ras->ras_stream_active = false;
+	ras->ras_stream_stamp = 0;
+	ras->ras_stream_gap = 0;
+}
+
+/* free the read-ahead streams of @fd */
+void ll_readahead_fini(struct ll_file_data *fd)
+{
+	if (fd->fd_ras_streams)
+		OBD_FREE_PTR_ARRAY(fd->fd_ras_streams, fd->fd_ras_nr_streams);
+	fd->fd_ras_streams = NULL;
+	fd->fd_ras_nr_streams = 0;
 }
 
 /*
@@ -1239,14 +1263,215 @@ static void ras_detect_read_pattern(struct ll_readahead_state *ras,
 		ras->ras_need_increase_window = true;
 	}
 
+	ras->ras_last_read_start_bytes = pos;
 	ras->ras_last_read_end_bytes = pos + bytes - 1;
 }
 
+static bool index_in_stride_window(struct ll_readahead_state *ras,
+				   pgoff_t index)
+{
+	loff_t pos = (loff_t)index << PAGE_SHIFT;
+
+	if (ras->ras_stride_length == 0 || ras->ras_stride_bytes == 0 ||
+	    ras->ras_stride_bytes == ras->ras_stride_length)
+		return false;
+
+	if (pos >= ras->ras_stride_offset) {
+		u64 offset;
+
+		div64_u64_rem(pos - ras->ras_stride_offset,
+			      ras->ras_stride_length, &offset);
+		if (offset < ras->ras_stride_bytes ||
+		    ras->ras_stride_length - offset < PAGE_SIZE)
+			return true;
+	} else if (ras->ras_stride_offset - pos < PAGE_SIZE) {
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Read-ahead streams.  Threads or MPI ranks reading distinct regions of a
+ * file through the same descriptor would keep resetting a single window, so
+ * up to ra_streams_max streams are tracked per descriptor, each detecting
+ * its own sequential or stride pattern and growing its own window.  A read
+ * belongs to the stream whose last read it is closest to, a read matching
+ * no stream starts a new one in a free slot or in the least recently used
+ * one, and streams which grow into each other are merged.
+ *
+ * A stride read jumps further than is_loose_seq_read() allows and its new
+ * stream has no window or stride yet, so a stream started past the end of
+ * the previous one keeps the gap between them. A read one more such gap
+ * past the stream belongs to it, which lets the stride detector see it.
+ */
+
+/* distance of a read at @pos to stream @ras, -1 if it does not belong */
+static loff_t ras_stream_distance(struct ll_readahead_state *ras,
+				  loff_t pos, loff_t bytes)
+{
+	loff_t end = ras->ras_last_read_end_bytes;
+	pgoff_t index = pos >> PAGE_SHIFT;
+
+	if (!ras->ras_stream_active)
+		return -1;
+
+	if (pos >= ras->ras_last_read_start_bytes && pos <= end)
+		return 0;
+
+	if (is_loose_seq_read(ras, pos) ||
+	    (ras->ras_stream_gap && !ras->ras_consecutive_stride_requests &&
+	     pos == end + 1 + ras->ras_stream_gap) ||
+	    (ras->ras_window_pages &&
+	     pos_in_window(index, ras->ras_window_start_idx, 0,
+			   ras->ras_window_pages - 1)) ||
+	    read_in_stride_window(ras, pos, bytes) ||
+	    (stride_io_mode(ras) && index_in_stride_window(ras, index)))
+		return pos > end ? pos - end : end - pos;
+
+	return -1;
+}
+
+/* start tracking a new stream at @pos in slot @ras, @gap past another */
+static void ras_stream_start(struct ll_readahead_state *ras, loff_t pos,
+			     loff_t gap)
+{
+	spin_lock(&ras->ras_lock);
+	ras_reset(ras, pos >> PAGE_SHIFT);
+	ras_stride_reset(ras);
+	/* the first read is sequential to the stream, not a stride from 0 */
+	ras->ras_last_read_end_bytes = pos ? pos - 1 : 0;
+	ras->ras_last_read_start_bytes = pos;
+	ras->ras_requests = 0;
+	ras->ras_range_min_start_idx = 0;
+	ras->ras_range_max_end_idx = 0;
+	ras->ras_range_requests = 0;
+	ras->ras_last_range_pages = 0;
+	ras->ras_async_last_readpage_idx = 0;
+	ras->ras_need_increase_window = false;
+	ras->ras_no_miss_check = false;
+	ras->ras_stream_active = true;
+	ras->ras_stream_gap = gap;
+	spin_unlock(&ras->ras_lock);
+}
+
+/**
+ * Find the read-ahead stream of @fd a read at @pos belongs to.
+ *
+ * If none matches, a new stream is started when \a create is set, which is
+ * the case for read(2) and mmap reads, otherwise the most recently used
+ * stream is returned.
+ */
+static struct ll_readahead_state *ll_ras_stream(struct inode *inode,
+						struct ll_file_data *fd,
+						loff_t pos, loff_t bytes,
+						bool create)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	unsigned int streams_max = READ_ONCE(sbi->ll_ra_info.ra_streams_max);
+	struct ll_readahead_state *streams = NULL;
+	struct ll_readahead_state *best;
+	struct ll_readahead_state *unused;
+	struct ll_readahead_state *lru;
+	struct ll_readahead_state *mru;
+	struct ll_readahead_state *ras;
+	loff_t best_dist = 0;
+	loff_t gap = 0;
+	loff_t dist;
+	unsigned int nr;
+	unsigned int i;
+
+	if (streams_max <= 1)
+		return &fd->fd_ras;
+
+again:
+	best = unused = lru = mru = NULL;
+	spin_lock(&fd->fd_ras_streams_lock);
+	nr = min(streams_max, fd->fd_ras_nr_streams + 1);
+	for (i = 0; i < nr; i++) {
+		ras = i ? &fd->fd_ras_streams[i - 1] : &fd->fd_ras;
+		if (!ras->ras_stream_active) {
+			if (!unused)
+				unused = ras;
+			continue;
+		}
+		if (!lru || ras->ras_stream_stamp < lru->ras_stream_stamp)
+			lru = ras;
+		if (!mru || ras->ras_stream_stamp > mru->ras_stream_stamp)
+			mru = ras;
+
+		dist = ras_stream_distance(ras, pos, bytes);
+		if (dist < 0)
+			continue;
+
+		if (!best) {
+			best = ras;
+			best_dist = dist;
+		} else if (create &&
+			   is_loose_seq_read(best, ras->ras_last_read_end_bytes)) {
+			/* keep the stream which read more */
+			if (ras->ras_consecutive_bytes >
+			    best->ras_consecutive_bytes)
+				swap(ras, best);
+			ras->ras_stream_active = false;
+			ll_ra_stats_inc_sbi(sbi, RA_STAT_STREAM_MERGED);
+		} else if (dist < best_dist) {
+			best = ras;
+			best_dist = dist;
+		}
+	}
+
+	if (!best && !create)
+		best = mru ? mru : &fd->fd_ras;
+
+	if (!best && !unused && !fd->fd_ras_streams && !streams) {
+		/* the first concurrent stream, allocate the slots */
+		spin_unlock(&fd->fd_ras_streams_lock);
+		OBD_ALLOC_PTR_ARRAY(streams, streams_max - 1);
+		if (streams) {
+			for (i = 0; i < streams_max - 1; i++)
+				ll_readahead_init(inode, &streams[i]);
+			goto again;
+		}
+		spin_lock(&fd->fd_ras_streams_lock);
+	} else if (!best && !unused && streams && !fd->fd_ras_streams) {
+		fd->fd_ras_streams = streams;
+		fd->fd_ras_nr_streams = streams_max - 1;
+		unused = &streams[0];
+		streams = NULL;
+	}
+
+	if (!best) {
+		if (mru && pos > mru->ras_last_read_end_bytes + 1)
+			gap = pos - mru->ras_last_read_end_bytes - 1;
+		if (unused) {
+			best = unused;
+		} else {
+			/* lru is set, at least fd_ras is active */
+			best = lru;
+			ll_ra_stats_inc_sbi(sbi, RA_STAT_STREAM_EVICTED);
+		}
+		ras_stream_start(best, pos, gap);
+		ll_ra_stats_inc_sbi(sbi, RA_STAT_STREAM_NEW);
+		CDEBUG(D_READA, DFID": new read-ahead stream at %lld\n",
+		       PFID(ll_inode2fid(inode)), pos);
+	}
+	best->ras_stream_stamp = ++fd->fd_ras_clock;
+	spin_unlock(&fd->fd_ras_streams_lock);
+
+	/* raced with another reader allocating the slots */
+	if (streams)
+		OBD_FREE_PTR_ARRAY(streams, streams_max - 1);
+
+	return best;
+}
+
 void ll_ras_enter(struct file *f, loff_t pos, size_t bytes)
 {
 	struct ll_file_data *fd = f->private_data;
-	struct ll_readahead_state *ras = &fd->fd_ras;
 	struct inode *inode = file_inode(f);
+	struct ll_readahead_state *ras = ll_ras_stream(inode, fd, pos, bytes,
+							true);
 	unsigned long index = pos >> PAGE_SHIFT;
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
 
@@ -1288,28 +1513,31 @@ out_unlock:
 	spin_unlock(&ras->ras_lock);
 }
 
-static bool index_in_stride_window(struct ll_readahead_state *ras,
-				   pgoff_t index)
+/*
+ * Size the read-ahead window of a page fault at \a index from the faulting
+ * VMA. A mapping advised MADV_SEQUENTIAL reads ahead to the end of the VMA,
+ * up to ra_max_pages_per_file, otherwise \a pages is only trimmed so that
+ * read-ahead does not run past the end of the mapping.
+ */
+static unsigned long ras_mmap_window_pages(struct ll_sb_info *sbi,
+					   struct cl_io *io, pgoff_t index,
+					   unsigned long pages)
 {
-	loff_t pos = (loff_t)index << PAGE_SHIFT;
+	pgoff_t end;
 
-	if (ras->ras_stride_length == 0 || ras->ras_stride_bytes == 0 ||
-	    ras->ras_stride_bytes == ras->ras_stride_length)
-		return false;
+	if (!io || io->ci_type != CIT_FAULT)
+		return pages;
 
-	if (pos >= ras->ras_stride_offset) {
-		u64 offset;
+	end = io->u.ci_fault.ft_vma_end;
+	if (end <= index)
+		return pages;
 
-		div64_u64_rem(pos - ras->ras_stride_offset,
-			      ras->ras_stride_length, &offset);
-		if (offset < ras->ras_stride_bytes ||
-		    ras->ras_stride_length - offset < PAGE_SIZE)
-			return true;
-	} else if (ras->ras_stride_offset - pos < PAGE_SIZE) {
-		return true;
-	}
+	if (io->ci_seq_read)
+		pages = max_t(unsigned long, pages,
+			      min_t(pgoff_t, end - index,
+				    sbi->ll_ra_info.ra_max_pages_per_file));
 
-	return false;
+	return min_t(pgoff_t, pages, end - index);
 }
 
 /*
@@ -1348,7 +1576,8 @@ static void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 	if (io && io->ci_seq_read) {
 		if (!hit) {
 			/* to avoid many small read RPC here */
-			ras->ras_window_pages = sbi->ll_ra_info.ra_range_pages;
+			ras->ras_window_pages = ras_mmap_window_pages(sbi, io,
+					index, sbi->ll_ra_info.ra_range_pages);
 			ll_ra_stats_inc_sbi(sbi, RA_STAT_MMAP_RANGE_READ);
 		}
 		goto skip;
@@ -1374,7 +1603,9 @@ static void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 					index = 0;
 				else
 					index -= ra_pages / 2;
-				ras->ras_window_pages = ra_pages;
+				ras->ras_window_pages =
+					ras_mmap_window_pages(sbi, io, index,
+							      ra_pages);
 				ll_ra_stats_inc_sbi(sbi,
 					RA_STAT_MMAP_RANGE_READ);
 			} else {
@@ -1693,7 +1924,9 @@ int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 
 	if (file) {
 		fd = file->private_data;
-		ras = &fd->fd_ras;
+		ras = ll_ras_stream(inode, fd,
+				    (loff_t)cl_page_index(page) << PAGE_SHIFT,
+				    cl_page_size(page), mmap);
 	}
 
 	/* PagePrivate2 is set in ll_io_zero_page() to tell us the vmpage
@@ -1806,13 +2039,13 @@ int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
  * 2 async readahead triggered and fast read could be used too.
  * < 0 on error.
  */
-static int kickoff_async_readahead(struct file *file, unsigned long pages)
+static int kickoff_async_readahead(struct file *file,
+				   struct ll_readahead_state *ras,
+				   unsigned long pages)
 {
 	struct ll_readahead_work *lrw;
 	struct inode *inode = file_inode(file);
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
-	struct ll_file_data *fd = file->private_data;
-	struct ll_readahead_state *ras = &fd->fd_ras;
 	struct ll_ra_info *ra = &sbi->ll_ra_info;
 	unsigned long throttle;
 	pgoff_t start_idx = ras_align(ras, ras->ras_next_readahead_idx);
@@ -1850,6 +2083,7 @@ static int kickoff_async_readahead(struct file *file, unsigned long pages)
 	if (lrw) {
 		atomic_inc(&sbi->ll_ra_info.ra_async_inflight);
 		lrw->lrw_file = get_file(file);
+		lrw->lrw_ras = ras;
 		lrw->lrw_start_idx = start_idx;
 		lrw->lrw_end_idx = end_idx;
 		lrw->lrw_user_pid = current->pid;
@@ -1892,7 +2126,7 @@ static bool ll_use_fast_io(struct file *file,
 
 	if (ras->ras_window_start_idx + ras->ras_window_pages <
 	    ras->ras_next_readahead_idx + skip_pages ||
-	    kickoff_async_readahead(file, fast_read_pages) > 0)
+	    kickoff_async_readahead(file, ras, fast_read_pages) > 0)
 		return true;
 
 	return false;
@@ -1955,7 +2189,7 @@ int ll_readpage(struct file *file, struct page *vmpage)
 	if (io == NULL) { /* fast read */
 		struct inode *inode = file_inode(file);
 		struct ll_file_data *fd = file->private_data;
-		struct ll_readahead_state *ras = &fd->fd_ras;
+		struct ll_readahead_state *ras;
 		struct lu_env  *local_env = NULL;
 
 		CDEBUG(D_VFSTRACE, "fast read pgno: %ld\n", vmpage->index);
@@ -1977,6 +2211,9 @@ int ll_readpage(struct file *file, struct page *vmpage)
 			if (lcc && lcc->lcc_type == LCC_MMAP)
 				flags |= LL_RAS_MMAP;
 
+			ras = ll_ras_stream(inode, fd,
+					    (loff_t)cl_page_index(page) <<
+					    PAGE_SHIFT, PAGE_SIZE, false);
 			/* For fast read, it updates read ahead state only
 			 * if the page is hit in cache because non cache page
 			 * case will be handled by slow read later. */
@@ -71,30 +71,22 @@ static void ll_invalidate_folio(struct folio *folio, size_t offset, size_t len)
 	LASSERT(!folio_test_writeback(folio));
 	LASSERT(folio_test_locked(folio));
 
-	if (!(offset == 0 && len == folio_size(folio)) &&
-	    !folio_test_large(folio))
+	/* a large folio has a single cl_page, which stays as long as some
+	 * of the folio does
+	 */
+	if (!(offset == 0 && len == folio_size(folio)))
 		return;
 
-	/* Drop the pages from the folio */
 	env = cl_env_percpu_get();
 	LASSERT(!IS_ERR(env));
 
 	inode = folio_inode(folio);
 	obj = ll_i2info(inode)->lli_clob;
 	if (obj != NULL) {
-		int n, npgs = folio_nr_pages(folio);
-
-		for (n = 0; n < npgs; n++) {
-			struct page *vmpage = folio_page(folio, n);
-
-			LASSERT(PageLocked(vmpage));
-			LASSERT(!PageWriteback(vmpage));
-
-			page = cl_vmpage_page(vmpage, obj);
-			if (page != NULL) {
-				cl_page_delete(env, page);
-				cl_page_put(env, page);
-			}
+		page = cl_vmpage_page(folio_page(folio, 0), obj);
+		if (page != NULL) {
+			cl_page_delete(env, page);
+			cl_page_put(env, page);
 		}
 	} else {
 		LASSERT(!folio_get_private(folio));
@@ -223,12 +215,8 @@ static bool do_release_page(struct page *vmpage, gfp_t wait)
 #ifdef HAVE_AOPS_RELEASE_FOLIO
 static bool ll_release_folio(struct folio *folio, gfp_t wait)
 {
-	struct page *vmpage = folio_page(folio, 0);
-
-	/* folio_nr_pages(folio) == 1 is fixed with grab_cache_page* */
-	BUG_ON(folio_nr_pages(folio) != 1);
-
-	return do_release_page(vmpage, wait);
+	/* the cl_page of a large folio hangs off its head page */
+	return do_release_page(folio_page(folio, 0), wait);
 }
 #else /* !HAVE_AOPS_RELEASE_FOLIO */
 #ifdef HAVE_RELEASEPAGE_WITH_INT
@@ -478,6 +466,22 @@ ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io, size_t size,
 #define MAX_DIO_SIZE ((MAX_MALLOC / sizeof(struct brw_page) * PAGE_SIZE) & \
 		      ~((size_t)DT_MAX_BRW_SIZE - 1))
 
+/* checksum type of bulk writes, 0 if they are not checksummed */
+static enum cksum_types ll_dio_cksum_type(struct ll_sb_info *sbi)
+{
+	enum cksum_types cksum_type = 0;
+	__u32 vallen = sizeof(cksum_type);
+	int rc;
+
+	if (!test_bit(LL_SBI_CHECKSUM, sbi->ll_flags))
+		return 0;
+
+	rc = obd_get_info(NULL, sbi->ll_dt_exp, sizeof(KEY_CHECKSUM_TYPE),
+			  KEY_CHECKSUM_TYPE, &vallen, &cksum_type);
+
+	return rc ? 0 : cksum_type;
+}
+
 static ssize_t
 ll_direct_IO_impl(struct kiocb *iocb, struct iov_iter *iter, int rw)
 {
@@ -491,6 +495,7 @@ ll_direct_IO_impl(struct kiocb *iocb, struct iov_iter *iter, int rw)
 	size_t count = iov_iter_count(iter);
 	ssize_t tot_bytes = 0, result = 0;
 	loff_t file_offset = iocb->ki_pos;
+	enum cksum_types cksum_type = 0;
 	bool sync_submit = false;
 	bool unaligned = false;
 	struct vvp_io *vio;
@@ -549,6 +554,10 @@ ll_direct_IO_impl(struct kiocb *iocb, struct iov_iter *iter, int rw)
 	LASSERT(ll_dio_aio);
 	LASSERT(ll_dio_aio->cda_iocb == iocb);
 
+	/* T10 guards are generated while copying unaligned writes in */
+	if (unaligned && rw == WRITE)
+		cksum_type = ll_dio_cksum_type(ll_i2sbi(inode));
+
 	/* We cannot do parallel submission of sub-I/Os - for AIO or regular
 	 * DIO - unless lockless because it causes us to release the lock
 	 * early.
@@ -612,6 +621,8 @@ ll_direct_IO_impl(struct kiocb *iocb, struct iov_iter *iter, int rw)
 		}
 
 		if (unaligned && rw == WRITE) {
+			if (cksum_type & OBD_CKSUM_T10_ALL)
+				ll_dio_alloc_guards(pvec, cksum_type);
 			result = ll_dio_user_copy(sdio, iter);
 			if (unlikely(result <= 0)) {
 				cl_sync_io_note(env, &sdio->csd_sync, result);
@@ -741,10 +752,14 @@ static int ll_prepare_partial_page(const struct lu_env *env, struct cl_io *io,
 	 * purposes here we can treat it like i_size.
 	 */
 	if (attr->cat_kms <= offset) {
-		char *kaddr = kmap_atomic(pg->cp_vmpage);
+		unsigned int i;
 
-		memset(kaddr, 0, PAGE_SIZE);
-		kunmap_atomic(kaddr);
+		for (i = 0; i < cl_page_nr(pg); i++) {
+			char *kaddr = kmap_atomic(nth_page(pg->cp_vmpage, i));
+
+			memset(kaddr, 0, PAGE_SIZE);
+			kunmap_atomic(kaddr);
+		}
 		GOTO(out, result = 0);
 	}
 
@@ -778,12 +793,65 @@ static int ll_tiny_write_begin(struct page *vmpage, struct address_space *mappin
 {
 	/* Page must be present, up to date, dirty, and not in writeback. */
 	if (!vmpage || !PageUptodate(vmpage) || !PageDirty(vmpage) ||
-	    PageWriteback(vmpage) || vmpage->mapping != mapping)
+	    PageWriteback(vmpage) || compound_head(vmpage)->mapping != mapping)
 		return -ENODATA;
 
 	return 0;
 }
 
+#ifdef HAVE_FILEMAP_ADD_FOLIO
+/*
+ * Return the large folio queued last by this write if it covers @index,
+ * the copy then goes on into it without locking it again.
+ */
+static struct cl_page *ll_queued_folio(struct vvp_io *vio, pgoff_t index)
+{
+	struct cl_page_list *plist = &vio->u.readwrite.vui_queue;
+	struct cl_page *page;
+
+	if (plist->pl_nr == 0)
+		return NULL;
+
+	page = cl_page_list_last(plist);
+	if (cl_page_nr(page) == 1 || index < cl_page_index(page) ||
+	    index >= cl_page_index(page) + cl_page_nr(page))
+		return NULL;
+
+	return page;
+}
+
+/*
+ * Add a folio of vui_folio_order to the page cache at @pos if the write
+ * covers it as a whole, see vvp_io_rw_lock() for the lock side of it.
+ * Return its locked head page, or NULL to go on with a PAGE_SIZE page.
+ */
+static struct page *ll_grab_cache_folio(struct address_space *mapping,
+					struct cl_io *io, struct vvp_io *vio,
+					loff_t pos)
+{
+	unsigned int order = vio->u.readwrite.vui_folio_order;
+	loff_t size = (loff_t)PAGE_SIZE << order;
+	gfp_t gfp = mapping_gfp_constraint(mapping, ~__GFP_FS);
+	struct folio *folio;
+
+	if (order == 0 || pos & (size - 1) ||
+	    pos + size > io->u.ci_wr.wr.crw_pos + io->u.ci_wr.wr.crw_bytes)
+		return NULL;
+
+	folio = filemap_alloc_folio(gfp | __GFP_NORETRY | __GFP_NOWARN, order);
+	if (folio == NULL)
+		return NULL;
+
+	/* -EEXIST when some of the range is cached already */
+	if (filemap_add_folio(mapping, folio, pos >> PAGE_SHIFT, gfp)) {
+		folio_put(folio);
+		return NULL;
+	}
+
+	return folio_page(folio, 0);
+}
+#endif
+
 static int ll_write_begin(struct file *file, struct address_space *mapping,
 			  loff_t pos, unsigned int len,
 #ifdef HAVE_GRAB_CACHE_PAGE_WRITE_BEGIN_WITH_FLAGS
@@ -799,6 +867,7 @@ static int ll_write_begin(struct file *file, struct address_space *mapping,
 	struct cl_object *clob = ll_i2info(mapping->host)->lli_clob;
 	pgoff_t index = pos >> PAGE_SHIFT;
 	struct page *vmpage = NULL;
+	struct page *head;
 	unsigned from = pos & (PAGE_SIZE - 1);
 	unsigned to = from + len;
 	int result = 0;
@@ -836,8 +905,22 @@ static int ll_write_begin(struct file *file, struct address_space *mapping,
 		}
 	}
 again:
+#ifdef HAVE_FILEMAP_ADD_FOLIO
+	page = ll_queued_folio(vvp_env_io(env), index);
+	if (page != NULL) {
+		/* owned by this IO already, ll_write_end() keeps it queued */
+		vmpage = nth_page(cl_page_vmpage(page), index -
+				  cl_page_index(page));
+		get_page(vmpage);
+		lcc->lcc_page = page;
+		GOTO(out, result = 0);
+	}
+
+	vmpage = ll_grab_cache_folio(mapping, io, vvp_env_io(env), pos);
+#endif
 	/* To avoid deadlock, try to lock page first. */
-	vmpage = grab_cache_page_nowait(mapping, index);
+	if (vmpage == NULL)
+		vmpage = grab_cache_page_nowait(mapping, index);
 
 	if (unlikely(vmpage == NULL ||
 		     PageDirty(vmpage) || PageWriteback(vmpage))) {
@@ -871,8 +954,11 @@ again:
 		}
 	}
 
+	/* a large folio is handled through its head page */
+	head = compound_head(vmpage);
+
 	/* page was truncated */
-	if (mapping != vmpage->mapping) {
+	if (mapping != head->mapping) {
 		CDEBUG(D_VFSTRACE, "page: %lu was truncated\n", index);
 		unlock_page(vmpage);
 		put_page(vmpage);
@@ -880,7 +966,7 @@ again:
 		goto again;
 	}
 
-	page = cl_page_find(env, clob, vmpage->index, vmpage, CPT_CACHEABLE);
+	page = cl_page_find(env, clob, head->index, head, CPT_CACHEABLE);
 	if (IS_ERR(page))
 		GOTO(out, result = PTR_ERR(page));
 
@@ -891,9 +977,13 @@ again:
 	if (!PageUptodate(vmpage)) {
 		/*
 		 * We're completely overwriting an existing page,
-		 * so _don't_ set it up to date until commit_write
+		 * so _don't_ set it up to date until commit_write.
+		 * A large folio counts once this write covers all of it.
 		 */
-		if (from == 0 && to == PAGE_SIZE) {
+		if (from == 0 && index == cl_page_index(page) &&
+		    (cl_page_nr(page) == 1 ? to == PAGE_SIZE :
+		     pos + cl_page_size(page) <= io->u.ci_wr.wr.crw_pos +
+						 io->u.ci_wr.wr.crw_bytes)) {
 			CL_PAGE_HEADER(D_PAGE, env, page, "full page write\n");
 			POISON_PAGE(vmpage, 0x11);
 		} else {
@@ -937,9 +1027,9 @@ static int ll_tiny_write_end(struct file *file, struct address_space *mapping,
 			     loff_t pos, unsigned int len, unsigned int copied,
 			     struct page *vmpage)
 {
-	struct cl_page *clpage = (struct cl_page *) vmpage->private;
+	struct cl_page *clpage = (struct cl_page *)compound_head(vmpage)->private;
 	loff_t kms = pos+copied;
-	loff_t to = kms & (PAGE_SIZE-1) ? kms & (PAGE_SIZE-1) : PAGE_SIZE;
+	loff_t to;
 	__u16 refcheck;
 	struct lu_env *env = cl_env_get(&refcheck);
 	int rc = 0;
@@ -959,6 +1049,9 @@ static int ll_tiny_write_end(struct file *file, struct address_space *mapping,
 	if (copied == 0)
 		goto out_env;
 
+	/* offset in the cl_page, which may be a large folio */
+	to = kms - ((loff_t)cl_page_index(clpage) << PAGE_SHIFT);
+
 	/* Update the underlying size information in the OSC/LOV objects this
 	 * page is part of.
 	 */
@@ -983,7 +1076,8 @@ static int ll_write_end(struct file *file, struct address_space *mapping,
 	struct cl_io *io;
 	struct vvp_io *vio;
 	struct cl_page *page;
-	unsigned from = pos & (PAGE_SIZE - 1);
+	struct cl_page_list *plist;
+	unsigned from;
 	bool unplug = false;
 	int result = 0;
 	ENTRY;
@@ -1005,9 +1099,20 @@ static int ll_write_end(struct file *file, struct address_space *mapping,
 	vio  = vvp_env_io(env);
 
 	LASSERT(cl_page_is_owned(page, io));
-	if (copied > 0) {
-		struct cl_page_list *plist = &vio->u.readwrite.vui_queue;
+	plist = &vio->u.readwrite.vui_queue;
+	/* offset in the cl_page, which may be a large folio */
+	from = pos - ((loff_t)cl_page_index(page) << PAGE_SHIFT);
+	if (plist->pl_nr > 0 && cl_page_list_last(plist) == page) {
+		/* more of the large folio queued by ll_write_begin() */
+		lcc->lcc_page = NULL;
+		if (copied == 0)
+			GOTO(out, result = 0);
 
+		LASSERT(from == vio->u.readwrite.vui_to);
+		vio->u.readwrite.vui_to = from + copied;
+		if (vio->u.readwrite.vui_to < cl_page_size(page))
+			GOTO(out, result = 0);
+	} else if (copied > 0) {
 		lcc->lcc_page = NULL; /* page will be queued */
 
 		/* Add it into write queue */
@@ -1029,6 +1134,11 @@ static int ll_write_end(struct file *file, struct address_space *mapping,
 
 		CL_PAGE_DEBUG(D_VFSTRACE, env, page,
 			      "queued page: %d.\n", plist->pl_nr);
+
+		/* a large folio is committed once it is copied in full */
+		if (cl_page_nr(page) > 1 &&
+		    vio->u.readwrite.vui_to < cl_page_size(page))
+			GOTO(out, result = 0);
 	} else {
 		cl_page_disown(env, io, page);
 
@@ -79,6 +79,8 @@ struct sa_entry {
 	struct qstr			 se_qstr;
 	/* entry fid */
 	struct lu_fid			 se_fid;
+	/* readdir says this is a directory, see ll_statahead_tree_hint() */
+	bool				 se_tree;
 };
 
 static unsigned int sai_generation;
@@ -492,6 +494,172 @@ static void ll_agl_add(struct ll_statahead_info *sai,
 	}
 }
 
+/*
+ * Tree walk mode.  Walkers like find, du or rsync stat the entries of a
+ * directory and then descend into its subdirectories, so each of them would
+ * start statahead cold.  The statahead of the parent predicts the descent
+ * from the readdir type of its entries: the subdirectories are put on
+ * ll_sb_info::ll_sa_tree_list, bounded by ll_sa_tree_window, the statahead
+ * threads read their first directory page ahead of time, and statahead is
+ * started as soon as one of them is opened rather than on the stat of its
+ * first entry.  Predictions pushed out of the window count as misses.
+ */
+static void ll_statahead_tree_hint(struct ll_statahead_info *sai,
+				   struct inode *inode)
+{
+	struct ll_inode_info *plli = ll_i2info(sai->sai_dentry->d_inode);
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_inode_info *old = NULL;
+
+	if (!S_ISDIR(inode->i_mode) || !sbi->ll_sa_tree_window)
+		return;
+
+	spin_lock(&sbi->ll_sa_tree_lock);
+	if (!list_empty(&lli->lli_sa_tree_list) || !igrab(inode)) {
+		spin_unlock(&sbi->ll_sa_tree_lock);
+		return;
+	}
+	if (sbi->ll_sa_tree_count >= sbi->ll_sa_tree_window) {
+		old = list_first_entry(&sbi->ll_sa_tree_list,
+				       struct ll_inode_info, lli_sa_tree_list);
+		list_del_init(&old->lli_sa_tree_list);
+		sbi->ll_sa_tree_count--;
+	}
+	lli->lli_sa_tree_fetched = false;
+	lli->lli_sa_tree_agl = sai->sai_agl_task != NULL;
+	list_add_tail(&lli->lli_sa_tree_list, &sbi->ll_sa_tree_list);
+	sbi->ll_sa_tree_count++;
+	spin_unlock(&sbi->ll_sa_tree_lock);
+
+	CDEBUG(D_READA, "%s: predict descent into "DFID"\n",
+	       sbi->ll_fsname, PFID(&lli->lli_fid));
+
+	if (old) {
+		atomic_inc(&sbi->ll_sa_tree_miss_total);
+		iput(&old->lli_vfs_inode);
+	}
+
+	/* let an idle statahead thread read the directory page */
+	spin_lock(&plli->lli_sa_lock);
+	if (sai->sai_task)
+		wake_up_process(sai->sai_task);
+	spin_unlock(&plli->lli_sa_lock);
+}
+
+/* take @dir off the tree walk window, return true if it was predicted */
+static bool ll_statahead_tree_take(struct inode *dir, bool *agl)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	bool hit = false;
+
+	if (list_empty(&lli->lli_sa_tree_list))
+		return false;
+
+	spin_lock(&sbi->ll_sa_tree_lock);
+	if (!list_empty(&lli->lli_sa_tree_list)) {
+		list_del_init(&lli->lli_sa_tree_list);
+		sbi->ll_sa_tree_count--;
+		*agl = lli->lli_sa_tree_agl;
+		hit = true;
+	}
+	spin_unlock(&sbi->ll_sa_tree_lock);
+
+	if (hit) {
+		atomic_inc(&sbi->ll_sa_tree_hit_total);
+		iput(dir);
+	}
+
+	return hit;
+}
+
+/* get a reference on a predicted directory whose page was not read yet */
+static struct inode *ll_statahead_tree_next(struct ll_sb_info *sbi)
+{
+	struct ll_inode_info *lli;
+	struct inode *dir = NULL;
+
+	spin_lock(&sbi->ll_sa_tree_lock);
+	list_for_each_entry(lli, &sbi->ll_sa_tree_list, lli_sa_tree_list) {
+		if (!lli->lli_sa_tree_fetched) {
+			lli->lli_sa_tree_fetched = true;
+			dir = igrab(&lli->lli_vfs_inode);
+			if (dir)
+				break;
+		}
+	}
+	spin_unlock(&sbi->ll_sa_tree_lock);
+
+	return dir;
+}
+
+static bool ll_statahead_tree_pending(struct ll_sb_info *sbi)
+{
+	struct ll_inode_info *lli;
+	bool pending = false;
+
+	spin_lock(&sbi->ll_sa_tree_lock);
+	list_for_each_entry(lli, &sbi->ll_sa_tree_list, lli_sa_tree_list) {
+		if (!lli->lli_sa_tree_fetched) {
+			pending = true;
+			break;
+		}
+	}
+	spin_unlock(&sbi->ll_sa_tree_lock);
+
+	return pending;
+}
+
+/* read the first page of the predicted directories, it stays cached */
+static void ll_statahead_tree_prefetch(struct ll_statahead_info *sai)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(sai->sai_dentry->d_inode);
+	struct md_op_data *op_data;
+	struct inode *dir;
+	struct page *page;
+
+	/* matches smp_store_release() in ll_deauthorize_statahead() */
+	while (smp_load_acquire(&sai->sai_task) &&
+	       (dir = ll_statahead_tree_next(sbi)) != NULL) {
+		op_data = ll_prep_md_op_data(NULL, dir, dir, NULL, 0, 0,
+					     LUSTRE_OPC_ANY, dir);
+		if (IS_ERR(op_data)) {
+			iput(dir);
+			break;
+		}
+
+		page = ll_get_dir_page(dir, op_data, 0, NULL);
+		ll_unlock_md_op_lsm(op_data);
+		if (!IS_ERR(page))
+			ll_release_page(dir, page, false);
+		CDEBUG(D_READA, "%s: prefetch dir "DFID": rc = %ld\n",
+		       sbi->ll_fsname, PFID(ll_inode2fid(dir)),
+		       IS_ERR(page) ? PTR_ERR(page) : 0);
+
+		ll_finish_md_op_data(op_data);
+		iput(dir);
+	}
+}
+
+/* drop all predictions, when tree walk mode is disabled or at umount */
+void ll_statahead_tree_fini(struct ll_sb_info *sbi)
+{
+	struct ll_inode_info *lli;
+
+	spin_lock(&sbi->ll_sa_tree_lock);
+	while ((lli = list_first_entry_or_null(&sbi->ll_sa_tree_list,
+					       struct ll_inode_info,
+					       lli_sa_tree_list)) != NULL) {
+		list_del_init(&lli->lli_sa_tree_list);
+		sbi->ll_sa_tree_count--;
+		spin_unlock(&sbi->ll_sa_tree_lock);
+		iput(&lli->lli_vfs_inode);
+		spin_lock(&sbi->ll_sa_tree_lock);
+	}
+	spin_unlock(&sbi->ll_sa_tree_lock);
+}
+
 /* Allocate sax */
 static struct ll_statahead_context *ll_sax_alloc(struct inode *dir)
 {
@@ -823,6 +991,8 @@ static void ll_statahead_interpret_work(struct work_struct *work)
 
 	if (agl_should_run(sai, child))
 		ll_agl_add(sai, child, entry->se_index);
+	if (entry->se_tree)
+		ll_statahead_tree_hint(sai, child);
 out:
 	ll_statahead_interpret_fini(lli, sai, item, entry, pill->rc_req, rc);
 }
@@ -1000,9 +1170,10 @@ static int sa_revalidate(struct inode *dir, struct sa_entry *entry,
 	RETURN(rc);
 }
 
-/* async stat for file with @name */
+/* async stat for file with @name, @tree if readdir says it is a directory */
 static void sa_statahead(struct ll_statahead_info *sai, struct dentry *parent,
-			 const char *name, int len, const struct lu_fid *fid)
+			 const char *name, int len, const struct lu_fid *fid,
+			 bool tree)
 {
 	struct inode *dir = parent->d_inode;
 	struct dentry *dentry = NULL;
@@ -1014,6 +1185,7 @@ static void sa_statahead(struct ll_statahead_info *sai, struct dentry *parent,
 	entry = sa_alloc(parent, sai, sai->sai_index, name, len, fid);
 	if (IS_ERR(entry))
 		RETURN_EXIT;
+	entry->se_tree = tree;
 
 	dentry = d_lookup(parent, &entry->se_qstr);
 	if (!dentry) {
@@ -1022,6 +1194,8 @@ static void sa_statahead(struct ll_statahead_info *sai, struct dentry *parent,
 		rc = sa_revalidate(dir, entry, dentry);
 		if (rc == 1 && agl_should_run(sai, dentry->d_inode))
 			ll_agl_add(sai, dentry->d_inode, entry->se_index);
+		if (rc == 1 && tree)
+			ll_statahead_tree_hint(sai, dentry->d_inode);
 	}
 
 	if (dentry)
@@ -1234,9 +1408,10 @@ static int ll_statahead_by_list(struct dentry *parent)
 			}
 
 			/*
-			 * don't stat-ahead first entry.
+			 * don't stat-ahead first entry, unless statahead was
+			 * started at opendir and nobody is looking it up yet.
 			 */
-			if (unlikely(++first == 1))
+			if (unlikely(++first == 1) && !sai->sai_tree)
 				continue;
 
 			fid_le_to_cpu(&fid, &ent->lde_fid);
@@ -1289,7 +1464,8 @@ static int ll_statahead_by_list(struct dentry *parent)
 				namelen = lltr.len;
 			}
 
-			sa_statahead(sai, parent, name, namelen, &fid);
+			sa_statahead(sai, parent, name, namelen, &fid,
+				     S_DT(lu_dirent_type_get(ent)) == DT_DIR);
 			llcrypt_fname_free_buffer(&lltr);
 		}
 
@@ -1297,6 +1473,8 @@ static int ll_statahead_by_list(struct dentry *parent)
 		ll_release_page(dir, page,
 				le32_to_cpu(dp->ldp_flags) & LDF_COLLIDE);
 
+		ll_statahead_tree_prefetch(sai);
+
 		if (sa_low_hit(sai)) {
 			rc = -EFAULT;
 			atomic_inc(&sbi->ll_sa_wrong);
@@ -1374,7 +1552,7 @@ static int ll_statahead_by_fname(struct ll_statahead_info *sai,
 		}
 		__set_current_state(TASK_RUNNING);
 
-		sa_statahead(sai, parent, fname, len + numlen, NULL);
+		sa_statahead(sai, parent, fname, len + numlen, NULL, false);
 		if (++i >= sai->sai_fend)
 			break;
 	}
@@ -1432,11 +1610,17 @@ static int ll_statahead_thread(void *arg)
 
 	/*
 	 * statahead is finished, but statahead entries need to be cached, wait
-	 * for file release closedir() call to stop me.
+	 * for file release closedir() call to stop me.  Meanwhile read ahead
+	 * the directories predicted by the last replies.
 	 */
 	while (({set_current_state(TASK_IDLE);
 		/* matches smp_store_release() in ll_deauthorize_statahead() */
 		smp_load_acquire(&sai->sai_task); })) {
+		if (ll_statahead_tree_pending(sbi)) {
+			__set_current_state(TASK_RUNNING);
+			ll_statahead_tree_prefetch(sai);
+			continue;
+		}
 		schedule();
 	}
 	__set_current_state(TASK_RUNNING);
@@ -1476,10 +1660,35 @@ out_stop_agl:
 	return rc;
 }
 
+enum {
+	/**
+	 * not first dirent, or is "."
+	 */
+	LS_NOT_FIRST_DE = 0,
+	/**
+	 * the first non-hidden dirent
+	 */
+	LS_FIRST_DE,
+	/**
+	 * the first hidden dirent, that is "."
+	 */
+	LS_FIRST_DOT_DE,
+	/**
+	 * no dirent, started at opendir for a tree walk
+	 */
+	LS_TREE_DE,
+};
+
+static int __start_statahead_thread(struct inode *dir, struct dentry *parent,
+				    int first, bool agl);
+
 /* authorize opened dir handle @key to statahead */
 void ll_authorize_statahead(struct inode *dir, void *key)
 {
 	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_file_data *fd = key;
+	bool authorized = false;
+	bool agl = false;
 
 	spin_lock(&lli->lli_sa_lock);
 	if (!lli->lli_opendir_key && !lli->lli_sai) {
@@ -1490,8 +1699,15 @@ void ll_authorize_statahead(struct inode *dir, void *key)
 		lli->lli_opendir_key = key;
 		lli->lli_opendir_pid = current->pid;
 		lli->lli_sa_enabled = 1;
+		authorized = true;
 	}
 	spin_unlock(&lli->lli_sa_lock);
+
+	/* a tree walk descends into a predicted directory, start now */
+	if (ll_statahead_tree_take(dir, &agl) && authorized &&
+	    ll_i2sbi(dir)->ll_sa_max)
+		__start_statahead_thread(dir, file_dentry(fd->fd_file),
+					 LS_TREE_DE, agl);
 }
 
 static void ll_deauthorize_statahead_fname(struct inode *dir, void *key)
@@ -1559,21 +1775,6 @@ void ll_deauthorize_statahead(struct inode *dir, void *key)
 	spin_unlock(&lli->lli_sa_lock);
 }
 
-enum {
-	/**
-	 * not first dirent, or is "."
-	 */
-	LS_NOT_FIRST_DE = 0,
-	/**
-	 * the first non-hidden dirent
-	 */
-	LS_FIRST_DE,
-	/**
-	 * the first hidden dirent, that is "."
-	 */
-	LS_FIRST_DOT_DE
-};
-
 /* file is first dirent under @dir */
 static int is_first_dirent(struct inode *dir, struct dentry *dentry)
 {
@@ -1860,40 +2061,25 @@ out:
 	RETURN(rc);
 }
 
-/**
- * start statahead thread
- *
- * \param[in] dir	parent directory
- * \param[in] dentry	dentry that triggers statahead, normally the first
- *			dirent under @dir
- * \param[in] agl	indicate whether AGL is needed
- * \retval		-EAGAIN on success, because when this function is
- *			called, it's already in lookup call, so client should
- *			do it itself instead of waiting for statahead thread
- *			to do it asynchronously.
- * \retval		negative number upon error
+/*
+ * start statahead thread for @dir, whose dentry is @parent.  @first tells
+ * whether hidden entries are stated (LS_FIRST_DOT_DE), or that statahead
+ * is started at opendir for a tree walk (LS_TREE_DE), in which case the
+ * first entry is stated too.  Returns -EAGAIN on success.
  */
-static int start_statahead_thread(struct inode *dir, struct dentry *dentry,
-				  bool agl)
+static int __start_statahead_thread(struct inode *dir, struct dentry *parent,
+				    int first, bool agl)
 {
 	int node = cfs_cpt_spread_node(cfs_cpt_tab, CFS_CPT_ANY);
 	struct ll_inode_info *lli = ll_i2info(dir);
 	struct ll_statahead_info *sai = NULL;
 	struct ll_statahead_context *ctx = NULL;
-	struct dentry *parent = dentry->d_parent;
 	struct task_struct *task;
 	struct ll_sb_info *sbi = ll_i2sbi(parent->d_inode);
-	int first = LS_FIRST_DE;
 	int rc = 0;
 
 	ENTRY;
 
-	/* I am the "lli_opendir_pid" owner, only me can set "lli_sai". */
-	first = is_first_dirent(dir, dentry);
-	if (first == LS_NOT_FIRST_DE)
-		/* It is not "ls -{a}l" operation, no need statahead for it. */
-		GOTO(out, rc = -EFAULT);
-
 	if (unlikely(atomic_inc_return(&sbi->ll_sa_running) >
 				       sbi->ll_sa_running_max)) {
 		CDEBUG(D_READA,
@@ -1909,7 +2095,8 @@ static int start_statahead_thread(struct inode *dir, struct dentry *dentry,
 	if (!ctx)
 		GOTO(out, rc = -ENOMEM);
 
-	sai->sai_ls_all = (first == LS_FIRST_DOT_DE);
+	sai->sai_ls_all = (first == LS_FIRST_DOT_DE || first == LS_TREE_DE);
+	sai->sai_tree = (first == LS_TREE_DE);
 
 	/*
 	 * if current lli_opendir_key was deauthorized, or dir re-opened by
@@ -1946,6 +2133,8 @@ static int start_statahead_thread(struct inode *dir, struct dentry *dentry,
 		ll_start_agl(parent, sai);
 
 	atomic_inc(&sbi->ll_sa_total);
+	if (sai->sai_tree)
+		atomic_inc(&sbi->ll_sa_tree_total);
 	sai->sai_task = task;
 
 	wake_up_process(task);
@@ -1971,12 +2160,46 @@ out:
 	if (ctx)
 		ll_sax_free(ctx);
 
-	if (first != LS_NOT_FIRST_DE)
-		atomic_dec(&sbi->ll_sa_running);
+	atomic_dec(&sbi->ll_sa_running);
 
 	RETURN(rc);
 }
 
+/**
+ * start statahead thread
+ *
+ * \param[in] dir	parent directory
+ * \param[in] dentry	dentry that triggers statahead, normally the first
+ *			dirent under @dir
+ * \param[in] agl	indicate whether AGL is needed
+ * \retval		-EAGAIN on success, because when this function is
+ *			called, it's already in lookup call, so client should
+ *			do it itself instead of waiting for statahead thread
+ *			to do it asynchronously.
+ * \retval		negative number upon error
+ */
+static int start_statahead_thread(struct inode *dir, struct dentry *dentry,
+				  bool agl)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	int first;
+
+	ENTRY;
+
+	/* I am the "lli_opendir_pid" owner, only me can set "lli_sai". */
+	first = is_first_dirent(dir, dentry);
+	if (first == LS_NOT_FIRST_DE) {
+		/* It is not "ls -{a}l" operation, no need statahead for it. */
+		spin_lock(&lli->lli_sa_lock);
+		if (lli->lli_opendir_pid == current->pid)
+			lli->lli_sa_enabled = 0;
+		spin_unlock(&lli->lli_sa_lock);
+		RETURN(-EFAULT);
+	}
+
+	RETURN(__start_statahead_thread(dir, dentry->d_parent, first, agl));
+}
+
 /*
  * Check whether statahead for @dir was started.
  */
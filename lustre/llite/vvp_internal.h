@@ -88,6 +88,9 @@ struct vvp_io {
 			unsigned long vui_read;
 			int vui_from;
 			int vui_to;
+			/* order of the folios write may add, under a lock
+			 * rounded to CL_PAGE_MAX_NR pages */
+			unsigned int vui_folio_order;
 		} readwrite; /* normal io */
 	} u;
 
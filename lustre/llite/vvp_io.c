@@ -552,10 +552,22 @@ static void vvp_io_update_iov(const struct lu_env *env,
 	iov_iter_truncate(vio->vui_iter, size);
 }
 
+/* Widen [@start, @end] to whole large folios of CL_PAGE_MAX_NR pages */
+static void vvp_io_folio_extent(loff_t *start, loff_t *end)
+{
+	loff_t size = (loff_t)CL_PAGE_MAX_NR << PAGE_SHIFT;
+
+	*start = round_down(*start, size);
+	if (*end != OBD_OBJECT_EOF)
+		*end = round_up(*end + 1, size) - 1;
+}
+
 static int vvp_io_rw_lock(const struct lu_env *env, struct cl_io *io,
                           enum cl_lock_mode mode, loff_t start, loff_t end)
 {
 	struct vvp_io *vio = vvp_env_io(env);
+	struct inode *inode = vvp_object_inode(io->ci_obj);
+	struct ll_inode_info *lli = ll_i2info(inode);
 	int result;
 	int ast_flags = 0;
 
@@ -579,6 +591,18 @@ static int vvp_io_rw_lock(const struct lu_env *env, struct cl_io *io,
 			ast_flags |= CEF_NEVER;
 	}
 
+	/* buffered writes may add large folios, see ll_write_begin() */
+	vio->u.readwrite.vui_folio_order = 0;
+	if (io->ci_type == CIT_WRITE && !(ast_flags & CEF_NEVER) &&
+	    !IS_ENCRYPTED(inode) && ll_i2sbi(inode)->ll_folio_order > 0) {
+		vio->u.readwrite.vui_folio_order =
+			ll_i2sbi(inode)->ll_folio_order;
+		set_bit(LLIF_LARGE_FOLIO, &lli->lli_flags);
+	}
+	/* a large folio is covered by the lock as a whole */
+	if (test_bit(LLIF_LARGE_FOLIO, &lli->lli_flags))
+		vvp_io_folio_extent(&start, &end);
+
 	result = vvp_mmap_locks(env, vio, io);
 	if (result == 0)
 		result = vvp_io_one_lock(env, io, ast_flags, mode, start, end);
@@ -604,14 +628,22 @@ static int vvp_io_fault_lock(const struct lu_env *env,
 {
         struct cl_io *io   = ios->cis_io;
         struct vvp_io *vio = cl2vvp_io(env, ios);
+	struct inode *inode = vvp_object_inode(io->ci_obj);
+	pgoff_t start = io->u.ci_fault.ft_index;
+	pgoff_t end = start;
+
+	/* the faulting page may be part of a large folio */
+	if (test_bit(LLIF_LARGE_FOLIO, &ll_i2info(inode)->lli_flags)) {
+		start = round_down(start, CL_PAGE_MAX_NR);
+		end = start + CL_PAGE_MAX_NR - 1;
+	}
         /*
          * XXX LDLM_FL_CBPENDING
          */
 	return vvp_io_one_lock_index(env,
 				     io, 0,
 				     vvp_mode_from_vma(vio->u.fault.ft_vma),
-				     io->u.ci_fault.ft_index,
-				     io->u.ci_fault.ft_index);
+				     start, end);
 }
 
 static int vvp_io_write_lock(const struct lu_env *env,
@@ -932,26 +964,41 @@ out:
 	return result;
 }
 
+/* Bytes covered by the pages of @plist, large ones included */
+static unsigned int vvp_page_list_bytes(struct cl_page_list *plist)
+{
+	struct cl_page *page;
+	unsigned int bytes = 0;
+
+	cl_page_list_for_each(page, plist)
+		bytes += cl_page_size(page);
+
+	return bytes;
+}
+
 static int vvp_io_commit_sync(const struct lu_env *env, struct cl_io *io,
 			      struct cl_page_list *plist, int from, int to)
 {
 	struct cl_2queue *queue = &io->ci_queue;
 	struct cl_page *page;
 	unsigned int bytes = 0;
+	unsigned int last_size;
 	int rc = 0;
 	ENTRY;
 
 	if (plist->pl_nr == 0)
 		RETURN(0);
 
-	if (from > 0 || to != PAGE_SIZE) {
+	last_size = cl_page_size(cl_page_list_last(plist));
+	if (from > 0 || to != last_size) {
 		page = cl_page_list_first(plist);
 		if (plist->pl_nr == 1) {
 			cl_page_clip(env, page, from, to);
 		} else {
 			if (from > 0)
-				cl_page_clip(env, page, from, PAGE_SIZE);
-			if (to != PAGE_SIZE) {
+				cl_page_clip(env, page, from,
+					     cl_page_size(page));
+			if (to != last_size) {
 				page = cl_page_list_last(plist);
 				cl_page_clip(env, page, 0, to);
 			}
@@ -969,14 +1016,14 @@ static int vvp_io_commit_sync(const struct lu_env *env, struct cl_io *io,
 
 	if (rc == 0) {
 		/* calculate bytes */
-		bytes = plist->pl_nr << PAGE_SHIFT;
-		bytes -= from + PAGE_SIZE - to;
+		bytes = vvp_page_list_bytes(plist);
+		bytes -= from + last_size - to;
 
 		while (plist->pl_nr > 0) {
 			page = cl_page_list_first(plist);
 			cl_page_list_del(env, plist, page);
 
-			cl_page_clip(env, page, 0, PAGE_SIZE);
+			cl_page_clip(env, page, 0, cl_page_size(page));
 
 			SetPageUptodate(cl_page_vmpage(page));
 			cl_page_disown(env, io, page);
@@ -1053,6 +1100,17 @@ static void vvp_set_pagevec_dirty(struct pagevec *pvec)
 		 "mapping must be set. page %p, page->private (cl_page) %p\n",
 		 page, (void *) page->private);
 
+	/* ll_account_page_dirtied() accounts a single page, leave large
+	 * folios to the generic code
+	 */
+	for (i = 0; i < count; i++) {
+		if (PageCompound(pvec->pages[i])) {
+			for (i = 0; i < count; i++)
+				__set_page_dirty_nobuffers(pvec->pages[i]);
+			RETURN_EXIT;
+		}
+	}
+
 	/*
 	 * kernels without HAVE_KALLSYMS_LOOKUP_NAME also don't have
 	 * account_dirty_page exported, and if we can't access that symbol,
@@ -1158,16 +1216,10 @@ static bool page_list_sanity_check(struct cl_object *obj,
 	pgoff_t index = CL_PAGE_EOF;
 
 	cl_page_list_for_each(page, plist) {
-		if (index == CL_PAGE_EOF) {
-			index = cl_page_index(page);
-			continue;
-		}
-
-		++index;
-		if (index == cl_page_index(page))
-			continue;
+		if (index != CL_PAGE_EOF && index != cl_page_index(page))
+			return false;
 
-		return false;
+		index = cl_page_index(page) + cl_page_nr(page);
 	}
 	return true;
 }
@@ -1183,16 +1235,43 @@ int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io)
 	int rc = 0;
 	int bytes = 0;
 	unsigned int npages = vio->u.readwrite.vui_queue.pl_nr;
+	unsigned int queued;
+	unsigned int last_size;
 	ENTRY;
 
 	if (npages == 0)
 		RETURN(0);
 
+	page = cl_page_list_last(queue);
+	if (cl_page_nr(page) > 1 &&
+	    vio->u.readwrite.vui_to < cl_page_size(page) &&
+	    !PageUptodate(cl_page_vmpage(page))) {
+		/* the copy into a new large folio stopped short, the rest
+		 * of it holds no data and must not go to the cache */
+		CL_PAGE_DEBUG(D_VFSTRACE, env, page,
+			      "drop partial folio: %d\n",
+			      vio->u.readwrite.vui_to);
+		cl_page_list_del(env, queue, page);
+		cl_page_discard(env, io, page);
+		cl_page_disown(env, io, page);
+		lu_ref_del(&page->cp_reference, "cl_io", io);
+		cl_page_put(env, page);
+
+		if (--npages == 0) {
+			cl_page_list_fini(env, queue);
+			RETURN(-EFAULT);
+		}
+		vio->u.readwrite.vui_to =
+			cl_page_size(cl_page_list_last(queue));
+	}
+
 	CDEBUG(D_VFSTRACE, "commit async pages: %d, from %d, to %d\n",
 		npages, vio->u.readwrite.vui_from, vio->u.readwrite.vui_to);
 
 	LASSERT(page_list_sanity_check(obj, queue));
 
+	queued = vvp_page_list_bytes(queue);
+	last_size = cl_page_size(cl_page_list_last(queue));
 	/* submit IO with async write */
 	rc = cl_io_commit_async(env, io, queue,
 				vio->u.readwrite.vui_from,
@@ -1201,12 +1280,12 @@ int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io)
 	npages -= queue->pl_nr; /* already committed pages */
 	if (npages > 0) {
 		/* calculate how many bytes were written */
-		bytes = npages << PAGE_SHIFT;
+		bytes = queued - vvp_page_list_bytes(queue);
 
 		/* first page */
 		bytes -= vio->u.readwrite.vui_from;
 		if (queue->pl_nr == 0) /* last page */
-			bytes -= PAGE_SIZE - vio->u.readwrite.vui_to;
+			bytes -= last_size - vio->u.readwrite.vui_to;
 		LASSERTF(bytes > 0, "bytes = %d, pages = %d\n", bytes, npages);
 
 		vio->u.readwrite.vui_written += bytes;
@@ -1526,7 +1605,7 @@ static int vvp_io_fault_start(const struct lu_env *env,
 	size = i_size_read(inode);
         /* Though we have already held a cl_lock upon this page, but
          * it still can be truncated locally. */
-	if (unlikely((vmpage->mapping != inode->i_mapping) ||
+	if (unlikely((compound_head(vmpage)->mapping != inode->i_mapping) ||
 		     (page_offset(vmpage) > size))) {
                 CDEBUG(D_PAGE, "llite: fault and truncate race happened!\n");
 
@@ -1574,7 +1653,7 @@ static int vvp_io_fault_start(const struct lu_env *env,
 		wait_on_page_writeback(vmpage);
 		if (!PageDirty(vmpage)) {
 			struct cl_page_list *plist = &vio->u.fault.ft_queue;
-			int to = PAGE_SIZE;
+			int to = cl_page_size(page);
 
 			/* vvp_page_assume() calls wait_on_page_writeback(). */
 			cl_page_assume(env, io, page);
@@ -1583,8 +1662,9 @@ static int vvp_io_fault_start(const struct lu_env *env,
 			cl_page_list_add(plist, page, true);
 
 			/* size fixup */
-			if (last_index == cl_page_index(page))
-				to = ((size - 1) & ~PAGE_MASK) + 1;
+			if (last_index < cl_page_index(page) + cl_page_nr(page))
+				to = size - ((loff_t)cl_page_index(page) <<
+					     PAGE_SHIFT);
 
 			/* Do not set Dirty bit here so that in case IO is
 			 * started before the page is really made dirty, we
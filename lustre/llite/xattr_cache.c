@@ -33,30 +33,65 @@
 #define DEBUG_SUBSYSTEM S_LLITE
 
 #include <linux/fs.h>
+#include <linux/jhash.h>
 #include <linux/sched.h>
 #include <linux/mm.h>
 #include <obd_support.h>
 #include <lustre_dlm.h>
 #include "llite_internal.h"
 
-/* If we ever have hundreds of extended attributes, we might want to consider
- * using a hash or a tree structure instead of list for faster lookups.
+/*
+ * The cached xattrs of an inode are kept in a struct ll_xattr_cache: the
+ * names and values are packed in a single arena, and a compact array of
+ * ll_xattr_entry sorted by name hash indexes them, so that getxattr does a
+ * binary search instead of walking a list.  listxattr reports the names in
+ * the reverse of the order they were added, as the list based cache did,
+ * which is kept in a second array of entry indexes.
+ * Deleted entries leave holes in the arena which are reclaimed when it is
+ * resized.
+ *
+ * The memory used by all caches of a mount is accounted in
+ * ll_sb_info::ll_xattr_cache_bytes and bounded by ll_xattr_cache_max.
+ * Filled caches are kept on ll_sb_info::ll_xattr_lru and the coldest ones
+ * are emptied when the limit is exceeded; they are refilled from the MDT
+ * on the next access.
  */
 struct ll_xattr_entry {
-	struct list_head	xe_list;    /* protected with
-					     * lli_xattrs_list_rwsem */
-	char			*xe_name;   /* xattr name, \0-terminated */
-	char			*xe_value;  /* xattr value */
-	unsigned		xe_namelen; /* strlen(xe_name) + 1 */
-	unsigned		xe_vallen;  /* xattr value length */
+	__u32			xe_hash;    /* jhash() of the name */
+	__u32			xe_offset;  /* of the name in xc_arena */
+	__u32			xe_namelen; /* strlen(name) + 1 */
+	__u32			xe_vallen;  /* xattr value length */
+};
+
+struct ll_xattr_cache {
+	struct list_head	 xc_lru;     /* on ll_sb_info::ll_xattr_lru
+					      * while the cache is filled */
+	struct ll_inode_info	*xc_lli;
+	struct ll_xattr_entry	*xc_entries; /* sorted by xe_hash */
+	__u32			*xc_order;   /* xc_entries indexes, in
+					      * insertion order */
+	char			*xc_arena;   /* names, each followed by
+					      * its value */
+	unsigned int		 xc_count;   /* entries in use */
+	unsigned int		 xc_max;     /* entries allocated */
+	unsigned int		 xc_used;    /* arena bytes used */
+	unsigned int		 xc_freed;   /* of which by deleted xattrs */
+	unsigned int		 xc_size;    /* arena bytes allocated */
+	long			 xc_bytes;   /* accounted in the sbi */
+	bool			 xc_referenced; /* hit since last LRU scan */
 };
 
+#define XATTR_CACHE_MIN_ENTRIES	8
+#define XATTR_CACHE_MIN_ARENA	256
+/* caches looked at per ll_xattr_cache_shrink() call */
+#define XATTR_CACHE_SHRINK_SCAN	128
+
 static struct kmem_cache *xattr_kmem;
 static struct lu_kmem_descr xattr_caches[] = {
 	{
 		.ckd_cache = &xattr_kmem,
 		.ckd_name  = "xattr_kmem",
-		.ckd_size  = sizeof(struct ll_xattr_entry)
+		.ckd_size  = sizeof(struct ll_xattr_cache)
 	},
 	{
 		.ckd_cache = NULL
@@ -73,46 +108,161 @@ void ll_xattr_fini(void)
 	lu_kmem_fini(xattr_caches);
 }
 
+static inline char *ll_xattr_name(struct ll_xattr_cache *xc,
+				  struct ll_xattr_entry *xe)
+{
+	return xc->xc_arena + xe->xe_offset;
+}
+
+static inline char *ll_xattr_value(struct ll_xattr_cache *xc,
+				   struct ll_xattr_entry *xe)
+{
+	return xc->xc_arena + xe->xe_offset + xe->xe_namelen;
+}
+
+/**
+ * Update the memory accounted for @xc in the sbi after it was resized.
+ */
+static void ll_xattr_cache_account(struct ll_sb_info *sbi,
+				   struct ll_xattr_cache *xc)
+{
+	long bytes = sizeof(*xc) + xc->xc_size +
+		     xc->xc_max * (sizeof(struct ll_xattr_entry) +
+				   sizeof(*xc->xc_order));
+
+	atomic_long_add(bytes - xc->xc_bytes, &sbi->ll_xattr_cache_bytes);
+	xc->xc_bytes = bytes;
+}
+
+static void ll_xattr_cache_lru_add(struct ll_sb_info *sbi,
+				   struct ll_xattr_cache *xc)
+{
+	spin_lock(&sbi->ll_xattr_lru_lock);
+	if (list_empty(&xc->xc_lru))
+		list_add(&xc->xc_lru, &sbi->ll_xattr_lru);
+	spin_unlock(&sbi->ll_xattr_lru_lock);
+}
+
+static void ll_xattr_cache_lru_del(struct ll_sb_info *sbi,
+				   struct ll_xattr_cache *xc)
+{
+	spin_lock(&sbi->ll_xattr_lru_lock);
+	list_del_init(&xc->xc_lru);
+	spin_unlock(&sbi->ll_xattr_lru_lock);
+}
+
 /**
  * Initializes xattr cache for an inode.
  *
- * This initializes the xattr list and marks cache presence.
+ * This allocates the xattr index and marks cache presence.
+ *
+ * \retval 0       success
+ * \retval -ENOMEM if no memory could be allocated for the cache
  */
-static void ll_xattr_cache_init(struct ll_inode_info *lli)
+static int ll_xattr_cache_init(struct ll_inode_info *lli)
 {
+	struct ll_xattr_cache *xc;
+
 	ENTRY;
 
 	LASSERT(lli != NULL);
 
-	INIT_LIST_HEAD(&lli->lli_xattrs);
+	OBD_SLAB_ALLOC_PTR_GFP(xc, xattr_kmem, GFP_NOFS);
+	if (xc == NULL)
+		RETURN(-ENOMEM);
+
+	INIT_LIST_HEAD(&xc->xc_lru);
+	xc->xc_lli = lli;
+	lli->lli_xattrs = xc;
+	ll_xattr_cache_account(ll_i2sbi(ll_info2i(lli)), xc);
 	set_bit(LLIF_XATTR_CACHE, &lli->lli_flags);
+
+	RETURN(0);
+}
+
+/**
+ * Move the live xattrs of @xc to a new arena of @size bytes.
+ *
+ * This drops the holes left by deleted xattrs.  @size must be large enough
+ * for the live xattrs; a zero @size frees the arena.
+ *
+ * \retval 0       success
+ * \retval -ENOMEM if the new arena could not be allocated, @xc is unchanged
+ */
+static int ll_xattr_cache_resize(struct ll_xattr_cache *xc, unsigned int size)
+{
+	struct ll_xattr_entry *xe;
+	char *arena = NULL;
+	unsigned int used = 0;
+	unsigned int i;
+
+	LASSERT(size >= xc->xc_used - xc->xc_freed);
+
+	if (size) {
+		OBD_ALLOC_LARGE(arena, size);
+		if (arena == NULL)
+			return -ENOMEM;
+	}
+
+	for (i = 0; i < xc->xc_count; i++) {
+		xe = &xc->xc_entries[i];
+		memcpy(arena + used, ll_xattr_name(xc, xe),
+		       xe->xe_namelen + xe->xe_vallen);
+		xe->xe_offset = used;
+		used += xe->xe_namelen + xe->xe_vallen;
+	}
+
+	if (xc->xc_arena)
+		OBD_FREE_LARGE(xc->xc_arena, xc->xc_size);
+	xc->xc_arena = arena;
+	xc->xc_size = size;
+	xc->xc_used = used;
+	xc->xc_freed = 0;
+
+	return 0;
 }
 
 /**
  *  This looks for a specific extended attribute.
  *
- *  Find in @cache and return @xattr_name attribute in @xattr,
- *  for the NULL @xattr_name return the first cached @xattr.
+ *  Find in @xc and return @xattr_name attribute in @xattr, and the index
+ *  where an entry of that name would be inserted in @pos.
  *
  *  \retval 0        success
  *  \retval -ENODATA if not found
  */
-static int ll_xattr_cache_find(struct list_head *cache,
+static int ll_xattr_cache_find(struct ll_xattr_cache *xc,
 			       const char *xattr_name,
-			       struct ll_xattr_entry **xattr)
+			       struct ll_xattr_entry **xattr,
+			       unsigned int *pos)
 {
+	unsigned int namelen = strlen(xattr_name) + 1;
+	__u32 hash = jhash(xattr_name, namelen, 0);
 	struct ll_xattr_entry *entry;
+	unsigned int lo = 0;
+	unsigned int hi = xc->xc_count;
+	unsigned int mid;
 
 	ENTRY;
 
-	list_for_each_entry(entry, cache, xe_list) {
-		/* xattr_name == NULL means look for any entry */
-		if (xattr_name == NULL ||
-		    strcmp(xattr_name, entry->xe_name) == 0) {
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (xc->xc_entries[mid].xe_hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (pos)
+		*pos = lo;
+
+	for (; lo < xc->xc_count && xc->xc_entries[lo].xe_hash == hash; lo++) {
+		entry = &xc->xc_entries[lo];
+		if (entry->xe_namelen == namelen &&
+		    memcmp(ll_xattr_name(xc, entry), xattr_name, namelen) == 0) {
 			*xattr = entry;
 			CDEBUG(D_CACHE, "find: [%s]=%.*s\n",
-			       entry->xe_name, entry->xe_vallen,
-			       entry->xe_value);
+			       xattr_name, entry->xe_vallen,
+			       ll_xattr_value(xc, entry));
 			RETURN(0);
 		}
 	}
@@ -129,16 +279,22 @@ static int ll_xattr_cache_find(struct list_head *cache,
  * \retval -ENOMEM if no memory could be allocated for the cached attr
  * \retval -EPROTO if duplicate xattr is being added
  */
-static int ll_xattr_cache_add(struct list_head *cache,
+static int ll_xattr_cache_add(struct ll_sb_info *sbi,
+			      struct ll_xattr_cache *xc,
 			      const char *xattr_name,
 			      const char *xattr_val,
-			      unsigned xattr_val_len)
+			      unsigned int xattr_val_len)
 {
+	unsigned int namelen = strlen(xattr_name) + 1;
+	unsigned int len = namelen + xattr_val_len;
 	struct ll_xattr_entry *xattr;
+	unsigned int pos;
+	unsigned int i;
+	int rc = 0;
 
 	ENTRY;
 
-	if (ll_xattr_cache_find(cache, xattr_name, &xattr) == 0) {
+	if (ll_xattr_cache_find(xc, xattr_name, &xattr, &pos) == 0) {
 		if (!strcmp(xattr_name, LL_XATTR_NAME_ENCRYPTION_CONTEXT) ||
 		    !strcmp(xattr_name, LL_XATTR_NAME_ENCRYPTION_CONTEXT_OLD))
 			/* it means enc ctx was already in cache,
@@ -150,102 +306,104 @@ static int ll_xattr_cache_add(struct list_head *cache,
 		RETURN(-EPROTO);
 	}
 
-	OBD_SLAB_ALLOC_PTR_GFP(xattr, xattr_kmem, GFP_NOFS);
-	if (xattr == NULL) {
-		CDEBUG(D_CACHE, "failed to allocate xattr\n");
-		RETURN(-ENOMEM);
+	if (xc->xc_count == xc->xc_max) {
+		unsigned int nr = max(xc->xc_max * 2,
+				      (unsigned int)XATTR_CACHE_MIN_ENTRIES);
+		struct ll_xattr_entry *entries;
+		__u32 *order;
+
+		OBD_ALLOC_PTR_ARRAY_LARGE(entries, nr);
+		OBD_ALLOC_PTR_ARRAY_LARGE(order, nr);
+		if (entries == NULL || order == NULL) {
+			CDEBUG(D_CACHE, "failed to alloc %u xattr entries\n",
+			       nr);
+			if (entries)
+				OBD_FREE_PTR_ARRAY_LARGE(entries, nr);
+			if (order)
+				OBD_FREE_PTR_ARRAY_LARGE(order, nr);
+			GOTO(out, rc = -ENOMEM);
+		}
+		if (xc->xc_entries) {
+			memcpy(entries, xc->xc_entries,
+			       xc->xc_count * sizeof(*entries));
+			memcpy(order, xc->xc_order,
+			       xc->xc_count * sizeof(*order));
+			OBD_FREE_PTR_ARRAY_LARGE(xc->xc_entries, xc->xc_max);
+			OBD_FREE_PTR_ARRAY_LARGE(xc->xc_order, xc->xc_max);
+		}
+		xc->xc_entries = entries;
+		xc->xc_order = order;
+		xc->xc_max = nr;
 	}
 
-	xattr->xe_namelen = strlen(xattr_name) + 1;
+	if (xc->xc_used + len > xc->xc_size) {
+		unsigned int size = xc->xc_used - xc->xc_freed + len;
 
-	OBD_ALLOC(xattr->xe_name, xattr->xe_namelen);
-	if (!xattr->xe_name) {
-		CDEBUG(D_CACHE, "failed to alloc xattr name %u\n",
-		       xattr->xe_namelen);
-		goto err_name;
-	}
-	OBD_ALLOC(xattr->xe_value, xattr_val_len);
-	if (!xattr->xe_value) {
-		CDEBUG(D_CACHE, "failed to alloc xattr value %d\n",
-		       xattr_val_len);
-		goto err_value;
+		size = max3(size, 2 * xc->xc_size,
+			    (unsigned int)XATTR_CACHE_MIN_ARENA);
+		rc = ll_xattr_cache_resize(xc, size);
+		if (rc) {
+			CDEBUG(D_CACHE, "failed to alloc xattr arena %u\n",
+			       size);
+			GOTO(out, rc);
+		}
 	}
 
-	memcpy(xattr->xe_name, xattr_name, xattr->xe_namelen);
-	memcpy(xattr->xe_value, xattr_val, xattr_val_len);
+	xattr = &xc->xc_entries[pos];
+	memmove(xattr + 1, xattr, (xc->xc_count - pos) * sizeof(*xattr));
+	for (i = 0; i < xc->xc_count; i++)
+		if (xc->xc_order[i] >= pos)
+			xc->xc_order[i]++;
+	xc->xc_order[xc->xc_count++] = pos;
+
+	xattr->xe_hash = jhash(xattr_name, namelen, 0);
+	xattr->xe_offset = xc->xc_used;
+	xattr->xe_namelen = namelen;
 	xattr->xe_vallen = xattr_val_len;
-	list_add(&xattr->xe_list, cache);
+	memcpy(ll_xattr_name(xc, xattr), xattr_name, namelen);
+	memcpy(ll_xattr_value(xc, xattr), xattr_val, xattr_val_len);
+	xc->xc_used += len;
 
 	CDEBUG(D_CACHE, "set: [%s]=%.*s\n", xattr_name,
 		xattr_val_len, xattr_val);
+out:
+	ll_xattr_cache_account(sbi, xc);
 
-	RETURN(0);
-err_value:
-	OBD_FREE(xattr->xe_name, xattr->xe_namelen);
-err_name:
-	OBD_SLAB_FREE_PTR(xattr, xattr_kmem);
-
-	RETURN(-ENOMEM);
-}
-
-/**
- * This removes an extended attribute from cache.
- *
- * Remove @xattr_name attribute from @cache.
- *
- * \retval 0        success
- * \retval -ENODATA if @xattr_name is not cached
- */
-static int ll_xattr_cache_del(struct list_head *cache,
-			      const char *xattr_name)
-{
-	struct ll_xattr_entry *xattr;
-
-	ENTRY;
-
-	CDEBUG(D_CACHE, "del xattr: %s\n", xattr_name);
-
-	if (ll_xattr_cache_find(cache, xattr_name, &xattr) == 0) {
-		list_del(&xattr->xe_list);
-		OBD_FREE(xattr->xe_name, xattr->xe_namelen);
-		OBD_FREE(xattr->xe_value, xattr->xe_vallen);
-		OBD_SLAB_FREE_PTR(xattr, xattr_kmem);
-
-		RETURN(0);
-	}
-
-	RETURN(-ENODATA);
+	RETURN(rc);
 }
 
 /**
  * This iterates cached extended attributes.
  *
- * Walk over cached attributes in @cache and
+ * Walk over cached attributes in @xc and
  * fill in @xld_buffer or only calculate buffer
  * size if @xld_buffer is NULL.
  *
  * \retval >= 0     buffer list size
  * \retval -ENODATA if the list cannot fit @xld_size buffer
  */
-static int ll_xattr_cache_list(struct list_head *cache,
+static int ll_xattr_cache_list(struct ll_xattr_cache *xc,
 			       char *xld_buffer,
 			       int xld_size)
 {
-	struct ll_xattr_entry *xattr, *tmp;
+	struct ll_xattr_entry *xattr;
 	int xld_tail = 0;
+	unsigned int i;
 
 	ENTRY;
 
-	list_for_each_entry_safe(xattr, tmp, cache, xe_list) {
+	/* most recently added first, as the list based cache did */
+	for (i = xc->xc_count; i-- > 0; ) {
+		xattr = &xc->xc_entries[xc->xc_order[i]];
 		CDEBUG(D_CACHE, "list: buffer=%p[%d] name=%s\n",
-			xld_buffer, xld_tail, xattr->xe_name);
+			xld_buffer, xld_tail, ll_xattr_name(xc, xattr));
 
 		if (xld_buffer) {
 			xld_size -= xattr->xe_namelen;
 			if (xld_size < 0)
 				break;
 			memcpy(&xld_buffer[xld_tail],
-			       xattr->xe_name, xattr->xe_namelen);
+			       ll_xattr_name(xc, xattr), xattr->xe_namelen);
 		}
 		xld_tail += xattr->xe_namelen;
 	}
@@ -287,13 +445,24 @@ static int ll_xattr_cache_filled(struct ll_inode_info *lli)
  */
 static int ll_xattr_cache_destroy_locked(struct ll_inode_info *lli)
 {
+	struct ll_sb_info *sbi = ll_i2sbi(ll_info2i(lli));
+	struct ll_xattr_cache *xc = lli->lli_xattrs;
+
 	ENTRY;
 
 	if (!ll_xattr_cache_valid(lli))
 		RETURN(0);
 
-	while (ll_xattr_cache_del(&lli->lli_xattrs, NULL) == 0)
-		/* empty loop */ ;
+	ll_xattr_cache_lru_del(sbi, xc);
+	if (xc->xc_arena)
+		OBD_FREE_LARGE(xc->xc_arena, xc->xc_size);
+	if (xc->xc_entries) {
+		OBD_FREE_PTR_ARRAY_LARGE(xc->xc_entries, xc->xc_max);
+		OBD_FREE_PTR_ARRAY_LARGE(xc->xc_order, xc->xc_max);
+	}
+	atomic_long_sub(xc->xc_bytes, &sbi->ll_xattr_cache_bytes);
+	OBD_SLAB_FREE_PTR(xc, xattr_kmem);
+	lli->lli_xattrs = NULL;
 
 	clear_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
 	clear_bit(LLIF_XATTR_CACHE, &lli->lli_flags);
@@ -315,6 +484,42 @@ int ll_xattr_cache_destroy(struct inode *inode)
 	RETURN(rc);
 }
 
+/* drop all xattrs but the encryption context, with the cache filled */
+static void ll_xattr_cache_empty_locked(struct inode *inode)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_xattr_cache *xc = lli->lli_xattrs;
+	struct ll_xattr_entry *enc;
+
+	ll_xattr_cache_lru_del(sbi, xc);
+
+	if (ll_xattr_cache_find(xc, xattr_for_enc(inode), &enc, NULL) == 0) {
+		CDEBUG(D_CACHE, "keep: %s, delete %u others\n",
+		       xattr_for_enc(inode), xc->xc_count - 1);
+		xc->xc_entries[0] = *enc;
+		xc->xc_order[0] = 0;
+		xc->xc_count = 1;
+		xc->xc_freed = xc->xc_used - enc->xe_namelen - enc->xe_vallen;
+	} else {
+		CDEBUG(D_CACHE, "delete %u xattrs\n", xc->xc_count);
+		xc->xc_count = 0;
+		xc->xc_freed = xc->xc_used;
+		if (xc->xc_entries) {
+			OBD_FREE_PTR_ARRAY_LARGE(xc->xc_entries, xc->xc_max);
+			OBD_FREE_PTR_ARRAY_LARGE(xc->xc_order, xc->xc_max);
+		}
+		xc->xc_entries = NULL;
+		xc->xc_order = NULL;
+		xc->xc_max = 0;
+	}
+	/* keeps the old arena if the small one cannot be allocated */
+	ll_xattr_cache_resize(xc, xc->xc_used - xc->xc_freed);
+	ll_xattr_cache_account(sbi, xc);
+
+	clear_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
+}
+
 /**
  * ll_xattr_cache_empty - empty xattr cache for @ino
  *
@@ -324,30 +529,53 @@ int ll_xattr_cache_destroy(struct inode *inode)
 int ll_xattr_cache_empty(struct inode *inode)
 {
 	struct ll_inode_info *lli = ll_i2info(inode);
-	struct ll_xattr_entry *entry, *n;
 
 	ENTRY;
 
 	down_write(&lli->lli_xattrs_list_rwsem);
-	if (!ll_xattr_cache_valid(lli) ||
-	    !ll_xattr_cache_filled(lli))
-		GOTO(out_empty, 0);
+	if (ll_xattr_cache_valid(lli) && ll_xattr_cache_filled(lli))
+		ll_xattr_cache_empty_locked(inode);
+	up_write(&lli->lli_xattrs_list_rwsem);
+
+	RETURN(0);
+}
 
-	list_for_each_entry_safe(entry, n, &lli->lli_xattrs, xe_list) {
-		if (strcmp(entry->xe_name, xattr_for_enc(inode)) == 0)
+/**
+ * Empty the least recently used xattr caches of @sbi until the memory they
+ * use is below ll_xattr_cache_max.
+ *
+ * Caches hit since the last scan get a second chance, and those whose lock
+ * is busy, including the one of the caller, are skipped.
+ */
+static void ll_xattr_cache_shrink(struct ll_sb_info *sbi)
+{
+	struct ll_xattr_cache *xc;
+	struct ll_inode_info *lli;
+	int scan = 0;
+
+	spin_lock(&sbi->ll_xattr_lru_lock);
+	while (atomic_long_read(&sbi->ll_xattr_cache_bytes) >
+	       sbi->ll_xattr_cache_max && !list_empty(&sbi->ll_xattr_lru) &&
+	       scan++ < XATTR_CACHE_SHRINK_SCAN) {
+		xc = list_last_entry(&sbi->ll_xattr_lru, struct ll_xattr_cache,
+				     xc_lru);
+		lli = xc->xc_lli;
+		if (xc->xc_referenced ||
+		    !down_write_trylock(&lli->lli_xattrs_list_rwsem)) {
+			xc->xc_referenced = false;
+			list_move(&xc->xc_lru, &sbi->ll_xattr_lru);
 			continue;
+		}
+		/* the inode cannot go away while its rwsem is held */
+		spin_unlock(&sbi->ll_xattr_lru_lock);
 
-		CDEBUG(D_CACHE, "delete: %s\n", entry->xe_name);
-		list_del(&entry->xe_list);
-		OBD_FREE(entry->xe_name, entry->xe_namelen);
-		OBD_FREE(entry->xe_value, entry->xe_vallen);
-		OBD_SLAB_FREE_PTR(entry, xattr_kmem);
-	}
-	clear_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
+		ll_xattr_cache_empty_locked(ll_info2i(lli));
+		up_write(&lli->lli_xattrs_list_rwsem);
+		atomic_inc(&sbi->ll_xattr_cache_evict);
 
-out_empty:
-	up_write(&lli->lli_xattrs_list_rwsem);
-	RETURN(0);
+		spin_lock(&sbi->ll_xattr_lru_lock);
+	}
+	spin_unlock(&sbi->ll_xattr_lru_lock);
 }
 
 /**
@@ -452,6 +680,7 @@ static int ll_xattr_cache_refill(struct inode *inode)
 	/* Do we have the data at this point? */
 	if (ll_xattr_cache_filled(lli)) {
 		ll_stats_ops_tally(sbi, LPROC_LL_GETXATTR_HITS, 1);
+		atomic_inc(&sbi->ll_xattr_cache_hit);
 		ll_intent_drop_lock(&oit);
 		GOTO(err_req, rc = 0);
 	}
@@ -486,8 +715,12 @@ static int ll_xattr_cache_refill(struct inode *inode)
 
 	CDEBUG(D_CACHE, "caching: xdata=%p xtail=%p\n", xdata, xtail);
 
-	if (!ll_xattr_cache_valid(lli))
-		ll_xattr_cache_init(lli);
+	atomic_inc(&sbi->ll_xattr_cache_miss);
+	if (!ll_xattr_cache_valid(lli)) {
+		rc = ll_xattr_cache_init(lli);
+		if (rc)
+			GOTO(err_cancel, rc);
+	}
 
 	for (i = 0; i < body->mbo_max_mdsize; i++) {
 		CDEBUG(D_CACHE, "caching [%s]=%.*s\n", xdata, *xsizes, xval);
@@ -514,8 +747,8 @@ static int ll_xattr_cache_refill(struct inode *inode)
 			CDEBUG(D_CACHE, "not caching trusted.som\n");
 			rc = 0;
 		} else {
-			rc = ll_xattr_cache_add(&lli->lli_xattrs, xdata, xval,
-						*xsizes);
+			rc = ll_xattr_cache_add(sbi, lli->lli_xattrs, xdata,
+						xval, *xsizes);
 		}
 		if (rc < 0) {
 			ll_xattr_cache_destroy_locked(lli);
@@ -526,10 +759,13 @@ static int ll_xattr_cache_refill(struct inode *inode)
 		xsizes++;
 	}
 
-	if (xdata != xtail || xval != xvtail)
+	if (xdata != xtail || xval != xvtail) {
 		CERROR("a hole in xattr data\n");
-	else
+	} else {
 		set_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
+		ll_xattr_cache_lru_add(sbi, lli->lli_xattrs);
+		ll_xattr_cache_shrink(sbi);
+	}
 
 	ll_set_lock_data(sbi->ll_md_exp, inode, &oit, NULL);
 	ll_intent_drop_lock(&oit);
@@ -595,22 +831,28 @@ int ll_xattr_cache_get(struct inode *inode,
 		downgrade_write(&lli->lli_xattrs_list_rwsem);
 	} else {
 		ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_GETXATTR_HITS, 1);
+		atomic_inc(&ll_i2sbi(inode)->ll_xattr_cache_hit);
 	}
 
 	if (!ll_xattr_cache_valid(lli))
 		GOTO(out, rc = -ENODATA);
 
+	if (!lli->lli_xattrs->xc_referenced)
+		lli->lli_xattrs->xc_referenced = true;
+
 	if (valid & OBD_MD_FLXATTR) {
 		struct ll_xattr_entry *xattr;
 
-		rc = ll_xattr_cache_find(&lli->lli_xattrs, name, &xattr);
+		rc = ll_xattr_cache_find(lli->lli_xattrs, name, &xattr, NULL);
 		if (rc == 0) {
 			rc = xattr->xe_vallen;
 			/* zero size means we are only requested size in rc */
 			if (size != 0) {
 				if (size >= xattr->xe_vallen)
-					memcpy(buffer, xattr->xe_value,
-						xattr->xe_vallen);
+					memcpy(buffer,
+					       ll_xattr_value(lli->lli_xattrs,
+							      xattr),
+					       xattr->xe_vallen);
 				else
 					rc = -ERANGE;
 			}
@@ -631,7 +873,7 @@ int ll_xattr_cache_get(struct inode *inode,
 			}
 		}
 	} else if (valid & OBD_MD_FLXATTRLS) {
-		rc = ll_xattr_cache_list(&lli->lli_xattrs,
+		rc = ll_xattr_cache_list(lli->lli_xattrs,
 					 size ? buffer : NULL, size);
 	}
 
@@ -658,14 +900,19 @@ int ll_xattr_cache_insert(struct inode *inode,
 			  size_t size)
 {
 	struct ll_inode_info *lli = ll_i2info(inode);
-	int rc;
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	int rc = 0;
 
 	ENTRY;
 
 	down_write(&lli->lli_xattrs_list_rwsem);
 	if (!ll_xattr_cache_valid(lli))
-		ll_xattr_cache_init(lli);
-	rc = ll_xattr_cache_add(&lli->lli_xattrs, name, buffer, size);
+		rc = ll_xattr_cache_init(lli);
+	if (!rc)
+		rc = ll_xattr_cache_add(sbi, lli->lli_xattrs, name, buffer,
+					size);
+	if (!rc)
+		ll_xattr_cache_shrink(sbi);
 	up_write(&lli->lli_xattrs_list_rwsem);
 	RETURN(rc);
 }
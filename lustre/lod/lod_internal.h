@@ -179,6 +179,10 @@ struct lod_layout_component {
 	__u32			  llc_flags;
 	__u32			  llc_magic;
 	__u64			  llc_timestamp; /* snapshot time */
+	/* chunk compression, valid with LCME_FL_COMPRESS */
+	__u8			  llc_compr_type;
+	__u8			  llc_compr_lvl;
+	__u8			  llc_compr_chunk_log_bits;
 	union {
 		struct { /* plain layout V1/V3. */
 			__u32			  llc_pattern;
@@ -333,6 +337,22 @@ static inline bool lod_is_hsm(const struct lod_layout_component *lod_comp)
 	       lov_hsm_type_supported(lod_comp->llc_type);
 }
 
+/* take the compression settings from \a lcme, dropping unknown types */
+static inline void
+lod_comp_set_compr(struct lod_layout_component *lod_comp,
+		   const struct lov_comp_md_entry_v1 *lcme)
+{
+	if (lcme->lcme_compr_type == LL_COMPR_TYPE_NONE ||
+	    lcme->lcme_compr_type >= LL_COMPR_TYPE_MAX) {
+		lod_comp->llc_flags &= ~LCME_FL_COMPRESS;
+		return;
+	}
+
+	lod_comp->llc_compr_type = lcme->lcme_compr_type;
+	lod_comp->llc_compr_lvl = lcme->lcme_compr_lvl;
+	lod_comp->llc_compr_chunk_log_bits = lcme->lcme_compr_chunk_log_bits;
+}
+
 static inline bool lod_is_splitting(const struct lod_object *lo)
 {
 	return lmv_hash_is_splitting(lo->ldo_dir_hash_type);
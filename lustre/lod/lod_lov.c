@@ -984,6 +984,12 @@ int lod_generate_lovea(const struct lu_env *env, struct lod_object *lo,
 				cpu_to_le64(lod_comp->llc_timestamp);
 		if (lod_comp->llc_flags & LCME_FL_EXTENSION && !is_dir)
 			lcm->lcm_magic = cpu_to_le32(LOV_MAGIC_SEL);
+		if (lod_comp->llc_flags & LCME_FL_COMPRESS) {
+			lcme->lcme_compr_type = lod_comp->llc_compr_type;
+			lcme->lcme_compr_lvl = lod_comp->llc_compr_lvl;
+			lcme->lcme_compr_chunk_log_bits =
+				lod_comp->llc_compr_chunk_log_bits;
+		}
 
 		lcme->lcme_extent.e_start =
 			cpu_to_le64(lod_comp->llc_extent.e_start);
@@ -1381,6 +1387,9 @@ int lod_parse_striping(const struct lu_env *env, struct lod_object *lo,
 			if (lod_comp->llc_flags & LCME_FL_NOSYNC)
 				lod_comp->llc_timestamp = le64_to_cpu(
 					comp_v1->lcm_entries[i].lcme_timestamp);
+			if (lod_comp->llc_flags & LCME_FL_COMPRESS)
+				lod_comp_set_compr(lod_comp,
+						   &comp_v1->lcm_entries[i]);
 			lod_comp->llc_id =
 				le32_to_cpu(comp_v1->lcm_entries[i].lcme_id);
 			if (lod_comp->llc_id == LCME_ID_INVAL)
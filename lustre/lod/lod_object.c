@@ -2821,6 +2821,8 @@ static int lod_declare_layout_add(const struct lu_env *env,
 		lod_comp->llc_extent.e_end = ext->e_end;
 		lod_comp->llc_stripe_offset = v1->lmm_stripe_offset;
 		lod_comp->llc_flags = comp_v1->lcm_entries[i].lcme_flags;
+		if (lod_comp->llc_flags & LCME_FL_COMPRESS)
+			lod_comp_set_compr(lod_comp, &comp_v1->lcm_entries[i]);
 
 		lod_comp->llc_stripe_size = v1->lmm_stripe_size;
 		lod_comp->llc_stripe_count = v1->lmm_stripe_count;
@@ -5435,6 +5437,9 @@ static int lod_get_default_lov_striping(const struct lu_env *env,
 				/* We only inherit certain flags from the layout */
 				llc->llc_flags = lcm->lcm_entries[i].lcme_flags &
 					LCME_TEMPLATE_FLAGS;
+				if (llc->llc_flags & LCME_FL_COMPRESS)
+					lod_comp_set_compr(llc,
+							&lcm->lcm_entries[i]);
 			}
 		}
 
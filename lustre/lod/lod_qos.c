@@ -2180,6 +2180,9 @@ int lod_use_defined_striping(const struct lu_env *env,
 			if (lod_comp->llc_flags & LCME_FL_NOSYNC)
 				lod_comp->llc_timestamp = le64_to_cpu(
 					comp_v1->lcm_entries[i].lcme_timestamp);
+			if (lod_comp->llc_flags & LCME_FL_COMPRESS)
+				lod_comp_set_compr(lod_comp,
+						   &comp_v1->lcm_entries[i]);
 			lod_comp->llc_id =
 				le32_to_cpu(comp_v1->lcm_entries[i].lcme_id);
 			if (lod_comp->llc_id == LCME_ID_INVAL)
@@ -2469,6 +2472,9 @@ int lod_qos_parse_config(const struct lu_env *env, struct lod_object *lo,
 			lod_comp->llc_flags =
 				comp_v1->lcm_entries[i].lcme_flags &
 					LCME_CL_COMP_FLAGS;
+			if (lod_comp->llc_flags & LCME_FL_COMPRESS)
+				lod_comp_set_compr(lod_comp,
+						   &comp_v1->lcm_entries[i]);
 		}
 
 		pool_name = NULL;
@@ -496,6 +496,61 @@ lsme_unpack_comp(struct lov_obd *lov, struct lov_mds_md *lmm,
 	}
 }
 
+/*
+ * Pass the compression settings of a component down to its stripes.  A
+ * chunk must not cross a stripe boundary, components that do not meet
+ * that are written uncompressed.
+ */
+static void lsme_unpack_compr(struct lov_stripe_md_entry *lsme,
+			      const struct lov_comp_md_entry_v1 *lcme)
+{
+	unsigned long chunk_size;
+	int i;
+
+	lsme->lsme_compr_type = lcme->lcme_compr_type;
+	lsme->lsme_compr_lvl = lcme->lcme_compr_lvl;
+	lsme->lsme_compr_chunk_log_bits = lcme->lcme_compr_chunk_log_bits;
+
+	if (!(lsme->lsme_flags & LCME_FL_COMPRESS) ||
+	    lsme->lsme_compr_type == LL_COMPR_TYPE_NONE ||
+	    lsme->lsme_compr_type >= LL_COMPR_TYPE_MAX ||
+	    !lsme_inited(lsme) || lsme_is_dom(lsme) ||
+	    lsme->lsme_pattern & LOV_PATTERN_F_RELEASED ||
+	    !lov_supported_comp_magic(lsme->lsme_magic))
+		return;
+
+	chunk_size = COMPR_GET_CHUNK_SIZE(lsme->lsme_compr_chunk_log_bits);
+	if (lsme->lsme_stripe_size % chunk_size) {
+		CDEBUG(D_LAYOUT,
+		       "component %u: stripe size %u not a multiple of chunk size %lu, not compressing\n",
+		       lsme->lsme_id, lsme->lsme_stripe_size, chunk_size);
+		return;
+	}
+
+	for (i = 0; i < lsme->lsme_stripe_count; i++) {
+		struct lov_oinfo *loi = lsme->lsme_oinfo[i];
+
+		loi->loi_compr_type = lsme->lsme_compr_type;
+		loi->loi_compr_level = lsme->lsme_compr_lvl;
+		loi->loi_compr_chunk_bits = lsme->lsme_compr_chunk_log_bits;
+	}
+}
+
+/* let the OSCs of a LCME_FL_SPARSE component elide zero pages on write */
+static void lsme_unpack_sparse(struct lov_stripe_md_entry *lsme)
+{
+	int i;
+
+	if (!(lsme->lsme_flags & LCME_FL_SPARSE) ||
+	    !lsme_inited(lsme) || lsme_is_dom(lsme) ||
+	    lsme->lsme_pattern & LOV_PATTERN_F_RELEASED ||
+	    !lov_supported_comp_magic(lsme->lsme_magic))
+		return;
+
+	for (i = 0; i < lsme->lsme_stripe_count; i++)
+		lsme->lsme_oinfo[i]->loi_sparse = 1;
+}
+
 static struct lov_stripe_md *
 lsm_unpackmd_comp_md_v1(struct lov_obd *lov, void *buf, size_t buf_size)
 {
@@ -571,6 +626,8 @@ lsm_unpackmd_comp_md_v1(struct lov_obd *lov, void *buf, size_t buf_size)
 			lsme->lsme_timestamp =
 				le64_to_cpu(lcme->lcme_timestamp);
 		lu_extent_le_to_cpu(&lsme->lsme_extent, &lcme->lcme_extent);
+		lsme_unpack_compr(lsme, lcme);
+		lsme_unpack_sparse(lsme);
 
 		if (i == entry_count - 1) {
 			lsm->lsm_maxbytes = (loff_t)lsme->lsme_extent.e_start +
@@ -684,11 +741,12 @@ void dump_lsm(unsigned int level, const struct lov_stripe_md *lsm)
 		CDEBUG(level, DEXT ": id: %u, flags: %x, "
 		       "magic 0x%08X, layout_gen %u, "
 		       "stripe count %u, sstripe size %u, "
-		       "pool: ["LOV_POOLNAMEF"]\n",
+		       "compr %u/%u/%u, pool: ["LOV_POOLNAMEF"]\n",
 		       PEXT(&lse->lsme_extent), lse->lsme_id, lse->lsme_flags,
 		       lse->lsme_magic, lse->lsme_layout_gen,
 		       lse->lsme_stripe_count, lse->lsme_stripe_size,
-		       lse->lsme_pool_name);
+		       lse->lsme_compr_type, lse->lsme_compr_lvl,
+		       lse->lsme_compr_chunk_log_bits, lse->lsme_pool_name);
 		if (!lsme_inited(lse) ||
 		    lse->lsme_pattern & LOV_PATTERN_F_RELEASED ||
 		    !lov_supported_comp_magic(lse->lsme_magic) ||
@@ -1152,6 +1152,22 @@ static int lov_get_info(const struct lu_env *env, struct obd_export *exp,
 		*((u32 *)val) = lov_mds_md_size(def_stripe_count, LOV_MAGIC_V3);
 	} else if (KEY_IS(KEY_TGT_COUNT)) {
 		*((int *)val) = lov->desc.ld_tgt_count;
+	} else if (KEY_IS(KEY_CHECKSUM_TYPE)) {
+		struct lov_tgt_desc *tgt;
+		u32 i;
+
+		/* all OSCs normally agree, ask the first usable one */
+		rc = -ENODEV;
+		for (i = 0; i < lov->desc.ld_tgt_count; i++) {
+			tgt = lov->lov_tgts[i];
+			if (tgt == NULL || tgt->ltd_exp == NULL ||
+			    !tgt->ltd_active)
+				continue;
+
+			rc = obd_get_info(env, tgt->ltd_exp, keylen, key,
+					  vallen, val);
+			break;
+		}
 	} else {
 		rc = -EINVAL;
 	}
@@ -335,7 +335,7 @@ static int mdc_cached_mb_seq_show(struct seq_file *m, void *v)
 		   (atomic_long_read(&cli->cl_lru_in_list) +
 		    atomic_long_read(&cli->cl_lru_busy)) >> shift,
 		    atomic_long_read(&cli->cl_lru_busy),
-		   cli->cl_lru_reclaim);
+		   (u64)atomic64_read(&cli->cl_lru_reclaim));
 
 	return 0;
 }
@@ -219,7 +219,7 @@ static bool mdc_check_and_discard_cb(const struct lu_env *env, struct cl_io *io,
 			}
 		}
 
-		info->oti_next_index = index + 1;
+		info->oti_next_index = index + osc_page_nr(ops);
 	}
 	return true;
 }
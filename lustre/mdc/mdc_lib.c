@@ -180,7 +180,7 @@ void mdc_file_sepol_pack(struct req_capsule *pill)
 }
 
 void mdc_readdir_pack(struct req_capsule *pill, __u64 pgoff, size_t size,
-		      const struct lu_fid *fid)
+		      const struct lu_fid *fid, __u32 attrs)
 {
 	struct mdt_body *b = req_capsule_client_get(pill, &RMF_MDT_BODY);
 
@@ -189,7 +189,7 @@ void mdc_readdir_pack(struct req_capsule *pill, __u64 pgoff, size_t size,
 	b->mbo_size = pgoff;			/* !! */
 	b->mbo_nlink = size;			/* !! */
 	__mdc_pack_body(b, -1);
-	b->mbo_mode = LUDA_FID | LUDA_TYPE;
+	b->mbo_mode = attrs;
 }
 
 /* packing of MDS records */
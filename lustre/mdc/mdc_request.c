@@ -1020,7 +1020,7 @@ out:
 }
 
 static int mdc_getpage(struct obd_export *exp, const struct lu_fid *fid,
-		       u64 offset, struct page **pages, int npages,
+		       u64 offset, __u32 attrs, struct page **pages, int npages,
 		       struct ptlrpc_request **request)
 {
 	struct ptlrpc_request   *req;
@@ -1060,7 +1060,8 @@ restart_bulk:
 		desc->bd_frag_ops->add_kiov_frag(desc, pages[i], 0,
 						 PAGE_SIZE);
 
-	mdc_readdir_pack(&req->rq_pill, offset, PAGE_SIZE * npages, fid);
+	mdc_readdir_pack(&req->rq_pill, offset, PAGE_SIZE * npages, fid,
+			 attrs);
 
 	ptlrpc_request_set_replen(req);
 	rc = ptlrpc_queue_wait(req);
@@ -1322,6 +1323,7 @@ static int ll_mdc_read_page_remote(void *data, struct page *page0)
 	int max_pages;
 	struct inode *inode;
 	struct lu_fid *fid;
+	__u32 attrs = LUDA_FID | LUDA_TYPE;
 	int rd_pgs = 0; /* number of pages actually read */
 	int npages;
 	int i;
@@ -1348,7 +1350,13 @@ static int ll_mdc_read_page_remote(void *data, struct page *page0)
 		page_pool[npages] = page;
 	}
 
-	rc = mdc_getpage(rp->rp_exp, fid, rp->rp_off, page_pool, npages, &req);
+	/* ask for the entry attributes, they fill fewer entries per page */
+	if (op_data->op_cli_flags & CLI_READDIR_PLUS &&
+	    exp_connect_readdir_plus(rp->rp_exp))
+		attrs |= LUDA_ATTR;
+
+	rc = mdc_getpage(rp->rp_exp, fid, rp->rp_off, attrs, page_pool, npages,
+			 &req);
 	if (rc < 0) {
 		/* page0 is special, which was added into page cache early */
 		cfs_delete_from_page_cache(page0);
@@ -2755,9 +2763,9 @@ static int mdc_import_event(struct obd_device *obd, struct obd_import *imp,
 			 */
 			osc_io_unplug(env, cli, NULL);
 
-			cfs_hash_for_each_nolock(ns->ns_rs_hash,
-						 osc_ldlm_resource_invalidate,
-						 env, 0);
+			ldlm_namespace_res_foreach(ns,
+						   osc_ldlm_resource_invalidate,
+						   env);
 			cl_env_put(env, &refcheck);
 			ldlm_namespace_cleanup(ns, LDLM_FL_LOCAL_ONLY);
 		} else {
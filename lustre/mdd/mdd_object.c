@@ -3750,11 +3750,89 @@ static int mdd_readpage_sanity_check(const struct lu_env *env,
 	return 0;
 }
 
+/*
+ * Pack the attributes of the entry \a ent into the struct luda_attr that
+ * follows it, see LUDA_ATTR.  The entry must have room for them.  No lock is
+ * taken on the child, the client only uses them as lazy attributes.
+ */
+static int mdd_dir_page_pack_attr(const struct lu_env *env,
+				  struct mdd_device *mdd,
+				  struct lu_dirent *ent, __u32 attr)
+{
+	struct lu_attr *la = &mdd_env_info(env)->mdi_cattr;
+	struct lustre_som_attrs som;
+	struct lu_buf som_buf = { .lb_buf = &som, .lb_len = sizeof(som) };
+	struct mdd_object *child;
+	struct luda_attr *lda;
+	struct lu_fid fid;
+	__u64 valid;
+	int rc;
+
+	if (!(le32_to_cpu(ent->lde_attrs) & LUDA_FID))
+		return -ENODATA;
+
+	fid_le_to_cpu(&fid, &ent->lde_fid);
+	if (!fid_is_sane(&fid))
+		return -EINVAL;
+
+	child = mdd_object_find(env, mdd, &fid);
+	if (IS_ERR(child))
+		return PTR_ERR(child);
+
+	if (mdd_object_remote(child))
+		GOTO(out, rc = -EREMOTE);
+
+	rc = mdd_la_get(env, child, la);
+	if (rc)
+		GOTO(out, rc);
+
+	valid = OBD_MD_FLTYPE | OBD_MD_FLMODE | OBD_MD_FLUID | OBD_MD_FLGID |
+		OBD_MD_FLNLINK | OBD_MD_FLFLAGS | OBD_MD_FLMTIME |
+		OBD_MD_FLATIME | OBD_MD_FLCTIME;
+
+	ent->lde_attrs |= cpu_to_le32(LUDA_ATTR);
+	lda = lu_dirent_attr_get(ent);
+	memset(lda, 0, sizeof(*lda));
+	lda->lda_mode = cpu_to_le32(la->la_mode);
+	lda->lda_uid = cpu_to_le32(la->la_uid);
+	lda->lda_gid = cpu_to_le32(la->la_gid);
+	lda->lda_nlink = cpu_to_le32(la->la_nlink);
+	lda->lda_flags = cpu_to_le32(la->la_flags);
+	lda->lda_mtime = cpu_to_le64(la->la_mtime);
+	lda->lda_atime = cpu_to_le64(la->la_atime);
+	lda->lda_ctime = cpu_to_le64(la->la_ctime);
+
+	if (!S_ISREG(la->la_mode)) {
+		valid |= OBD_MD_FLSIZE | OBD_MD_FLBLOCKS;
+		lda->lda_size = cpu_to_le64(la->la_size);
+		lda->lda_blocks = cpu_to_le64(la->la_blocks);
+	} else if (mdo_xattr_get(env, child, &som_buf,
+				 XATTR_NAME_SOM) == sizeof(som)) {
+		/* the size of regular files is only known from SOM */
+		lustre_som_swab(&som);
+		if (som.lsa_valid & SOM_FL_STRICT)
+			valid |= OBD_MD_FLSIZE | OBD_MD_FLBLOCKS;
+		else if (som.lsa_valid & SOM_FL_LAZY)
+			valid |= OBD_MD_FLLAZYSIZE | OBD_MD_FLLAZYBLOCKS;
+		lda->lda_size = cpu_to_le64(som.lsa_size);
+		lda->lda_blocks = cpu_to_le64(som.lsa_blocks);
+	}
+	lda->lda_valid = cpu_to_le64(valid);
+
+	ent->lde_reclen = cpu_to_le16(lu_dirent_calc_size(
+				le16_to_cpu(ent->lde_namelen), attr));
+out:
+	mdd_object_put(env, child);
+
+	return rc;
+}
+
 static int mdd_dir_page_build(const struct lu_env *env, struct dt_object *obj,
 			      union lu_page *lp, size_t bytes,
 			      const struct dt_it_ops *iops,
 			      struct dt_it *it, __u32 attr, void *arg)
 {
+	struct mdd_device *mdd = arg;
 	struct lu_dirpage *dp = &lp->lp_dir;
 	void *area = dp;
 	__u64 hash = 0;
@@ -3793,12 +3871,19 @@ static int mdd_dir_page_build(const struct lu_env *env, struct dt_object *obj,
 
 		if (bytes >= recsize &&
 		    !CFS_FAIL_CHECK(OBD_FAIL_MDS_DIR_PAGE_WALK)) {
-			result = iops->rec(env, it, (struct dt_rec *)ent, attr);
+			/* OSD packs the name only, LUDA_ATTR is added here */
+			result = iops->rec(env, it, (struct dt_rec *)ent,
+					   attr & ~LUDA_ATTR);
 			if (result == -ESTALE)
 				GOTO(next, result);
 			if (result != 0)
 				GOTO(out, result);
 
+			/* entry is still valid without attributes */
+			if (attr & LUDA_ATTR)
+				mdd_dir_page_pack_attr(env, mdd, ent, LUDA_ATTR |
+					le32_to_cpu(ent->lde_attrs));
+
 			/* OSD might not able to pack all attributes, so
 			 * recheck record length had room to store FID
 			 */
@@ -3886,7 +3971,7 @@ int mdd_readpage(const struct lu_env *env, struct md_object *obj,
         }
 
 	rc = dt_index_walk(env, mdd_object_child(mdd_obj), rdpg,
-			   mdd_dir_page_build, NULL);
+			   mdd_dir_page_build, mdo2mdd(obj));
 	if (rc >= 0) {
 		struct lu_dirpage	*dp;
 
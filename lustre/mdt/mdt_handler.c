@@ -2852,6 +2852,31 @@ static int mdt_set_info(struct tgt_session_info *tsi)
 	RETURN(rc);
 }
 
+/*
+ * Entry attributes are only returned to callers allowed to search the
+ * directory, like a getattr by name would require.
+ */
+static bool mdt_readdir_plus_allowed(struct tgt_session_info *tsi,
+				     struct mdt_object *obj)
+{
+	struct mdt_thread_info *info;
+	bool allowed = false;
+
+	if (!exp_connect_readdir_plus(tsi->tsi_exp))
+		return false;
+
+	info = tsi2mdt_info(tsi);
+	if (!mdt_init_ucred(info, (struct mdt_body *)info->mti_body)) {
+		allowed = !mo_permission(tsi->tsi_env, NULL,
+					 mdt_object_child(obj), NULL,
+					 MAY_EXEC);
+		mdt_exit_ucred(info);
+	}
+	mdt_thread_info_fini(info);
+
+	return allowed;
+}
+
 static int mdt_readpage(struct tgt_session_info *tsi)
 {
 	struct mdt_thread_info	*info = mdt_th_info(tsi->tsi_env);
@@ -2886,6 +2911,9 @@ static int mdt_readpage(struct tgt_session_info *tsi)
 	rdpg->rp_attrs = reqbody->mbo_mode;
 	if (exp_connect_flags(tsi->tsi_exp) & OBD_CONNECT_64BITHASH)
 		rdpg->rp_attrs |= LUDA_64BITHASH;
+	if ((rdpg->rp_attrs & LUDA_ATTR) &&
+	    !mdt_readdir_plus_allowed(tsi, object))
+		rdpg->rp_attrs &= ~LUDA_ATTR;
 	rdpg->rp_count  = min_t(unsigned int, reqbody->mbo_nlink,
 				exp_max_brw_size(tsi->tsi_exp));
 	rdpg->rp_npages = (rdpg->rp_count + PAGE_SIZE - 1) >>
@@ -53,4 +53,7 @@ extern unsigned short cl_page_kmem_size_array[16];
 struct cl_thread_info *cl_env_info(const struct lu_env *env);
 void __cl_page_disown(const struct lu_env *env, struct cl_page *pg);
 
+int cl_dio_pools_init(void);
+void cl_dio_pools_fini(void);
+
 #endif /* _CL_INTERNAL_H */
@@ -26,6 +26,7 @@
 #include <linux/mmu_context.h>
 #include <obd_class.h>
 #include <obd_support.h>
+#include <obd_cksum.h>
 #include <lustre_fid.h>
 #include <cl_object.h>
 #include "cl_internal.h"
@@ -1346,13 +1347,291 @@ void cl_sub_dio_free(struct cl_sub_dio *sdio)
 }
 EXPORT_SYMBOL(cl_sub_dio_free);
 
+/*
+ * Bounce pages of unaligned DIO.
+ *
+ * Each CPT keeps a pool of free pages allocated on its own node, so that
+ * small unaligned DIO takes its buffer from the pool of the CPU doing the
+ * copy instead of the page allocator.  As with the sptlrpc encryption page
+ * pools, pages freed by ll_free_dio_buffer() go back to the pool they came
+ * from up to dio_pool_max_mb per CPT, and the shrinker releases the free
+ * pages above CL_DIO_POOL_RESERVE.
+ */
+static unsigned int dio_pool_max_mb = 16;
+module_param(dio_pool_max_mb, uint, 0444);
+MODULE_PARM_DESC(dio_pool_max_mb,
+		 "Memory kept per CPT for unaligned DIO bounce pages (MB), 0 to disable");
+
+/* pages allocated per CPT when the pool is set up and kept by the shrinker */
+#define CL_DIO_POOL_RESERVE	(1 << (20 - PAGE_SHIFT))
+
+struct cl_dio_pool {
+	spinlock_t	cdp_lock;
+	/* free pages, the first cdp_free of them */
+	struct page	**cdp_pages;
+	unsigned int	cdp_free;
+	unsigned int	cdp_max;
+	int		cdp_node;
+	time64_t	cdp_last_access;
+	/* statistics */
+	unsigned long	cdp_st_access;		/* pages asked for */
+	unsigned long	cdp_st_missing;		/* from the page allocator */
+	unsigned long	cdp_st_overflow;	/* freed, pool full */
+	unsigned long	cdp_st_shrunk;		/* freed by the shrinker */
+	unsigned int	cdp_st_shrinks;
+};
+
+static struct cl_dio_pool **cl_dio_pools;
+static struct dentry *cl_dio_pools_debugfs;
+
+/* take up to \a count free pages of pool \a cpt, return how many */
+static unsigned int cl_dio_pool_get(int cpt, struct page **pages,
+				    unsigned int count)
+{
+	struct cl_dio_pool *pool;
+	unsigned int nr;
+
+	if (!cl_dio_pools)
+		return 0;
+
+	pool = cl_dio_pools[cpt];
+	spin_lock(&pool->cdp_lock);
+	nr = min(count, pool->cdp_free);
+	pool->cdp_free -= nr;
+	memcpy(pages, pool->cdp_pages + pool->cdp_free, nr * sizeof(*pages));
+	pool->cdp_st_access += count;
+	pool->cdp_st_missing += count - nr;
+	pool->cdp_last_access = ktime_get_seconds();
+	spin_unlock(&pool->cdp_lock);
+
+	return nr;
+}
+
+/* give \a count pages back to pool \a cpt, free what does not fit */
+static void cl_dio_pool_put(int cpt, struct page **pages, unsigned int count)
+{
+	struct cl_dio_pool *pool;
+	unsigned int nr = 0;
+
+	if (cl_dio_pools) {
+		pool = cl_dio_pools[cpt];
+		spin_lock(&pool->cdp_lock);
+		nr = min(count, pool->cdp_max - pool->cdp_free);
+		memcpy(pool->cdp_pages + pool->cdp_free, pages,
+		       nr * sizeof(*pages));
+		pool->cdp_free += nr;
+		pool->cdp_st_overflow += count - nr;
+		spin_unlock(&pool->cdp_lock);
+	}
+
+	for (; nr < count; nr++)
+		__free_page(pages[nr]);
+}
+
+/* release up to \a nr free pages of \a pool above \a keep */
+static unsigned long cl_dio_pool_release(struct cl_dio_pool *pool,
+					 unsigned long nr, unsigned int keep)
+{
+	struct page **pages;
+	unsigned long i;
+
+	spin_lock(&pool->cdp_lock);
+	if (pool->cdp_free <= keep) {
+		spin_unlock(&pool->cdp_lock);
+		return 0;
+	}
+	nr = min_t(unsigned long, nr, pool->cdp_free - keep);
+	pool->cdp_free -= nr;
+	pages = pool->cdp_pages + pool->cdp_free;
+	for (i = 0; i < nr; i++) {
+		__free_page(pages[i]);
+		pages[i] = NULL;
+	}
+	if (nr) {
+		pool->cdp_st_shrunk += nr;
+		pool->cdp_st_shrinks++;
+	}
+	spin_unlock(&pool->cdp_lock);
+
+	return nr;
+}
+
+static unsigned long cl_dio_pool_shrink_count(struct shrinker *s,
+					      struct shrink_control *sc)
+{
+	struct cl_dio_pool *pool;
+	unsigned long count = 0;
+	int i;
+
+	cfs_percpt_for_each(pool, i, cl_dio_pools) {
+		unsigned int free = READ_ONCE(pool->cdp_free);
+
+		if (free > CL_DIO_POOL_RESERVE)
+			count += free - CL_DIO_POOL_RESERVE;
+	}
+
+	return count;
+}
+
+static unsigned long cl_dio_pool_shrink_scan(struct shrinker *s,
+					     struct shrink_control *sc)
+{
+	struct cl_dio_pool *pool;
+	unsigned long freed = 0;
+	int i;
+
+	cfs_percpt_for_each(pool, i, cl_dio_pools) {
+		if (freed >= sc->nr_to_scan)
+			break;
+		freed += cl_dio_pool_release(pool, sc->nr_to_scan - freed,
+					     CL_DIO_POOL_RESERVE);
+	}
+	if (freed)
+		CDEBUG(D_CACHE, "released %lu DIO bounce pages\n", freed);
+
+	return freed;
+}
+
+#ifdef HAVE_SHRINKER_COUNT
+static struct shrinker cl_dio_pool_shrinker = {
+	.count_objects	= cl_dio_pool_shrink_count,
+	.scan_objects	= cl_dio_pool_shrink_scan,
+	.seeks		= DEFAULT_SEEKS,
+};
+#else
+static int cl_dio_pool_shrink(struct shrinker *shrinker,
+			      struct shrink_control *sc)
+{
+	if (sc->nr_to_scan != 0)
+		cl_dio_pool_shrink_scan(shrinker, sc);
+
+	return cl_dio_pool_shrink_count(shrinker, sc);
+}
+
+static struct shrinker cl_dio_pool_shrinker = {
+	.shrink  = cl_dio_pool_shrink,
+	.seeks   = DEFAULT_SEEKS,
+};
+#endif /* HAVE_SHRINKER_COUNT */
+
+static int cl_dio_pools_seq_show(struct seq_file *m, void *v)
+{
+	struct cl_dio_pool *pool;
+	int i;
+
+	if (!cl_dio_pools)
+		return 0;
+
+	cfs_percpt_for_each(pool, i, cl_dio_pools) {
+		spin_lock(&pool->cdp_lock);
+		seq_printf(m, "- cpt: %d\n"
+			   "  node: %d\n"
+			   "  max_pages: %u\n"
+			   "  free_pages: %u\n"
+			   "  last_access: %llds\n"
+			   "  pages_wanted: %lu\n"
+			   "  pages_missing: %lu\n"
+			   "  pages_overflow: %lu\n"
+			   "  pages_shrunk: %lu\n"
+			   "  shrinks: %u\n",
+			   i, pool->cdp_node, pool->cdp_max, pool->cdp_free,
+			   ktime_get_seconds() - pool->cdp_last_access,
+			   pool->cdp_st_access, pool->cdp_st_missing,
+			   pool->cdp_st_overflow, pool->cdp_st_shrunk,
+			   pool->cdp_st_shrinks);
+		spin_unlock(&pool->cdp_lock);
+	}
+
+	return 0;
+}
+LDEBUGFS_SEQ_FOPS_RO(cl_dio_pools);
+
+static void cl_dio_pools_free(void)
+{
+	struct cl_dio_pool *pool;
+	int i;
+
+	cfs_percpt_for_each(pool, i, cl_dio_pools) {
+		if (!pool->cdp_pages)
+			continue;
+		cl_dio_pool_release(pool, pool->cdp_free, 0);
+		OBD_FREE_PTR_ARRAY_LARGE(pool->cdp_pages, pool->cdp_max);
+	}
+	cfs_percpt_free(cl_dio_pools);
+	cl_dio_pools = NULL;
+}
+
+int cl_dio_pools_init(void)
+{
+	struct cl_dio_pool **pools;
+	struct cl_dio_pool *pool;
+	struct page *page;
+	int rc;
+	int i;
+
+	if (!dio_pool_max_mb)
+		return 0;
+
+	pools = cfs_percpt_alloc(cfs_cpt_tab, sizeof(*pool));
+	if (!pools)
+		return -ENOMEM;
+
+	cfs_percpt_for_each(pool, i, pools) {
+		spin_lock_init(&pool->cdp_lock);
+		pool->cdp_node = cfs_cpt_spread_node(cfs_cpt_tab, i);
+		pool->cdp_max = max_t(unsigned int, CL_DIO_POOL_RESERVE,
+				      dio_pool_max_mb << (20 - PAGE_SHIFT));
+		pool->cdp_last_access = ktime_get_seconds();
+		OBD_CPT_ALLOC_LARGE(pool->cdp_pages, cfs_cpt_tab, i,
+				    pool->cdp_max * sizeof(*pool->cdp_pages));
+		if (!pool->cdp_pages)
+			GOTO(out_free, rc = -ENOMEM);
+
+		while (pool->cdp_free < CL_DIO_POOL_RESERVE) {
+			page = alloc_pages_node(pool->cdp_node, GFP_KERNEL, 0);
+			if (!page)
+				break;
+			pool->cdp_pages[pool->cdp_free++] = page;
+		}
+	}
+	cl_dio_pools = pools;
+
+	rc = register_shrinker(&cl_dio_pool_shrinker);
+	if (rc)
+		GOTO(out_free, rc);
+
+	cl_dio_pools_debugfs = debugfs_create_file("dio_bounce_pools", 0444,
+						   debugfs_lustre_root, NULL,
+						   &cl_dio_pools_fops);
+
+	return 0;
+
+out_free:
+	cl_dio_pools = pools;
+	cl_dio_pools_free();
+	return rc;
+}
+
+void cl_dio_pools_fini(void)
+{
+	if (!cl_dio_pools)
+		return;
+
+	/* class_procfs_clean() runs later, the file must not outlive pools */
+	debugfs_remove_recursive(cl_dio_pools_debugfs);
+	cl_dio_pools_debugfs = NULL;
+	unregister_shrinker(&cl_dio_pool_shrinker);
+	cl_dio_pools_free();
+}
+
 /*
  * For unaligned DIO.
  *
  * Allocate the internal buffer from/to which we will perform DIO.  This takes
  * the user I/O parameters and allocates an internal buffer large enough to
  * hold it.  The pages in this buffer are aligned with pages in the file (ie,
- * they have a 1-to-1 mapping with file pages).
+ * they have a 1-to-1 mapping with file pages).  The pages are taken from
+ * the bounce page pool of the current CPT first.
  */
 int ll_allocate_dio_buffer(struct ll_dio_pages *pvec, size_t io_size)
 {
@@ -1385,7 +1664,10 @@ int ll_allocate_dio_buffer(struct ll_dio_pages *pvec, size_t io_size)
 	if (pvec->ldp_pages == NULL)
 		RETURN(-ENOMEM);
 
-	for (i = 0; i < pvec->ldp_count; i++) {
+	/* remap CPUs outside of the CPT table */
+	pvec->ldp_cpt = cfs_cpt_current(cfs_cpt_tab, 1);
+	i = cl_dio_pool_get(pvec->ldp_cpt, pvec->ldp_pages, pvec->ldp_count);
+	for (; i < pvec->ldp_count; i++) {
 		new_page = alloc_page(GFP_NOFS);
 		if (!new_page) {
 			result = -ENOMEM;
@@ -1409,12 +1691,43 @@ out:
 }
 EXPORT_SYMBOL(ll_allocate_dio_buffer);
 
+static void ll_dio_free_guards(struct ll_dio_pages *pvec)
+{
+	OBD_FREE_LARGE(pvec->ldp_guards, pvec->ldp_count *
+		       LL_DIO_GUARDS_PER_PAGE * sizeof(*pvec->ldp_guards));
+	pvec->ldp_guards = NULL;
+}
+
+/*
+ * For unaligned DIO writes with a T10 checksum type.
+ *
+ * Allocate room for the guard tags of the internal buffer, so that
+ * ll_dio_user_copy() can generate them while each sector is still hot in
+ * the CPU cache. Failing to allocate only means the OSC generates them itself.
+ */
+void ll_dio_alloc_guards(struct ll_dio_pages *pvec,
+			 enum cksum_types cksum_type)
+{
+	obd_dif_csum_fn *fn;
+	int sector_size;
+
+	obd_t10_cksum2dif(cksum_type, &fn, &sector_size);
+	if (!fn)
+		return;
+
+	OBD_ALLOC_LARGE(pvec->ldp_guards, pvec->ldp_count *
+			LL_DIO_GUARDS_PER_PAGE * sizeof(*pvec->ldp_guards));
+	if (pvec->ldp_guards)
+		pvec->ldp_cksum_type = cksum_type;
+}
+EXPORT_SYMBOL(ll_dio_alloc_guards);
+
 void ll_free_dio_buffer(struct ll_dio_pages *pvec)
 {
-	int i;
+	if (pvec->ldp_guards)
+		ll_dio_free_guards(pvec);
 
-	for (i = 0; i < pvec->ldp_count; i++)
-		__free_page(pvec->ldp_pages[i]);
+	cl_dio_pool_put(pvec->ldp_cpt, pvec->ldp_pages, pvec->ldp_count);
 
 #ifdef HAVE_DIO_ITER
 	kfree(pvec->ldp_pages);
@@ -1464,6 +1777,86 @@ EXPORT_SYMBOL(ll_release_user_pages);
 #define kthread_unuse_mm(mm) unuse_mm(mm)
 #endif
 
+/* generate the guard of the sector [from, to) of page \a i of the buffer */
+static void ll_dio_sector_guard(struct ll_dio_pages *pvec, int i,
+				unsigned long pg_from, unsigned long from,
+				unsigned long to)
+{
+#if IS_ENABLED(CONFIG_CRC_T10DIF)
+	obd_dif_csum_fn *fn;
+	int sector_size;
+	__be16 *guard;
+	int used;
+	int rc;
+
+	obd_t10_cksum2dif(pvec->ldp_cksum_type, &fn, &sector_size);
+	/* the guards of a page start at the sector its data starts in */
+	guard = pvec->ldp_guards + i * LL_DIO_GUARDS_PER_PAGE +
+		from / sector_size - pg_from / sector_size;
+	rc = obd_page_dif_generate_buffer("dio", pvec->ldp_pages[i], from,
+					  to - from, guard, 1, &used,
+					  sector_size, fn);
+	if (rc == 0)
+		return;
+#endif
+	/* leave it to the OSC */
+	ll_dio_free_guards(pvec);
+}
+
+static size_t ll_dio_copy_from_iter(struct page *page, unsigned long offset,
+				    size_t bytes, struct iov_iter *iter)
+{
+#ifndef HAVE_COPY_PAGE_FROM_ITER_ATOMIC
+	size_t copied = iov_iter_copy_from_user_atomic(page, iter, offset,
+						       bytes);
+
+	iov_iter_advance(iter, copied);
+	return copied;
+#else
+	return copy_page_from_iter_atomic(page, offset, bytes, iter);
+#endif
+}
+
+/*
+ * Copy \a bytes at \a offset of page \a i of the buffer from \a iter a
+ * sector at a time, and generate the guard of each sector as soon as it is
+ * complete, while its data is still in the CPU cache. The data of the page
+ * starts at \a pg_from, a copy cut short resumes within its sector.
+ *
+ * \retval	bytes copied
+ */
+static size_t ll_dio_copy_guarded(struct ll_dio_pages *pvec, int i,
+				  unsigned long pg_from, unsigned long offset,
+				  size_t bytes, struct iov_iter *iter)
+{
+	struct page *page = pvec->ldp_pages[i];
+	unsigned long end = offset + bytes;
+	size_t copied = 0;
+	obd_dif_csum_fn *fn;
+	int sector_size;
+
+	obd_t10_cksum2dif(pvec->ldp_cksum_type, &fn, &sector_size);
+	while (offset < end) {
+		unsigned long next = min_t(unsigned long,
+					   round_up(offset + 1, sector_size),
+					   end);
+		unsigned long from = max_t(unsigned long, pg_from,
+					   round_down(offset, sector_size));
+		size_t done;
+
+		done = ll_dio_copy_from_iter(page, offset, next - offset, iter);
+		copied += done;
+		if (done < next - offset)
+			break;
+		offset = next;
+
+		if (pvec->ldp_guards)
+			ll_dio_sector_guard(pvec, i, pg_from, from, next);
+	}
+
+	return copied;
+}
+
 /* copy IO data to/from internal buffer and userspace iovec */
 ssize_t ll_dio_user_copy(struct cl_sub_dio *sdio, struct iov_iter *write_iov)
 {
@@ -1471,6 +1864,8 @@ ssize_t ll_dio_user_copy(struct cl_sub_dio *sdio, struct iov_iter *write_iov)
 	struct ll_dio_pages *pvec = &sdio->csd_dio_pages;
 	struct mm_struct *mm = sdio->csd_ll_aio->cda_mm;
 	loff_t pos = pvec->ldp_file_offset;
+	/* where the data of the current page starts, for its guards */
+	unsigned long pg_from = pos & ~PAGE_MASK;
 	size_t count = sdio->csd_bytes;
 	size_t original_count = count;
 	int short_copies = 0;
@@ -1545,14 +1940,13 @@ ssize_t ll_dio_user_copy(struct cl_sub_dio *sdio, struct iov_iter *write_iov)
 			 */
 			flush_dcache_page(page);
 
-#ifndef HAVE_COPY_PAGE_FROM_ITER_ATOMIC
-			copied = iov_iter_copy_from_user_atomic(page, iter,
-								offset, bytes);
-			iov_iter_advance(iter, copied);
-#else
-			copied = copy_page_from_iter_atomic(page, offset, bytes,
-							    iter);
-#endif
+			if (pvec->ldp_guards)
+				copied = ll_dio_copy_guarded(pvec, i, pg_from,
+							     offset, bytes,
+							     iter);
+			else
+				copied = ll_dio_copy_from_iter(page, offset,
+							       bytes, iter);
 
 		} else /* READ */ {
 			copied = copy_page_to_iter(page, offset, bytes, iter);
@@ -1589,6 +1983,7 @@ ssize_t ll_dio_user_copy(struct cl_sub_dio *sdio, struct iov_iter *write_iov)
 			break;
 
 		i++;
+		pg_from = 0;
 	}
 
 out:
@@ -1115,8 +1115,14 @@ int cl_global_init(void)
 	if (result) /* no cl_env_percpu_fini on error */
 		GOTO(out_keys, result);
 
+	result = cl_dio_pools_init();
+	if (result)
+		GOTO(out_percpu, result);
+
 	return 0;
 
+out_percpu:
+	cl_env_percpu_fini();
 out_keys:
 	lu_context_key_degister(&cl_key);
 out_kmem:
@@ -1134,6 +1140,7 @@ void cl_global_fini(void)
 {
 	int i;
 
+	cl_dio_pools_fini();
 	for (i = 0; i < ARRAY_SIZE(cl_page_kmem_array); i++) {
 		if (cl_page_kmem_array[i]) {
 			kmem_cache_destroy(cl_page_kmem_array[i]);
@@ -271,6 +271,7 @@ struct cl_page *cl_page_alloc(const struct lu_env *env, struct cl_object *o,
 		 */
 		BUILD_BUG_ON((1 << CP_STATE_BITS) < CPS_NR); /* cp_state */
 		BUILD_BUG_ON((1 << CP_TYPE_BITS) < CPT_NR); /* cp_type */
+		BUILD_BUG_ON((1 << CP_ORDER_BITS) <= CL_PAGE_MAX_ORDER);
 		refcount_set(&cl_page->cp_ref, 1);
 		cl_page->cp_obj = o;
 		if (type != CPT_TRANSIENT)
@@ -287,6 +288,11 @@ struct cl_page *cl_page_alloc(const struct lu_env *env, struct cl_object *o,
 			cl_page->cp_inode = NULL;
 		else
 			cl_page->cp_inode = page2inode(vmpage);
+		if (type == CPT_CACHEABLE && PageCompound(vmpage)) {
+			LASSERT(vmpage == compound_head(vmpage));
+			LASSERT(compound_order(vmpage) <= CL_PAGE_MAX_ORDER);
+			cl_page->cp_order = compound_order(vmpage);
+		}
 		INIT_LIST_HEAD(&cl_page->cp_batch);
 		lu_ref_init(&cl_page->cp_reference);
 		head = o;
@@ -318,6 +324,9 @@ struct cl_page *cl_page_alloc(const struct lu_env *env, struct cl_object *o,
  * Returns a cl_page with index \a idx at the object \a o, and associated with
  * the VM page \a vmpage.
  *
+ * A cacheable \a vmpage may be any page of a large folio; the cl_page always
+ * hangs off the head page and covers the whole folio.
+ *
  * This is the main entry point into the cl_page caching interface. First, a
  * cache (implemented as a per-object radix tree) is consulted. If page is
  * found there, it is returned immediately. Otherwise new page is allocated
@@ -345,6 +354,9 @@ struct cl_page *cl_page_find(const struct lu_env *env,
                idx, PFID(&hdr->coh_lu.loh_fid), vmpage, vmpage->private, type);
         /* fast path. */
         if (type == CPT_CACHEABLE) {
+		/* the cl_page of a large folio hangs off its head page */
+		vmpage = compound_head(vmpage);
+		idx = vmpage->index;
 		/* vmpage lock is used to protect the child/parent
 		 * relationship */
 		LASSERT(PageLocked(vmpage));
@@ -520,7 +532,7 @@ struct cl_page *cl_vmpage_page(struct page *vmpage, struct cl_object *obj)
 	 *       bottom-to-top pass.
 	 */
 
-	page = (struct cl_page *)vmpage->private;
+	page = (struct cl_page *)compound_head(vmpage)->private;
 	if (page != NULL) {
 		cl_page_get_trust(page);
 		LASSERT(page->cp_type == CPT_CACHEABLE);
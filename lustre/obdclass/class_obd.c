@@ -42,6 +42,7 @@
 #include <obd_class.h>
 #include <uapi/linux/lnet/lnetctl.h>
 #include <lustre_kernelcomm.h>
+#include <lustre_compr.h>
 #include <lprocfs_status.h>
 #include <cl_object.h>
 #ifdef HAVE_SERVER_SUPPORT
@@ -770,10 +771,14 @@ static int __init obdclass_init(void)
 	if (err)
 		goto cleanup_cl_global;
 
+	err = ll_compr_init();
+	if (err)
+		goto cleanup_llog_info;
+
 #ifdef HAVE_SERVER_SUPPORT
 	err = dt_global_init();
 	if (err != 0)
-		goto cleanup_llog_info;
+		goto cleanup_compr;
 
 	err = lu_ucred_global_init();
 	if (err != 0)
@@ -797,8 +802,11 @@ cleanup_all:
 cleanup_dt_global:
 	dt_global_fini();
 
-cleanup_llog_info:
+cleanup_compr:
 #endif /* HAVE_SERVER_SUPPORT */
+	ll_compr_fini();
+
+cleanup_llog_info:
 	llog_info_fini();
 
 cleanup_cl_global:
@@ -874,6 +882,7 @@ static void __exit obdclass_exit(void)
 	lu_ucred_global_fini();
 	dt_global_fini();
 #endif /* HAVE_SERVER_SUPPORT */
+	ll_compr_fini();
 	llog_info_fini();
 	cl_global_fini();
 	lu_global_fini();
@@ -658,6 +658,9 @@ static const char *const obd_connect_names[] = {
 	"large_nid",			/* 0x100000000 */
 	"compressed_file",		/* 0x200000000 */
 	"unaligned_dio",		/* 0x400000000 */
+	"readdir_plus",			/* 0x800000000 */
+	"zero_write",			/* 0x1000000000 */
+	"multi_obj_brw",		/* 0x2000000000 */
 	NULL
 };
 
@@ -0,0 +1,378 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/obdclass/lustre_compr.c
+ *
+ * Chunk compression through the kernel crypto compression API.  Transforms
+ * are expensive to set up (zstd and deflate allocate large workspaces), so
+ * idle ones are kept in a small pool per algorithm and reused.
+ */
+
+#define DEBUG_SUBSYSTEM S_CLASS
+
+#include <linux/crc32.h>
+#include <linux/crypto.h>
+#include <linux/highmem.h>
+#include <linux/vmalloc.h>
+#include <obd_support.h>
+#include <lustre_compr.h>
+
+/* kernel crypto algorithm for each stored compression type */
+static const char * const ll_compr_alg_names[LL_COMPR_TYPE_MAX] = {
+	[LL_COMPR_TYPE_GZIP]	= "deflate",
+	[LL_COMPR_TYPE_LZ4FC]	= "lz4",
+	[LL_COMPR_TYPE_LZ4HC]	= "lz4hc",
+	[LL_COMPR_TYPE_LZO]	= "lzo",
+	[LL_COMPR_TYPE_ZSTD]	= "zstd",
+};
+
+static const char * const ll_compr_type_names[LL_COMPR_TYPE_MAX] = {
+	[LL_COMPR_TYPE_NONE]	= "none",
+	[LL_COMPR_TYPE_FAST]	= "fast",
+	[LL_COMPR_TYPE_BEST]	= "best",
+	[LL_COMPR_TYPE_GZIP]	= "gzip",
+	[LL_COMPR_TYPE_LZ4FC]	= "lz4",
+	[LL_COMPR_TYPE_LZ4HC]	= "lz4hc",
+	[LL_COMPR_TYPE_LZO]	= "lzo",
+	[LL_COMPR_TYPE_ZSTD]	= "zstd",
+};
+
+struct ll_compr_pool {
+	spinlock_t		 lcp_lock;
+	int			 lcp_count;
+	/* idle transforms, at most ll_compr_pool_max of them */
+	struct crypto_comp	**lcp_tfms;
+};
+
+static struct ll_compr_pool ll_compr_pools[LL_COMPR_TYPE_MAX];
+static int ll_compr_pool_max;
+static u64 ll_compr_mask;
+
+u64 ll_compr_supported_mask(void)
+{
+	return ll_compr_mask;
+}
+EXPORT_SYMBOL(ll_compr_supported_mask);
+
+const char *ll_compr_type_name(enum ll_compr_type type)
+{
+	if (type >= LL_COMPR_TYPE_MAX)
+		return "unknown";
+
+	return ll_compr_type_names[type];
+}
+EXPORT_SYMBOL(ll_compr_type_name);
+
+/**
+ * Map the FAST and BEST aliases onto an algorithm available on this node.
+ * The result is what gets recorded in the chunk header, so readers never
+ * see an alias.
+ */
+enum ll_compr_type ll_compr_type_resolve(enum ll_compr_type type)
+{
+	switch (type) {
+	case LL_COMPR_TYPE_FAST:
+		if (ll_compr_mask & BIT_ULL(LL_COMPR_TYPE_LZ4FC))
+			return LL_COMPR_TYPE_LZ4FC;
+		return LL_COMPR_TYPE_LZO;
+	case LL_COMPR_TYPE_BEST:
+		if (ll_compr_mask & BIT_ULL(LL_COMPR_TYPE_ZSTD))
+			return LL_COMPR_TYPE_ZSTD;
+		return LL_COMPR_TYPE_GZIP;
+	default:
+		return type < LL_COMPR_TYPE_MAX ? type : LL_COMPR_TYPE_NONE;
+	}
+}
+EXPORT_SYMBOL(ll_compr_type_resolve);
+
+static struct crypto_comp *ll_compr_tfm_get(enum ll_compr_type type)
+{
+	struct ll_compr_pool *pool = &ll_compr_pools[type];
+	struct crypto_comp *tfm = NULL;
+
+	spin_lock(&pool->lcp_lock);
+	if (pool->lcp_count > 0)
+		tfm = pool->lcp_tfms[--pool->lcp_count];
+	spin_unlock(&pool->lcp_lock);
+
+	if (!tfm)
+		tfm = crypto_alloc_comp(ll_compr_alg_names[type], 0, 0);
+
+	return tfm;
+}
+
+static void ll_compr_tfm_put(enum ll_compr_type type, struct crypto_comp *tfm)
+{
+	struct ll_compr_pool *pool = &ll_compr_pools[type];
+
+	spin_lock(&pool->lcp_lock);
+	if (pool->lcp_count < ll_compr_pool_max) {
+		pool->lcp_tfms[pool->lcp_count++] = tfm;
+		tfm = NULL;
+	}
+	spin_unlock(&pool->lcp_lock);
+
+	if (tfm)
+		crypto_free_comp(tfm);
+}
+
+static u32 ll_compr_hdr_csum(const struct ll_compr_hdr *llch)
+{
+	struct ll_compr_hdr tmp = *llch;
+
+	tmp.llch_hdr_csum = 0;
+
+	return crc32_le(0, (const unsigned char *)&tmp, sizeof(tmp));
+}
+
+/**
+ * Check whether a chunk starts with a usable compression header.
+ *
+ * Raw chunks can contain anything, so the header checksum is what tells a
+ * compressed chunk apart from raw data that happens to start with the magic.
+ */
+bool ll_compr_hdr_valid(const struct ll_compr_hdr *llch,
+			unsigned int chunk_size)
+{
+	if (le32_to_cpu(llch->llch_magic) != LLCH_MAGIC ||
+	    llch->llch_header_size != sizeof(*llch) ||
+	    le32_to_cpu(llch->llch_hdr_csum) != ll_compr_hdr_csum(llch))
+		return false;
+
+	if (COMPR_GET_CHUNK_SIZE(llch->llch_chunk_log_bits) != chunk_size ||
+	    le32_to_cpu(llch->llch_compr_size) > chunk_size - sizeof(*llch)) {
+		CERROR("bad compressed chunk header: chunk %u/%lu, size %u\n",
+		       chunk_size,
+		       COMPR_GET_CHUNK_SIZE(llch->llch_chunk_log_bits),
+		       le32_to_cpu(llch->llch_compr_size));
+		return false;
+	}
+
+	return true;
+}
+EXPORT_SYMBOL(ll_compr_hdr_valid);
+
+/**
+ * Compress one chunk.
+ *
+ * \param[in] type	compression type, aliases are resolved here
+ * \param[in] level	level recorded in the header; the crypto API always
+ *			uses the default level of the algorithm
+ * \param[in] chunk_bits	lcme_compr_chunk_log_bits of the layout
+ * \param[in] src	the chunk_size / PAGE_SIZE pages of the chunk
+ * \param[out] dst	chunk_size / PAGE_SIZE - 1 pages for the result
+ * \param[out] dst_pages	number of \a dst pages used
+ *
+ * \retval 0		header and compressed data are in \a dst
+ * \retval -E2BIG	compression would not save a page, store it raw
+ * \retval negative	other errors, store the chunk raw as well
+ */
+int ll_compress_pages(enum ll_compr_type type, unsigned int level,
+		      unsigned int chunk_bits, struct page **src,
+		      struct page **dst, unsigned int *dst_pages)
+{
+	unsigned int chunk_size = COMPR_GET_CHUNK_SIZE(chunk_bits);
+	unsigned int count = chunk_size >> PAGE_SHIFT;
+	struct ll_compr_hdr *llch;
+	struct crypto_comp *tfm;
+	unsigned int len;
+	void *in = NULL;
+	void *out = NULL;
+	int rc;
+
+	type = ll_compr_type_resolve(type);
+	if (!(ll_compr_mask & BIT_ULL(type)))
+		return -EOPNOTSUPP;
+	if (count < 2)
+		return -E2BIG;
+
+	tfm = ll_compr_tfm_get(type);
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
+
+	in = vmap(src, count, VM_MAP, PAGE_KERNEL);
+	out = vmap(dst, count - 1, VM_MAP, PAGE_KERNEL);
+	if (!in || !out)
+		GOTO(out_unmap, rc = -ENOMEM);
+
+	/* output that does not fit in one page less than the input is
+	 * refused by the compressor
+	 */
+	len = (count - 1) * PAGE_SIZE - sizeof(*llch);
+	rc = crypto_comp_compress(tfm, in, chunk_size, out + sizeof(*llch),
+				  &len);
+	if (rc)
+		GOTO(out_unmap, rc = -E2BIG);
+
+	llch = out;
+	memset(llch, 0, sizeof(*llch));
+	llch->llch_magic = cpu_to_le32(LLCH_MAGIC);
+	llch->llch_header_size = sizeof(*llch);
+	llch->llch_compr_type = type;
+	llch->llch_compr_level = level;
+	llch->llch_chunk_log_bits = chunk_bits;
+	llch->llch_compr_size = cpu_to_le32(len);
+	llch->llch_hdr_csum = cpu_to_le32(ll_compr_hdr_csum(llch));
+
+	len += sizeof(*llch);
+	*dst_pages = DIV_ROUND_UP(len, PAGE_SIZE);
+	/* do not write stale bounce page contents to disk */
+	memset(out + len, 0, *dst_pages * PAGE_SIZE - len);
+out_unmap:
+	if (out)
+		vunmap(out);
+	if (in)
+		vunmap(in);
+	ll_compr_tfm_put(type, tfm);
+
+	return rc;
+}
+EXPORT_SYMBOL(ll_compress_pages);
+
+static int ll_decompress_data(const struct ll_compr_hdr *llch,
+			      const void *src, void *dst,
+			      unsigned int chunk_size)
+{
+	enum ll_compr_type type = llch->llch_compr_type;
+	unsigned int csize = le32_to_cpu(llch->llch_compr_size);
+	struct crypto_comp *tfm;
+	unsigned int len;
+	int rc;
+
+	if (type >= LL_COMPR_TYPE_MAX || !(ll_compr_mask & BIT_ULL(type)) ||
+	    !ll_compr_alg_names[type])
+		return -EOPNOTSUPP;
+
+	tfm = ll_compr_tfm_get(type);
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
+
+	len = chunk_size;
+	rc = crypto_comp_decompress(tfm, src, csize, dst, &len);
+	ll_compr_tfm_put(type, tfm);
+	if (rc) {
+		CERROR("cannot decompress %s chunk of %u bytes: rc = %d\n",
+		       ll_compr_type_name(type), csize, rc);
+		return -EIO;
+	}
+	if (len < chunk_size)
+		memset(dst + len, 0, chunk_size - len);
+
+	return 0;
+}
+
+/**
+ * Decompress one chunk in place.
+ *
+ * \a pages holds the chunk as stored on the OST.  A chunk without a valid
+ * header is raw and left untouched, otherwise it is replaced with the
+ * decompressed data.
+ *
+ * \retval 0		\a pages contain the uncompressed chunk
+ * \retval -EOPNOTSUPP	the algorithm is not available on this node
+ * \retval negative	corrupted data or allocation failure
+ */
+int ll_decompress_pages(struct page **pages, unsigned int chunk_bits)
+{
+	unsigned int chunk_size = COMPR_GET_CHUNK_SIZE(chunk_bits);
+	unsigned int count = chunk_size >> PAGE_SHIFT;
+	struct ll_compr_hdr llch;
+	unsigned int csize;
+	void *data;
+	void *buf;
+	int rc;
+
+	data = kmap_atomic(pages[0]);
+	memcpy(&llch, data, sizeof(llch));
+	kunmap_atomic(data);
+
+	if (!ll_compr_hdr_valid(&llch, chunk_size))
+		return 0;
+
+	data = vmap(pages, count, VM_MAP, PAGE_KERNEL);
+	if (!data)
+		return -ENOMEM;
+
+	/* source and destination are the same pages */
+	csize = le32_to_cpu(llch.llch_compr_size);
+	OBD_ALLOC_LARGE(buf, csize);
+	if (!buf)
+		GOTO(out_unmap, rc = -ENOMEM);
+	memcpy(buf, data + sizeof(llch), csize);
+
+	rc = ll_decompress_data(&llch, buf, data, chunk_size);
+	OBD_FREE_LARGE(buf, csize);
+out_unmap:
+	vunmap(data);
+
+	return rc;
+}
+EXPORT_SYMBOL(ll_decompress_pages);
+
+/**
+ * Decompress one chunk from a flat buffer, for callers that already have
+ * the stored chunk in memory and checked its header.
+ *
+ * \param[in] src	the stored chunk, starting with its header
+ * \param[out] dst	\a chunk_size bytes for the uncompressed data
+ */
+int ll_decompress_chunk(const void *src, void *dst, unsigned int chunk_size)
+{
+	const struct ll_compr_hdr *llch = src;
+
+	return ll_decompress_data(llch, src + sizeof(*llch), dst, chunk_size);
+}
+EXPORT_SYMBOL(ll_decompress_chunk);
+
+int ll_compr_init(void)
+{
+	int type;
+
+	ll_compr_pool_max = num_online_cpus();
+	for (type = 0; type < LL_COMPR_TYPE_MAX; type++) {
+		struct ll_compr_pool *pool = &ll_compr_pools[type];
+
+		spin_lock_init(&pool->lcp_lock);
+		if (!ll_compr_alg_names[type] ||
+		    !crypto_has_comp(ll_compr_alg_names[type], 0, 0))
+			continue;
+
+		OBD_ALLOC_PTR_ARRAY(pool->lcp_tfms, ll_compr_pool_max);
+		if (!pool->lcp_tfms) {
+			ll_compr_fini();
+			return -ENOMEM;
+		}
+		ll_compr_mask |= BIT_ULL(type);
+	}
+
+	if (ll_compr_mask & (BIT_ULL(LL_COMPR_TYPE_LZ4FC) |
+			     BIT_ULL(LL_COMPR_TYPE_LZO)))
+		ll_compr_mask |= BIT_ULL(LL_COMPR_TYPE_FAST);
+	if (ll_compr_mask & (BIT_ULL(LL_COMPR_TYPE_ZSTD) |
+			     BIT_ULL(LL_COMPR_TYPE_GZIP)))
+		ll_compr_mask |= BIT_ULL(LL_COMPR_TYPE_BEST);
+
+	CDEBUG(D_INFO, "supported compression types %#llx\n", ll_compr_mask);
+
+	return 0;
+}
+
+void ll_compr_fini(void)
+{
+	int type;
+
+	for (type = 0; type < LL_COMPR_TYPE_MAX; type++) {
+		struct ll_compr_pool *pool = &ll_compr_pools[type];
+
+		if (!pool->lcp_tfms)
+			continue;
+
+		while (pool->lcp_count > 0)
+			crypto_free_comp(pool->lcp_tfms[--pool->lcp_count]);
+		OBD_FREE_PTR_ARRAY(pool->lcp_tfms, ll_compr_pool_max);
+		pool->lcp_tfms = NULL;
+	}
+	ll_compr_mask = 0;
+}
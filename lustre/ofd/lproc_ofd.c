@@ -984,6 +984,9 @@ void ofd_stats_counter_init(struct lprocfs_stats *stats, unsigned int offset,
 			     LPROCFS_TYPE_LATENCY & (~cntr_umask), "quotactl");
 	lprocfs_counter_init(stats, LPROC_OFD_STATS_PREALLOC,
 			     LPROCFS_TYPE_LATENCY & (~cntr_umask), "prealloc");
+	lprocfs_counter_init(stats, LPROC_OFD_STATS_DECOMPR_BYTES,
+			     LPROCFS_TYPE_BYTES_FULL_HISTOGRAM & (~cntr_umask),
+			     "decompr_bytes");
 }
 
 LPROC_SEQ_FOPS(lprocfs_nid_stats_clear);
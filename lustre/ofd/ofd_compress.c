@@ -0,0 +1,1012 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/ofd/ofd_compress.c
+ *
+ * Server side decompression of compressed chunks for reads from clients
+ * which cannot decompress the stored algorithm themselves, either because
+ * they don't support OBD_CONNECT2_COMPRESS at all or because the algorithm
+ * is missing from their ocd_compr_type.
+ *
+ * The stored pages are never modified: decompressed data is placed into
+ * private bounce pages which are swapped into the niobuf_local array for
+ * the bulk and swapped back before the buffers are released.
+ *
+ * Objects holding compressed chunks are flagged with XATTR_NAME_COMPR,
+ * reads of other objects never look for chunk headers. Raw writes,
+ * truncates and punches cutting through a compressed chunk of such an
+ * object first get the chunk stored uncompressed, so the part of it they
+ * leave alone stays readable.
+ */
+
+#define DEBUG_SUBSYSTEM S_FILTER
+
+#include <linux/highmem.h>
+#include <libcfs/libcfs_cpu.h>
+#include <lustre_compr.h>
+
+#include "ofd_internal.h"
+
+/* idle workspaces kept per CPT, more are freed once released */
+#define OFD_COMPR_WS_PER_CPT	4
+
+#define OFD_COMPR_CHUNK_MAX	COMPR_GET_CHUNK_SIZE(COMPR_CHUNK_MAX_BITS)
+#define OFD_COMPR_LNB_MAX	(OFD_COMPR_CHUNK_MAX >> PAGE_SHIFT)
+
+struct ofd_compr_pool {
+	spinlock_t		 ocp_lock;
+	struct list_head	 ocp_idle;
+	int			 ocp_nr_idle;
+};
+
+struct ofd_compr_ws {
+	struct list_head	 ocw_list;
+	int			 ocw_cpt;
+	/* stored and decompressed data of the chunk being handled */
+	void			*ocw_src;
+	void			*ocw_dst;
+	/* file range of the chunk decompressed into ocw_dst by the read */
+	__u64			 ocw_dst_start;
+	unsigned int		 ocw_dst_len;
+	/* buffers for reads outside of the RPC pages */
+	struct niobuf_local	*ocw_lnb;
+	/* original page of each swapped niobuf_local, by lnb index */
+	struct page		**ocw_orig;
+	/* pages of chunks crossing the RPC range, prepared before the read */
+	struct page		**ocw_pre_page;
+	__u64			*ocw_pre_off;
+	int			 ocw_nr_pre;
+	/* bytes decompressed for this RPC */
+	__u64			 ocw_bytes;
+};
+
+static void ofd_compr_ws_free(struct ofd_compr_ws *ws)
+{
+	if (ws->ocw_src)
+		OBD_FREE_LARGE(ws->ocw_src, OFD_COMPR_CHUNK_MAX);
+	if (ws->ocw_dst)
+		OBD_FREE_LARGE(ws->ocw_dst, OFD_COMPR_CHUNK_MAX);
+	if (ws->ocw_lnb)
+		OBD_FREE_PTR_ARRAY_LARGE(ws->ocw_lnb, OFD_COMPR_LNB_MAX);
+	if (ws->ocw_orig)
+		OBD_FREE_PTR_ARRAY_LARGE(ws->ocw_orig, PTLRPC_MAX_BRW_PAGES);
+	if (ws->ocw_pre_page)
+		OBD_FREE_PTR_ARRAY_LARGE(ws->ocw_pre_page,
+					 PTLRPC_MAX_BRW_PAGES);
+	if (ws->ocw_pre_off)
+		OBD_FREE_PTR_ARRAY_LARGE(ws->ocw_pre_off,
+					 PTLRPC_MAX_BRW_PAGES);
+	OBD_FREE_PTR(ws);
+}
+
+static struct ofd_compr_ws *ofd_compr_ws_alloc(int cpt)
+{
+	struct ofd_compr_ws *ws;
+
+	OBD_CPT_ALLOC_PTR(ws, cfs_cpt_tab, cpt);
+	if (!ws)
+		return NULL;
+
+	INIT_LIST_HEAD(&ws->ocw_list);
+	ws->ocw_cpt = cpt;
+	OBD_ALLOC_LARGE(ws->ocw_src, OFD_COMPR_CHUNK_MAX);
+	OBD_ALLOC_LARGE(ws->ocw_dst, OFD_COMPR_CHUNK_MAX);
+	OBD_ALLOC_PTR_ARRAY_LARGE(ws->ocw_lnb, OFD_COMPR_LNB_MAX);
+	OBD_ALLOC_PTR_ARRAY_LARGE(ws->ocw_orig, PTLRPC_MAX_BRW_PAGES);
+	OBD_ALLOC_PTR_ARRAY_LARGE(ws->ocw_pre_page, PTLRPC_MAX_BRW_PAGES);
+	OBD_ALLOC_PTR_ARRAY_LARGE(ws->ocw_pre_off, PTLRPC_MAX_BRW_PAGES);
+	if (!ws->ocw_src || !ws->ocw_dst || !ws->ocw_lnb || !ws->ocw_orig ||
+	    !ws->ocw_pre_page || !ws->ocw_pre_off) {
+		ofd_compr_ws_free(ws);
+		return NULL;
+	}
+
+	return ws;
+}
+
+static struct ofd_compr_ws *ofd_compr_ws_get(struct ofd_device *ofd)
+{
+	struct ofd_compr_pool *pool;
+	struct ofd_compr_ws *ws = NULL;
+	int cpt;
+
+	cpt = cfs_cpt_current(cfs_cpt_tab, 1);
+	pool = ofd->ofd_compr_pools[cpt];
+
+	spin_lock(&pool->ocp_lock);
+	if (!list_empty(&pool->ocp_idle)) {
+		ws = list_first_entry(&pool->ocp_idle, struct ofd_compr_ws,
+				      ocw_list);
+		list_del_init(&ws->ocw_list);
+		pool->ocp_nr_idle--;
+	}
+	spin_unlock(&pool->ocp_lock);
+
+	if (!ws)
+		ws = ofd_compr_ws_alloc(cpt);
+
+	return ws;
+}
+
+static void ofd_compr_ws_put(struct ofd_device *ofd, struct ofd_compr_ws *ws)
+{
+	struct ofd_compr_pool *pool = ofd->ofd_compr_pools[ws->ocw_cpt];
+	int i;
+
+	/* pages prepared for a chunk but not used by the RPC */
+	for (i = 0; i < ws->ocw_nr_pre; i++) {
+		if (ws->ocw_pre_page[i]) {
+			__free_page(ws->ocw_pre_page[i]);
+			ws->ocw_pre_page[i] = NULL;
+		}
+	}
+	ws->ocw_nr_pre = 0;
+	ws->ocw_dst_len = 0;
+	ws->ocw_bytes = 0;
+
+	spin_lock(&pool->ocp_lock);
+	if (pool->ocp_nr_idle < OFD_COMPR_WS_PER_CPT) {
+		list_add(&ws->ocw_list, &pool->ocp_idle);
+		pool->ocp_nr_idle++;
+		ws = NULL;
+	}
+	spin_unlock(&pool->ocp_lock);
+
+	if (ws)
+		ofd_compr_ws_free(ws);
+}
+
+/**
+ * Set up the per-CPT decompression workspace pools of OFD device.
+ *
+ * \param[in] m		OFD device
+ *
+ * \retval		0 on success
+ * \retval		negative value on error
+ */
+int ofd_compr_init(struct ofd_device *m)
+{
+	struct ofd_compr_pool *pool;
+	int i;
+
+	m->ofd_compr_pools = cfs_percpt_alloc(cfs_cpt_tab, sizeof(*pool));
+	if (!m->ofd_compr_pools)
+		return -ENOMEM;
+
+	cfs_percpt_for_each(pool, i, m->ofd_compr_pools) {
+		spin_lock_init(&pool->ocp_lock);
+		INIT_LIST_HEAD(&pool->ocp_idle);
+		pool->ocp_nr_idle = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * Free the decompression workspaces of OFD device.
+ *
+ * \param[in] m		OFD device
+ */
+void ofd_compr_fini(struct ofd_device *m)
+{
+	struct ofd_compr_pool *pool;
+	struct ofd_compr_ws *ws;
+	int i;
+
+	if (!m->ofd_compr_pools)
+		return;
+
+	cfs_percpt_for_each(pool, i, m->ofd_compr_pools) {
+		while ((ws = list_first_entry_or_null(&pool->ocp_idle,
+						      struct ofd_compr_ws,
+						      ocw_list)) != NULL) {
+			list_del(&ws->ocw_list);
+			ofd_compr_ws_free(ws);
+		}
+	}
+
+	cfs_percpt_free(m->ofd_compr_pools);
+	m->ofd_compr_pools = NULL;
+}
+
+/*
+ * Whether the client has to be given decompressed data. Types this server
+ * cannot decompress are always sent as stored.
+ */
+static bool ofd_compr_needed(struct obd_export *exp, enum ll_compr_type type)
+{
+	if (!(ll_compr_supported_mask() & BIT_ULL(type)))
+		return false;
+
+	return !exp_connect_compress(exp) ||
+	       !(exp->exp_connect_data.ocd_compr_type & BIT_ULL(type));
+}
+
+/*
+ * Load XATTR_NAME_COMPR of \a fo once. Done under the object lock, so it
+ * cannot race with ofd_compr_attr_set().
+ */
+static int ofd_compr_attr_load(const struct lu_env *env, struct ofd_object *fo)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	struct ll_compr_attr *lca = &info->fti_compr_attr;
+	struct lu_buf *buf = &info->fti_buf;
+	int rc;
+
+	if (fo->ofo_compr_loaded)
+		return 0;
+
+	ofd_read_lock(env, fo);
+	if (fo->ofo_compr_loaded)
+		GOTO(unlock, rc = 0);
+
+	buf->lb_buf = lca;
+	buf->lb_len = sizeof(*lca);
+	rc = dt_xattr_get(env, ofd_object_child(fo), buf, XATTR_NAME_COMPR);
+	if (rc == -ENODATA) {
+		fo->ofo_compr_types = 0;
+	} else if (rc < 0) {
+		GOTO(unlock, rc);
+	} else if (rc < sizeof(*lca) ||
+		   lca->lca_chunk_log_bits > COMPR_CHUNK_MAX_BITS) {
+		GOTO(unlock, rc = -EINVAL);
+	} else {
+		fo->ofo_compr_types = le32_to_cpu(lca->lca_types);
+		fo->ofo_compr_bits = lca->lca_chunk_log_bits;
+	}
+	fo->ofo_compr_loaded = true;
+	rc = 0;
+unlock:
+	ofd_read_unlock(env, fo);
+
+	return rc;
+}
+
+/*
+ * Quick check that no chunk of \a fo could need decompression for this
+ * client, so objects never written compressed and clients handling every
+ * type stored never pay for the probing.
+ */
+static bool ofd_compr_skip(struct obd_export *exp, struct ofd_object *fo)
+{
+	u64 types = fo->ofo_compr_types & ll_compr_supported_mask();
+
+	if (exp_connect_compress(exp))
+		types &= ~exp->exp_connect_data.ocd_compr_type;
+
+	return !types;
+}
+
+/*
+ * Check that \a llch describes a compressed chunk of 2^bits starting at
+ * \a start. The bits are checked first, so probing a smaller chunk at an
+ * aligned offset does not complain about the size.
+ */
+static bool ofd_compr_hdr_check(const struct ll_compr_hdr *llch, __u64 start,
+				unsigned int bits)
+{
+	unsigned int chunk_size = COMPR_GET_CHUNK_SIZE(bits);
+
+	if (le32_to_cpu(llch->llch_magic) != LLCH_MAGIC ||
+	    llch->llch_chunk_log_bits != bits || start & (chunk_size - 1))
+		return false;
+
+	return ll_compr_hdr_valid(llch, chunk_size);
+}
+
+/*
+ * Read \a len bytes of the object at \a start into \a buf, outside of the
+ * RPC pages. Holes and data past EOF read as zeroes. The caller holds the
+ * object read lock.
+ */
+static int ofd_compr_read_buf(const struct lu_env *env, struct ofd_object *fo,
+			      struct ofd_compr_ws *ws, __u64 start,
+			      unsigned int len, void *buf)
+{
+	struct dt_object *o = ofd_object_child(fo);
+	struct niobuf_remote rnb = {
+		.rnb_offset = start,
+		.rnb_len = len,
+	};
+	struct niobuf_local *lnb = ws->ocw_lnb;
+	unsigned int done = 0;
+	int nr, i, rc;
+
+	nr = dt_bufs_get(env, o, &rnb, lnb, OFD_COMPR_LNB_MAX,
+			 DT_BUFS_TYPE_READ);
+	if (nr < 0)
+		return nr;
+
+	rc = dt_read_prep(env, o, lnb, nr);
+
+	for (i = 0; rc == 0 && i < nr && lnb[i].lnb_rc > 0; i++) {
+		char *ptr = kmap_atomic(lnb[i].lnb_page);
+
+		memcpy(buf + done, ptr + (lnb[i].lnb_page_offset & ~PAGE_MASK),
+		       lnb[i].lnb_rc);
+		kunmap_atomic(ptr);
+		done += lnb[i].lnb_rc;
+	}
+	dt_bufs_put(env, o, lnb, nr);
+
+	if (rc)
+		return rc;
+	if (done < len)
+		memset(buf + done, 0, len - done);
+
+	return 0;
+}
+
+/*
+ * Copy the decompressed pages of the chunk at \a start which fall into
+ * [\a from, \a to) into new pages recorded in ws->ocw_pre_*.
+ */
+static int ofd_compr_pre_pages(struct ofd_compr_ws *ws, __u64 start,
+			       __u64 from, __u64 to)
+{
+	__u64 off;
+
+	for (off = from & PAGE_MASK; off < to; off += PAGE_SIZE) {
+		struct page *page;
+		char *ptr;
+
+		if (ws->ocw_nr_pre >= PTLRPC_MAX_BRW_PAGES)
+			return -EOVERFLOW;
+
+		page = alloc_page(GFP_NOFS);
+		if (!page)
+			return -ENOMEM;
+
+		ptr = kmap_atomic(page);
+		memcpy(ptr, ws->ocw_dst + (off - start), PAGE_SIZE);
+		kunmap_atomic(ptr);
+
+		ws->ocw_pre_off[ws->ocw_nr_pre] = off;
+		ws->ocw_pre_page[ws->ocw_nr_pre] = page;
+		ws->ocw_nr_pre++;
+	}
+
+	return 0;
+}
+
+/*
+ * Look for a compressed chunk containing \a pos which is only partly
+ * covered by [\a from, \a to), and decompress the covered part of it.
+ * Chunks entirely inside the range are left to ofd_decompress_read().
+ *
+ * \retval	end of the chunk containing \a pos
+ */
+static __s64 ofd_compr_boundary(const struct lu_env *env,
+				struct obd_export *exp, struct ofd_object *fo,
+				struct ofd_compr_ws *ws, __u64 pos,
+				__u64 from, __u64 to)
+{
+	struct ll_compr_hdr *llch = ws->ocw_src;
+	unsigned int bits = fo->ofo_compr_bits;
+	unsigned int chunk_size = COMPR_GET_CHUNK_SIZE(bits);
+	__u64 start = round_down(pos, chunk_size);
+	int rc;
+
+	if (start >= from && start + chunk_size <= to)
+		return start + chunk_size;
+
+	ofd_read_lock(env, fo);
+	rc = ofd_compr_read_buf(env, fo, ws, start, sizeof(*llch), llch);
+	if (rc || !ofd_compr_hdr_check(llch, start, bits) ||
+	    !ofd_compr_needed(exp, llch->llch_compr_type)) {
+		ofd_read_unlock(env, fo);
+		return rc ?: start + chunk_size;
+	}
+
+	rc = ofd_compr_read_buf(env, fo, ws, start,
+				sizeof(*llch) + le32_to_cpu(llch->llch_compr_size),
+				ws->ocw_src);
+	ofd_read_unlock(env, fo);
+	if (rc)
+		return rc;
+	rc = ll_decompress_chunk(ws->ocw_src, ws->ocw_dst, chunk_size);
+	if (rc)
+		return rc;
+
+	rc = ofd_compr_pre_pages(ws, start, max(start, from),
+				 min(start + chunk_size, to));
+	if (rc)
+		return rc;
+	ws->ocw_bytes += chunk_size;
+
+	return start + chunk_size;
+}
+
+/**
+ * Decompress chunks crossing the edges of the remote buffers.
+ *
+ * Called before the RPC pages are taken, as reading the rest of such a
+ * chunk needs buffers of its own. The result is kept in the workspace
+ * until ofd_decompress_read() puts it into the RPC pages.
+ *
+ * \param[in] env	execution environment
+ * \param[in] exp	OBD export of client
+ * \param[in] ofd	OFD device
+ * \param[in] fo	OFD object
+ * \param[in] niocount	number of remote buffers
+ * \param[in] rnb	remote buffers
+ *
+ * \retval		0 on success
+ * \retval		negative value on error
+ */
+int ofd_decompress_read_prep(const struct lu_env *env, struct obd_export *exp,
+			     struct ofd_device *ofd, struct ofd_object *fo,
+			     int niocount, struct niobuf_remote *rnb)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	struct ofd_compr_ws *ws;
+	__s64 next = 0;
+	int i;
+
+	ENTRY;
+
+	info->fti_compr_ws = NULL;
+	next = ofd_compr_attr_load(env, fo);
+	if (next < 0)
+		GOTO(out_nows, next);
+	if (ofd_compr_skip(exp, fo))
+		RETURN(0);
+
+	ws = ofd_compr_ws_get(ofd);
+	if (!ws)
+		RETURN(-ENOMEM);
+	info->fti_compr_ws = ws;
+
+	for (i = 0; i < niocount; i++) {
+		__u64 from = rnb[i].rnb_offset;
+		__u64 to = from + rnb[i].rnb_len;
+
+		/*
+		 * Each remote buffer is handled on its own, a chunk shared
+		 * with the next one is decompressed again for it.
+		 */
+		next = ofd_compr_boundary(env, exp, fo, ws, from, from, to);
+		if (next < 0)
+			GOTO(out, next);
+		if (to <= (__u64)next)
+			continue;
+		next = ofd_compr_boundary(env, exp, fo, ws, to - 1, from, to);
+		if (next < 0)
+			GOTO(out, next);
+	}
+	RETURN(0);
+out:
+	ofd_compr_ws_put(ofd, ws);
+	info->fti_compr_ws = NULL;
+out_nows:
+	CERROR("%s: cannot decompress "DFID" for %s: rc = %d\n",
+	       ofd_name(ofd), PFID(lu_object_fid(&fo->ofo_obj.do_lu)),
+	       obd_export_nid2str(exp), (int)next);
+	RETURN(next);
+}
+
+static void ofd_compr_swap(struct ofd_compr_ws *ws, struct niobuf_local *lnb,
+			   int i, struct page *page)
+{
+	LASSERT(!ws->ocw_orig[i]);
+	ws->ocw_orig[i] = lnb[i].lnb_page;
+	lnb[i].lnb_page = page;
+	/* the guard of the stored data is no good for the new content */
+	lnb[i].lnb_guard_disk = 0;
+}
+
+/*
+ * Put the decompressed page at \a off of the chunk held in ws->ocw_dst
+ * into lnb[\a i].
+ */
+static int ofd_compr_dst_page(struct ofd_compr_ws *ws,
+			      struct niobuf_local *lnb, int i, __u64 off)
+{
+	struct page *page = alloc_page(GFP_NOFS);
+	char *ptr;
+
+	if (!page)
+		return -ENOMEM;
+
+	ptr = kmap_atomic(page);
+	memcpy(ptr, ws->ocw_dst + (off - ws->ocw_dst_start), PAGE_SIZE);
+	kunmap_atomic(ptr);
+	ofd_compr_swap(ws, lnb, i, page);
+
+	return 0;
+}
+
+/*
+ * Decompress the chunk starting at lnb[\a i] if it is compressed in a type
+ * the client cannot handle.
+ *
+ * The chunk stays in ws->ocw_dst, so pages of it which are not contiguous
+ * with lnb[\a i] in the RPC get their data from there when the caller
+ * reaches them. The stored data itself has to be in the pages following
+ * lnb[\a i], a client which cannot decompress must never get it as is.
+ *
+ * \retval	number of niobufs handled, 0 if not a chunk to decompress
+ * \retval	negative value on error
+ */
+static int ofd_compr_inner(struct obd_export *exp, struct ofd_compr_ws *ws,
+			   struct niobuf_local *lnb, int i, int npages)
+{
+	__u64 start = lnb[i].lnb_file_offset;
+	struct ll_compr_hdr *llch;
+	unsigned int chunk_size, stored, bits;
+	int count, j, rc;
+	char *ptr;
+
+	if (lnb[i].lnb_page_offset & ~PAGE_MASK ||
+	    lnb[i].lnb_rc < sizeof(*llch) ||
+	    start & (COMPR_GET_CHUNK_SIZE(0) - 1))
+		return 0;
+
+	ptr = kmap_atomic(lnb[i].lnb_page);
+	memcpy(ws->ocw_src, ptr, sizeof(*llch));
+	kunmap_atomic(ptr);
+
+	llch = ws->ocw_src;
+	bits = llch->llch_chunk_log_bits;
+	if (bits > COMPR_CHUNK_MAX_BITS ||
+	    !ofd_compr_hdr_check(llch, start, bits) ||
+	    !ofd_compr_needed(exp, llch->llch_compr_type))
+		return 0;
+
+	/* pages of the chunk following lnb[i] contiguously in the RPC */
+	chunk_size = COMPR_GET_CHUNK_SIZE(bits);
+	for (count = 1; count < chunk_size >> PAGE_SHIFT; count++) {
+		j = i + count;
+		if (j >= npages ||
+		    lnb[j].lnb_file_offset != start + count * PAGE_SIZE ||
+		    lnb[j].lnb_page_offset & ~PAGE_MASK || ws->ocw_orig[j])
+			break;
+	}
+
+	stored = sizeof(*llch) + le32_to_cpu(llch->llch_compr_size);
+	if (stored > count * PAGE_SIZE) {
+		CDEBUG(D_PAGE, "chunk at %llu: %u stored bytes, %d pages\n",
+		       start, stored, count);
+		return -EIO;
+	}
+
+	for (j = 0; j * PAGE_SIZE < stored; j++) {
+		unsigned int len = min_t(unsigned int, PAGE_SIZE,
+					 stored - j * PAGE_SIZE);
+		unsigned int valid = max(lnb[i + j].lnb_rc, 0);
+
+		ptr = kmap_atomic(lnb[i + j].lnb_page);
+		memcpy(ws->ocw_src + j * PAGE_SIZE, ptr, min(len, valid));
+		kunmap_atomic(ptr);
+		if (valid < len)
+			memset(ws->ocw_src + j * PAGE_SIZE + valid, 0,
+			       len - valid);
+	}
+
+	ws->ocw_dst_len = 0;
+	rc = ll_decompress_chunk(ws->ocw_src, ws->ocw_dst, chunk_size);
+	if (rc)
+		return rc;
+	ws->ocw_dst_start = start;
+	ws->ocw_dst_len = chunk_size;
+	ws->ocw_bytes += chunk_size;
+
+	for (j = 0; j < count; j++) {
+		rc = ofd_compr_dst_page(ws, lnb, i + j, start + j * PAGE_SIZE);
+		if (rc)
+			return rc;
+	}
+
+	return count;
+}
+
+/**
+ * Put decompressed data into the RPC pages after they were read.
+ *
+ * Pages prepared by ofd_decompress_read_prep() replace their niobufs and
+ * chunks lying entirely inside the RPC are decompressed from the pages
+ * just read. Reads of chunks which cannot be decompressed fail rather than
+ * give compressed data to the client. The original pages are restored by ofd_decompress_read_fini().
+ *
+ * \param[in] env	execution environment
+ * \param[in] exp	OBD export of client
+ * \param[in] ofd	OFD device
+ * \param[in] npages	number of local buffers
+ * \param[in] lnb	local buffers
+ *
+ * \retval		0 on success
+ * \retval		negative value on error
+ */
+int ofd_decompress_read(const struct lu_env *env, struct obd_export *exp,
+			struct ofd_device *ofd, int npages,
+			struct niobuf_local *lnb)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	struct ofd_compr_ws *ws = info->fti_compr_ws;
+	int i, p = 0, rc = 0;
+
+	ENTRY;
+
+	if (!ws)
+		RETURN(0);
+
+	for (i = 0; i < npages; i++) {
+		__u64 off = lnb[i].lnb_file_offset & PAGE_MASK;
+
+		while (p < ws->ocw_nr_pre && ws->ocw_pre_off[p] < off)
+			p++;
+		if (p < ws->ocw_nr_pre && ws->ocw_pre_off[p] == off) {
+			ofd_compr_swap(ws, lnb, i, ws->ocw_pre_page[p]);
+			ws->ocw_pre_page[p++] = NULL;
+			continue;
+		}
+		/* rest of a chunk split up in the RPC */
+		if (ws->ocw_dst_len && off >= ws->ocw_dst_start &&
+		    off < ws->ocw_dst_start + ws->ocw_dst_len) {
+			rc = ofd_compr_dst_page(ws, lnb, i, off);
+			if (rc < 0)
+				break;
+			continue;
+		}
+
+		rc = ofd_compr_inner(exp, ws, lnb, i, npages);
+		if (rc < 0)
+			break;
+		if (rc > 0)
+			i += rc - 1;
+		rc = 0;
+	}
+
+	if (rc) {
+		CERROR("%s: cannot decompress "DFID" for %s: rc = %d\n",
+		       ofd_name(ofd),
+		       PFID(lu_object_fid(&info->fti_obj->ofo_obj.do_lu)),
+		       obd_export_nid2str(exp), rc);
+		ofd_decompress_read_fini(env, ofd, npages, lnb);
+	} else if (!ws->ocw_bytes) {
+		/* nothing compressed, drop the workspace early */
+		ofd_compr_ws_put(ofd, ws);
+		info->fti_compr_ws = NULL;
+	}
+
+	RETURN(rc);
+}
+
+/**
+ * Restore the original RPC pages and release the workspace.
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] npages	number of local buffers
+ * \param[in] lnb	local buffers
+ *
+ * \retval		bytes decompressed for the RPC
+ */
+__u64 ofd_decompress_read_fini(const struct lu_env *env,
+			       struct ofd_device *ofd, int npages,
+			       struct niobuf_local *lnb)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	struct ofd_compr_ws *ws = info->fti_compr_ws;
+	__u64 bytes;
+	int i;
+
+	if (!ws)
+		return 0;
+
+	for (i = 0; i < npages; i++) {
+		if (ws->ocw_orig[i]) {
+			__free_page(lnb[i].lnb_page);
+			lnb[i].lnb_page = ws->ocw_orig[i];
+			ws->ocw_orig[i] = NULL;
+		}
+	}
+
+	bytes = ws->ocw_bytes;
+	ofd_compr_ws_put(ofd, ws);
+	info->fti_compr_ws = NULL;
+
+	return bytes;
+}
+
+/**
+ * Find the compressed chunks written by an RPC.
+ *
+ * Called once the data is in \a lnb. The types and chunk size found are
+ * left in ofd_thread_info::fti_compr_attr for ofd_compr_attr_set().
+ *
+ * \param[in] env	execution environment
+ * \param[in] fo	OFD object
+ * \param[in] npages	number of local buffers
+ * \param[in] lnb	local buffers
+ *
+ * \retval		1 if XATTR_NAME_COMPR of \a fo has to be updated
+ * \retval		0 if not
+ * \retval		negative value on error
+ */
+int ofd_compr_attr_prep(const struct lu_env *env, struct ofd_object *fo,
+			int npages, struct niobuf_local *lnb)
+{
+	struct ll_compr_attr *lca = &ofd_info(env)->fti_compr_attr;
+	struct ll_compr_hdr llch;
+	__u32 types = 0;
+	unsigned int bits = 0;
+	int i, rc;
+
+	for (i = 0; i < npages; i++) {
+		char *ptr;
+
+		if (!(lnb[i].lnb_flags & OBD_BRW_COMPRESSED) ||
+		    lnb[i].lnb_page_offset & ~PAGE_MASK ||
+		    lnb[i].lnb_len < sizeof(llch))
+			continue;
+
+		ptr = kmap_atomic(lnb[i].lnb_page);
+		memcpy(&llch, ptr, sizeof(llch));
+		kunmap_atomic(ptr);
+
+		if (llch.llch_chunk_log_bits > COMPR_CHUNK_MAX_BITS ||
+		    !ofd_compr_hdr_check(&llch, lnb[i].lnb_file_offset,
+					 llch.llch_chunk_log_bits))
+			continue;
+
+		types |= BIT(llch.llch_compr_type);
+		bits = llch.llch_chunk_log_bits;
+	}
+	if (!types)
+		return 0;
+
+	rc = ofd_compr_attr_load(env, fo);
+	if (rc)
+		return rc;
+	if (!(types & ~fo->ofo_compr_types) && bits == fo->ofo_compr_bits)
+		return 0;
+
+	memset(lca, 0, sizeof(*lca));
+	lca->lca_types = cpu_to_le32(types);
+	lca->lca_chunk_log_bits = bits;
+
+	return 1;
+}
+
+/**
+ * Store XATTR_NAME_COMPR prepared by ofd_compr_attr_prep().
+ *
+ * Called with the object write locked, in the transaction of the write.
+ *
+ * \param[in] env	execution environment
+ * \param[in] fo	OFD object
+ * \param[in] th	transaction handle
+ *
+ * \retval		0 on success
+ * \retval		negative value on error
+ */
+int ofd_compr_attr_set(const struct lu_env *env, struct ofd_object *fo,
+		       struct thandle *th)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	struct ll_compr_attr *lca = &info->fti_compr_attr;
+	__u32 types = le32_to_cpu(lca->lca_types) | fo->ofo_compr_types;
+	int rc;
+
+	/* another write got there first */
+	if (types == fo->ofo_compr_types &&
+	    lca->lca_chunk_log_bits == fo->ofo_compr_bits)
+		return 0;
+
+	lca->lca_types = cpu_to_le32(types);
+	info->fti_buf.lb_buf = lca;
+	info->fti_buf.lb_len = sizeof(*lca);
+	rc = dt_xattr_set(env, ofd_object_child(fo), &info->fti_buf,
+			  XATTR_NAME_COMPR, 0, th);
+	if (rc)
+		return rc;
+
+	fo->ofo_compr_types = types;
+	fo->ofo_compr_bits = lca->lca_chunk_log_bits;
+
+	return 0;
+}
+
+/*
+ * Store the chunk at \a start uncompressed if it is compressed.
+ *
+ * The chunk is read and decompressed under the read lock, then written back
+ * raw in a transaction of its own. The data is only written if no other
+ * change was made to the object meanwhile, otherwise this starts over.
+ */
+static int ofd_compr_unpack_chunk(const struct lu_env *env,
+				  struct ofd_device *ofd,
+				  struct ofd_object *fo, __u64 start)
+{
+	struct lu_attr *la = &ofd_info(env)->fti_attr2;
+	struct dt_object *o = ofd_object_child(fo);
+	unsigned int bits = fo->ofo_compr_bits;
+	unsigned int chunk_size = COMPR_GET_CHUNK_SIZE(bits);
+	struct niobuf_remote rnb = { .rnb_offset = start };
+	struct ofd_compr_ws *ws;
+	struct ll_compr_hdr *llch;
+	struct niobuf_local *lnb;
+	struct thandle *th;
+	bool compressed;
+	bool written = false;
+	bool retry;
+	int gen, nr, i, rc;
+
+	ENTRY;
+
+	ws = ofd_compr_ws_get(ofd);
+	if (!ws)
+		RETURN(-ENOMEM);
+	llch = ws->ocw_src;
+	lnb = ws->ocw_lnb;
+
+again:
+	compressed = false;
+	retry = false;
+	ofd_read_lock(env, fo);
+	gen = atomic_read(&fo->ofo_data_gen);
+	rc = ofd_compr_read_buf(env, fo, ws, start, sizeof(*llch), llch);
+	if (!rc && ofd_compr_hdr_check(llch, start, bits)) {
+		compressed = true;
+		rc = ofd_compr_read_buf(env, fo, ws, start,
+					sizeof(*llch) +
+					le32_to_cpu(llch->llch_compr_size),
+					ws->ocw_src);
+		if (!rc) {
+			la->la_valid = 0;
+			rc = dt_attr_get(env, o, la);
+		}
+	}
+	ofd_read_unlock(env, fo);
+	if (rc || !compressed || la->la_size <= start)
+		GOTO(out, rc);
+
+	rc = ll_decompress_chunk(ws->ocw_src, ws->ocw_dst, chunk_size);
+	if (rc)
+		GOTO(out, rc);
+
+	/* the object size is kept, the chunk may be cut by a truncate */
+	rnb.rnb_len = min_t(__u64, chunk_size, la->la_size - start);
+	nr = dt_bufs_get(env, o, &rnb, lnb, OFD_COMPR_LNB_MAX,
+			 DT_BUFS_TYPE_WRITE);
+	if (nr < 0)
+		GOTO(out, rc = nr);
+
+	ofd_read_lock(env, fo);
+	rc = dt_write_prep(env, o, lnb, nr);
+	ofd_read_unlock(env, fo);
+	if (rc)
+		GOTO(put, rc);
+
+	for (i = 0; i < nr; i++) {
+		unsigned int poff = lnb[i].lnb_page_offset & ~PAGE_MASK;
+		char *ptr = kmap_atomic(lnb[i].lnb_page);
+
+		memcpy(ptr + poff,
+		       ws->ocw_dst + (lnb[i].lnb_file_offset - start),
+		       lnb[i].lnb_len);
+		/* nothing stale is left past EOF */
+		if (poff + lnb[i].lnb_len < PAGE_SIZE)
+			memset(ptr + poff + lnb[i].lnb_len, 0,
+			       PAGE_SIZE - poff - lnb[i].lnb_len);
+		kunmap_atomic(ptr);
+	}
+
+	th = ofd_trans_create(env, ofd);
+	if (IS_ERR(th))
+		GOTO(put, rc = PTR_ERR(th));
+
+	rc = dt_declare_write_commit(env, o, lnb, nr, th);
+	if (rc)
+		GOTO(stop, rc);
+
+	/* no transno needed, the data of the chunk stays the same */
+	rc = dt_trans_start_local(env, ofd->ofd_osd, th);
+	if (rc)
+		GOTO(stop, rc);
+
+	ofd_write_lock(env, fo);
+	if (!ofd_object_exists(fo))
+		GOTO(unlock, rc = -ENOENT);
+	if (atomic_read(&fo->ofo_data_gen) != gen) {
+		retry = true;
+		GOTO(unlock, rc = 0);
+	}
+
+	rc = dt_write_commit(env, o, lnb, nr, th, la->la_size);
+	if (!rc) {
+		atomic_inc(&fo->ofo_data_gen);
+		written = true;
+	}
+unlock:
+	ofd_write_unlock(env, fo);
+stop:
+	dt_trans_stop(env, ofd->ofd_osd, th);
+put:
+	dt_bufs_put(env, o, lnb, nr);
+	if (retry)
+		goto again;
+out:
+	if (written)
+		CDEBUG(D_INODE, "%s: chunk %llu of "DFID" stored raw\n",
+		       ofd_name(ofd), start,
+		       PFID(lu_object_fid(&fo->ofo_obj.do_lu)));
+	ofd_compr_ws_put(ofd, ws);
+	RETURN(rc);
+}
+
+/**
+ * Store the compressed chunks cut by [\a start, \a end) uncompressed.
+ *
+ * Raw data written over part of a compressed chunk, or a truncate inside
+ * it, would corrupt the rest of the chunk. Such a chunk is decompressed and
+ * written back raw first, which does not change the data it holds.
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] fo	OFD object
+ * \param[in] start	start of the range
+ * \param[in] end	end of the range, OBD_OBJECT_EOF for a truncate
+ *
+ * \retval		0 on success
+ * \retval		negative value on error
+ */
+int ofd_compr_unpack(const struct lu_env *env, struct ofd_device *ofd,
+		     struct ofd_object *fo, __u64 start, __u64 end)
+{
+	__u64 chunk_size;
+	int rc;
+
+	rc = ofd_compr_attr_load(env, fo);
+	if (rc || !fo->ofo_compr_types)
+		return rc;
+
+	chunk_size = COMPR_GET_CHUNK_SIZE(fo->ofo_compr_bits);
+	if (start & (chunk_size - 1)) {
+		rc = ofd_compr_unpack_chunk(env, ofd, fo,
+					    round_down(start, chunk_size));
+		if (rc)
+			return rc;
+		/* both ends in the same chunk */
+		if (end - 1 < round_up(start, chunk_size))
+			return 0;
+	}
+	if (end != OBD_OBJECT_EOF && end & (chunk_size - 1))
+		rc = ofd_compr_unpack_chunk(env, ofd, fo,
+					    round_down(end - 1, chunk_size));
+
+	return rc;
+}
+
+/**
+ * Prepare the object for the raw remote buffers of a write.
+ *
+ * \param[in] env	execution environment
+ * \param[in] ofd	OFD device
+ * \param[in] fo	OFD object
+ * \param[in] niocount	number of remote buffers
+ * \param[in] rnb	remote buffers
+ *
+ * \retval		0 on success
+ * \retval		negative value on error
+ */
+int ofd_compr_write_prep(const struct lu_env *env, struct ofd_device *ofd,
+			 struct ofd_object *fo, int niocount,
+			 struct niobuf_remote *rnb)
+{
+	int i, rc = 0;
+
+	for (i = 0; i < niocount && !rc; i++) {
+		/* compressed chunks are always written whole */
+		if (rnb[i].rnb_flags & OBD_BRW_COMPRESSED)
+			continue;
+
+		rc = ofd_compr_unpack(env, ofd, fo, rnb[i].rnb_offset,
+				      rnb[i].rnb_offset + rnb[i].rnb_len);
+	}
+
+	return rc;
+}
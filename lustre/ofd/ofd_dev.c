@@ -2506,23 +2506,31 @@ static int ofd_rw_hpreq_lock_match(struct ptlrpc_request *req,
 	enum ldlm_mode  mode;
 	struct ldlm_extent ext;
 	__u32 opc = lustre_msg_get_opc(req->rq_reqmsg);
+	int objcount;
 
 	ENTRY;
 
 	ioo = req_capsule_client_get(&req->rq_pill, &RMF_OBD_IOOBJ);
 	LASSERT(ioo != NULL);
+	objcount = req_capsule_get_size(&req->rq_pill, &RMF_OBD_IOOBJ,
+					RCL_CLIENT) / sizeof(*ioo);
 
 	rnb = req_capsule_client_get(&req->rq_pill, &RMF_NIOBUF_REMOTE);
 	LASSERT(rnb != NULL);
 
+	/* a multi-object write holds one lock on each of its objects */
+	LASSERT(lock->l_resource != NULL);
+	while (!ostid_res_name_eq(&ioo->ioo_oid, &lock->l_resource->lr_name)) {
+		if (--objcount == 0)
+			RETURN(0);
+		rnb += ioo->ioo_bufcnt;
+		ioo++;
+	}
+
 	ext.start = rnb->rnb_offset;
 	rnb += ioo->ioo_bufcnt - 1;
 	ext.end = rnb->rnb_offset + rnb->rnb_len - 1;
 
-	LASSERT(lock->l_resource != NULL);
-	if (!ostid_res_name_eq(&ioo->ioo_oid, &lock->l_resource->lr_name))
-		RETURN(0);
-
 	/* a bulk write can only hold a reference on a PW extent lock
 	 * or GROUP lock.
 	 */
@@ -2557,6 +2565,8 @@ static int ofd_rw_hpreq_check(struct ptlrpc_request *req)
 	struct obd_ioobj	*ioo;
 	struct niobuf_remote	*rnb;
 	int opc;
+	int objcount;
+	int i;
 	struct ldlm_prolong_args pa = { 0 };
 
 	ENTRY;
@@ -2574,6 +2584,8 @@ static int ofd_rw_hpreq_check(struct ptlrpc_request *req)
 
 	ioo = req_capsule_client_get(&req->rq_pill, &RMF_OBD_IOOBJ);
 	LASSERT(ioo != NULL);
+	objcount = req_capsule_get_size(&req->rq_pill, &RMF_OBD_IOOBJ,
+					RCL_CLIENT) / sizeof(*ioo);
 
 	rnb = req_capsule_client_get(&req->rq_pill, &RMF_NIOBUF_REMOTE);
 	LASSERT(rnb != NULL);
@@ -2594,6 +2606,18 @@ static int ofd_rw_hpreq_check(struct ptlrpc_request *req)
 
 	ofd_prolong_extent_locks(tsi, &pa);
 
+	/* the other objects of a multi-object write, see
+	 * tgt_ioobj_body_unpack()
+	 */
+	for (i = 1; i < objcount; i++) {
+		rnb++;
+		pa.lpa_extent.start = rnb->rnb_offset;
+		rnb += ioo[i].ioo_bufcnt - 1;
+		pa.lpa_extent.end = rnb->rnb_offset + rnb->rnb_len - 1;
+		ost_fid_build_resid(&ioo[i].ioo_oid.oi_fid, &pa.lpa_resid);
+		ldlm_resource_prolong(&pa);
+	}
+
 	CDEBUG(D_DLMTRACE, "%s: refreshed %u locks timeout for req %p\n",
 	       tgt_name(tsi->tsi_tgt), pa.lpa_blocks_cnt, req);
 
@@ -3074,14 +3098,20 @@ static int ofd_init0(const struct lu_env *env, struct ofd_device *m,
 		obt->obt_nodemap_config_file = nodemap_config;
 	}
 
-	rc = ofd_start_inconsistency_verification_thread(m);
+	rc = ofd_compr_init(m);
 	if (rc != 0)
 		GOTO(err_fini_nm, rc);
 
+	rc = ofd_start_inconsistency_verification_thread(m);
+	if (rc != 0)
+		GOTO(err_fini_compr, rc);
+
 	tgt_adapt_sptlrpc_conf(&m->ofd_lut);
 
 	RETURN(0);
 
+err_fini_compr:
+	ofd_compr_fini(m);
 err_fini_nm:
 	nm_config_file_deregister_tgt(env, obt->obt_nodemap_config_file);
 	obt->obt_nodemap_config_file = NULL;
@@ -3134,6 +3164,7 @@ static void ofd_fini(const struct lu_env *env, struct ofd_device *m)
 	ofd_stop_inconsistency_verification_thread(m);
 	lfsck_degister(env, m->ofd_osd);
 	ofd_fs_cleanup(env, m);
+	ofd_compr_fini(m);
 	nm_config_file_deregister_tgt(env,
 				      obd2obt(obd)->obt_nodemap_config_file);
 	obd2obt(obd)->obt_nodemap_config_file = NULL;
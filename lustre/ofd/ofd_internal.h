@@ -75,6 +75,7 @@ enum {
 	LPROC_OFD_STATS_SET_INFO,
 	LPROC_OFD_STATS_QUOTACTL,
 	LPROC_OFD_STATS_PREALLOC,
+	LPROC_OFD_STATS_DECOMPR_BYTES,
 	LPROC_OFD_STATS_LAST,
 };
 
@@ -126,6 +127,9 @@ struct ofd_device {
 	unsigned int		 ofd_access_log_size;
 	unsigned int		 ofd_access_log_mask;
 
+	/* per-CPT workspaces for decompressing reads, see ofd_compress.c */
+	struct ofd_compr_pool	**ofd_compr_pools;
+
 	struct list_head	ofd_seq_list;
 	rwlock_t		ofd_seq_list_lock;
 	int			ofd_seq_count;
@@ -187,6 +191,12 @@ struct ofd_object {
 	time64_t		ofo_atime_ondisk;
 	unsigned int		ofo_pfid_checking:1,
 				ofo_pfid_verified:1;
+	/* XATTR_NAME_COMPR, valid once ofo_compr_loaded is set */
+	bool			ofo_compr_loaded;
+	__u8			ofo_compr_bits;
+	__u32			ofo_compr_types;
+	/* bumped by every change of the object data */
+	atomic_t		ofo_data_gen;
 };
 
 static inline struct ofd_object *ofd_obj(struct lu_object *o)
@@ -269,6 +279,11 @@ struct ofd_thread_info {
 	struct filter_fid		 fti_mds_fid;
 	struct ost_id			 fti_ostid;
 	struct ofd_object		*fti_obj;
+	/* objects of a multi-object write and their first local buffer */
+	struct ofd_object		*fti_objs[PTLRPC_MAX_BRW_OBJS];
+	int				 fti_objs_lnb[PTLRPC_MAX_BRW_OBJS + 1];
+	struct ofd_compr_ws		*fti_compr_ws;
+	struct ll_compr_attr		 fti_compr_attr;
 	union {
 		char			 name[64]; /* for ofd_init0() */
 		struct obd_statfs	 osfs;    /* for obdofd_statfs() */
@@ -302,6 +317,28 @@ void ofd_access(const struct lu_env *env, struct ofd_device *m,
 		const struct lu_fid *parent_fid, __u64 begin, __u64 end,
 		unsigned int size, unsigned int segment_count, int rw);
 
+/* ofd_compress.c */
+int ofd_compr_init(struct ofd_device *m);
+void ofd_compr_fini(struct ofd_device *m);
+int ofd_decompress_read_prep(const struct lu_env *env, struct obd_export *exp,
+			     struct ofd_device *ofd, struct ofd_object *fo,
+			     int niocount, struct niobuf_remote *rnb);
+int ofd_decompress_read(const struct lu_env *env, struct obd_export *exp,
+			struct ofd_device *ofd, int npages,
+			struct niobuf_local *lnb);
+__u64 ofd_decompress_read_fini(const struct lu_env *env,
+			       struct ofd_device *ofd, int npages,
+			       struct niobuf_local *lnb);
+int ofd_compr_unpack(const struct lu_env *env, struct ofd_device *ofd,
+		     struct ofd_object *fo, __u64 start, __u64 end);
+int ofd_compr_write_prep(const struct lu_env *env, struct ofd_device *ofd,
+			 struct ofd_object *fo, int niocount,
+			 struct niobuf_remote *rnb);
+int ofd_compr_attr_prep(const struct lu_env *env, struct ofd_object *fo,
+			int npages, struct niobuf_local *lnb);
+int ofd_compr_attr_set(const struct lu_env *env, struct ofd_object *fo,
+		       struct thandle *th);
+
 /* ofd_dev.c */
 extern struct lu_context_key ofd_thread_key;
 int ofd_postrecov(const struct lu_env *env, struct ofd_device *ofd);
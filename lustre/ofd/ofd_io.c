@@ -615,6 +615,11 @@ static int ofd_preprw_read(const struct lu_env *env, struct obd_export *exp,
 	if (ptlrpc_connection_is_local(exp->exp_connection))
 		dbt |= DT_BUFS_TYPE_LOCAL;
 
+	/* needs its own buffers, so done before the RPC pages are taken */
+	rc = ofd_decompress_read_prep(env, exp, ofd, fo, niocount, rnb);
+	if (unlikely(rc))
+		GOTO(obj_put, rc);
+
 	begin = -1;
 	end = 0;
 
@@ -654,6 +659,10 @@ static int ofd_preprw_read(const struct lu_env *env, struct obd_export *exp,
 		GOTO(unlock, rc);
 	ofd_read_unlock(env, fo);
 
+	rc = ofd_decompress_read(env, exp, ofd, *nr_local, lnb);
+	if (unlikely(rc))
+		GOTO(buf_put, rc);
+
 	ofd_access(env, ofd,
 		&(struct lu_fid) {
 			.f_seq = oa->o_parent_seq,
@@ -670,6 +679,7 @@ static int ofd_preprw_read(const struct lu_env *env, struct obd_export *exp,
 unlock:
 	ofd_read_unlock(env, fo);
 buf_put:
+	ofd_decompress_read_fini(env, ofd, *nr_local, lnb);
 	dt_bufs_put(env, ofd_object_child(fo), lnb, *nr_local);
 obj_put:
 	ofd_object_put(env, fo);
@@ -677,125 +687,153 @@ obj_put:
 }
 
 /**
- * Prepare buffers for write request processing.
+ * Re-create the object of a write replayed during recovery.
  *
- * This function converts remote buffers from client to local buffers
- * and prepares the latter. If there is recovery in progress and required
- * object is missing then it can be re-created before write.
+ * If there is recovery in progress and the object is missing, it can
+ * be re-created before the write.
  *
  * \param[in] env	execution environment
- * \param[in] exp	OBD export of client
  * \param[in] ofd	OFD device
- * \param[in] fid	FID of object
- * \param[in] la	object attributes
- * \param[in] oa	OBDO structure from client
- * \param[in] objcount	always 1
- * \param[in] obj	object data
- * \param[in] rnb	remote buffers
- * \param[in] nr_local	number of local buffers
- * \param[in] lnb	local buffers
- * \param[in] jobid	job ID name
+ * \param[in] oa	OBDO structure of the object from client
  *
- * \retval		0 on successful prepare
+ * \retval		0 on success
  * \retval		negative value on error
  */
-static int ofd_preprw_write(const struct lu_env *env, struct obd_export *exp,
-			    struct ofd_device *ofd, const struct lu_fid *fid,
-			    struct lu_attr *la, struct obdo *oa,
-			    int objcount, struct obd_ioobj *obj,
-			    struct niobuf_remote *rnb, int *nr_local,
-			    struct niobuf_local *lnb)
+static int ofd_preprw_recreate(const struct lu_env *env,
+			       struct ofd_device *ofd, struct obdo *oa)
 {
-	struct ofd_object *fo;
-	int i, j, k, rc = 0, tot_bytes = 0;
-	enum dt_bufs_type dbt = DT_BUFS_TYPE_WRITE;
-	int maxlnb = *nr_local;
-	__u64 begin, end;
+	u64 seq = ostid_seq(&oa->o_oi);
+	u64 oid = ostid_id(&oa->o_oi);
+	struct ofd_seq *oseq;
+	int rc = 0;
 
-	ENTRY;
-	LASSERT(env != NULL);
-	LASSERT(objcount == 1);
+	oseq = ofd_seq_load(env, ofd, seq);
+	if (IS_ERR(oseq)) {
+		CERROR("%s: Can't find FID Sequence %#llx: rc = %d\n",
+		       ofd_name(ofd), seq, (int)PTR_ERR(oseq));
+		return -EINVAL;
+	}
 
-	if (unlikely(exp->exp_obd->obd_recovering)) {
-		u64 seq = ostid_seq(&oa->o_oi);
-		u64 oid = ostid_id(&oa->o_oi);
-		struct ofd_seq *oseq;
+	if (oid > ofd_seq_last_oid(oseq)) {
+		int sync = 0;
+		int diff;
 
-		oseq = ofd_seq_load(env, ofd, seq);
-		if (IS_ERR(oseq)) {
-			CERROR("%s: Can't find FID Sequence %#llx: rc = %d\n",
-			       ofd_name(ofd), seq, (int)PTR_ERR(oseq));
-			GOTO(out, rc = -EINVAL);
-		}
+		mutex_lock(&oseq->os_create_lock);
+		diff = oid - ofd_seq_last_oid(oseq);
 
-		if (oid > ofd_seq_last_oid(oseq)) {
-			int sync = 0;
-			int diff;
+		/* Do sync create if the seq is about to used up */
+		sync = ofd_seq_is_exhausted(ofd, oa);
+		if (sync < 0) {
+			mutex_unlock(&oseq->os_create_lock);
+			ofd_seq_put(env, oseq);
+			return sync;
+		}
 
-			mutex_lock(&oseq->os_create_lock);
-			diff = oid - ofd_seq_last_oid(oseq);
+		while (diff > 0) {
+			u64 next_id = ofd_seq_last_oid(oseq) + 1;
+			int count = ofd_precreate_batch(ofd, diff);
 
-			/* Do sync create if the seq is about to used up */
-			sync = ofd_seq_is_exhausted(ofd, oa);
-			if (sync < 0) {
+			rc = ofd_precreate_objects(env, ofd, next_id,
+						   oseq, count, sync,
+						   false);
+			if (rc < 0) {
 				mutex_unlock(&oseq->os_create_lock);
 				ofd_seq_put(env, oseq);
-				GOTO(out, rc = sync);
-			}
-
-			while (diff > 0) {
-				u64 next_id = ofd_seq_last_oid(oseq) + 1;
-				int count = ofd_precreate_batch(ofd, diff);
-
-				rc = ofd_precreate_objects(env, ofd, next_id,
-							   oseq, count, sync,
-							   false);
-				if (rc < 0) {
-					mutex_unlock(&oseq->os_create_lock);
-					ofd_seq_put(env, oseq);
-					GOTO(out, rc);
-				}
-
-				diff -= rc;
+				return rc;
 			}
 
-			mutex_unlock(&oseq->os_create_lock);
+			diff -= rc;
 		}
 
-		ofd_seq_put(env, oseq);
+		mutex_unlock(&oseq->os_create_lock);
 	}
 
-	/* Process incoming grant info, set OBD_BRW_GRANTED flag and grant some
-	 * space back if possible, we have to do this outside of the lock as
-	 * grant preparation may need to sync whole fs thus wait for all the
-	 * transactions to complete. */
-	tgt_grant_prepare_write(env, exp, oa, rnb, obj->ioo_bufcnt);
+	ofd_seq_put(env, oseq);
+	return 0;
+}
 
-	fo = ofd_object_find(env, ofd, fid);
+/**
+ * Prepare buffers of one object for write request processing.
+ *
+ * This function converts the remote buffers of one object to local
+ * buffers and prepares the latter. On error, the buffers and the object
+ * are released.
+ *
+ * \param[in] env	execution environment
+ * \param[in] exp	OBD export of client
+ * \param[in] ofd	OFD device
+ * \param[in] oa	OBDO structure of the object from client
+ * \param[in] obj	object data
+ * \param[in] rnb	remote buffers of the object
+ * \param[in,out] nr_local	room for local buffers, then number used
+ * \param[in] lnb	local buffers
+ * \param[out] fop	the object
+ *
+ * \retval		0 on successful prepare
+ * \retval		negative value on error
+ */
+static int ofd_preprw_write_obj(const struct lu_env *env,
+				struct obd_export *exp,
+				struct ofd_device *ofd, struct obdo *oa,
+				struct obd_ioobj *obj,
+				struct niobuf_remote *rnb, int *nr_local,
+				struct niobuf_local *lnb,
+				struct ofd_object **fop)
+{
+	struct lu_attr *la_size = &ofd_info(env)->fti_attr2;
+	struct ofd_object *fo;
+	int i, j, k, rc = 0, tot_bytes = 0;
+	enum dt_bufs_type dbt = DT_BUFS_TYPE_WRITE;
+	int maxlnb = *nr_local;
+	__u64 begin, end;
+	__u64 eof = OBD_OBJECT_EOF;
+
+	ENTRY;
+
+	fo = ofd_object_find(env, ofd, &oa->o_oi.oi_fid);
 	if (IS_ERR(fo))
-		GOTO(out, rc = PTR_ERR(fo));
+		RETURN(PTR_ERR(fo));
 	LASSERT(fo != NULL);
 
-	ofd_info(env)->fti_obj = fo;
-
 	if (!ofd_object_exists(fo)) {
 		CERROR("%s: BRW to missing obj "DOSTID"\n",
 		       exp->exp_obd->obd_name, POSTID(&obj->ioo_oid));
-		ofd_object_put(env, fo);
-		GOTO(out, rc = -ENOENT);
+		GOTO(obj_put, rc = -ENOENT);
 	}
 
 	if (ptlrpc_connection_is_local(exp->exp_connection))
 		dbt |= DT_BUFS_TYPE_LOCAL;
 
+	/* compressed chunks only partly overwritten are stored raw first */
+	rc = ofd_compr_write_prep(env, ofd, fo, obj->ioo_bufcnt, rnb);
+	if (unlikely(rc))
+		GOTO(obj_put, rc);
+
 	begin = -1;
 	end = 0;
 
+	/* zero ranges past EOF need no blocks, a hole reads back the same.
+	 * The size is only a hint here, writes beyond it are covered by the
+	 * extent lock of the client.
+	 */
+	if (exp_connect_zero_write(exp)) {
+		la_size->la_valid = 0;
+		if (!dt_attr_get(env, ofd_object_child(fo), la_size))
+			eof = la_size->la_size;
+	}
+
 	/* parse remote buffers to local buffers and prepare the latter */
 	for (*nr_local = 0, i = 0, j = 0; i < obj->ioo_bufcnt; i++) {
 		begin = min_t(__u64, begin, rnb[i].rnb_offset);
 		end = max_t(__u64, end, rnb[i].rnb_offset + rnb[i].rnb_len);
 
+		/* the last niobuf is kept to extend the object size */
+		if (rnb[i].rnb_flags & OBD_BRW_ZERO &&
+		    rnb[i].rnb_offset >= eof && i < obj->ioo_bufcnt - 1) {
+			tot_bytes += rnb[i].rnb_len;
+			continue;
+		}
+
 		if (CFS_FAIL_CHECK(OBD_FAIL_OST_2BIG_NIOBUF))
 			rnb[i].rnb_len += PAGE_SIZE;
 		rc = dt_bufs_get(env, ofd_object_child(fo),
@@ -842,6 +880,14 @@ static int ofd_preprw_write(const struct lu_env *env, struct obd_export *exp,
 	if (unlikely(rc != 0))
 		GOTO(err, rc);
 
+	/* zero ranges inside the object are written, but not in the bulk */
+	for (j = 0; j < *nr_local; j++) {
+		if (lnb[j].lnb_flags & OBD_BRW_ZERO)
+			zero_user(lnb[j].lnb_page,
+				  lnb[j].lnb_page_offset & ~PAGE_MASK,
+				  lnb[j].lnb_len);
+	}
+
 	ofd_read_unlock(env, fo);
 
 	ofd_access(env, ofd,
@@ -855,13 +901,118 @@ static int ofd_preprw_write(const struct lu_env *env, struct obd_export *exp,
 		obj->ioo_bufcnt,
 		WRITE);
 
+	*fop = fo;
 	RETURN(0);
 
 err:
 	ofd_read_unlock(env, fo);
 err_nolock:
 	dt_bufs_put(env, ofd_object_child(fo), lnb, *nr_local);
+obj_put:
 	ofd_object_put(env, fo);
+	return rc;
+}
+
+/**
+ * Get the attributes the client sent for one object of a write.
+ *
+ * A multi-object write carries them in RMF_IOOBJ_BODY, the ost_body of
+ * the request only describes its first object, see tgt_brw_write().
+ */
+static inline struct obdo *ofd_ioobj_oa(const struct lu_env *env,
+					struct obdo *oa, int objcount, int i)
+{
+	if (objcount == 1)
+		return oa;
+
+	return &tgt_ses_info(env)->tsi_ioobj_bodies[i].oa;
+}
+
+/**
+ * Prepare buffers for write request processing.
+ *
+ * This function converts remote buffers from client to local buffers
+ * and prepares the latter, object after object. Incoming grant is
+ * processed once for the whole request.
+ *
+ * The objects are kept in ofd_thread_info::fti_objs[] with the index of
+ * their first local buffer in fti_objs_lnb[], the last entry of which is
+ * the number of local buffers.
+ *
+ * \param[in] env	execution environment
+ * \param[in] exp	OBD export of client
+ * \param[in] ofd	OFD device
+ * \param[in] oa	OBDO structure from client
+ * \param[in] objcount	number of objects
+ * \param[in] obj	object data
+ * \param[in] rnb	remote buffers
+ * \param[in] nr_local	number of local buffers
+ * \param[in] lnb	local buffers
+ *
+ * \retval		0 on successful prepare
+ * \retval		negative value on error
+ */
+static int ofd_preprw_write(const struct lu_env *env, struct obd_export *exp,
+			    struct ofd_device *ofd, struct obdo *oa,
+			    int objcount, struct obd_ioobj *obj,
+			    struct niobuf_remote *rnb, int *nr_local,
+			    struct niobuf_local *lnb)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	int *objs_lnb = info->fti_objs_lnb;
+	int maxlnb = *nr_local;
+	int niocount = 0;
+	int i, j, rc = 0;
+
+	ENTRY;
+	LASSERT(env != NULL);
+	LASSERT(objcount > 0 && objcount <= PTLRPC_MAX_BRW_OBJS);
+
+	for (i = 0; i < objcount; i++) {
+		if (unlikely(exp->exp_obd->obd_recovering)) {
+			rc = ofd_preprw_recreate(env, ofd,
+					ofd_ioobj_oa(env, oa, objcount, i));
+			if (rc)
+				GOTO(out, rc);
+		}
+		niocount += obj[i].ioo_bufcnt;
+	}
+
+	/* compressed chunks are only sent one object at a time */
+	for (j = 0; objcount > 1 && j < niocount; j++) {
+		if (rnb[j].rnb_flags & OBD_BRW_COMPRESSED)
+			GOTO(out, rc = -EPROTO);
+	}
+
+	/* Process incoming grant info, set OBD_BRW_GRANTED flag and grant some
+	 * space back if possible, we have to do this outside of the lock as
+	 * grant preparation may need to sync whole fs thus wait for all the
+	 * transactions to complete. */
+	tgt_grant_prepare_write(env, exp, oa, rnb, niocount);
+
+	for (objs_lnb[0] = 0, i = 0; i < objcount; i++) {
+		int count = maxlnb - objs_lnb[i];
+
+		rc = ofd_preprw_write_obj(env, exp, ofd,
+					  ofd_ioobj_oa(env, oa, objcount, i),
+					  &obj[i], rnb, &count,
+					  lnb + objs_lnb[i], &info->fti_objs[i]);
+		if (rc)
+			GOTO(err, rc);
+		objs_lnb[i + 1] = objs_lnb[i] + count;
+		rnb += obj[i].ioo_bufcnt;
+	}
+	*nr_local = objs_lnb[objcount];
+	info->fti_obj = info->fti_objs[0];
+
+	RETURN(0);
+
+err:
+	while (i-- > 0) {
+		dt_bufs_put(env, ofd_object_child(info->fti_objs[i]),
+			    lnb + objs_lnb[i], objs_lnb[i + 1] - objs_lnb[i]);
+		ofd_object_put(env, info->fti_objs[i]);
+	}
 	/* tgt_grant_prepare_write() was called, so we must commit */
 	tgt_grant_commit(exp, oa->o_grant_used, rc);
 out:
@@ -882,7 +1033,7 @@ out:
  * \param[in] cmd	IO type (read/write)
  * \param[in] exp	OBD export of client
  * \param[in] oa	OBDO structure from request
- * \param[in] objcount	always 1
+ * \param[in] objcount	number of objects, only writes have more
  * \param[in] obj	object data
  * \param[in] rnb	remote buffers
  * \param[in] nr_local	number of local buffers
@@ -937,13 +1088,12 @@ int ofd_preprw(const struct lu_env *env, int cmd, struct obd_export *exp,
 		ofd_seq_put(env, oseq);
 	}
 
-	LASSERT(objcount == 1);
+	LASSERT(objcount == 1 || cmd == OBD_BRW_WRITE);
 	LASSERT(obj->ioo_bufcnt > 0);
 
 	if (cmd == OBD_BRW_WRITE) {
-		la_from_obdo(&info->fti_attr, oa, OBD_MD_FLGETATTR);
-		rc = ofd_preprw_write(env, exp, ofd, fid, &info->fti_attr, oa,
-				      objcount, obj, rnb, nr_local, lnb);
+		rc = ofd_preprw_write(env, exp, ofd, oa, objcount, obj, rnb,
+				      nr_local, lnb);
 	} else if (cmd == OBD_BRW_READ) {
 		tgt_grant_prepare_read(env, exp, oa);
 		rc = ofd_preprw_read(env, exp, ofd, fid, &info->fti_attr, oa,
@@ -1228,13 +1378,16 @@ ofd_commitrw_write(const struct lu_env *env, struct obd_export *exp,
 {
 	struct ofd_thread_info *info = ofd_info(env);
 	struct filter_export_data *fed = &exp->exp_filter_data;
+	struct lu_attr *la_size = &info->fti_attr2;
 	struct ofd_object *fo;
 	struct dt_object *o;
 	struct thandle *th;
+	__u64 compr_size = 0;
 	int rc = 0;
 	int rc2 = 0;
 	int retries = 0;
 	int i, restart = 0;
+	bool compr_attr = false;
 	bool soft_sync = false;
 	bool cb_registered = false;
 	bool fake_write = false;
@@ -1266,6 +1419,28 @@ ofd_commitrw_write(const struct lu_env *env, struct obd_export *exp,
 
 	la->la_valid &= LA_ATIME | LA_MTIME | LA_CTIME;
 
+	/* compressed chunks take less room than the data they hold, so the
+	 * object size cannot be derived from the written extents; the client
+	 * sends the end of the uncompressed write instead
+	 */
+	if (exp_connect_compress(exp) && oa->o_valid & OBD_MD_FLSIZE) {
+		for (i = 0; i < niocount; i++) {
+			if (lnb[i].lnb_flags & OBD_BRW_COMPRESSED) {
+				compr_size = oa->o_size;
+				break;
+			}
+		}
+	}
+
+	/* flag the object for the OST side users of the chunk headers */
+	if (exp_connect_compress(exp)) {
+		rc = ofd_compr_attr_prep(env, fo, niocount, lnb);
+		if (rc < 0)
+			GOTO(out, rc);
+		compr_attr = rc > 0;
+		rc = 0;
+	}
+
 	/* do fake write, to simulate the write case for performance testing */
 	if (CFS_FAIL_CHECK_QUIET(OBD_FAIL_OST_FAKE_RW)) {
 		struct niobuf_local *last = &lnb[niocount - 1];
@@ -1327,11 +1502,32 @@ retry:
 			GOTO(out_stop, rc);
 	}
 
+	if (compr_size) {
+		la_size->la_valid = LA_SIZE;
+		la_size->la_size = compr_size;
+		rc = dt_declare_attr_set(env, o, la_size, th);
+		if (rc)
+			GOTO(out_stop, rc);
+	}
+
+	if (compr_attr) {
+		info->fti_buf.lb_buf = &info->fti_compr_attr;
+		info->fti_buf.lb_len = sizeof(info->fti_compr_attr);
+		rc = dt_declare_xattr_set(env, o, &info->fti_buf,
+					  XATTR_NAME_COMPR, 0, th);
+		if (rc)
+			GOTO(out_stop, rc);
+	}
+
 	rc = ofd_trans_start(env, ofd, fo, th);
 	if (rc)
 		GOTO(out_stop, rc);
 
-	ofd_read_lock(env, fo);
+	/* the size check below must not race with other writers */
+	if (compr_size || compr_attr)
+		ofd_write_lock(env, fo);
+	else
+		ofd_read_lock(env, fo);
 	if (!ofd_object_exists(fo))
 		GOTO(out_unlock, rc = -ENOENT);
 
@@ -1353,13 +1549,37 @@ retry:
 			restart = th->th_restart_tran;
 			GOTO(out_unlock, rc);
 		}
+		atomic_inc(&fo->ofo_data_gen);
+	}
+
+	if (compr_attr) {
+		rc = ofd_compr_attr_set(env, fo, th);
+		if (rc)
+			GOTO(out_unlock, rc);
+	}
+
+	if (compr_size) {
+		la_size->la_valid = 0;
+		rc = dt_attr_get(env, o, la_size);
+		if (rc)
+			GOTO(out_unlock, rc);
+		if (la_size->la_size < compr_size) {
+			la_size->la_valid = LA_SIZE;
+			la_size->la_size = compr_size;
+			rc = dt_attr_set(env, o, la_size, th);
+			if (rc)
+				GOTO(out_unlock, rc);
+		}
 	}
 
 	/* get attr to return */
 	rc = dt_attr_get(env, o, la);
 
 out_unlock:
-	ofd_read_unlock(env, fo);
+	if (compr_size || compr_attr)
+		ofd_write_unlock(env, fo);
+	else
+		ofd_read_unlock(env, fo);
 out_stop:
 	/* Force commit to make the just-deleted blocks
 	 * reusable. LU-456 */
@@ -1411,6 +1631,316 @@ out:
 	RETURN(rc);
 }
 
+/**
+ * Commit the buffers of a multi-object write to the storage.
+ *
+ * Same as ofd_commitrw_write(), but the data of all objects of the
+ * request is written in one transaction. The attributes of each object
+ * are taken from and returned in tgt_session_info::tsi_ioobj_bodies[].
+ * Compressed chunks are never part of such a write, see
+ * ofd_preprw_write().
+ *
+ * \param[in] env	execution environment
+ * \param[in] exp	OBD export of client
+ * \param[in] ofd	OFD device
+ * \param[in] objcount	number of objects
+ * \param[in] lnb	local buffers
+ * \param[in] granted	grant space consumed for the bulk I/O
+ * \param[in] old_rc	result of processing at this point
+ *
+ * \retval		0 on successful commit
+ * \retval		negative value on error
+ */
+static int
+ofd_commitrw_write_multi(const struct lu_env *env, struct obd_export *exp,
+			 struct ofd_device *ofd, int objcount,
+			 struct niobuf_local *lnb, unsigned long granted,
+			 int old_rc)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	struct ost_body *bodies = tgt_ses_info(env)->tsi_ioobj_bodies;
+	struct filter_export_data *fed = &exp->exp_filter_data;
+	struct lu_attr *la = &info->fti_attr;
+	struct ofd_object **fo = info->fti_objs;
+	int *objs_lnb = info->fti_objs_lnb;
+	int niocount = objs_lnb[objcount];
+	struct thandle *th;
+	struct dt_object *o;
+	int rc = 0;
+	int rc2 = 0;
+	int retries = 0;
+	int i, restart = 0;
+	bool soft_sync = false;
+	bool cb_registered = false;
+	const __u64 times = OBD_MD_FLATIME | OBD_MD_FLMTIME | OBD_MD_FLCTIME;
+
+	ENTRY;
+
+	LASSERT(bodies != NULL);
+
+	if (old_rc)
+		GOTO(out, rc = old_rc);
+
+	/* the first write to each object must set some attributes, before
+	 * dt_declare_write_commit() for quota enforcement
+	 */
+	for (i = 0; i < objcount; i++) {
+		if (!ofd_object_exists(fo[i]))
+			GOTO(out, rc = -ENOENT);
+
+		la_from_obdo(la, &bodies[i].oa, OBD_MD_FLUID | OBD_MD_FLGID |
+			     OBD_MD_FLPROJID | times);
+		rc = ofd_write_attr_set(env, ofd, fo[i], la, &bodies[i].oa);
+		if (rc)
+			GOTO(out, rc);
+	}
+
+retry:
+	CFS_FAIL_TIMEOUT(OBD_FAIL_OFD_COMMITRW_DELAY, cfs_fail_val);
+
+	th = ofd_trans_create(env, ofd);
+	if (IS_ERR(th))
+		GOTO(out, rc = PTR_ERR(th));
+
+	th->th_sync |= ofd->ofd_sync_journal;
+	if (th->th_sync == 0) {
+		for (i = 0; i < niocount; i++) {
+			if (!(lnb[i].lnb_flags & OBD_BRW_ASYNC)) {
+				th->th_sync = 1;
+				break;
+			}
+			if (lnb[i].lnb_flags & OBD_BRW_SOFT_SYNC)
+				soft_sync = true;
+		}
+	}
+
+	if (CFS_FAIL_CHECK(OBD_FAIL_OST_DQACQ_NET))
+		GOTO(out_stop, rc = -EINPROGRESS);
+
+	for (i = 0; i < objcount; i++) {
+		o = ofd_object_child(fo[i]);
+		rc = dt_declare_write_commit(env, o, lnb + objs_lnb[i],
+					     objs_lnb[i + 1] - objs_lnb[i], th);
+		if (rc)
+			GOTO(out_stop, rc);
+
+		la_from_obdo(la, &bodies[i].oa, times);
+		if (la->la_valid & LA_ATIME &&
+		    la->la_atime <= fo[i]->ofo_atime_ondisk)
+			la->la_valid &= ~LA_ATIME;
+		if (la->la_valid) {
+			rc = dt_declare_attr_set(env, o, la, th);
+			if (rc)
+				GOTO(out_stop, rc);
+		}
+	}
+
+	/* no single object to track the version of */
+	rc = ofd_trans_start(env, ofd, NULL, th);
+	if (rc)
+		GOTO(out_stop, rc);
+
+	for (i = 0; i < objcount; i++) {
+		o = ofd_object_child(fo[i]);
+
+		ofd_read_lock(env, fo[i]);
+		if (!ofd_object_exists(fo[i]))
+			GOTO(out_unlock, rc = -ENOENT);
+
+		la_from_obdo(la, &bodies[i].oa, times);
+		if (la->la_valid & LA_ATIME &&
+		    la->la_atime <= fo[i]->ofo_atime_ondisk)
+			la->la_valid &= ~LA_ATIME;
+		if (la->la_valid &&
+		    tgt_fmd_check(exp, lu_object_fid(&fo[i]->ofo_obj.do_lu),
+				  info->fti_xid)) {
+			rc = dt_attr_set(env, o, la, th);
+			if (rc)
+				GOTO(out_unlock, rc);
+			if (la->la_valid & LA_ATIME)
+				fo[i]->ofo_atime_ondisk = la->la_atime;
+		}
+
+		rc = dt_write_commit(env, o, lnb + objs_lnb[i],
+				     objs_lnb[i + 1] - objs_lnb[i], th,
+				     bodies[i].oa.o_size);
+		if (rc) {
+			restart = th->th_restart_tran;
+			GOTO(out_unlock, rc);
+		}
+		atomic_inc(&fo[i]->ofo_data_gen);
+
+		/* get attr to return */
+		rc = dt_attr_get(env, o, la);
+		if (rc)
+			GOTO(out_unlock, rc);
+		obdo_from_la(&bodies[i].oa, la, OFD_VALID_FLAGS);
+		ofd_read_unlock(env, fo[i]);
+	}
+	GOTO(out_stop, rc);
+
+out_unlock:
+	ofd_read_unlock(env, fo[i]);
+out_stop:
+	/* Force commit to make the just-deleted blocks
+	 * reusable. LU-456 */
+	if (rc == -ENOSPC)
+		th->th_sync = 1;
+
+	/* do this before trans stop in case commit has finished */
+	if (!th->th_sync && soft_sync && !cb_registered) {
+		ofd_soft_sync_cb_add(th, exp);
+		cb_registered = true;
+	}
+
+	if (rc == 0 && granted > 0) {
+		if (tgt_grant_commit_cb_add(th, exp, granted) == 0)
+			granted = 0;
+	}
+
+	rc2 = ofd_trans_stop(env, ofd, th, restart ? 0 : rc);
+	if (!rc)
+		rc = rc2;
+	if (rc == -ENOSPC && retries++ < 3) {
+		CDEBUG(D_INODE, "retry after force commit, retries:%d\n",
+		       retries);
+		goto retry;
+	}
+
+	if (restart) {
+		retries++;
+		restart = 0;
+		if (retries % 10000 == 0)
+			CERROR("%s: restart IO write too many times: %d\n",
+				ofd_name(ofd), retries);
+		CDEBUG(D_INODE, "retry transaction, retries:%d\n",
+		       retries);
+		goto retry;
+	}
+	if (!soft_sync)
+		/* reset fed_soft_sync_count upon non-SOFT_SYNC RPC */
+		atomic_set(&fed->fed_soft_sync_count, 0);
+	else if (atomic_inc_return(&fed->fed_soft_sync_count) ==
+		 ofd->ofd_soft_sync_limit)
+		dt_commit_async(env, ofd->ofd_osd);
+
+out:
+	for (i = 0; i < objcount; i++) {
+		dt_bufs_put(env, ofd_object_child(fo[i]), lnb + objs_lnb[i],
+			    objs_lnb[i + 1] - objs_lnb[i]);
+		ofd_object_put(env, fo[i]);
+	}
+	if (granted > 0)
+		tgt_grant_commit(exp, granted, old_rc);
+	RETURN(rc);
+}
+
+/**
+ * Return the quota state of a write to the client.
+ *
+ * \param[in] oa	OBDO structure of the reply
+ * \param[in] lnb	first local buffer of the object
+ * \param[in] root_squash	whether the owner is squashed
+ */
+static void ofd_write_quota_flags(struct obdo *oa, struct niobuf_local *lnb,
+				  int root_squash)
+{
+	if (lnb->lnb_flags & OBD_BRW_OVER_USRQUOTA) {
+		if (oa->o_valid & OBD_MD_FLFLAGS)
+			oa->o_flags |= OBD_FL_NO_USRQUOTA;
+		else
+			oa->o_flags = OBD_FL_NO_USRQUOTA;
+	}
+
+	if (lnb->lnb_flags & OBD_BRW_OVER_GRPQUOTA) {
+		if (oa->o_valid & OBD_MD_FLFLAGS)
+			oa->o_flags |= OBD_FL_NO_GRPQUOTA;
+		else
+			oa->o_flags = OBD_FL_NO_GRPQUOTA;
+	}
+	if (lnb->lnb_flags & OBD_BRW_OVER_PRJQUOTA) {
+		if (oa->o_valid & OBD_MD_FLFLAGS)
+			oa->o_flags |= OBD_FL_NO_PRJQUOTA;
+		else
+			oa->o_flags = OBD_FL_NO_PRJQUOTA;
+	}
+
+	if (lnb->lnb_flags & OBD_BRW_ROOT_PRJQUOTA)
+		oa->o_flags |= OBD_FL_ROOT_PRJQUOTA;
+
+	if (root_squash)
+		oa->o_flags |= OBD_FL_ROOT_SQUASH;
+
+	oa->o_valid |= OBD_MD_FLFLAGS;
+	oa->o_valid |= OBD_MD_FLALLQUOTA;
+}
+
+/**
+ * Finish a multi-object write.
+ *
+ * Counterpart of the write branch of ofd_commitrw() for the objects
+ * described by tgt_session_info::tsi_ioobj_bodies[]: squashed owners do
+ * not bypass quota, and the quota state and client IDs of each object
+ * are returned in its own body.
+ */
+static int ofd_commitrw_multi(const struct lu_env *env,
+			      struct obd_export *exp, struct obdo *oa,
+			      int objcount, struct niobuf_local *lnb,
+			      int old_rc)
+{
+	struct ofd_thread_info *info = ofd_info(env);
+	struct ost_body *bodies = tgt_ses_info(env)->tsi_ioobj_bodies;
+	int *objs_lnb = info->fti_objs_lnb;
+	struct lu_nodemap *nodemap;
+	__u32 squashed = 0;
+	int i, j, rc;
+
+	BUILD_BUG_ON(PTLRPC_MAX_BRW_OBJS > 32);
+
+	nodemap = nodemap_get_from_exp(exp);
+	if (IS_ERR(nodemap) && old_rc == 0)
+		old_rc = PTR_ERR(nodemap);
+
+	/* do not bypass quota enforcement if squashed uid */
+	for (i = 0; !IS_ERR_OR_NULL(nodemap) && i < objcount; i++) {
+		if (nodemap_map_id(nodemap, NODEMAP_UID, NODEMAP_FS_TO_CLIENT,
+				   bodies[i].oa.o_uid) != nodemap->nm_squash_uid)
+			continue;
+		for (j = objs_lnb[i]; j < objs_lnb[i + 1]; j++)
+			lnb[j].lnb_flags &= ~OBD_BRW_SYS_RESOURCE;
+		squashed |= BIT(i);
+	}
+
+	rc = ofd_commitrw_write_multi(env, exp, ofd_exp(exp), objcount, lnb,
+				      oa->o_grant_used, old_rc);
+
+	for (i = 0; i < objcount; i++) {
+		struct obdo *boa = &bodies[i].oa;
+
+		/* don't report overquota flag if we failed before reaching
+		 * commit */
+		if (old_rc == 0 && (rc == 0 || rc == -EDQUOT))
+			ofd_write_quota_flags(boa, &lnb[objs_lnb[i]],
+					      !!(squashed & BIT(i)));
+
+		/* Convert back to client IDs. LU-9671. */
+		if (IS_ERR_OR_NULL(nodemap))
+			continue;
+		boa->o_uid = nodemap_map_id(nodemap, NODEMAP_UID,
+					    NODEMAP_FS_TO_CLIENT, boa->o_uid);
+		boa->o_gid = nodemap_map_id(nodemap, NODEMAP_GID,
+					    NODEMAP_FS_TO_CLIENT, boa->o_gid);
+		boa->o_projid = nodemap_map_id(nodemap, NODEMAP_PROJID,
+					       NODEMAP_FS_TO_CLIENT,
+					       boa->o_projid);
+	}
+
+	if (!IS_ERR_OR_NULL(nodemap))
+		nodemap_putref(nodemap);
+
+	return rc;
+}
+
 /**
  * Commit bulk IO to the storage.
  *
@@ -1423,7 +1953,7 @@ out:
  * \param[in] cmd	IO type (READ/WRITE)
  * \param[in] exp	OBD export of client
  * \param[in] oa	OBDO structure from client
- * \param[in] objcount	always 1
+ * \param[in] objcount	number of objects, only writes have more
  * \param[in] obj	object data
  * \param[in] rnb	remote buffers
  * \param[in] npages	number of local buffers
@@ -1457,7 +1987,13 @@ int ofd_commitrw(const struct lu_env *env, int cmd, struct obd_export *exp,
 		jobid = tsi->tsi_jobid;
 	}
 
-	if (cmd == OBD_BRW_WRITE) {
+	if (cmd == OBD_BRW_WRITE && objcount > 1) {
+		ofd_counter_incr(exp, LPROC_OFD_STATS_WRITE_BYTES, jobid, nob);
+		ofd_counter_incr(exp, LPROC_OFD_STATS_WRITE, jobid,
+				 ktime_us_delta(ktime_get(), kstart));
+
+		rc = ofd_commitrw_multi(env, exp, oa, objcount, lnb, old_rc);
+	} else if (cmd == OBD_BRW_WRITE) {
 		struct lu_nodemap *nodemap;
 		__u32 mapped_uid, mapped_gid, mapped_projid;
 
@@ -1518,37 +2054,9 @@ int ofd_commitrw(const struct lu_env *env, int cmd, struct obd_export *exp,
 
 		/* don't report overquota flag if we failed before reaching
 		 * commit */
-		if (old_rc == 0 && (rc == 0 || rc == -EDQUOT)) {
+		if (old_rc == 0 && (rc == 0 || rc == -EDQUOT))
 			/* return the overquota flags to client */
-			if (lnb[0].lnb_flags & OBD_BRW_OVER_USRQUOTA) {
-				if (oa->o_valid & OBD_MD_FLFLAGS)
-					oa->o_flags |= OBD_FL_NO_USRQUOTA;
-				else
-					oa->o_flags = OBD_FL_NO_USRQUOTA;
-			}
-
-			if (lnb[0].lnb_flags & OBD_BRW_OVER_GRPQUOTA) {
-				if (oa->o_valid & OBD_MD_FLFLAGS)
-					oa->o_flags |= OBD_FL_NO_GRPQUOTA;
-				else
-					oa->o_flags = OBD_FL_NO_GRPQUOTA;
-			}
-			if (lnb[0].lnb_flags & OBD_BRW_OVER_PRJQUOTA) {
-				if (oa->o_valid & OBD_MD_FLFLAGS)
-					oa->o_flags |= OBD_FL_NO_PRJQUOTA;
-				else
-					oa->o_flags = OBD_FL_NO_PRJQUOTA;
-			}
-
-			if (lnb[0].lnb_flags & OBD_BRW_ROOT_PRJQUOTA)
-				oa->o_flags |= OBD_FL_ROOT_PRJQUOTA;
-
-			if (root_squash)
-				oa->o_flags |= OBD_FL_ROOT_SQUASH;
-
-			oa->o_valid |= OBD_MD_FLFLAGS;
-			oa->o_valid |= OBD_MD_FLALLQUOTA;
-		}
+			ofd_write_quota_flags(oa, &lnb[0], root_squash);
 
 		/**
 		 * Update LVB after writing finish for server lock, see
@@ -1574,11 +2082,18 @@ int ofd_commitrw(const struct lu_env *env, int cmd, struct obd_export *exp,
 		oa->o_gid = mapped_gid;
 		oa->o_projid = mapped_projid;
 	} else if (cmd == OBD_BRW_READ) {
+		__u64 decompr;
+
 		/* see comment on LPROC_OFD_STATS_WRITE_BYTES usage above */
 		ofd_counter_incr(exp, LPROC_OFD_STATS_READ_BYTES, jobid, nob);
 		ofd_counter_incr(exp, LPROC_OFD_STATS_READ, jobid,
 				 ktime_us_delta(ktime_get(), kstart));
 
+		decompr = ofd_decompress_read_fini(env, ofd, npages, lnb);
+		if (decompr)
+			ofd_counter_incr(exp, LPROC_OFD_STATS_DECOMPR_BYTES,
+					 jobid, decompr);
+
 		rc = ofd_commitrw_read(env, ofd, fid, objcount,
 				       npages, lnb);
 		if (old_rc)
@@ -39,6 +39,8 @@
 
 #define DEBUG_SUBSYSTEM S_FILTER
 
+#include <linux/falloc.h>
+
 #include <dt_object.h>
 #include <lustre_lfsck.h>
 #include <lustre_export.h>
@@ -811,6 +813,13 @@ int ofd_object_fallocate(const struct lu_env *env, struct ofd_object *fo,
 		}
 	}
 
+	/* keep the data of compressed chunks cut by the hole */
+	if (mode & FALLOC_FL_PUNCH_HOLE) {
+		rc = ofd_compr_unpack(env, ofd, fo, start, end);
+		if (rc)
+			RETURN(rc);
+	}
+
 	th = ofd_trans_create(env, ofd);
 	if (IS_ERR(th))
 		RETURN(PTR_ERR(th));
@@ -848,6 +857,7 @@ int ofd_object_fallocate(const struct lu_env *env, struct ofd_object *fo,
 	rc = dt_falloc(env, dob, start, end, mode, th);
 	if (rc)
 		GOTO(unlock, rc);
+	atomic_inc(&fo->ofo_data_gen);
 
 	rc = dt_attr_set(env, dob, la, th);
 	if (rc)
@@ -918,6 +928,11 @@ int ofd_object_punch(const struct lu_env *env, struct ofd_object *fo,
 	if (rc != 0)
 		GOTO(out, rc);
 
+	/* keep the data of a compressed chunk cut by the truncate */
+	rc = ofd_compr_unpack(env, ofd, fo, start, end);
+	if (rc != 0)
+		GOTO(out, rc);
+
 	th = ofd_trans_create(env, ofd);
 	if (IS_ERR(th))
 		GOTO(out, rc = PTR_ERR(th));
@@ -965,6 +980,7 @@ int ofd_object_punch(const struct lu_env *env, struct ofd_object *fo,
 	rc = dt_punch(env, dob, start, OBD_OBJECT_EOF, th);
 	if (rc)
 		GOTO(unlock, rc);
+	atomic_inc(&fo->ofo_data_gen);
 
 	fl = ofd_object_ff_update(env, fo, oa, ff);
 	if (fl < 0)
@@ -195,7 +195,7 @@ static int osc_cached_mb_seq_show(struct seq_file *m, void *v)
 		   (atomic_long_read(&cli->cl_lru_in_list) +
 		    atomic_long_read(&cli->cl_lru_busy)) >> shift,
 		    atomic_long_read(&cli->cl_lru_busy),
-		   cli->cl_lru_reclaim);
+		   (u64)atomic64_read(&cli->cl_lru_reclaim));
 
 	return 0;
 }
@@ -393,6 +393,65 @@ static ssize_t checksums_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(checksums);
 
+static ssize_t zero_write_show(struct kobject *kobj, struct attribute *attr,
+			       char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", !!obd->u.cli.cl_zero_write);
+}
+
+static ssize_t zero_write_store(struct kobject *kobj, struct attribute *attr,
+				const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	obd->u.cli.cl_zero_write = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(zero_write);
+
+static ssize_t max_objs_per_rpc_show(struct kobject *kobj,
+				     struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 obd->u.cli.cl_max_objs_per_rpc);
+}
+
+static ssize_t max_objs_per_rpc_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val > PTLRPC_MAX_BRW_OBJS)
+		return -ERANGE;
+
+	obd->u.cli.cl_max_objs_per_rpc = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(max_objs_per_rpc);
+
 DECLARE_CKSUM_NAME;
 
 static int osc_checksum_type_seq_show(struct seq_file *m, void *v)
@@ -670,6 +729,185 @@ static ssize_t grant_shrink_store(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RW_ATTR(grant_shrink);
 
+static ssize_t rpc_autotune_target_us_show(struct kobject *kobj,
+					   struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 cli->cl_rpc_tune.crt_target_us);
+}
+
+static ssize_t rpc_autotune_target_us_store(struct kobject *kobj,
+					    struct attribute *attr,
+					    const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	osc_rpc_tune_enable(cli, val);
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(rpc_autotune_target_us);
+
+static ssize_t rpc_autotune_min_rpcs_in_flight_show(struct kobject *kobj,
+						    struct attribute *attr,
+						    char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 cli->cl_rpc_tune.crt_min_rpcs);
+}
+
+static ssize_t rpc_autotune_min_rpcs_in_flight_store(struct kobject *kobj,
+						     struct attribute *attr,
+						     const char *buffer,
+						     size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val == 0 || val > OSC_MAX_RIF_MAX)
+		return -ERANGE;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	cli->cl_rpc_tune.crt_min_rpcs = val;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(rpc_autotune_min_rpcs_in_flight);
+
+static ssize_t rpc_autotune_min_pages_per_rpc_show(struct kobject *kobj,
+						   struct attribute *attr,
+						   char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 cli->cl_rpc_tune.crt_min_pages);
+}
+
+static ssize_t rpc_autotune_min_pages_per_rpc_store(struct kobject *kobj,
+						    struct attribute *attr,
+						    const char *buffer,
+						    size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+	u64 val;
+	int rc;
+
+	rc = sysfs_memparse(buffer, count, &val, "B");
+	if (rc)
+		return rc;
+
+	/* like max_pages_per_rpc, a value in bytes is converted to pages */
+	if (val >= ONE_MB_BRW_SIZE)
+		val >>= PAGE_SHIFT;
+	if (val == 0 || val > PTLRPC_MAX_BRW_PAGES)
+		return -ERANGE;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	cli->cl_rpc_tune.crt_min_pages = val;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(rpc_autotune_min_pages_per_rpc);
+
+static ssize_t write_stage_pages_show(struct kobject *kobj,
+				      struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", cli->cl_stage_pages);
+}
+
+static ssize_t write_stage_pages_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	/* 0 and 1 both stage a single page, as before batching */
+	if (val > OSC_STAGE_PAGES_MAX)
+		return -ERANGE;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	cli->cl_stage_pages = val;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(write_stage_pages);
+
+static int osc_rpc_autotune_seq_show(struct seq_file *m, void *v)
+{
+	struct obd_device *obd = m->private;
+	struct client_obd *cli = &obd->u.cli;
+	struct cl_rpc_tune *crt = &cli->cl_rpc_tune;
+	struct cl_rpc_tune_event *crte;
+	u32 i;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	seq_printf(m, "target_us: %u\n"
+		   "rpcs_in_flight: %u\n"
+		   "pages_per_rpc: %u\n"
+		   "trace:\n",
+		   crt->crt_target_us, osc_rpc_tune_rpcs(cli),
+		   osc_rpc_tune_pages(cli));
+	i = crt->crt_trace_nr > CL_RPC_TUNE_TRACE ?
+	    crt->crt_trace_nr - CL_RPC_TUNE_TRACE : 0;
+	for (; i < crt->crt_trace_nr; i++) {
+		crte = &crt->crt_trace[i % CL_RPC_TUNE_TRACE];
+		seq_printf(m,
+			   "  - { time: %lld, action: \"%s\", latency_us: %u, rate_kbps: %u, rpcs_in_flight: %u, pages_per_rpc: %u }\n",
+			   crte->crte_time, crte->crte_action,
+			   crte->crte_latency_us, crte->crte_rate_kbps,
+			   crte->crte_rpcs, crte->crte_pages);
+	}
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return 0;
+}
+LPROC_SEQ_FOPS_RO(osc_rpc_autotune);
+
 LPROC_SEQ_FOPS_RO_TYPE(osc, connect_flags);
 LPROC_SEQ_FOPS_RO_TYPE(osc, server_uuid);
 LPROC_SEQ_FOPS_RO_TYPE(osc, timeouts);
@@ -701,6 +939,8 @@ struct lprocfs_vars lprocfs_osc_obd_vars[] = {
 	  .fops	=	&osc_pinger_recov_fops		},
 	{ .name	=	"unstable_stats",
 	  .fops	=	&osc_unstable_stats_fops	},
+	{ .name	=	"rpc_autotune",
+	  .fops	=	&osc_rpc_autotune_fops		},
 	{ NULL }
 };
 
@@ -818,6 +1058,142 @@ static ssize_t osc_rpc_stats_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(osc_rpc_stats);
 
+static const char * const osc_stage_flush_names[CL_STAGE_FLUSH_NR] = {
+	[CL_STAGE_FLUSH_IO_END]		= "io_end",
+	[CL_STAGE_FLUSH_EXTENT]		= "extent",
+	[CL_STAGE_FLUSH_NO_SPACE]	= "no_space",
+};
+
+static int osc_write_stage_stats_seq_show(struct seq_file *seq, void *v)
+{
+	struct obd_device *obd = seq->private;
+	struct client_obd *cli = &obd->u.cli;
+	struct cl_stage_stats *css = &cli->cl_stage_stats;
+	unsigned long tot;
+	unsigned long cum = 0;
+	int i;
+
+	spin_lock(&cli->cl_loi_list_lock);
+
+	lprocfs_stats_header(seq, ktime_get_real(), css->css_init, 25,
+			     ":", true, "");
+	seq_printf(seq, "stage pages:          %u\n", cli->cl_stage_pages);
+	seq_printf(seq, "fills:                %llu\n", css->css_fills);
+	seq_printf(seq, "fill pages:           %llu\n", css->css_fill_pages);
+	seq_printf(seq, "fill grant bytes:     %llu\n", css->css_fill_grant);
+	seq_printf(seq, "unused pages:         %llu\n", css->css_flush_pages);
+	seq_printf(seq, "unused grant bytes:   %llu\n", css->css_flush_grant);
+	for (i = 0; i < CL_STAGE_FLUSH_NR; i++)
+		seq_printf(seq, "flush %-15s %llu\n",
+			   osc_stage_flush_names[i], css->css_flushes[i]);
+	seq_printf(seq, "lock holds:           %llu\n", css->css_locked);
+	seq_printf(seq, "lock hold avg ns:     %llu\n",
+		   css->css_locked ?
+		   div64_u64(css->css_hold_ns, css->css_locked) : 0);
+	seq_printf(seq, "lock hold max ns:     %llu\n", css->css_hold_max_ns);
+
+	seq_puts(seq, "\npages per fill        fills   % cum %\n");
+	tot = lprocfs_oh_sum(&css->css_batch_hist);
+	for (i = 0; i < OBD_HIST_MAX && cum < tot; i++) {
+		unsigned long n = css->css_batch_hist.oh_buckets[i];
+
+		cum += n;
+		seq_printf(seq, "%d:\t\t%10lu %3u %3u\n",
+			   1 << i, n, pct(n, tot),
+			   pct(cum, tot));
+	}
+
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return 0;
+}
+
+static ssize_t osc_write_stage_stats_seq_write(struct file *file,
+					       const char __user *buf,
+					       size_t len, loff_t *off)
+{
+	struct seq_file *seq = file->private_data;
+	struct obd_device *obd = seq->private;
+	struct client_obd *cli = &obd->u.cli;
+	struct cl_stage_stats *css = &cli->cl_stage_stats;
+
+	lprocfs_oh_clear(&css->css_batch_hist);
+	spin_lock(&cli->cl_loi_list_lock);
+	css->css_fills = 0;
+	css->css_fill_pages = 0;
+	css->css_fill_grant = 0;
+	memset(css->css_flushes, 0, sizeof(css->css_flushes));
+	css->css_flush_pages = 0;
+	css->css_flush_grant = 0;
+	css->css_locked = 0;
+	css->css_hold_ns = 0;
+	css->css_hold_max_ns = 0;
+	css->css_init = ktime_get_real();
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return len;
+}
+LPROC_SEQ_FOPS(osc_write_stage_stats);
+
+static int osc_lru_shards_seq_show(struct seq_file *seq, void *v)
+{
+	struct obd_device *obd = seq->private;
+	struct client_obd *cli = &obd->u.cli;
+	struct cl_lru_shard *shard;
+	int i;
+
+	lprocfs_stats_header(seq, ktime_get_real(),
+			     cli->cl_lru_shards[0]->cls_init, 25, ":", true, "");
+	seq_printf(seq, "%-4s %12s %10s %12s %10s %10s\n", "cpt", "pages",
+		   "shrinks", "shrunk", "avg_us", "max_us");
+	cfs_percpt_for_each(shard, i, cli->cl_lru_shards) {
+		long pages;
+		u64 shrinks;
+		u64 shrunk;
+		u64 ns;
+		u64 max_ns;
+
+		spin_lock(&shard->cls_lock);
+		pages = shard->cls_count;
+		shrinks = shard->cls_shrinks;
+		shrunk = shard->cls_shrink_pages;
+		ns = shard->cls_shrink_ns;
+		max_ns = shard->cls_shrink_max_ns;
+		spin_unlock(&shard->cls_lock);
+
+		seq_printf(seq, "%-4d %12ld %10llu %12llu %10llu %10llu\n",
+			   i, pages, shrinks, shrunk,
+			   shrinks ? div64_u64(ns, shrinks * NSEC_PER_USEC) : 0,
+			   div64_u64(max_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static ssize_t osc_lru_shards_seq_write(struct file *file,
+					const char __user *buf,
+					size_t len, loff_t *off)
+{
+	struct seq_file *seq = file->private_data;
+	struct obd_device *obd = seq->private;
+	struct client_obd *cli = &obd->u.cli;
+	struct cl_lru_shard *shard;
+	int i;
+
+	cfs_percpt_for_each(shard, i, cli->cl_lru_shards) {
+		spin_lock(&shard->cls_lock);
+		shard->cls_shrinks = 0;
+		shard->cls_shrink_pages = 0;
+		shard->cls_shrink_ns = 0;
+		shard->cls_shrink_max_ns = 0;
+		shard->cls_init = ktime_get_real();
+		spin_unlock(&shard->cls_lock);
+	}
+
+	return len;
+}
+LPROC_SEQ_FOPS(osc_lru_shards);
+
 static int osc_stats_seq_show(struct seq_file *seq, void *v)
 {
 	struct obd_device *obd = seq->private;
@@ -829,6 +1205,12 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 		   stats->os_lockless_writes);
 	seq_printf(seq, "lockless_read_bytes\t\t%llu\n",
 		   stats->os_lockless_reads);
+	seq_printf(seq, "zero_write_bytes\t\t%llu\n",
+		   stats->os_zero_writes);
+	seq_printf(seq, "multi_obj_write_rpcs\t\t%llu\n",
+		   stats->os_multi_obj_writes);
+	seq_printf(seq, "multi_obj_write_objs\t\t%llu\n",
+		   stats->os_multi_obj_objs);
 	return 0;
 }
 
@@ -857,6 +1239,12 @@ static int lprocfs_osc_attach_seqstat(struct obd_device *obd)
 	if (rc == 0)
 		rc = lprocfs_obd_seq_create(obd, "rpc_stats", 0644,
 					    &osc_rpc_stats_fops, obd);
+	if (rc == 0)
+		rc = lprocfs_obd_seq_create(obd, "write_stage_stats", 0644,
+					    &osc_write_stage_stats_fops, obd);
+	if (rc == 0)
+		rc = lprocfs_obd_seq_create(obd, "lru_shards", 0644,
+					    &osc_lru_shards_fops, obd);
 
 	return rc;
 }
@@ -886,6 +1274,12 @@ static struct attribute *osc_attrs[] = {
 	&lustre_attr_idle_timeout.attr,
 	&lustre_attr_idle_connect.attr,
 	&lustre_attr_grant_shrink.attr,
+	&lustre_attr_rpc_autotune_target_us.attr,
+	&lustre_attr_rpc_autotune_min_rpcs_in_flight.attr,
+	&lustre_attr_rpc_autotune_min_pages_per_rpc.attr,
+	&lustre_attr_write_stage_pages.attr,
+	&lustre_attr_zero_write.attr,
+	&lustre_attr_max_objs_per_rpc.attr,
 	&lustre_attr_at_max.attr,
 	&lustre_attr_at_min.attr,
 	&lustre_attr_at_history.attr,
@@ -251,8 +251,10 @@ static int osc_extent_sanity_check0(struct osc_extent *ext,
 	page_count = 0;
 	list_for_each_entry(oap, &ext->oe_pages, oap_pending_item) {
 		pgoff_t index = osc_index(oap2osc(oap));
-		++page_count;
-		if (index > ext->oe_end || index < ext->oe_start)
+		unsigned int nr = osc_page_nr(oap2osc(oap));
+
+		page_count += nr;
+		if (index + nr - 1 > ext->oe_end || index < ext->oe_start)
 			GOTO(out, rc = 110);
 	}
 	if (page_count != ext->oe_nr_pages)
@@ -638,12 +640,12 @@ void osc_extent_release(const struct lu_env *env, struct osc_extent *ext)
 }
 
 /**
- * Find or create an extent which includes @index, core function to manage
- * extent tree.
+ * Find or create an extent which includes the @nr pages starting at @index,
+ * core function to manage extent tree.
  */
 static struct osc_extent *osc_extent_find(const struct lu_env *env,
 					  struct osc_object *obj, pgoff_t index,
-					  unsigned int *grants)
+					  unsigned int nr, unsigned int *grants)
 {
 	struct client_obd *cli = osc_cli(obj);
 	struct osc_lock   *olck;
@@ -653,9 +655,11 @@ static struct osc_extent *osc_extent_find(const struct lu_env *env,
 	struct osc_extent *conflict = NULL;
 	struct osc_extent *found = NULL;
 	pgoff_t    chunk;
+	pgoff_t    last_chunk;
 	pgoff_t    max_end;
 	unsigned int max_pages; /* max_pages_per_rpc */
 	unsigned int chunksize;
+	unsigned int nr_chunks;
 	int        ppc_bits; /* pages per chunk bits */
 	pgoff_t    chunk_mask;
 	int        rc;
@@ -678,26 +682,36 @@ static struct osc_extent *osc_extent_find(const struct lu_env *env,
 	chunk_mask = ~((1 << ppc_bits) - 1);
 	chunksize  = 1 << cli->cl_chunkbits;
 	chunk      = index >> ppc_bits;
+	last_chunk = (index + nr - 1) >> ppc_bits;
+	nr_chunks  = last_chunk - chunk + 1;
 
 	/* align end to RPC edge. */
-	max_pages = cli->cl_max_pages_per_rpc;
+	max_pages = osc_rpc_tune_pages(cli);
 	if ((max_pages & ~chunk_mask) != 0) {
 		CERROR("max_pages: %#x chunkbits: %u chunk_mask: %#lx\n",
 		       max_pages, cli->cl_chunkbits, chunk_mask);
 		RETURN(ERR_PTR(-EINVAL));
 	}
+	/* a large page must not straddle an RPC edge */
+	if (max_pages % nr != 0)
+		max_pages = max(round_down(max_pages, nr), nr);
 	max_end = index - (index % max_pages) + max_pages - 1;
 	max_end = min_t(pgoff_t, max_end, descr->cld_end);
+	if (max_end < index + nr - 1) {
+		CERROR("%s: page %lu+%u is not covered by lock end %lu\n",
+		       cli_name(cli), index, nr, (pgoff_t)descr->cld_end);
+		GOTO(out, found = ERR_PTR(-ERANGE));
+	}
 
 	/* initialize new extent by parameters so far */
 	cur->oe_max_end = max_end;
 	cur->oe_start   = index & chunk_mask;
-	cur->oe_end     = ((index + ~chunk_mask + 1) & chunk_mask) - 1;
+	cur->oe_end     = ((last_chunk + 1) << ppc_bits) - 1;
 	if (cur->oe_start < descr->cld_start)
 		cur->oe_start = descr->cld_start;
 	if (cur->oe_end > max_end)
 		cur->oe_end = max_end;
-	cur->oe_grants  = chunksize + cli->cl_grant_extent_tax;
+	cur->oe_grants  = nr_chunks * chunksize + cli->cl_grant_extent_tax;
 	cur->oe_mppr    = max_pages;
 	if (olck->ols_dlmlock != NULL) {
 		LASSERT(olck->ols_hold);
@@ -706,7 +720,7 @@ static struct osc_extent *osc_extent_find(const struct lu_env *env,
 	}
 
 	/* grants has been allocated by caller */
-	LASSERTF(*grants >= chunksize + cli->cl_grant_extent_tax,
+	LASSERTF(*grants >= cur->oe_grants,
 		 "%u/%u/%u.\n", *grants, chunksize, cli->cl_grant_extent_tax);
 	LASSERTF((max_end - cur->oe_start) < max_pages, EXTSTR"\n",
 		 EXTPARA(cur));
@@ -721,7 +735,7 @@ restart:
 		pgoff_t ext_chk_end = ext->oe_end >> ppc_bits;
 
 		LASSERT(sanity_check_nolock(ext) == 0);
-		if (chunk > ext_chk_end + 1 || chunk < ext_chk_start)
+		if (chunk > ext_chk_end + 1 || last_chunk < ext_chk_start)
 			break;
 
 		/* if covering by different locks, no chance to match */
@@ -733,7 +747,7 @@ restart:
 		}
 
 		/* discontiguous chunks? */
-		if (chunk + 1 < ext_chk_start)
+		if (last_chunk + 1 < ext_chk_start)
 			continue;
 
 		/* ok, from now on, ext and cur have these attrs:
@@ -766,8 +780,8 @@ restart:
 			continue;
 
 		if (osc_extent_merge(env, ext, cur) == 0) {
-			LASSERT(*grants >= chunksize);
-			*grants -= chunksize;
+			LASSERT(*grants >= nr_chunks * chunksize);
+			*grants -= nr_chunks * chunksize;
 
 			/*
 			 * Try to merge with the next one too because we
@@ -855,10 +869,13 @@ int osc_extent_finish(const struct lu_env *env, struct osc_extent *ext,
 			last_count = oap->oap_count;
 		}
 
-		--ext->oe_nr_pages;
+		ext->oe_nr_pages -= osc_page_nr(oap2osc(oap));
 		osc_ap_completion(env, cli, oap, sent, rc);
 	}
 	EASSERT(ext->oe_nr_pages == 0, ext);
+	/* only the last PAGE_SIZE part of a large page can be partial */
+	if (last_count > (int)PAGE_SIZE)
+		last_count = ((last_count - 1) & ~PAGE_MASK) + 1;
 
 	if (!sent) {
 		lost_grant = ext->oe_grants;
@@ -947,10 +964,9 @@ static int osc_extent_truncate(struct osc_extent *ext, pgoff_t trunc_index,
 	struct osc_async_page *oap;
 	struct osc_async_page *tmp;
 	struct pagevec        *pvec;
-	int                    pages_in_chunk = 0;
+	pgoff_t                last_kept = 0;
 	int                    ppc_bits    = cli->cl_chunkbits -
 					     PAGE_SHIFT;
-	__u64                  trunc_chunk = trunc_index >> ppc_bits;
 	int                    grants   = 0;
 	int                    nr_pages = 0;
 	int                    rc       = 0;
@@ -982,17 +998,18 @@ static int osc_extent_truncate(struct osc_extent *ext, pgoff_t trunc_index,
 				     oap_pending_item) {
 		pgoff_t index = osc_index(oap2osc(oap));
 		struct cl_page  *page = oap2cl_page(oap);
+		unsigned int nr = cl_page_nr(page);
 
 		LASSERT(list_empty(&oap->oap_rpc_item));
 
 		/* only discard the pages with their index greater than
-		 * trunc_index, and ... */
+		 * trunc_index, and ... a large page straddling trunc_index
+		 * is kept as a whole, like a partial page */
 		if (index < trunc_index ||
 		    (index == trunc_index && partial)) {
-			/* accounting how many pages remaining in the chunk
+			/* remember the last page remaining in the extent
 			 * so that we can calculate grants correctly. */
-			if (index >> ppc_bits == trunc_chunk)
-				++pages_in_chunk;
+			last_kept = max(last_kept, index + nr - 1);
 			continue;
 		}
 
@@ -1012,8 +1029,8 @@ static int osc_extent_truncate(struct osc_extent *ext, pgoff_t trunc_index,
 		lu_ref_del(&page->cp_reference, "truncate", current);
 		cl_pagevec_put(env, page, pvec);
 
-		--ext->oe_nr_pages;
-		++nr_pages;
+		ext->oe_nr_pages -= nr;
+		nr_pages += nr;
 	}
 	pagevec_release(pvec);
 
@@ -1023,29 +1040,22 @@ static int osc_extent_truncate(struct osc_extent *ext, pgoff_t trunc_index,
 
 	osc_object_lock(obj);
 	if (ext->oe_nr_pages == 0) {
-		LASSERT(pages_in_chunk == 0);
 		grants = ext->oe_grants;
 		ext->oe_grants = 0;
 	} else { /* calculate how many grants we can free */
-		int     chunks = (ext->oe_end >> ppc_bits) - trunc_chunk;
+		pgoff_t keep_chunk = last_kept >> ppc_bits;
+		int     chunks = (ext->oe_end >> ppc_bits) - keep_chunk;
 		pgoff_t last_index;
 
-
-		/* if there is no pages in this chunk, we can also free grants
-		 * for the last chunk */
-		if (pages_in_chunk == 0) {
-			/* if this is the 1st chunk and no pages in this chunk,
-			 * ext->oe_nr_pages must be zero, so we should be in
-			 * the other if-clause. */
-			LASSERT(trunc_chunk > 0);
-			--trunc_chunk;
-			++chunks;
-		}
+		/* the grants of the chunks past the last remaining page
+		 * can be freed */
+		LASSERT(last_kept >= ext->oe_start &&
+			last_kept <= ext->oe_end);
 
 		/* this is what we can free from this extent */
 		grants          = chunks << cli->cl_chunkbits;
 		ext->oe_grants -= grants;
-		last_index      = ((trunc_chunk + 1) << ppc_bits) - 1;
+		last_index      = ((keep_chunk + 1) << ppc_bits) - 1;
 		ext->oe_end     = min(last_index, ext->oe_max_end);
 		LASSERT(ext->oe_end >= ext->oe_start);
 		LASSERT(ext->oe_grants > 0);
@@ -1084,7 +1094,7 @@ static int osc_extent_make_ready(const struct lu_env *env,
 	OSC_EXTENT_DUMP(D_CACHE, ext, "make ready\n");
 
 	list_for_each_entry(oap, &ext->oe_pages, oap_pending_item) {
-		++page_count;
+		page_count += osc_page_nr(oap2osc(oap));
 		if (last == NULL || last->oap_obj_off < oap->oap_obj_off)
 			last = oap;
 
@@ -1113,7 +1123,8 @@ static int osc_extent_make_ready(const struct lu_env *env,
 		int last_oap_count = osc_refresh_count(env, last, OBD_BRW_WRITE);
 		LASSERTF(last_oap_count > 0,
 			 "last_oap_count %d\n", last_oap_count);
-		LASSERT(last->oap_page_off + last_oap_count <= PAGE_SIZE);
+		LASSERT(last->oap_page_off + last_oap_count <=
+			osc_page_nr(oap2osc(last)) << PAGE_SHIFT);
 		last->oap_count = last_oap_count;
 		last->oap_async_flags |= ASYNC_COUNT_STABLE;
 	}
@@ -1122,7 +1133,8 @@ static int osc_extent_make_ready(const struct lu_env *env,
 	 * because it's known they are not the last page */
 	list_for_each_entry(oap, &ext->oe_pages, oap_pending_item) {
 		if (!(oap->oap_async_flags & ASYNC_COUNT_STABLE)) {
-			oap->oap_count = PAGE_SIZE - oap->oap_page_off;
+			oap->oap_count = (osc_page_nr(oap2osc(oap)) <<
+					  PAGE_SHIFT) - oap->oap_page_off;
 			oap->oap_async_flags |= ASYNC_COUNT_STABLE;
 		}
 	}
@@ -1139,36 +1151,37 @@ static int osc_extent_make_ready(const struct lu_env *env,
 /**
  * Quick and simple version of osc_extent_find(). This function is frequently
  * called to expand the extent for the same IO. To expand the extent, the
- * page index must be in the same or next chunk of ext->oe_end.
+ * page index must be in the same or next chunk of ext->oe_end, the @nr pages
+ * starting there may span more chunks.
  */
 static int osc_extent_expand(struct osc_extent *ext, pgoff_t index,
-			     unsigned int *grants)
+			     unsigned int nr, unsigned int *grants)
 {
 	struct osc_object *obj = ext->oe_obj;
 	struct client_obd *cli = osc_cli(obj);
 	struct osc_extent *next;
 	int ppc_bits = cli->cl_chunkbits - PAGE_SHIFT;
 	pgoff_t chunk = index >> ppc_bits;
+	pgoff_t last_chunk = (index + nr - 1) >> ppc_bits;
 	pgoff_t end_chunk;
 	pgoff_t end_index;
 	unsigned int chunksize = 1 << cli->cl_chunkbits;
+	unsigned int bytes;
 	int rc = 0;
 	ENTRY;
 
-	LASSERT(ext->oe_max_end >= index && ext->oe_start <= index);
+	LASSERT(ext->oe_max_end >= index + nr - 1 && ext->oe_start <= index);
 	osc_object_lock(obj);
 	LASSERT(sanity_check_nolock(ext) == 0);
 	end_chunk = ext->oe_end >> ppc_bits;
 	if (chunk > end_chunk + 1)
 		GOTO(out, rc = -ERANGE);
 
-	if (end_chunk >= chunk)
+	if (end_chunk >= last_chunk)
 		GOTO(out, rc = 0);
 
-	LASSERT(end_chunk + 1 == chunk);
-
 	/* try to expand this extent to cover @index */
-	end_index = min(ext->oe_max_end, ((chunk + 1) << ppc_bits) - 1);
+	end_index = min(ext->oe_max_end, ((last_chunk + 1) << ppc_bits) - 1);
 
 	/* don't go over the maximum extent size reported by server */
 	if (end_index - ext->oe_start + 1 > cli->cl_max_extent_pages)
@@ -1180,10 +1193,11 @@ static int osc_extent_expand(struct osc_extent *ext, pgoff_t index,
 		 * this case will be handled by osc_extent_find() */
 		GOTO(out, rc = -EAGAIN);
 
+	bytes = (last_chunk - end_chunk) * chunksize;
 	ext->oe_end = end_index;
-	ext->oe_grants += chunksize;
-	LASSERT(*grants >= chunksize);
-	*grants -= chunksize;
+	ext->oe_grants += bytes;
+	LASSERT(*grants >= bytes);
+	*grants -= bytes;
 	EASSERTF(osc_extent_is_overlapped(obj, ext) == 0, ext,
 		 "overlapped after expanding for %lu.\n", index);
 	EXIT;
@@ -1263,7 +1277,8 @@ static int osc_refresh_count(const struct lu_env *env,
 			     struct osc_async_page *oap, int cmd)
 {
 	struct osc_page  *opg = oap2osc_page(oap);
-	pgoff_t index = osc_index(oap2osc(oap));
+	loff_t offset = oap->oap_obj_off;
+	int size = osc_page_nr(opg) << PAGE_SHIFT;
 	struct cl_object *obj = osc2cl(osc_page_object(opg));
 	struct cl_attr   *attr = &osc_env_info(env)->oti_attr;
 	int result;
@@ -1279,14 +1294,14 @@ static int osc_refresh_count(const struct lu_env *env,
 	if (result < 0)
 		return result;
 	kms = attr->cat_kms;
-	if (index << PAGE_SHIFT >= kms)
+	if (offset >= kms)
 		/* catch race with truncate */
 		return 0;
-	else if ((index + 1) << PAGE_SHIFT > kms)
+	else if (offset + size > kms)
 		/* catch sub-page write at end of file */
-		return kms & ~PAGE_MASK;
+		return kms - offset;
 	else
-		return PAGE_SIZE;
+		return size;
 }
 
 static int osc_completion(const struct lu_env *env, struct osc_async_page *oap,
@@ -1356,20 +1371,20 @@ static int osc_completion(const struct lu_env *env, struct osc_async_page *oap,
 
 /* caller must hold loi_list_lock */
 static void osc_consume_write_grant(struct client_obd *cli,
-				    struct brw_page *pga)
+				    struct brw_page *pga, unsigned int nr)
 {
 	assert_spin_locked(&cli->cl_loi_list_lock);
 	LASSERT(!(pga->bp_flag & OBD_BRW_FROM_GRANT));
-	cli->cl_dirty_pages++;
+	cli->cl_dirty_pages += nr;
 	pga->bp_flag |= OBD_BRW_FROM_GRANT;
 	CDEBUG(D_CACHE, "using %lu grant credits for brw %p page %p\n",
-	       PAGE_SIZE, pga, pga->bp_page);
+	       nr * PAGE_SIZE, pga, pga->bp_page);
 }
 
 /* the companion to osc_consume_write_grant, called when a brw has completed.
  * must be called with the loi lock held. */
 static void osc_release_write_grant(struct client_obd *cli,
-				    struct brw_page *pga)
+				    struct brw_page *pga, unsigned int nr)
 {
 	ENTRY;
 
@@ -1380,8 +1395,8 @@ static void osc_release_write_grant(struct client_obd *cli,
 	}
 
 	pga->bp_flag &= ~OBD_BRW_FROM_GRANT;
-	atomic_long_dec(&obd_dirty_pages);
-	cli->cl_dirty_pages--;
+	atomic_long_sub(nr, &obd_dirty_pages);
+	cli->cl_dirty_pages -= nr;
 	EXIT;
 }
 
@@ -1484,7 +1499,8 @@ static void osc_free_grant(struct client_obd *cli, unsigned int nr_pages,
 static void osc_exit_cache(struct client_obd *cli, struct osc_async_page *oap)
 {
 	spin_lock(&cli->cl_loi_list_lock);
-	osc_release_write_grant(cli, &oap->oap_brw_page);
+	osc_release_write_grant(cli, &oap->oap_brw_page,
+				osc_page_nr(oap2osc(oap)));
 	spin_unlock(&cli->cl_loi_list_lock);
 }
 
@@ -1496,6 +1512,7 @@ static int osc_enter_cache_try(struct client_obd *cli,
 			       struct osc_async_page *oap,
 			       int bytes)
 {
+	unsigned int nr = osc_page_nr(oap2osc(oap));
 	int rc;
 
 	OSC_DUMP_GRANT(D_CACHE, cli, "need:%d\n", bytes);
@@ -1504,14 +1521,14 @@ static int osc_enter_cache_try(struct client_obd *cli,
 	if (rc < 0)
 		return 0;
 
-	if (cli->cl_dirty_pages < cli->cl_dirty_max_pages) {
-		if (atomic_long_add_return(1, &obd_dirty_pages) <=
+	if (cli->cl_dirty_pages + nr <= cli->cl_dirty_max_pages) {
+		if (atomic_long_add_return(nr, &obd_dirty_pages) <=
 		    obd_max_dirty_pages) {
-			osc_consume_write_grant(cli, &oap->oap_brw_page);
+			osc_consume_write_grant(cli, &oap->oap_brw_page, nr);
 			rc = 1;
 			goto out;
 		} else
-			atomic_long_dec(&obd_dirty_pages);
+			atomic_long_sub(nr, &obd_dirty_pages);
 	}
 	__osc_unreserve_grant(cli, bytes, bytes);
 
@@ -1519,6 +1536,138 @@ out:
 	return rc;
 }
 
+static void osc_stage_account(struct client_obd *cli, ktime_t start)
+__must_hold(&cli->cl_loi_list_lock)
+{
+	struct cl_stage_stats *css = &cli->cl_stage_stats;
+	u64 hold = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	css->css_locked++;
+	css->css_hold_ns += hold;
+	if (hold > css->css_hold_max_ns)
+		css->css_hold_max_ns = hold;
+}
+
+/**
+ * Give back the dirty page credits and grant staged by the writer \a oio.
+ *
+ * The grant staged for extents that grew became dirty grant, the rest is
+ * available again.
+ */
+void osc_io_stage_flush(struct osc_io *oio, enum cl_stage_flush reason)
+{
+	struct osc_io_stage *stage = &oio->oi_stage;
+	struct client_obd *cli = stage->ois_cli;
+	struct cl_stage_stats *css;
+	ktime_t start;
+
+	if (!cli)
+		return;
+
+	if (!stage->ois_pages && !stage->ois_grant && !stage->ois_grant_used) {
+		stage->ois_cli = NULL;
+		return;
+	}
+
+	spin_lock(&cli->cl_loi_list_lock);
+	start = ktime_get();
+	cli->cl_dirty_pages -= stage->ois_pages;
+	atomic_long_sub(stage->ois_pages, &obd_dirty_pages);
+	__osc_unreserve_grant(cli, stage->ois_grant + stage->ois_grant_used,
+			      stage->ois_grant);
+	if (stage->ois_pages || stage->ois_grant)
+		osc_wake_cache_waiters(cli);
+
+	css = &cli->cl_stage_stats;
+	css->css_flushes[reason]++;
+	css->css_flush_pages += stage->ois_pages;
+	css->css_flush_grant += stage->ois_grant;
+	osc_stage_account(cli, start);
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	memset(stage, 0, sizeof(*stage));
+}
+EXPORT_SYMBOL(osc_io_stage_flush);
+
+/**
+ * Make sure the writer \a oio has staged \a npages dirty page credits and
+ * \a grant bytes of grant for the active extent.
+ *
+ * Writers appending to their active extent used to take cl_loi_list_lock
+ * for every page to account it as dirty and, at chunk boundaries, to
+ * reserve grant for the extent to grow.  Instead each writer takes up to
+ * cl_stage_pages of dirty pages and as many chunks of grant at once, and
+ * uses them without the lock until osc_io_stage_flush().
+ *
+ * \retval true if the page can be added from the staging
+ * \retval false if the dirty or grant limit is reached
+ */
+static bool osc_io_stage_fill(struct client_obd *cli, struct osc_io *oio,
+			      unsigned int npages, unsigned int grant)
+{
+	struct osc_io_stage *stage = &oio->oi_stage;
+	unsigned int batch = max(READ_ONCE(cli->cl_stage_pages), 1U);
+	unsigned int chunk = 1 << cli->cl_chunkbits;
+	struct cl_stage_stats *css;
+	unsigned int pages = 0;
+	unsigned int bytes = 0;
+	ktime_t start;
+	long over;
+	bool ok;
+
+	if (stage->ois_cli == cli && stage->ois_pages >= npages &&
+	    stage->ois_grant >= grant)
+		return true;
+
+	if (stage->ois_cli != cli)
+		osc_io_stage_flush(oio, CL_STAGE_FLUSH_EXTENT);
+
+	spin_lock(&cli->cl_loi_list_lock);
+	start = ktime_get();
+	stage->ois_cli = cli;
+
+	if (stage->ois_pages < npages &&
+	    cli->cl_dirty_pages < cli->cl_dirty_max_pages) {
+		pages = min_t(unsigned long, max(batch, npages),
+			      cli->cl_dirty_max_pages - cli->cl_dirty_pages);
+		over = atomic_long_add_return(pages, &obd_dirty_pages) -
+		       (long)obd_max_dirty_pages;
+		if (over > 0) {
+			over = min_t(long, over, pages);
+			atomic_long_sub(over, &obd_dirty_pages);
+			pages -= over;
+		}
+		cli->cl_dirty_pages += pages;
+		stage->ois_pages += pages;
+	}
+
+	if (stage->ois_grant < grant) {
+		bytes = max(batch >> (cli->cl_chunkbits - PAGE_SHIFT), 1U);
+		bytes = min_t(unsigned long, bytes * chunk,
+			      round_down(cli->cl_avail_grant, chunk));
+		if (bytes < grant - stage->ois_grant ||
+		    osc_reserve_grant(cli, bytes) < 0)
+			bytes = 0;
+		stage->ois_grant += bytes;
+	}
+	ok = stage->ois_pages >= npages && stage->ois_grant >= grant;
+
+	css = &cli->cl_stage_stats;
+	if (pages || bytes) {
+		css->css_fills++;
+		css->css_fill_pages += pages;
+		css->css_fill_grant += bytes;
+		if (pages)
+			lprocfs_oh_tally_log2(&css->css_batch_hist, pages);
+	}
+	osc_stage_account(cli, start);
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	OSC_DUMP_GRANT(D_CACHE, cli, "staged %u pages %u grant: %s",
+		       pages, bytes, ok ? "ok" : "short");
+	return ok;
+}
+
 /* Following two inlines exist to pass code fragments
  * to wait_event_idle_exclusive_timeout_cmd().  Passing
  * code fragments as macro args can look confusing, so
@@ -1627,7 +1776,7 @@ out:
 static int osc_max_rpc_in_flight(struct client_obd *cli, struct osc_object *osc)
 {
 	int hprpc = !!list_empty(&osc->oo_hp_exts);
-	return rpcs_in_flight(cli) >= cli->cl_max_rpcs_in_flight + hprpc;
+	return rpcs_in_flight(cli) >= osc_rpc_tune_rpcs(cli) + hprpc;
 }
 
 /* This maintains the lists of pending pages to read/write for a given object
@@ -1814,8 +1963,45 @@ struct extent_rpc_data {
 	unsigned int		erd_max_pages;
 	unsigned int		erd_max_chunks;
 	unsigned int		erd_max_extents;
+	/* extents of other objects join a multi-object write */
+	bool			erd_shared;
 };
 
+/*
+ * A multi-object write carries one ioobj and one ost_body per object, they
+ * must fit in OST_IO_MAXREQSIZE along with the niobufs of its pages.
+ */
+#define OSC_BRW_OBJS_PAGES	(DT_MAX_BRW_PAGES - PTLRPC_MAX_BRW_OBJS *     \
+				 (sizeof(struct obd_ioobj) +		      \
+				  sizeof(struct ost_body) +		      \
+				  2 * sizeof(__u32)) /			      \
+				 sizeof(struct niobuf_remote))
+
+/*
+ * Whether @ext can be sent in a multi-object write: the extra objects carry
+ * plain cached pages only, see osc_brw_prep_request().
+ */
+static bool osc_extent_shareable(const struct osc_extent *ext)
+{
+	struct osc_async_page *oap;
+	struct inode *inode;
+
+	if (ext->oe_hp || ext->oe_srvlock || ext->oe_dio || ext->oe_sync ||
+	    ext->oe_no_merge || ext->oe_is_rdma_only)
+		return false;
+
+	if (osc_compr_chunk_pages(ext->oe_obj))
+		return false;
+
+	oap = list_first_entry_or_null(&ext->oe_pages, struct osc_async_page,
+				       oap_pending_item);
+	if (oap == NULL)
+		return false;
+	inode = oap2cl_page(oap)->cp_inode;
+
+	return !(inode && IS_ENCRYPTED(inode));
+}
+
 static inline unsigned osc_extent_chunks(const struct osc_extent *ext)
 {
 	struct client_obd *cli = osc_cli(ext->oe_obj);
@@ -1890,6 +2076,11 @@ static int try_to_add_extent_for_io(struct client_obd *cli,
 	if (data->erd_page_count + ext->oe_nr_pages > data->erd_max_pages)
 		RETURN(0);
 
+	if (data->erd_shared &&
+	    (data->erd_page_count + ext->oe_nr_pages > OSC_BRW_OBJS_PAGES ||
+	     !osc_extent_shareable(ext)))
+		RETURN(0);
+
 	list_for_each_entry(tmp, data->erd_rpc_list, oe_link) {
 		EASSERT(tmp->oe_owner == current, tmp);
 
@@ -1917,39 +2108,36 @@ static int try_to_add_extent_for_io(struct client_obd *cli,
  * 4. If urgent list is not empty, goto 2;
  * 5. Traverse the extent tree from the 1st extent;
  * 6. Above steps exit if there is no space in this RPC.
+ *
+ * The RPC described by @data may already hold extents of other objects.
+ * Return the number of pages of @obj added to it.
  */
 static unsigned int get_write_extents(struct osc_object *obj,
-				      struct list_head *rpclist)
+				      struct extent_rpc_data *data)
 {
 	struct client_obd *cli = osc_cli(obj);
 	struct osc_extent *ext;
-	struct extent_rpc_data data = {
-		.erd_rpc_list	= rpclist,
-		.erd_page_count	= 0,
-		.erd_max_pages	= cli->cl_max_pages_per_rpc,
-		.erd_max_chunks	= osc_max_write_chunks(cli),
-		.erd_max_extents = 256,
-	};
+	unsigned int count = data->erd_page_count;
 
 	assert_osc_object_is_locked(obj);
 	while ((ext = list_first_entry_or_null(&obj->oo_hp_exts,
 					       struct osc_extent,
 					       oe_link)) != NULL) {
-		if (!try_to_add_extent_for_io(cli, ext, &data))
-			return data.erd_page_count;
-		EASSERT(ext->oe_nr_pages <= data.erd_max_pages, ext);
+		if (!try_to_add_extent_for_io(cli, ext, data))
+			return data->erd_page_count - count;
+		EASSERT(ext->oe_nr_pages <= data->erd_max_pages, ext);
 	}
-	if (data.erd_page_count == data.erd_max_pages)
-		return data.erd_page_count;
+	if (data->erd_page_count == data->erd_max_pages)
+		return data->erd_page_count - count;
 
 	while ((ext = list_first_entry_or_null(&obj->oo_urgent_exts,
 					       struct osc_extent,
 					       oe_link)) != NULL) {
-		if (!try_to_add_extent_for_io(cli, ext, &data))
-			return data.erd_page_count;
+		if (!try_to_add_extent_for_io(cli, ext, data))
+			return data->erd_page_count - count;
 	}
-	if (data.erd_page_count == data.erd_max_pages)
-		return data.erd_page_count;
+	if (data->erd_page_count == data->erd_max_pages)
+		return data->erd_page_count - count;
 
 	/* One key difference between full extents and other extents: full
 	 * extents can usually only be added if the rpclist was empty, so if we
@@ -1960,11 +2148,11 @@ static unsigned int get_write_extents(struct osc_object *obj,
 	while ((ext = list_first_entry_or_null(&obj->oo_full_exts,
 					       struct osc_extent,
 					       oe_link)) != NULL) {
-		if (!try_to_add_extent_for_io(cli, ext, &data))
+		if (!try_to_add_extent_for_io(cli, ext, data))
 			break;
 	}
-	if (data.erd_page_count == data.erd_max_pages)
-		return data.erd_page_count;
+	if (data->erd_page_count == data->erd_max_pages)
+		return data->erd_page_count - count;
 
 	for (ext = first_extent(obj);
 	     ext;
@@ -1974,10 +2162,41 @@ static unsigned int get_write_extents(struct osc_object *obj,
 		    (!list_empty(&ext->oe_link) && ext->oe_owner))
 			continue;
 
-		if (!try_to_add_extent_for_io(cli, ext, &data))
-			return data.erd_page_count;
+		if (!try_to_add_extent_for_io(cli, ext, data))
+			return data->erd_page_count - count;
 	}
-	return data.erd_page_count;
+	return data->erd_page_count - count;
+}
+
+/*
+ * Pick up to @max objects other than @osc with few enough pending writes to
+ * fit in @room pages, to send their dirty pages in the write RPC of @osc.
+ * Takes a reference on each object returned in @objs.
+ */
+static int osc_pick_shared_objs(struct client_obd *cli, struct osc_object *osc,
+				unsigned int room, struct osc_object **objs,
+				int max)
+{
+	struct osc_object *tmp;
+	int count = 0;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	list_for_each_entry(tmp, &cli->cl_loi_write_list, oo_write_item) {
+		int nr_writes = atomic_read(&tmp->oo_nr_writes);
+
+		if (count == max)
+			break;
+		if (tmp == osc || nr_writes == 0 || nr_writes > room ||
+		    !list_empty(&tmp->oo_hp_exts))
+			continue;
+
+		cl_object_get(osc2cl(tmp));
+		objs[count++] = tmp;
+		room -= nr_writes;
+	}
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
 }
 
 static int
@@ -1989,14 +2208,24 @@ __must_hold(osc)
 	struct osc_extent *ext;
 	struct osc_extent *tmp;
 	struct osc_extent *first = NULL;
+	struct osc_object *objs[PTLRPC_MAX_BRW_OBJS - 1];
+	struct extent_rpc_data data = {
+		.erd_rpc_list	= &rpclist,
+		.erd_page_count	= 0,
+		.erd_max_pages	= osc_rpc_tune_pages(cli),
+		.erd_max_chunks	= osc_max_write_chunks(cli),
+		.erd_max_extents = 256,
+	};
 	unsigned int page_count = 0;
+	int nr_objs = 0;
 	int srvlock = 0;
 	int rc = 0;
+	int i;
 	ENTRY;
 
 	assert_osc_object_is_locked(osc);
 
-	page_count = get_write_extents(osc, &rpclist);
+	page_count = get_write_extents(osc, &data);
 	LASSERT(equi(page_count == 0, list_empty(&rpclist)));
 
 	if (list_empty(&rpclist))
@@ -2017,6 +2246,53 @@ __must_hold(osc)
 	 * lock order is page lock -> object lock. */
 	osc_object_unlock(osc);
 
+	/* the dirty pages of small objects bound for the same OST fill up
+	 * the rest of the RPC, see OBD_CONNECT2_MULTI_OBJ_BRW
+	 */
+	if (cli->cl_max_objs_per_rpc > 1 &&
+	    imp_connect_multi_obj_brw(cli->cl_import) &&
+	    data.erd_page_count < min_t(unsigned int, data.erd_max_pages,
+					OSC_BRW_OBJS_PAGES)) {
+		data.erd_shared = true;
+		list_for_each_entry(ext, &rpclist, oe_link) {
+			if (!osc_extent_shareable(ext)) {
+				data.erd_shared = false;
+				break;
+			}
+		}
+		if (data.erd_shared)
+			nr_objs = osc_pick_shared_objs(cli, osc,
+				min_t(unsigned int, data.erd_max_pages,
+				      OSC_BRW_OBJS_PAGES) -
+				data.erd_page_count, objs,
+				min_t(int, cli->cl_max_objs_per_rpc,
+				      PTLRPC_MAX_BRW_OBJS) - 1);
+	}
+
+	for (i = 0; i < nr_objs; i++) {
+		struct osc_object *other = objs[i];
+		unsigned int count;
+
+		osc_object_lock(other);
+		if (!list_empty(&other->oo_hp_exts)) {
+			osc_object_unlock(other);
+			continue;
+		}
+		ext = list_last_entry(&rpclist, struct osc_extent, oe_link);
+		count = get_write_extents(other, &data);
+		if (count > 0) {
+			osc_update_pending(other, OBD_BRW_WRITE, -count);
+			list_for_each_entry_continue(ext, &rpclist, oe_link) {
+				if (ext->oe_state == OES_CACHE)
+					osc_extent_state_set(ext, OES_LOCKING);
+				else
+					osc_extent_state_set(ext, OES_RPC);
+			}
+			page_count += count;
+		}
+		osc_object_unlock(other);
+	}
+
 	list_for_each_entry_safe(ext, tmp, &rpclist, oe_link) {
 		if (ext->oe_state == OES_LOCKING) {
 			rc = osc_extent_make_ready(env, ext);
@@ -2040,6 +2316,11 @@ __must_hold(osc)
 		LASSERT(list_empty(&rpclist));
 	}
 
+	for (i = 0; i < nr_objs; i++) {
+		osc_list_maint(cli, objs[i]);
+		cl_object_put(env, osc2cl(objs[i]));
+	}
+
 	osc_object_lock(osc);
 	RETURN(rc);
 }
@@ -2065,18 +2346,28 @@ __must_hold(osc)
 	struct extent_rpc_data data = {
 		.erd_rpc_list	= &rpclist,
 		.erd_page_count	= 0,
-		.erd_max_pages	= cli->cl_max_pages_per_rpc,
+		.erd_max_pages	= osc_rpc_tune_pages(cli),
 		.erd_max_chunks	= UINT_MAX,
 		.erd_max_extents = UINT_MAX,
 	};
+	pgoff_t start = CL_PAGE_EOF;
+	pgoff_t end = 0;
 	int rc = 0;
 	ENTRY;
 
 	assert_osc_object_is_locked(osc);
 	list_for_each_entry_safe(ext, next, &osc->oo_reading_exts, oe_link) {
 		EASSERT(ext->oe_state == OES_LOCK_DONE, ext);
+		/* reads of compressed chunks also fetch the gaps between */
+		if (!list_empty(&rpclist) &&
+		    osc_compr_read_span(osc, min(start, ext->oe_start),
+					max(end, ext->oe_end)) >
+		    PTLRPC_MAX_BRW_PAGES)
+			break;
 		if (!try_to_add_extent_for_io(cli, ext, &data))
 			break;
+		start = min(start, ext->oe_start);
+		end = max(end, ext->oe_end);
 		osc_extent_state_set(ext, OES_RPC);
 		EASSERT(ext->oe_nr_pages <= data.erd_max_pages, ext);
 	}
@@ -2274,11 +2565,13 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 	struct client_obd     *cli = osc_cli(osc);
 	struct pagevec        *pvec = &osc_env_info(env)->oti_pagevec;
 	pgoff_t index;
+	unsigned int nr = osc_page_nr(ops);
 	unsigned int tmp;
 	unsigned int grants = 0;
 	u32    brw_flags = OBD_BRW_ASYNC;
 	int    cmd = OBD_BRW_WRITE;
 	int    need_release = 0;
+	enum cl_stage_flush flush = CL_STAGE_FLUSH_EXTENT;
 	int    rc = 0;
 	ENTRY;
 
@@ -2348,55 +2641,60 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 	 * 2. otherwise, a new extent will be allocated. */
 
 	ext = oio->oi_active;
-	if (ext != NULL && ext->oe_start <= index && ext->oe_max_end >= index) {
-		/* one chunk plus extent overhead must be enough to write this
-		 * page */
-		grants = (1 << cli->cl_chunkbits) + cli->cl_grant_extent_tax;
-		if (ext->oe_end >= index)
-			grants = 0;
-
-		/* it doesn't need any grant to dirty this page */
-		spin_lock(&cli->cl_loi_list_lock);
-		rc = osc_enter_cache_try(cli, oap, grants);
-		if (rc == 0) { /* try failed */
-			grants = 0;
+	if (ext != NULL && ext->oe_start <= index &&
+	    ext->oe_max_end >= index + nr - 1) {
+		/* more chunks are needed to write past the extent end, the
+		 * dirty pages and the grant come from what this writer staged */
+		int ppc_bits = cli->cl_chunkbits - PAGE_SHIFT;
+
+		grants = 0;
+		if (ext->oe_end < index + nr - 1)
+			grants = (((index + nr - 1) >> ppc_bits) -
+				  (ext->oe_end >> ppc_bits)) <<
+				 cli->cl_chunkbits;
+
+		if (!osc_io_stage_fill(cli, oio, nr, grants)) {
+			flush = CL_STAGE_FLUSH_NO_SPACE;
 			need_release = 1;
-		} else if (ext->oe_end < index) {
+		} else if (grants > 0) {
 			tmp = grants;
 			/* try to expand this extent */
-			rc = osc_extent_expand(ext, index, &tmp);
+			rc = osc_extent_expand(ext, index, nr, &tmp);
 			if (rc < 0) {
 				need_release = 1;
-				/* don't free reserved grant */
 			} else {
 				OSC_EXTENT_DUMP(D_CACHE, ext,
 						"expanded for %lu.\n", index);
-				osc_unreserve_grant_nolock(cli, grants, tmp);
-				grants = 0;
+				oio->oi_stage.ois_grant -= grants - tmp;
+				oio->oi_stage.ois_grant_used += grants - tmp;
 			}
 		}
-		spin_unlock(&cli->cl_loi_list_lock);
+		if (!need_release) {
+			oio->oi_stage.ois_pages -= nr;
+			oap->oap_brw_flags |= OBD_BRW_FROM_GRANT;
+		}
+		grants = 0;
 		rc = 0;
 	} else if (ext != NULL) {
 		/* index is located outside of active extent */
 		need_release = 1;
 	}
 	if (need_release) {
+		/* osc_enter_cache() may wait for what this writer staged */
+		osc_io_stage_flush(oio, flush);
 		osc_extent_release(env, ext);
 		oio->oi_active = NULL;
 		ext = NULL;
 	}
 
 	if (ext == NULL) {
-		tmp = (1 << cli->cl_chunkbits) + cli->cl_grant_extent_tax;
+		int ppc_bits = cli->cl_chunkbits - PAGE_SHIFT;
+
+		tmp = ((((index + nr - 1) >> ppc_bits) - (index >> ppc_bits) +
+			1) << cli->cl_chunkbits) + cli->cl_grant_extent_tax;
 
 		/* try to find new extent to cover this page */
 		LASSERT(oio->oi_active == NULL);
-		/* we may have allocated grant for this page if we failed
-		 * to expand the previous active extent. */
-		LASSERT(ergo(grants > 0, grants >= tmp));
-
-		rc = 0;
 
 		/* We must not hold a page lock while we do osc_enter_cache()
 		 * or osc_extent_find(), so we must mark dirty & unlock
@@ -2406,15 +2704,13 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 			pagevec_reinit(pvec);
 		}
 
-		if (grants == 0) {
-			rc = osc_enter_cache(env, cli, oap, tmp);
-			if (rc == 0)
-				grants = tmp;
-		}
+		rc = osc_enter_cache(env, cli, oap, tmp);
+		if (rc == 0)
+			grants = tmp;
 
 		tmp = grants;
 		if (rc == 0) {
-			ext = osc_extent_find(env, osc, index, &tmp);
+			ext = osc_extent_find(env, osc, index, nr, &tmp);
 			if (IS_ERR(ext)) {
 				LASSERT(tmp == grants);
 				osc_exit_cache(cli, oap);
@@ -2430,8 +2726,9 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 
 	LASSERT(ergo(rc == 0, ext != NULL));
 	if (ext != NULL) {
-		EASSERTF(ext->oe_end >= index && ext->oe_start <= index,
-			 ext, "index = %lu.\n", index);
+		EASSERTF(ext->oe_end >= index + nr - 1 &&
+			 ext->oe_start <= index,
+			 ext, "index = %lu/%u.\n", index, nr);
 		LASSERT((oap->oap_brw_flags & OBD_BRW_FROM_GRANT) != 0);
 
 		osc_object_lock(osc);
@@ -2439,7 +2736,7 @@ int osc_queue_async_io(const struct lu_env *env, struct cl_io *io,
 			ext->oe_srvlock = ops->ops_srvlock;
 		else
 			LASSERT(ext->oe_srvlock == ops->ops_srvlock);
-		++ext->oe_nr_pages;
+		ext->oe_nr_pages += nr;
 		list_add_tail(&oap->oap_pending_item, &ext->oe_pages);
 		osc_object_unlock(osc);
 
@@ -2572,7 +2869,7 @@ int osc_queue_sync_pages(const struct lu_env *env, struct cl_io *io,
 	struct osc_extent     *ext;
 	struct osc_async_page *oap;
 	int     page_count = 0;
-	int     mppr       = cli->cl_max_pages_per_rpc;
+	int     mppr       = osc_rpc_tune_pages(cli);
 	bool	can_merge   = true;
 	pgoff_t start      = CL_PAGE_EOF;
 	pgoff_t end        = 0;
@@ -2582,16 +2879,18 @@ int osc_queue_sync_pages(const struct lu_env *env, struct cl_io *io,
 	list_for_each_entry(oap, list, oap_pending_item) {
 		struct osc_page *opg = oap2osc_page(oap);
 		pgoff_t index = osc_index(opg);
+		unsigned int nr = osc_page_nr(opg);
 
-		if (index > end)
-			end = index;
+		if (index + nr - 1 > end)
+			end = index + nr - 1;
 		if (index < start)
 			start = index;
-		++page_count;
-		mppr <<= (page_count > mppr);
+		page_count += nr;
+		while (page_count > mppr)
+			mppr <<= 1;
 
 		if (unlikely(opg->ops_from > 0 ||
-			     opg->ops_to < PAGE_SIZE - 1))
+			     opg->ops_to < (nr << PAGE_SHIFT) - 1))
 			can_merge = false;
 	}
 
@@ -2635,7 +2934,8 @@ int osc_queue_sync_pages(const struct lu_env *env, struct cl_io *io,
 		if (osc_reserve_grant(cli, grants) == 0) {
 			list_for_each_entry(oap, list, oap_pending_item) {
 				osc_consume_write_grant(cli,
-							&oap->oap_brw_page);
+					&oap->oap_brw_page,
+					osc_page_nr(oap2osc_page(oap)));
 			}
 			atomic_long_add(page_count, &obd_dirty_pages);
 			osc_unreserve_grant_nolock(cli, grants, 0);
@@ -3039,7 +3339,8 @@ int osc_cache_writeback_range(const struct lu_env *env, struct osc_object *obj,
 EXPORT_SYMBOL(osc_cache_writeback_range);
 
 /**
- * Returns a list of pages by a given [start, end] of \a obj.
+ * Returns a list of pages by a given [start, end] of \a obj, including a
+ * large page which only overlaps the start of the range.
  *
  * Gang tree lookup (radix_tree_gang_lookup()) optimization is absolutely
  * crucial in the face of [offset, EOF] locks.
@@ -3061,7 +3362,8 @@ bool osc_page_gang_lookup(const struct lu_env *env, struct cl_io *io,
 	bool            tree_lock = true;
 	ENTRY;
 
-	idx = start;
+	/* a large page is indexed by its first page only */
+	idx = round_down(start, CL_PAGE_MAX_NR);
 	pvec = osc_env_info(env)->oti_pvec;
 	pagevec = &osc_env_info(env)->oti_pagevec;
 	ll_pagevec_init(pagevec, 0);
@@ -3080,6 +3382,8 @@ bool osc_page_gang_lookup(const struct lu_env *env, struct cl_io *io,
 				end_of_region = true;
 				break;
 			}
+			if (idx + osc_page_nr(ops) <= start)
+				continue;
 
 			page = ops->ops_cl.cpl_page;
 			LASSERT(page->cp_type == CPT_CACHEABLE);
@@ -3157,12 +3461,13 @@ static bool check_and_discard_cb(const struct lu_env *env, struct cl_io *io,
 		struct osc_page *ops = pvec[i];
 		struct cl_page *page = ops->ops_cl.cpl_page;
 		pgoff_t index = osc_index(ops);
+		pgoff_t last = index + cl_page_nr(page) - 1;
 		bool discard = false;
 
 		/* negative lock caching */
 		if (index < info->oti_ng_index) {
 			discard = true;
-		} else if (index >= info->oti_fn_index) {
+		} else if (last >= info->oti_fn_index) {
 			struct ldlm_lock *tmp;
 			/* refresh non-overlapped index */
 			tmp = osc_dlmlock_at_pgoff(env, osc, index,
@@ -3196,6 +3501,10 @@ static bool check_and_discard_cb(const struct lu_env *env, struct cl_io *io,
 					if (end == OBD_OBJECT_EOF)
 						info->oti_fn_index =
 							CL_PAGE_EOF;
+					/* a large page must be covered by
+					 * one lock as a whole */
+					if (last >= info->oti_fn_index)
+						discard = true;
 				}
 				LDLM_LOCK_PUT(tmp);
 			} else {
@@ -3213,7 +3522,7 @@ static bool check_and_discard_cb(const struct lu_env *env, struct cl_io *io,
 			}
 		}
 
-		info->oti_next_index = index + 1;
+		info->oti_next_index = last + 1;
 	}
 	return true;
 }
@@ -3229,7 +3538,7 @@ bool osc_discard_cb(const struct lu_env *env, struct cl_io *io,
 		struct cl_page *page = ops->ops_cl.cpl_page;
 
 		/* page is top page. */
-		info->oti_next_index = osc_index(ops) + 1;
+		info->oti_next_index = osc_index(ops) + osc_page_nr(ops);
 		if (cl_page_own(env, io, page) == 0) {
 			if (!ergo(page->cp_type == CPT_CACHEABLE,
 				  !PageDirty(cl_page_vmpage(page))))
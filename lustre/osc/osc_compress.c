@@ -0,0 +1,466 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/osc/osc_compress.c
+ *
+ * Chunked compression of bulk RPCs for components with LCME_FL_COMPRESS.
+ *
+ * On write, every chunk fully covered by the RPC is compressed into bounce
+ * pages and sent with OBD_BRW_COMPRESSED; the pages after the compressed
+ * data are not written.  Partial chunks are always sent raw, the OST first
+ * stores a compressed chunk they cut through uncompressed, see
+ * ofd_compr_unpack().
+ *
+ * On read, the RPC is widened to whole chunks so that the header and all of
+ * the compressed data are fetched, then each chunk is decompressed in place
+ * and the parts the caller did not ask for are dropped.
+ *
+ * Writes to components with LCME_FL_SPARSE use the same view of the wire
+ * pages to flag all-zero pages with OBD_BRW_ZERO, the OST then writes them
+ * without fetching their data, or skips them past EOF.
+ */
+
+#define DEBUG_SUBSYSTEM S_OSC
+
+#include <lustre_compr.h>
+#include <lustre_osc.h>
+#include <lustre_sec.h>
+
+#include "osc_internal.h"
+
+void osc_compr_rpc_free(struct osc_compr_rpc *ocr)
+{
+	u32 max_pages;
+
+	if (!ocr)
+		return;
+
+	max_pages = ocr->ocr_max_pages;
+	if (ocr->ocr_nr_bounce)
+		sptlrpc_enc_pool_put_pages_array(ocr->ocr_bounce,
+						 ocr->ocr_nr_bounce);
+	if (ocr->ocr_bounce)
+		OBD_FREE_PTR_ARRAY_LARGE(ocr->ocr_bounce, max_pages);
+	if (ocr->ocr_orig)
+		OBD_FREE_PTR_ARRAY_LARGE(ocr->ocr_orig, max_pages);
+	if (ocr->ocr_brw)
+		OBD_FREE_PTR_ARRAY_LARGE(ocr->ocr_brw, max_pages);
+	if (ocr->ocr_pga)
+		OBD_FREE_PTR_ARRAY_LARGE(ocr->ocr_pga, max_pages);
+	if (ocr->ocr_chunk)
+		OBD_FREE_PTR_ARRAY(ocr->ocr_chunk, ocr->ocr_chunk_pages);
+	OBD_FREE_PTR(ocr);
+}
+
+static struct osc_compr_rpc *osc_compr_rpc_alloc(u32 max_pages,
+						 unsigned int chunk_bits,
+						 unsigned int chunk_pages)
+{
+	struct osc_compr_rpc *ocr;
+
+	OBD_ALLOC_PTR(ocr);
+	if (!ocr)
+		return NULL;
+
+	ocr->ocr_max_pages = max_pages;
+	ocr->ocr_chunk_bits = chunk_bits;
+	ocr->ocr_chunk_pages = chunk_pages;
+	OBD_ALLOC_PTR_ARRAY_LARGE(ocr->ocr_pga, max_pages);
+	OBD_ALLOC_PTR_ARRAY_LARGE(ocr->ocr_brw, max_pages);
+	OBD_ALLOC_PTR_ARRAY_LARGE(ocr->ocr_orig, max_pages);
+	OBD_ALLOC_PTR_ARRAY_LARGE(ocr->ocr_bounce, max_pages);
+	OBD_ALLOC_PTR_ARRAY(ocr->ocr_chunk, chunk_pages);
+	if (!ocr->ocr_pga || !ocr->ocr_brw || !ocr->ocr_orig ||
+	    !ocr->ocr_bounce || !ocr->ocr_chunk) {
+		osc_compr_rpc_free(ocr);
+		return NULL;
+	}
+
+	return ocr;
+}
+
+/* whether pga[0 .. chunk_pages - 1] hold exactly one whole chunk */
+static bool osc_compr_chunk_complete(struct brw_page **pga, u32 count,
+				     unsigned int chunk_pages,
+				     unsigned int chunk_bits)
+{
+	u64 start = pga[0]->bp_off;
+	unsigned int i;
+
+	if (count < chunk_pages ||
+	    start & (COMPR_GET_CHUNK_SIZE(chunk_bits) - 1))
+		return false;
+
+	for (i = 0; i < chunk_pages; i++) {
+		if (pga[i]->bp_off != start + ((u64)i << PAGE_SHIFT) ||
+		    pga[i]->bp_count != PAGE_SIZE ||
+		    pga[i]->bp_flag != pga[0]->bp_flag)
+			return false;
+	}
+
+	return true;
+}
+
+static int osc_compr_write_prep(struct osc_object *osc, struct obdo *oa,
+				struct brw_page **pga, u32 page_count,
+				struct osc_compr_rpc **ocrp)
+{
+	const struct lov_oinfo *loi = osc->oo_oinfo;
+	unsigned int chunk_pages = osc_compr_chunk_pages(osc);
+	unsigned int chunk_bits = loi->loi_compr_chunk_bits;
+	struct osc_compr_rpc *ocr;
+	u32 nr_chunks = 0;
+	u32 compressed = 0;
+	u32 used = 0;
+	u32 wire = 0;
+	u32 i;
+	int rc;
+
+	/* a single page chunk cannot get any smaller */
+	if (chunk_pages < 2 || !ll_compr_type_supported(loi->loi_compr_type))
+		return 0;
+
+	for (i = 0; i < page_count; i++) {
+		if (osc_compr_chunk_complete(pga + i, page_count - i,
+					     chunk_pages, chunk_bits)) {
+			nr_chunks++;
+			i += chunk_pages - 1;
+		}
+	}
+	if (!nr_chunks)
+		return 0;
+
+	ocr = osc_compr_rpc_alloc(page_count, chunk_bits, chunk_pages);
+	if (!ocr)
+		return -ENOMEM;
+
+	/* at most chunk_pages - 1 pages of output for each chunk */
+	ocr->ocr_nr_bounce = nr_chunks * (chunk_pages - 1);
+	rc = sptlrpc_enc_pool_get_pages_array(ocr->ocr_bounce,
+					      ocr->ocr_nr_bounce);
+	if (rc) {
+		CDEBUG(D_SEC, "failed to allocate from enc pool: rc = %d\n",
+		       rc);
+		ocr->ocr_nr_bounce = 0;
+		osc_compr_rpc_free(ocr);
+		/* not fatal, the pages are sent uncompressed */
+		return 0;
+	}
+
+	for (i = 0; i < page_count; i++) {
+		struct brw_page *pg = pga[i];
+		unsigned int dst_pages;
+		unsigned int j;
+
+		if (!osc_compr_chunk_complete(pga + i, page_count - i,
+					      chunk_pages, chunk_bits)) {
+			ocr->ocr_brw[wire] = *pg;
+			ocr->ocr_pga[wire] = &ocr->ocr_brw[wire];
+			wire++;
+			continue;
+		}
+
+		for (j = 0; j < chunk_pages; j++)
+			ocr->ocr_chunk[j] = pga[i + j]->bp_page;
+
+		rc = ll_compress_pages(loi->loi_compr_type,
+				       loi->loi_compr_level, chunk_bits,
+				       ocr->ocr_chunk, ocr->ocr_bounce + used,
+				       &dst_pages);
+		if (rc) {
+			CDEBUG(D_PAGE, "chunk at %llu stored raw: rc = %d\n",
+			       pg->bp_off, rc);
+			for (j = 0; j < chunk_pages; j++, wire++) {
+				ocr->ocr_brw[wire] = *pga[i + j];
+				ocr->ocr_pga[wire] = &ocr->ocr_brw[wire];
+			}
+		} else {
+			for (j = 0; j < dst_pages; j++, wire++) {
+				struct brw_page *cpg = &ocr->ocr_brw[wire];
+
+				cpg->bp_off = pg->bp_off + ((u64)j << PAGE_SHIFT);
+				cpg->bp_page = ocr->ocr_bounce[used + j];
+				cpg->bp_count = PAGE_SIZE;
+				cpg->bp_flag = pg->bp_flag | OBD_BRW_COMPRESSED;
+				ocr->ocr_pga[wire] = cpg;
+			}
+			used += dst_pages;
+			compressed++;
+		}
+		i += chunk_pages - 1;
+	}
+
+	/* give back what the compressor did not need */
+	if (used < ocr->ocr_nr_bounce)
+		sptlrpc_enc_pool_put_pages_array(ocr->ocr_bounce + used,
+						 ocr->ocr_nr_bounce - used);
+	ocr->ocr_nr_bounce = used;
+
+	if (!compressed) {
+		osc_compr_rpc_free(ocr);
+		return 0;
+	}
+
+	/* the OST cannot tell the file size from compressed data */
+	oa->o_size = pga[page_count - 1]->bp_off +
+		     pga[page_count - 1]->bp_count;
+	oa->o_valid |= OBD_MD_FLSIZE;
+
+	CDEBUG(D_PAGE, "compressed %u/%u chunks, %u pages instead of %u\n",
+	       compressed, nr_chunks, wire, page_count);
+	ocr->ocr_page_count = wire;
+	*ocrp = ocr;
+
+	return 0;
+}
+
+static int osc_compr_read_prep(struct client_obd *cli, struct osc_object *osc,
+			       struct brw_page **pga, u32 page_count,
+			       struct osc_compr_rpc **ocrp)
+{
+	unsigned int chunk_pages = osc_compr_chunk_pages(osc);
+	unsigned int chunk_bits = osc->oo_oinfo->loi_compr_chunk_bits;
+	u64 chunk_size = COMPR_GET_CHUNK_SIZE(chunk_bits);
+	u64 start = round_down(pga[0]->bp_off, chunk_size);
+	u64 end = round_up(pga[page_count - 1]->bp_off +
+			   pga[page_count - 1]->bp_count, chunk_size);
+	struct osc_compr_rpc *ocr;
+	u32 wire_count = (end - start) >> PAGE_SHIFT;
+	u32 nr_bounce = 0;
+	u32 i, j;
+	int rc;
+
+	/* kept in bounds by osc_compr_read_span() when building the RPC */
+	if (wire_count > PTLRPC_MAX_BRW_PAGES) {
+		CERROR("%s: read of %u pages at %llu exceeds bulk limit: rc = %d\n",
+		       cli_name(cli), wire_count, start, -EFBIG);
+		return -EFBIG;
+	}
+
+	ocr = osc_compr_rpc_alloc(wire_count, chunk_bits, chunk_pages);
+	if (!ocr)
+		return -ENOMEM;
+	ocr->ocr_page_count = wire_count;
+
+	for (i = 0, j = 0; i < wire_count; i++) {
+		u64 off = start + ((u64)i << PAGE_SHIFT);
+		struct brw_page *wpg = &ocr->ocr_brw[i];
+
+		ocr->ocr_pga[i] = wpg;
+		wpg->bp_off = off;
+		wpg->bp_count = PAGE_SIZE;
+		wpg->bp_flag = pga[0]->bp_flag;
+		if (j < page_count && (pga[j]->bp_off & PAGE_MASK) == off) {
+			if (pga[j]->bp_off == off &&
+			    pga[j]->bp_count == PAGE_SIZE)
+				wpg->bp_page = pga[j]->bp_page;
+			else
+				ocr->ocr_orig[i] = pga[j];
+			j++;
+		}
+		if (!wpg->bp_page)
+			nr_bounce++;
+	}
+	LASSERT(j == page_count);
+
+	if (nr_bounce) {
+		rc = sptlrpc_enc_pool_get_pages_array(ocr->ocr_bounce,
+						      nr_bounce);
+		if (rc) {
+			CDEBUG(D_SEC, "failed to allocate from enc pool: rc = %d\n",
+			       rc);
+			osc_compr_rpc_free(ocr);
+			return rc;
+		}
+		ocr->ocr_nr_bounce = nr_bounce;
+		for (i = 0, j = 0; i < wire_count; i++)
+			if (!ocr->ocr_brw[i].bp_page)
+				ocr->ocr_brw[i].bp_page = ocr->ocr_bounce[j++];
+	}
+
+	*ocrp = ocr;
+
+	return 0;
+}
+
+/**
+ * Build the pages to send for a BRW RPC on a compressed component.
+ *
+ * \param[out] ocrp	left NULL if \a pga can be sent as is
+ *
+ * \retval 0		success
+ * \retval negative	the RPC cannot be sent
+ */
+int osc_compr_rpc_prep(struct client_obd *cli, int opc, struct obdo *oa,
+		       struct brw_page **pga, u32 page_count,
+		       struct osc_compr_rpc **ocrp)
+{
+	struct osc_async_page *oap;
+	struct cl_page *clpage;
+	struct osc_object *osc;
+	struct inode *inode;
+
+	*ocrp = NULL;
+	if (!pga[0]->bp_page || !imp_connect_compress(cli->cl_import))
+		return 0;
+
+	oap = brw_page2oap(pga[0]);
+	if (oap->oap_brw_flags & OBD_BRW_RDMA_ONLY)
+		return 0;
+
+	clpage = oap2cl_page(oap);
+	inode = clpage->cp_inode;
+	/* encrypted data does not compress */
+	if (!inode || IS_ENCRYPTED(inode))
+		return 0;
+
+	osc = oap->oap_obj;
+	if (!osc_compr_chunk_pages(osc))
+		return 0;
+
+	if (opc == OST_WRITE)
+		return osc_compr_write_prep(osc, oa, pga, page_count, ocrp);
+
+	return osc_compr_read_prep(cli, osc, pga, page_count, ocrp);
+}
+
+/**
+ * Decompress the chunks of a whole-chunk read and copy the partially
+ * requested pages back to the caller.  Pages past a short read are zeroed
+ * by then, so chunks beyond EOF are seen as raw.
+ */
+int osc_compr_rpc_fini(struct osc_compr_rpc *ocr)
+{
+	unsigned int chunk_pages = ocr->ocr_chunk_pages;
+	u32 i, j;
+	int rc;
+
+	for (i = 0; i < ocr->ocr_page_count; i += chunk_pages) {
+		for (j = 0; j < chunk_pages; j++)
+			ocr->ocr_chunk[j] = ocr->ocr_pga[i + j]->bp_page;
+
+		rc = ll_decompress_pages(ocr->ocr_chunk, ocr->ocr_chunk_bits);
+		if (rc) {
+			CERROR("cannot decompress chunk at %llu: rc = %d\n",
+			       ocr->ocr_pga[i]->bp_off, rc);
+			return rc;
+		}
+	}
+
+	for (i = 0; i < ocr->ocr_page_count; i++) {
+		struct brw_page *pg = ocr->ocr_orig[i];
+		unsigned int poff;
+		char *src;
+		char *dst;
+
+		if (!pg)
+			continue;
+
+		poff = pg->bp_off & ~PAGE_MASK;
+		src = kmap_atomic(ocr->ocr_pga[i]->bp_page);
+		dst = kmap_atomic(pg->bp_page);
+		memcpy(dst + poff, src + poff, pg->bp_count);
+		kunmap_atomic(dst);
+		kunmap_atomic(src);
+	}
+
+	return 0;
+}
+
+static bool osc_zero_page(struct brw_page *pg)
+{
+	bool zero;
+	void *addr;
+
+	if (pg->bp_off & ~PAGE_MASK || pg->bp_count != PAGE_SIZE)
+		return false;
+
+	addr = kmap_atomic(pg->bp_page);
+	zero = !memchr_inv(addr, 0, PAGE_SIZE);
+	kunmap_atomic(addr);
+
+	return zero;
+}
+
+/**
+ * Flag the whole zero pages of a write to a LCME_FL_SPARSE component, so
+ * that they are not part of the bulk.  The last page is always sent, the
+ * OST relies on it to extend the object size.
+ *
+ * \param[out] ocrp	left NULL if no page is elided
+ *
+ * \retval 0		success
+ * \retval negative	the RPC cannot be sent
+ */
+int osc_zero_rpc_prep(struct client_obd *cli, int opc,
+		      struct brw_page **pga, u32 page_count,
+		      struct osc_compr_rpc **ocrp)
+{
+	struct osc_async_page *oap;
+	struct osc_compr_rpc *ocr;
+	struct inode *inode;
+	u64 bytes = 0;
+	u32 nr_zero = 0;
+	u32 first;
+	u32 i;
+
+	*ocrp = NULL;
+	if (opc != OST_WRITE || page_count < 2 || !cli->cl_zero_write ||
+	    !pga[0]->bp_page || !imp_connect_zero_write(cli->cl_import))
+		return 0;
+
+	oap = brw_page2oap(pga[0]);
+	if (oap->oap_brw_flags & OBD_BRW_RDMA_ONLY ||
+	    !oap->oap_obj->oo_oinfo->loi_sparse)
+		return 0;
+
+	inode = oap2cl_page(oap)->cp_inode;
+	if (!inode || IS_ENCRYPTED(inode))
+		return 0;
+
+	/* short io carries the data inline, there is no bulk to shrink */
+	for (i = 0; i < page_count; i++)
+		bytes += pga[i]->bp_count;
+	if (bytes <= cli->cl_max_short_io_bytes &&
+	    imp_connect_shortio(cli->cl_import))
+		return 0;
+
+	for (first = 0; first < page_count - 1; first++) {
+		if (osc_zero_page(pga[first]))
+			break;
+	}
+	if (first == page_count - 1)
+		return 0;
+
+	OBD_ALLOC_PTR(ocr);
+	if (!ocr)
+		return -ENOMEM;
+
+	ocr->ocr_max_pages = page_count;
+	OBD_ALLOC_PTR_ARRAY_LARGE(ocr->ocr_pga, page_count);
+	OBD_ALLOC_PTR_ARRAY_LARGE(ocr->ocr_brw, page_count);
+	if (!ocr->ocr_pga || !ocr->ocr_brw) {
+		osc_compr_rpc_free(ocr);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < page_count; i++) {
+		ocr->ocr_brw[i] = *pga[i];
+		ocr->ocr_pga[i] = &ocr->ocr_brw[i];
+		if (i < first || i == page_count - 1 ||
+		    (i > first && !osc_zero_page(pga[i])))
+			continue;
+
+		ocr->ocr_brw[i].bp_flag |= OBD_BRW_ZERO;
+		ocr->ocr_zero_bytes += PAGE_SIZE;
+		nr_zero++;
+	}
+
+	CDEBUG(D_PAGE, "elided %u/%u zero pages\n", nr_zero, page_count);
+	ocr->ocr_page_count = page_count;
+	*ocrp = ocr;
+
+	return 0;
+}
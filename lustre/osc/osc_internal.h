@@ -35,6 +35,7 @@
 #define OAP_MAGIC 8675309
 
 #include <libcfs/linux/linux-mem.h>
+#include <lustre_compr.h>
 #include <lustre_osc.h>
 
 extern atomic_t osc_pool_req_count;
@@ -136,6 +137,30 @@ static inline unsigned long rpcs_in_flight(struct client_obd *cli)
 	return cli->cl_r_in_flight + cli->cl_w_in_flight;
 }
 
+/* RPCs in flight allowed, lowered by osc_rpc_tune_update() */
+static inline u32 osc_rpc_tune_rpcs(struct client_obd *cli)
+{
+	u32 rpcs = cli->cl_max_rpcs_in_flight;
+
+	if (READ_ONCE(cli->cl_rpc_tune.crt_target_us))
+		rpcs = min(rpcs, READ_ONCE(cli->cl_rpc_tune.crt_rpcs));
+
+	return rpcs;
+}
+
+/* pages per RPC, lowered by osc_rpc_tune_update(), chunk aligned */
+static inline u32 osc_rpc_tune_pages(struct client_obd *cli)
+{
+	u32 pages = cli->cl_max_pages_per_rpc;
+
+	if (READ_ONCE(cli->cl_rpc_tune.crt_target_us))
+		pages = min(pages, READ_ONCE(cli->cl_rpc_tune.crt_pages));
+
+	return pages;
+}
+
+void osc_rpc_tune_enable(struct client_obd *cli, u32 target_us);
+
 static inline char *cli_name(struct client_obd *cli)
 {
 	return cli->cl_import->imp_obd->obd_name;
@@ -208,6 +233,64 @@ static inline unsigned int osc_max_write_chunks(const struct client_obd *cli)
 	return PTLRPC_MAX_BRW_SIZE >> cli->cl_chunkbits;
 }
 
+/* osc_compress.c */
+struct osc_compr_rpc {
+	/* pages actually sent to or received from the OST */
+	struct brw_page		**ocr_pga;
+	u32			  ocr_page_count;
+	/* size of the arrays below */
+	u32			  ocr_max_pages;
+	u32			  ocr_chunk_bits;
+	u32			  ocr_chunk_pages;
+	/* backing store for the ocr_pga entries not taken from the caller */
+	struct brw_page		 *ocr_brw;
+	/* read: caller page to copy a partially requested page back to */
+	struct brw_page		**ocr_orig;
+	/* bounce pages taken from the enc pool */
+	struct page		**ocr_bounce;
+	u32			  ocr_nr_bounce;
+	/* pages of one chunk passed to the compression helpers */
+	struct page		**ocr_chunk;
+	/* write: bytes of the OBD_BRW_ZERO pages left out of the bulk */
+	u64			  ocr_zero_bytes;
+};
+
+static inline unsigned int osc_compr_chunk_pages(const struct osc_object *osc)
+{
+	const struct lov_oinfo *loi = osc->oo_oinfo;
+
+	if (loi->loi_compr_type == LL_COMPR_TYPE_NONE ||
+	    loi->loi_compr_chunk_bits > COMPR_CHUNK_MAX_BITS)
+		return 0;
+
+	return COMPR_GET_CHUNK_SIZE(loi->loi_compr_chunk_bits) >> PAGE_SHIFT;
+}
+
+/*
+ * Pages in the bulk of a read of pages [\a start, \a end] once it is
+ * widened to whole chunks by osc_compr_read_prep(), gaps included. RPCs
+ * are built so that this never goes over PTLRPC_MAX_BRW_PAGES.
+ */
+static inline pgoff_t osc_compr_read_span(const struct osc_object *osc,
+					  pgoff_t start, pgoff_t end)
+{
+	unsigned int chunk_pages = osc_compr_chunk_pages(osc);
+
+	if (!chunk_pages)
+		return end - start + 1;
+
+	return round_up(end + 1, chunk_pages) - round_down(start, chunk_pages);
+}
+
+int osc_compr_rpc_prep(struct client_obd *cli, int opc, struct obdo *oa,
+		       struct brw_page **pga, u32 page_count,
+		       struct osc_compr_rpc **ocrp);
+int osc_compr_rpc_fini(struct osc_compr_rpc *ocr);
+void osc_compr_rpc_free(struct osc_compr_rpc *ocr);
+int osc_zero_rpc_prep(struct client_obd *cli, int opc,
+		      struct brw_page **pga, u32 page_count,
+		      struct osc_compr_rpc **ocrp);
+
 static inline void osc_set_io_portal(struct ptlrpc_request *req)
 {
 	struct obd_import *imp = req->rq_import;
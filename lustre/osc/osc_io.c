@@ -138,6 +138,8 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
 	unsigned int max_pages;
 	unsigned int ppc_bits; /* pages per chunk bits */
 	unsigned int ppc;
+	pgoff_t first = 0;
+	pgoff_t last = 0;
 	bool sync_queue = false;
 
 	LASSERT(qin->pl_nr > 0);
@@ -146,7 +148,7 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
 
 	osc = cl2osc(ios->cis_obj);
 	cli = osc_cli(osc);
-	max_pages = cli->cl_max_pages_per_rpc;
+	max_pages = osc_rpc_tune_pages(cli);
 	ppc_bits = cli->cl_chunkbits - PAGE_SHIFT;
 	ppc = 1 << ppc_bits;
 
@@ -167,6 +169,8 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
          */
         cl_page_list_for_each_safe(page, tmp, qin) {
                 struct osc_async_page *oap;
+		pgoff_t index;
+		unsigned int nr;
 
                 /* Top level IO. */
                 io = page->cp_owner;
@@ -184,6 +188,23 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
                         break;
                 }
 
+		/* a read widened to whole chunks must fit in one bulk, and
+		 * a large page must not overflow the RPC */
+		index = osc_index(opg);
+		nr = cl_page_nr(page);
+		if (queued > 0 &&
+		    (queued + nr > max_pages ||
+		     (crt == CRT_READ &&
+		      osc_compr_read_span(osc, min(first, index),
+					  max(last, index + nr - 1)) >
+		      PTLRPC_MAX_BRW_PAGES))) {
+			result = osc_queue_sync_pages(env, io, osc, &list,
+						      brw_flags);
+			if (result < 0)
+				break;
+			queued = 0;
+		}
+
                 result = cl_page_prep(env, io, page, crt);
 		if (result != 0) {
                         LASSERT(result < 0);
@@ -202,6 +223,14 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
 			oap->oap_async_flags = ASYNC_URGENT|ASYNC_READY|ASYNC_COUNT_STABLE;
 		}
 
+		if (queued == 0) {
+			first = index;
+			last = index + nr - 1;
+		} else {
+			first = min(first, index);
+			last = max(last, index + nr - 1);
+		}
+
 		osc_page_submit(env, opg, crt, brw_flags);
 		list_add_tail(&oap->oap_pending_item, &list);
 
@@ -210,8 +239,8 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
 		else /* async IO */
 			cl_page_list_del(env, qin, page);
 
-		queued++;
-		if (queued == max_pages) {
+		queued += nr;
+		if (queued >= max_pages) {
 			sync_queue = true;
 		} else if (crt == CRT_WRITE) {
 			unsigned int chunks;
@@ -321,8 +350,9 @@ int osc_io_commit_async(const struct lu_env *env,
 			cl_page_clip(env, page, from, to);
 		} else {
 			if (from != 0)
-				cl_page_clip(env, page, from, PAGE_SIZE);
-			if (to != PAGE_SIZE)
+				cl_page_clip(env, page, from,
+					     cl_page_size(page));
+			if (to != cl_page_size(last_page))
 				cl_page_clip(env, last_page, 0, to);
 		}
 	}
@@ -354,7 +384,7 @@ int osc_io_commit_async(const struct lu_env *env,
 		}
 
 		osc_page_touch_at(env, osc2cl(osc), osc_index(opg),
-				  page == last_page ? to : PAGE_SIZE);
+				  page == last_page ? to : cl_page_size(page));
 
 		cl_page_list_del(env, qin, page);
 
@@ -381,6 +411,7 @@ int osc_io_commit_async(const struct lu_env *env,
 	 * osc_io_end() is called, so release it earlier.
 	 * for mkwrite(), it's known there is no further pages. */
 	if (cl_io_is_sync_write(io) && oio->oi_active != NULL) {
+		osc_io_stage_flush(oio, CL_STAGE_FLUSH_IO_END);
 		osc_extent_release(env, oio->oi_active);
 		oio->oi_active = NULL;
 	}
@@ -395,6 +426,7 @@ void osc_io_extent_release(const struct lu_env *env,
 {
 	struct osc_io *oio = cl2osc_io(env, ios);
 
+	osc_io_stage_flush(oio, CL_STAGE_FLUSH_IO_END);
 	if (oio->oi_active != NULL) {
 		osc_extent_release(env, oio->oi_active);
 		oio->oi_active = NULL;
@@ -1120,6 +1152,7 @@ void osc_io_end(const struct lu_env *env, const struct cl_io_slice *slice)
 {
 	struct osc_io *oio = cl2osc_io(env, slice);
 
+	osc_io_stage_flush(oio, CL_STAGE_FLUSH_IO_END);
 	if (oio->oi_active) {
 		osc_extent_release(env, oio->oi_active);
 		oio->oi_active = NULL;
@@ -133,8 +133,18 @@ static void osc_lock_build_policy(const struct lu_env *env,
 				  union ldlm_policy_data *policy)
 {
 	const struct cl_lock_descr *d = &lock->cll_descr;
+	unsigned int chunk_pages = osc_compr_chunk_pages(cl2osc(d->cld_obj));
+	pgoff_t start = d->cld_start;
+	pgoff_t end = d->cld_end;
+
+	/* compressed chunks are read and written as a whole */
+	if (chunk_pages > 1) {
+		start = round_down(start, chunk_pages);
+		if (end != CL_PAGE_EOF)
+			end = round_up(end + 1, chunk_pages) - 1;
+	}
 
-	osc_index2policy(policy, d->cld_obj, d->cld_start, d->cld_end);
+	osc_index2policy(policy, d->cld_obj, start, end);
 	policy->l_extent.gid = d->cld_gid;
 }
 
@@ -650,7 +660,7 @@ static bool weigh_cb(const struct lu_env *env, struct cl_io *io,
 		    PageWriteback(page->cp_vmpage))
 			return false;
 
-		*(pgoff_t *)cbdata = osc_index(ops) + 1;
+		*(pgoff_t *)cbdata = osc_index(ops) + osc_page_nr(ops);
 	}
 	return true;
 }
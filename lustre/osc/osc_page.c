@@ -194,6 +194,11 @@ static void osc_page_delete(const struct lu_env *env,
 		LASSERT(ergo(value != NULL, value == opg));
 	}
 
+	if (opg->ops_tails != NULL) {
+		OBD_FREE_PTR_ARRAY(opg->ops_tails, osc_page_nr(opg) - 1);
+		opg->ops_tails = NULL;
+	}
+
 	EXIT;
 }
 
@@ -249,7 +254,7 @@ int osc_page_init(const struct lu_env *env, struct cl_object *obj,
 	int result;
 
 	opg->ops_from = 0;
-	opg->ops_to = PAGE_SIZE - 1;
+	opg->ops_to = cl_page_size(cl_page) - 1;
 
 	INIT_LIST_HEAD(&opg->ops_lru);
 
@@ -257,6 +262,12 @@ int osc_page_init(const struct lu_env *env, struct cl_object *obj,
 	if (result != 0)
 		return result;
 
+	if (cl_page_nr(cl_page) > 1) {
+		OBD_ALLOC_PTR_ARRAY(opg->ops_tails, cl_page_nr(cl_page) - 1);
+		if (opg->ops_tails == NULL)
+			return -ENOMEM;
+	}
+
 	opg->ops_srvlock = osc_io_srvlock(oio);
 	cl_page_slice_add(cl_page, &opg->ops_cl, obj, &osc_page_ops);
 
@@ -401,41 +412,69 @@ int lru_queue_work(const struct lu_env *env, void *data)
 	RETURN(0);
 }
 
+/* CPT of the NUMA node holding \a vmpage */
+static inline unsigned short osc_lru_page_cpt(struct page *vmpage)
+{
+	int cpt = cfs_cpt_of_node(cfs_cpt_tab, page_to_nid(vmpage));
+
+	return cpt < 0 ? cfs_cpt_current(cfs_cpt_tab, 1) : cpt;
+}
+
+/* LRU shard \a opg is kept on, set up by osc_lru_alloc() */
+static inline struct cl_lru_shard *osc_lru_shard(struct client_obd *cli,
+						 struct osc_page *opg)
+{
+	return cli->cl_lru_shards[opg->ops_lru_cpt];
+}
+
 void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 {
-	LIST_HEAD(lru);
+	struct cl_lru_shard *locked = NULL;
+	struct cl_lru_shard *shard;
 	struct osc_async_page *oap;
 	long npages = 0;
 
+	/* pages of one batch usually come from the same node */
 	list_for_each_entry(oap, plist, oap_pending_item) {
 		struct osc_page *opg = oap2osc_page(oap);
 
 		if (!opg->ops_in_lru)
 			continue;
 
-		++npages;
+		shard = osc_lru_shard(cli, opg);
+		if (shard != locked) {
+			if (locked != NULL)
+				spin_unlock(&locked->cls_lock);
+			locked = shard;
+			spin_lock(&locked->cls_lock);
+		}
+
+		npages += osc_page_nr(opg);
 		LASSERT(list_empty(&opg->ops_lru));
-		list_add(&opg->ops_lru, &lru);
+		list_add_tail(&opg->ops_lru, &shard->cls_list);
+		shard->cls_count += osc_page_nr(opg);
 	}
+	if (locked != NULL)
+		spin_unlock(&locked->cls_lock);
 
 	if (npages > 0) {
-		spin_lock(&cli->cl_lru_list_lock);
-		list_splice_tail(&lru, &cli->cl_lru_list);
 		atomic_long_sub(npages, &cli->cl_lru_busy);
 		atomic_long_add(npages, &cli->cl_lru_in_list);
 		cli->cl_lru_last_used = ktime_get_real_seconds();
-		spin_unlock(&cli->cl_lru_list_lock);
 
 		if (waitqueue_active(&osc_lru_waitq))
 			(void)ptlrpcd_queue_work(cli->cl_lru_work);
 	}
 }
 
-static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
+static void __osc_lru_del(struct client_obd *cli, struct cl_lru_shard *shard,
+			  struct osc_page *opg)
 {
-	LASSERT(atomic_long_read(&cli->cl_lru_in_list) > 0);
+	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= osc_page_nr(opg));
+	LASSERT(shard->cls_count >= osc_page_nr(opg));
 	list_del_init(&opg->ops_lru);
-	atomic_long_dec(&cli->cl_lru_in_list);
+	shard->cls_count -= osc_page_nr(opg);
+	atomic_long_sub(osc_page_nr(opg), &cli->cl_lru_in_list);
 }
 
 /**
@@ -445,16 +484,19 @@ static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	if (opg->ops_in_lru) {
-		spin_lock(&cli->cl_lru_list_lock);
+		struct cl_lru_shard *shard = osc_lru_shard(cli, opg);
+
+		spin_lock(&shard->cls_lock);
 		if (!list_empty(&opg->ops_lru)) {
-			__osc_lru_del(cli, opg);
+			__osc_lru_del(cli, shard, opg);
 		} else {
-			LASSERT(atomic_long_read(&cli->cl_lru_busy) > 0);
-			atomic_long_dec(&cli->cl_lru_busy);
+			LASSERT(atomic_long_read(&cli->cl_lru_busy) >=
+				osc_page_nr(opg));
+			atomic_long_sub(osc_page_nr(opg), &cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&shard->cls_lock);
 
-		atomic_long_inc(cli->cl_lru_left);
+		atomic_long_add(osc_page_nr(opg), cli->cl_lru_left);
 		/* this is a great place to release more LRU pages if
 		 * this osc occupies too many LRU pages and kernel is
 		 * stealing one of them. */
@@ -476,14 +518,16 @@ static void osc_lru_use(struct client_obd *cli, struct osc_page *opg)
 	/* If page is being transferred for the first time,
 	 * ops_lru should be empty */
 	if (opg->ops_in_lru) {
+		struct cl_lru_shard *shard = osc_lru_shard(cli, opg);
+
 		if (list_empty(&opg->ops_lru))
 			return;
-		spin_lock(&cli->cl_lru_list_lock);
+		spin_lock(&shard->cls_lock);
 		if (!list_empty(&opg->ops_lru)) {
-			__osc_lru_del(cli, opg);
-			atomic_long_inc(&cli->cl_lru_busy);
+			__osc_lru_del(cli, shard, opg);
+			atomic_long_add(osc_page_nr(opg), &cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&shard->cls_lock);
 	}
 }
 
@@ -522,55 +566,40 @@ static inline bool lru_page_busy(struct client_obd *cli, struct cl_page *page)
 	if (cli->cl_cache->ccc_unstable_check) {
 		struct page *vmpage = cl_page_vmpage(page);
 
-		/* vmpage have two known users: cl_page and VM page cache */
-		if (page_count(vmpage) - page_mapcount(vmpage) > 2)
+		/* vmpage have two known users: cl_page and VM page cache,
+		 * the latter holds one reference per page of a folio */
+		if (page_count(vmpage) - page_mapcount(vmpage) >
+		    cl_page_nr(page) + 1)
 			return true;
 	}
 	return false;
 }
 
 /**
- * Drop @target of pages from LRU at most.
+ * Drop @target of pages from LRU shard @shard at most.
  */
-long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
-		   long target, bool force)
+static long osc_lru_shrink_shard(const struct lu_env *env,
+				 struct client_obd *cli,
+				 struct cl_lru_shard *shard,
+				 long target, bool force)
 {
 	struct cl_io *io;
 	struct cl_object *clobj = NULL;
 	struct cl_page **pvec;
 	struct osc_page *opg;
+	ktime_t start = ktime_get();
+	u64 elapsed;
 	long count = 0;
-	int maxscan = 0;
+	long maxscan = 0;
 	int index = 0;
 	int rc = 0;
-	ENTRY;
-
-	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
-	if (atomic_long_read(&cli->cl_lru_in_list) == 0 || target <= 0)
-		RETURN(0);
-
-	CDEBUG(D_CACHE, "%s: shrinkers: %d, force: %d\n",
-	       cli_name(cli), atomic_read(&cli->cl_lru_shrinkers), force);
-	if (!force) {
-		if (atomic_read(&cli->cl_lru_shrinkers) > 0)
-			RETURN(-EBUSY);
-
-		if (atomic_inc_return(&cli->cl_lru_shrinkers) > 1) {
-			atomic_dec(&cli->cl_lru_shrinkers);
-			RETURN(-EBUSY);
-		}
-	} else {
-		atomic_inc(&cli->cl_lru_shrinkers);
-	}
 
 	pvec = (struct cl_page **)osc_env_info(env)->oti_pvec;
 	io = osc_env_thread_io(env);
 
-	spin_lock(&cli->cl_lru_list_lock);
-	if (force)
-		cli->cl_lru_reclaim++;
-	maxscan = min(target << 1, atomic_long_read(&cli->cl_lru_in_list));
-	while (!list_empty(&cli->cl_lru_list)) {
+	spin_lock(&shard->cls_lock);
+	maxscan = min(target << 1, shard->cls_count);
+	while (!list_empty(&shard->cls_list)) {
 		struct cl_page *page;
 		bool will_free = false;
 
@@ -580,11 +609,11 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		if (--maxscan < 0)
 			break;
 
-		opg = list_first_entry(&cli->cl_lru_list, struct osc_page,
+		opg = list_first_entry(&shard->cls_list, struct osc_page,
 				       ops_lru);
 		page = opg->ops_cl.cpl_page;
 		if (lru_page_busy(cli, page)) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
+			list_move_tail(&opg->ops_lru, &shard->cls_list);
 			continue;
 		}
 
@@ -593,7 +622,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			struct cl_object *tmp = page->cp_obj;
 
 			cl_object_get(tmp);
-			spin_unlock(&cli->cl_lru_list_lock);
+			spin_unlock(&shard->cls_lock);
 
 			if (clobj != NULL) {
 				discard_pagevec(env, io, pvec, index);
@@ -609,7 +638,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			io->ci_ignore_layout = 1;
 			rc = cl_io_init(env, io, CIT_MISC, clobj);
 
-			spin_lock(&cli->cl_lru_list_lock);
+			spin_lock(&shard->cls_lock);
 
 			if (rc != 0)
 				break;
@@ -622,7 +651,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			if (!lru_page_busy(cli, page)) {
 				/* remove it from lru list earlier to avoid
 				 * lock contention */
-				__osc_lru_del(cli, opg);
+				__osc_lru_del(cli, shard, opg);
 				opg->ops_in_lru = 0; /* will be discarded */
 
 				cl_page_get(page);
@@ -633,24 +662,25 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		}
 
 		if (!will_free) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
+			list_move_tail(&opg->ops_lru, &shard->cls_list);
 			continue;
 		}
 
-		/* Don't discard and free the page with cl_lru_list held */
+		/* Don't discard and free the page with cls_lock held */
 		pvec[index++] = page;
 		if (unlikely(index == OTI_PVEC_SIZE)) {
-			spin_unlock(&cli->cl_lru_list_lock);
+			spin_unlock(&shard->cls_lock);
 			discard_pagevec(env, io, pvec, index);
 			index = 0;
 
-			spin_lock(&cli->cl_lru_list_lock);
+			spin_lock(&shard->cls_lock);
 		}
 
-		if (++count >= target)
+		count += cl_page_nr(page);
+		if (count >= target)
 			break;
 	}
-	spin_unlock(&cli->cl_lru_list_lock);
+	spin_unlock(&shard->cls_lock);
 
 	if (clobj != NULL) {
 		discard_pagevec(env, io, pvec, index);
@@ -659,6 +689,100 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		cl_object_put(env, clobj);
 	}
 
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), start));
+	spin_lock(&shard->cls_lock);
+	shard->cls_shrinks++;
+	shard->cls_shrink_pages += count;
+	shard->cls_shrink_ns += elapsed;
+	if (elapsed > shard->cls_shrink_max_ns)
+		shard->cls_shrink_max_ns = elapsed;
+	spin_unlock(&shard->cls_lock);
+
+	return count > 0 ? count : rc;
+}
+
+/*
+ * Shard to shrink first: an IO thread short of LRU slots frees the pages of
+ * its own node, while the background shrinking trims the longest list so
+ * that the nodes are evened out.
+ */
+static int osc_lru_shrink_first(struct client_obd *cli, bool force)
+{
+	struct cl_lru_shard *shard;
+	long max = 0;
+	int first = 0;
+	int i;
+
+	if (force)
+		return cfs_cpt_current(cfs_cpt_tab, 1);
+
+	cfs_percpt_for_each(shard, i, cli->cl_lru_shards) {
+		long nr = READ_ONCE(shard->cls_count);
+
+		if (nr > max) {
+			max = nr;
+			first = i;
+		}
+	}
+
+	return first;
+}
+
+/**
+ * Drop @target of pages from LRU at most.
+ *
+ * The shards are scanned in turn starting from the one picked by
+ * osc_lru_shrink_first(), the others are only touched if it can't provide
+ * enough pages.
+ */
+long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
+		   long target, bool force)
+{
+	int ncpt = cfs_percpt_number(cli->cl_lru_shards);
+	struct cl_lru_shard *shard;
+	long count = 0;
+	long rc = 0;
+	int first;
+	int i;
+	ENTRY;
+
+	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
+	if (atomic_long_read(&cli->cl_lru_in_list) == 0 || target <= 0)
+		RETURN(0);
+
+	CDEBUG(D_CACHE, "%s: shrinkers: %d, force: %d\n",
+	       cli_name(cli), atomic_read(&cli->cl_lru_shrinkers), force);
+	if (!force) {
+		if (atomic_read(&cli->cl_lru_shrinkers) > 0)
+			RETURN(-EBUSY);
+
+		if (atomic_inc_return(&cli->cl_lru_shrinkers) > 1) {
+			atomic_dec(&cli->cl_lru_shrinkers);
+			RETURN(-EBUSY);
+		}
+	} else {
+		atomic_inc(&cli->cl_lru_shrinkers);
+	}
+
+	first = osc_lru_shrink_first(cli, force);
+	if (force)
+		atomic64_inc(&cli->cl_lru_reclaim);
+
+	for (i = 0; i < ncpt && count < target; i++) {
+		if (!force && atomic_read(&cli->cl_lru_shrinkers) > 1)
+			break;
+
+		shard = cli->cl_lru_shards[(first + i) % ncpt];
+		if (READ_ONCE(shard->cls_count) == 0)
+			continue;
+
+		rc = osc_lru_shrink_shard(env, cli, shard, target - count,
+					  force);
+		if (rc < 0)
+			break;
+		count += rc;
+	}
+
 	atomic_dec(&cli->cl_lru_shrinkers);
 	if (count > 0) {
 		atomic_long_add(count, cli->cl_lru_left);
@@ -747,8 +871,24 @@ out:
 	return rc;
 }
 
+/* Take \a nr slots from \a left unless fewer than that are left */
+static bool osc_lru_take(atomic_long_t *left, long nr)
+{
+	long c = atomic_long_read(left);
+
+	while (c >= nr) {
+		long old = atomic_long_cmpxchg(left, c, c - nr);
+
+		if (old == c)
+			return true;
+		c = old;
+	}
+	return false;
+}
+
 /**
- * osc_lru_alloc() is called to allocate an LRU slot for a cl_page.
+ * osc_lru_alloc() is called to allocate an LRU slot for a cl_page, a large
+ * folio takes one slot per page.
  *
  * Usually the LRU slots are reserved in osc_io_iter_rw_init().
  * Only in the case that the LRU slots are in extreme shortage, it should
@@ -758,6 +898,7 @@ static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 			 struct osc_page *opg)
 {
 	struct osc_io *oio = osc_env_io(env);
+	long nr = osc_page_nr(opg);
 	int rc = 0;
 
 	ENTRY;
@@ -765,22 +906,22 @@ static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 	if (cli->cl_cache == NULL) /* shall not be in LRU */
 		RETURN(0);
 
-	if (oio->oi_lru_reserved > 0) {
-		--oio->oi_lru_reserved;
+	if (oio->oi_lru_reserved >= nr) {
+		oio->oi_lru_reserved -= nr;
 		goto out;
 	}
 
 	LASSERT(atomic_long_read(cli->cl_lru_left) >= 0);
-	while (!atomic_long_add_unless(cli->cl_lru_left, -1, 0)) {
+	while (!osc_lru_take(cli->cl_lru_left, nr)) {
 		/* run out of LRU spaces, try to drop some by itself */
-		rc = osc_lru_reclaim(cli, 1);
+		rc = osc_lru_reclaim(cli, nr);
 		if (rc < 0)
 			break;
 		if (rc > 0)
 			continue;
 		/* IO issued by readahead, don't try hard */
 		if (oio->oi_is_readahead) {
-			if (atomic_long_read(cli->cl_lru_left) > 0)
+			if (atomic_long_read(cli->cl_lru_left) >= nr)
 				continue;
 			rc = -EBUSY;
 			break;
@@ -789,7 +930,7 @@ static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 		cond_resched();
 		rc = l_wait_event_abortable(
 			osc_lru_waitq,
-			atomic_long_read(cli->cl_lru_left) > 0);
+			atomic_long_read(cli->cl_lru_left) >= nr);
 		if (rc < 0) {
 			rc = -EINTR;
 			break;
@@ -798,7 +939,9 @@ static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 
 out:
 	if (rc >= 0) {
-		atomic_long_inc(&cli->cl_lru_busy);
+		atomic_long_add(nr, &cli->cl_lru_busy);
+		opg->ops_lru_cpt =
+			osc_lru_page_cpt(cl_page_vmpage(opg->ops_cl.cpl_page));
 		opg->ops_in_lru = 1;
 		rc = 0;
 	}
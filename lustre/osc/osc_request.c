@@ -1161,7 +1161,7 @@ static inline int can_merge_pages(struct brw_page *p1, struct brw_page *p2)
 		unsigned mask = ~(OBD_BRW_FROM_GRANT | OBD_BRW_NOCACHE |
 				  OBD_BRW_SYNC       | OBD_BRW_ASYNC   |
 				  OBD_BRW_NOQUOTA    | OBD_BRW_SOFT_SYNC |
-				  OBD_BRW_SYS_RESOURCE);
+				  OBD_BRW_SYS_RESOURCE | OBD_BRW_ZERO);
 
                 /* warn if we try to combine flags that we don't know to be
                  * safe to combine */
@@ -1177,11 +1177,53 @@ static inline int can_merge_pages(struct brw_page *p1, struct brw_page *p2)
 }
 
 #if IS_ENABLED(CONFIG_CRC_T10DIF)
+/*
+ * Guard tags generated by ll_dio_user_copy() for a page of the internal
+ * buffer of an unaligned DIO write, if they are of \a cksum_type and cover
+ * the \a nr_guards sectors of the page starting at offset \a off.
+ */
+static __be16 *osc_dio_page_guards(struct brw_page *pg,
+				   enum cksum_types cksum_type,
+				   unsigned int off, int nr_guards)
+{
+	struct cl_page *clpage = oap2cl_page(brw_page2oap(pg));
+	struct ll_dio_pages *pvec;
+	struct cl_sub_dio *sdio;
+	unsigned int from;
+	pgoff_t idx;
+
+	if (clpage->cp_type != CPT_TRANSIENT || !clpage->cp_sync_io)
+		return NULL;
+
+	sdio = container_of(clpage->cp_sync_io, struct cl_sub_dio, csd_sync);
+	pvec = &sdio->csd_dio_pages;
+	if (!sdio->csd_unaligned || !pvec->ldp_guards ||
+	    pvec->ldp_cksum_type != cksum_type)
+		return NULL;
+
+	/* bp_page differs once encrypted into a bounce page */
+	idx = clpage->cp_page_index - (pvec->ldp_file_offset >> PAGE_SHIFT);
+	if (idx >= pvec->ldp_count || pvec->ldp_pages[idx] != pg->bp_page)
+		return NULL;
+
+	/* the guards of a page start at the sector the copy started in */
+	from = idx == 0 ? pvec->ldp_file_offset & ~PAGE_MASK : 0;
+	if (nr_guards <= 0 || nr_guards > LL_DIO_GUARDS_PER_PAGE || off != from)
+		return NULL;
+
+	return pvec->ldp_guards + idx * LL_DIO_GUARDS_PER_PAGE;
+}
+
+/*
+ * \a dio_type is the checksum type when \a pga are the pages of the osc
+ * cache, so guards already generated for DIO pages may be used.
+ */
 static int osc_checksum_bulk_t10pi(const char *obd_name, int nob,
 				   size_t pg_count, struct brw_page **pga,
 				   int opc, obd_dif_csum_fn *fn,
 				   int sector_size,
-				   u32 *check_sum, bool resend)
+				   u32 *check_sum, bool resend,
+				   enum cksum_types dio_type)
 {
 	struct ahash_request *req;
 	/* Used Adler as the default checksum type on top of DIF tags */
@@ -1194,6 +1236,7 @@ static int osc_checksum_bulk_t10pi(const char *obd_name, int nob,
 	int used;
 	u32 cksum;
 	unsigned int bufsize = sizeof(cksum);
+	__be16 *guards;
 	int rc = 0, rc2;
 	int i = 0;
 
@@ -1225,6 +1268,13 @@ static int osc_checksum_bulk_t10pi(const char *obd_name, int nob,
 		int guards_needed = DIV_ROUND_UP(off + count, sector_size) -
 					(off / sector_size);
 
+		/* not in the bulk, so not in the checksum either */
+		if (pga[i]->bp_flag & OBD_BRW_ZERO) {
+			pg_count--;
+			i++;
+			continue;
+		}
+
 		if (guards_needed > guard_number - used_number) {
 			cfs_crypto_hash_update_page(req, __page, 0,
 				used_number * sizeof(*guard_start));
@@ -1241,17 +1291,27 @@ static int osc_checksum_bulk_t10pi(const char *obd_name, int nob,
 			kunmap(pga[i]->bp_page);
 		}
 
-		/*
-		 * The left guard number should be able to hold checksums of a
-		 * whole page
-		 */
-		rc = obd_page_dif_generate_buffer(obd_name, pga[i]->bp_page,
-						  pga[i]->bp_off & ~PAGE_MASK,
-						  count,
-						  guard_start + used_number,
-						  guard_number - used_number,
-						  &used, sector_size,
-						  fn);
+		guards = NULL;
+		if (opc == OST_WRITE && dio_type)
+			guards = osc_dio_page_guards(pga[i], dio_type, off,
+						     guards_needed);
+		if (guards) {
+			used = guards_needed;
+			memcpy(guard_start + used_number, guards,
+			       used * sizeof(*guard_start));
+		} else {
+			/*
+			 * The left guard number should be able to hold
+			 * checksums of a whole page
+			 */
+			rc = obd_page_dif_generate_buffer(obd_name,
+						pga[i]->bp_page,
+						pga[i]->bp_off & ~PAGE_MASK,
+						count,
+						guard_start + used_number,
+						guard_number - used_number,
+						&used, sector_size, fn);
+		}
 		if (unlikely(resend))
 			CDEBUG(D_PAGE | D_HA,
 			       "pga[%u]: used %u off %llu+%u gen checksum: %*phN\n",
@@ -1294,7 +1354,8 @@ out:
 #else /* !CONFIG_CRC_T10DIF */
 #define obd_dif_ip_fn NULL
 #define obd_dif_crc_fn NULL
-#define osc_checksum_bulk_t10pi(name, nob, pgc, pga, opc, fn, ssize, csum, re) \
+#define osc_checksum_bulk_t10pi(name, nob, pgc, pga, opc, fn, ssize, csum, re, \
+				dio) \
 	-EOPNOTSUPP
 #endif /* CONFIG_CRC_T10DIF */
 
@@ -1304,23 +1365,38 @@ static int osc_checksum_bulk(int nob, size_t pg_count,
 			     u32 *cksum)
 {
 	int				i = 0;
-	struct ahash_request	       *req;
+	struct ahash_request	       *req = NULL;
 	unsigned int			bufsize;
 	unsigned char			cfs_alg = cksum_obd2cfs(cksum_type);
+	struct cfs_crypto_mb_buf	bufs[CFS_CRYPTO_MB_BATCH];
+	int				nr = 0;
+	u32				crc = 0;
+	bool				mb;
 
 	LASSERT(pg_count > 0);
 
-	req = cfs_crypto_hash_init(cfs_alg, NULL, 0);
-	if (IS_ERR(req)) {
-		CERROR("Unable to initialize checksum hash %s\n",
-		       cfs_crypto_hash_name(cfs_alg));
-		return PTR_ERR(req);
+	/* CRC32C pages are checksummed several at a time in parallel */
+	mb = cfs_alg == CFS_HASH_ALG_CRC32C && cfs_crypto_crc32c_mb_enabled();
+	if (!mb) {
+		req = cfs_crypto_hash_init(cfs_alg, NULL, 0);
+		if (IS_ERR(req)) {
+			CERROR("Unable to initialize checksum hash %s\n",
+			       cfs_crypto_hash_name(cfs_alg));
+			return PTR_ERR(req);
+		}
 	}
 
 	while (nob > 0 && pg_count > 0) {
 		unsigned int count =
 			pga[i]->bp_count > nob ? nob : pga[i]->bp_count;
 
+		/* not in the bulk, so not in the checksum either */
+		if (pga[i]->bp_flag & OBD_BRW_ZERO) {
+			pg_count--;
+			i++;
+			continue;
+		}
+
 		/* corrupt the data before we compute the checksum, to
 		 * simulate an OST->client data error */
 		if (i == 0 && opc == OST_READ &&
@@ -1331,9 +1407,19 @@ static int osc_checksum_bulk(int nob, size_t pg_count,
 			memcpy(ptr + off, "bad1", min_t(typeof(nob), 4, nob));
 			kunmap(pga[i]->bp_page);
 		}
-		cfs_crypto_hash_update_page(req, pga[i]->bp_page,
-					    pga[i]->bp_off & ~PAGE_MASK,
-					    count);
+		if (mb) {
+			bufs[nr].cmb_page = pga[i]->bp_page;
+			bufs[nr].cmb_offset = pga[i]->bp_off & ~PAGE_MASK;
+			bufs[nr].cmb_len = count;
+			if (++nr == CFS_CRYPTO_MB_BATCH) {
+				cfs_crypto_crc32c_mb(&crc, bufs, nr);
+				nr = 0;
+			}
+		} else {
+			cfs_crypto_hash_update_page(req, pga[i]->bp_page,
+						    pga[i]->bp_off & ~PAGE_MASK,
+						    count);
+		}
 		LL_CDEBUG_PAGE(D_PAGE, pga[i]->bp_page, "off %d\n",
 			       (int)(pga[i]->bp_off & ~PAGE_MASK));
 
@@ -1342,8 +1428,15 @@ static int osc_checksum_bulk(int nob, size_t pg_count,
 		i++;
 	}
 
-	bufsize = sizeof(*cksum);
-	cfs_crypto_hash_final(req, (unsigned char *)cksum, &bufsize);
+	if (mb) {
+		if (nr > 0)
+			cfs_crypto_crc32c_mb(&crc, bufs, nr);
+		/* same byte order as the "crc32c" shash digest */
+		*cksum = (__force u32)cpu_to_le32(crc);
+	} else {
+		bufsize = sizeof(*cksum);
+		cfs_crypto_hash_final(req, (unsigned char *)cksum, &bufsize);
+	}
 
 	/* For sending we only compute the wrong checksum instead
 	 * of corrupting the data so it is still correct on a redo */
@@ -1357,7 +1450,7 @@ static int osc_checksum_bulk_rw(const char *obd_name,
 				enum cksum_types cksum_type,
 				int nob, size_t pg_count,
 				struct brw_page **pga, int opc,
-				u32 *check_sum, bool resend)
+				u32 *check_sum, bool resend, bool cached_pga)
 {
 	obd_dif_csum_fn *fn = NULL;
 	int sector_size = 0;
@@ -1369,7 +1462,7 @@ static int osc_checksum_bulk_rw(const char *obd_name,
 	if (fn)
 		rc = osc_checksum_bulk_t10pi(obd_name, nob, pg_count, pga,
 					     opc, fn, sector_size, check_sum,
-					     resend);
+					     resend, cached_pga ? cksum_type : 0);
 	else
 		rc = osc_checksum_bulk(nob, pg_count, pga, opc, cksum_type,
 				       check_sum);
@@ -1501,9 +1594,17 @@ static inline void osc_release_bounce_pages(struct brw_page **pga,
 #endif
 }
 
+/* whether page \a i of a multi-object write starts object \a j + 1 */
+static inline bool osc_brw_obj_next(struct osc_brw_objs *objs, int j, u32 i)
+{
+	return objs != NULL && j + 1 < objs->ob_count &&
+	       objs->ob_objs[j + 1].obo_first == i;
+}
+
 static int
 osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 		     u32 page_count, struct brw_page **pga,
+		     struct osc_brw_objs *objs,
 		     struct ptlrpc_request **reqp, int resend)
 {
 	struct ptlrpc_request *req;
@@ -1511,7 +1612,8 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 	struct ost_body *body;
 	struct obd_ioobj *ioobj;
 	struct niobuf_remote *niobuf;
-	int niocount, i, requested_nob, opc, rc, short_io_size = 0;
+	int niocount, i, j, requested_nob, opc, rc, short_io_size = 0;
+	u32 obj_first, obj_last;
 	struct osc_brw_async_args *aa;
 	struct req_capsule *pill;
 	struct brw_page *pg_prev;
@@ -1522,6 +1624,10 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 	bool gpu = 0;
 	bool enable_checksum = true;
 	struct cl_page *clpage;
+	struct osc_compr_rpc *compr = NULL;
+	struct brw_page **oap_pga = pga;
+	u32 oap_page_count = page_count;
+	unsigned int max_brw;
 
 	ENTRY;
 	if (pga[0]->bp_page) {
@@ -1691,16 +1797,46 @@ retry_encrypt:
 		}
 	}
 
-        for (niocount = i = 1; i < page_count; i++) {
-                if (!can_merge_pages(pga[i - 1], pga[i]))
-                        niocount++;
-        }
+	/* from here on pga holds the pages on the wire, which can differ from
+	 * the cached pages on compressed components. A multi-object write
+	 * sends the cached pages as they are.
+	 */
+	if (objs == NULL) {
+		rc = osc_compr_rpc_prep(cli, opc, oa, pga, page_count, &compr);
+		if (!rc && !compr)
+			rc = osc_zero_rpc_prep(cli, opc, pga, page_count,
+					       &compr);
+		if (rc) {
+			ptlrpc_request_free(req);
+			RETURN(rc);
+		}
+	}
+	if (compr) {
+		pga = compr->ocr_pga;
+		page_count = compr->ocr_page_count;
+	}
+
+	if (objs != NULL)
+		objs->ob_objs[0].obo_niocount = 1;
+	for (niocount = i = 1, j = 0; i < page_count; i++) {
+		/* a niobuf never spans two objects */
+		if (osc_brw_obj_next(objs, j, i)) {
+			objs->ob_objs[++j].obo_niocount = 1;
+			niocount++;
+		} else if (!can_merge_pages(pga[i - 1], pga[i])) {
+			if (objs != NULL)
+				objs->ob_objs[j].obo_niocount++;
+			niocount++;
+		}
+	}
 
-        pill = &req->rq_pill;
-        req_capsule_set_size(pill, &RMF_OBD_IOOBJ, RCL_CLIENT,
-                             sizeof(*ioobj));
-        req_capsule_set_size(pill, &RMF_NIOBUF_REMOTE, RCL_CLIENT,
-                             niocount * sizeof(*niobuf));
+	pill = &req->rq_pill;
+	req_capsule_set_size(pill, &RMF_OBD_IOOBJ, RCL_CLIENT,
+			     (objs ? objs->ob_count : 1) * sizeof(*ioobj));
+	req_capsule_set_size(pill, &RMF_NIOBUF_REMOTE, RCL_CLIENT,
+			     niocount * sizeof(*niobuf));
+	req_capsule_set_size(pill, &RMF_IOOBJ_BODY, RCL_CLIENT,
+			     objs ? objs->ob_count * sizeof(*body) : 0);
 
 	for (i = 0; i < page_count; i++) {
 		short_io_size += pga[i]->bp_count;
@@ -1711,7 +1847,7 @@ retry_encrypt:
 		}
 	}
 
-	if (brw_page2oap(pga[0])->oap_brw_flags & OBD_BRW_RDMA_ONLY) {
+	if (brw_page2oap(oap_pga[0])->oap_brw_flags & OBD_BRW_RDMA_ONLY) {
 		enable_checksum = false;
 		short_io_size = 0;
 		gpu = 1;
@@ -1724,6 +1860,7 @@ retry_encrypt:
 
 	/* If this is an empty RPC to old server, just ignore it */
 	if (!short_io_size && !pga[0]->bp_page) {
+		osc_compr_rpc_free(compr);
 		ptlrpc_request_free(req);
 		RETURN(-ENODATA);
 	}
@@ -1736,6 +1873,7 @@ retry_encrypt:
 
         rc = ptlrpc_request_pack(req, LUSTRE_OST_VERSION, opc);
         if (rc) {
+		osc_compr_rpc_free(compr);
                 ptlrpc_request_free(req);
                 RETURN(rc);
         }
@@ -1752,8 +1890,16 @@ retry_encrypt:
 		goto no_bulk;
 	}
 
-	desc = ptlrpc_prep_bulk_imp(req, page_count,
-		cli->cl_import->imp_connect_data.ocd_brw_size >> LNET_MTU_BITS,
+	max_brw = cli->cl_import->imp_connect_data.ocd_brw_size >> LNET_MTU_BITS;
+	/* whole-chunk reads can be larger than the negotiated RPC size */
+	if (compr) {
+		max_brw = max(max_brw, 1U);
+		while (max_brw < PTLRPC_BULK_OPS_COUNT &&
+		       ((u64)max_brw << LNET_MTU_BITS) <
+		       ((u64)page_count << PAGE_SHIFT))
+			max_brw <<= 1;
+	}
+	desc = ptlrpc_prep_bulk_imp(req, page_count, max_brw,
 		(opc == OST_WRITE ? PTLRPC_BULK_GET_SOURCE :
 			PTLRPC_BULK_PUT_SINK),
 		OST_BULK_PORTAL,
@@ -1792,6 +1938,25 @@ no_bulk:
 	else /* short io */
 		ioobj_max_brw_set(ioobj, 0);
 
+	/* each object of a multi-object write has its own ioobj and body */
+	if (objs != NULL) {
+		struct ost_body *bodies;
+
+		bodies = req_capsule_client_get(pill, &RMF_IOOBJ_BODY);
+		LASSERT(bodies != NULL && desc != NULL);
+		for (j = 0; j < objs->ob_count; j++) {
+			struct obdo *obo_oa = &objs->ob_objs[j].obo_oa;
+
+			obdo_to_ioobj(obo_oa, &ioobj[j]);
+			ioobj[j].ioo_bufcnt = objs->ob_objs[j].obo_niocount;
+			ioobj_max_brw_set(&ioobj[j], desc->bd_md_max_brw);
+			lustre_set_wire_obdo(&req->rq_import->imp_connect_data,
+					     &bodies[j].oa, obo_oa);
+			bodies[j].oa.o_uid = obo_oa->o_uid;
+			bodies[j].oa.o_gid = obo_oa->o_gid;
+		}
+	}
+
 	if (inode && IS_ENCRYPTED(inode) &&
 	    llcrypt_has_encryption_key(inode) &&
 	    !CFS_FAIL_CHECK(OBD_FAIL_LFSCK_NO_ENCFLAG)) {
@@ -1819,20 +1984,31 @@ no_bulk:
 
 	LASSERT(page_count > 0);
 	pg_prev = pga[0];
-        for (requested_nob = i = 0; i < page_count; i++, niobuf++) {
-                struct brw_page *pg = pga[i];
+	obj_first = 0;
+	obj_last = objs ? objs->ob_objs[0].obo_count - 1 : page_count - 1;
+	for (requested_nob = i = 0, j = 0; i < page_count; i++, niobuf++) {
+		struct brw_page *pg = pga[i];
 		int poff = pg->bp_off & ~PAGE_MASK;
+		bool obj_next = osc_brw_obj_next(objs, j, i);
+
+		/* the pages of each object are checked on their own */
+		if (obj_next) {
+			j++;
+			obj_first = i;
+			obj_last = i + objs->ob_objs[j].obo_count - 1;
+		}
 
                 LASSERT(pg->bp_count > 0);
                 /* make sure there is no gap in the middle of page array */
-		LASSERTF(page_count == 1 ||
-			 (ergo(i == 0, poff + pg->bp_count == PAGE_SIZE) &&
-			  ergo(i > 0 && i < page_count - 1,
+		LASSERTF(obj_first == obj_last || compr ||
+			 (ergo(i == obj_first,
+			       poff + pg->bp_count == PAGE_SIZE) &&
+			  ergo(i > obj_first && i < obj_last,
 			       poff == 0 && pg->bp_count == PAGE_SIZE)   &&
-			  ergo(i == page_count - 1, poff == 0)),
+			  ergo(i == obj_last, poff == 0)),
 			 "i: %d/%d pg: %p off: %llu, count: %u\n",
 			 i, page_count, pg, pg->bp_off, pg->bp_count);
-                LASSERTF(i == 0 || pg->bp_off > pg_prev->bp_off,
+		LASSERTF(i == obj_first || pg->bp_off > pg_prev->bp_off,
 			 "i %d p_c %u pg %p [pri %lu ind %lu] off %llu"
 			 " prev_pg %p [pri %lu ind %lu] off %llu\n",
                          i, page_count,
@@ -1849,13 +2025,16 @@ no_bulk:
 			       ptr + poff,
 			       pg->bp_count);
 			kunmap_atomic(ptr);
-		} else if (short_io_size == 0) {
+		} else if (short_io_size == 0 &&
+			   !(pg->bp_flag & OBD_BRW_ZERO)) {
 			desc->bd_frag_ops->add_kiov_frag(desc, pg->bp_page, poff,
 							 pg->bp_count);
 		}
-		requested_nob += pg->bp_count;
+		/* zero pages are only described by their niobuf */
+		if (!(pg->bp_flag & OBD_BRW_ZERO))
+			requested_nob += pg->bp_count;
 
-                if (i > 0 && can_merge_pages(pg_prev, pg)) {
+		if (i > 0 && !obj_next && can_merge_pages(pg_prev, pg)) {
                         niobuf--;
 			niobuf->rnb_len += pg->bp_count;
 		} else {
@@ -1903,7 +2082,8 @@ no_bulk:
 			rc = osc_checksum_bulk_rw(obd_name, cksum_type,
 						  requested_nob, page_count,
 						  pga, OST_WRITE,
-						  &body->oa.o_cksum, resend);
+						  &body->oa.o_cksum, resend,
+						  compr == NULL);
 			if (rc < 0) {
 				CDEBUG(D_PAGE, "failed to checksum: rc = %d\n",
 				       rc);
@@ -1946,10 +2126,12 @@ no_bulk:
 	aa->aa_oa = oa;
 	aa->aa_requested_nob = requested_nob;
 	aa->aa_nio_count = niocount;
-	aa->aa_page_count = page_count;
+	aa->aa_page_count = oap_page_count;
 	aa->aa_resends = 0;
-	aa->aa_ppga = pga;
+	aa->aa_ppga = oap_pga;
 	aa->aa_cli = cli;
+	aa->aa_compr = compr;
+	aa->aa_objs = objs;
 	INIT_LIST_HEAD(&aa->aa_oaps);
 
 	*reqp = req;
@@ -1960,6 +2142,7 @@ no_bulk:
         RETURN(0);
 
  out:
+	osc_compr_rpc_free(compr);
         ptlrpc_req_finished(req);
         RETURN(rc);
 }
@@ -2032,6 +2215,8 @@ check_write_checksum(struct obdo *oa, const struct lnet_processid *peer,
 		     struct osc_brw_async_args *aa)
 {
 	const char *obd_name = aa->aa_cli->cl_import->imp_obd->obd_name;
+	struct brw_page **pga = aa->aa_ppga;
+	u32 page_count = aa->aa_page_count;
 	enum cksum_types cksum_type;
 	obd_dif_csum_fn *fn = NULL;
 	int sector_size = 0;
@@ -2044,8 +2229,13 @@ check_write_checksum(struct obdo *oa, const struct lnet_processid *peer,
                 return 0;
         }
 
+	if (aa->aa_compr) {
+		pga = aa->aa_compr->ocr_pga;
+		page_count = aa->aa_compr->ocr_page_count;
+	}
+
 	if (aa->aa_cli->cl_checksum_dump)
-		dump_all_bulk_pages(oa, aa->aa_page_count, aa->aa_ppga,
+		dump_all_bulk_pages(oa, page_count, pga,
 				    server_cksum, client_cksum);
 
 	cksum_type = obd_cksum_type_unpack(oa->o_valid & OBD_MD_FLFLAGS ?
@@ -2074,12 +2264,12 @@ check_write_checksum(struct obdo *oa, const struct lnet_processid *peer,
 
 	if (fn)
 		rc = osc_checksum_bulk_t10pi(obd_name, aa->aa_requested_nob,
-					     aa->aa_page_count, aa->aa_ppga,
+					     page_count, pga,
 					     OST_WRITE, fn, sector_size,
-					     &new_cksum, true);
+					     &new_cksum, true, 0);
 	else
-		rc = osc_checksum_bulk(aa->aa_requested_nob, aa->aa_page_count,
-				       aa->aa_ppga, OST_WRITE, cksum_type,
+		rc = osc_checksum_bulk(aa->aa_requested_nob, page_count,
+				       pga, OST_WRITE, cksum_type,
 				       &new_cksum);
 
 	if (rc < 0)
@@ -2104,9 +2294,9 @@ check_write_checksum(struct obdo *oa, const struct lnet_processid *peer,
 			   oa->o_valid & OBD_MD_FLFID ? oa->o_parent_seq : (__u64)0,
 			   oa->o_valid & OBD_MD_FLFID ? oa->o_parent_oid : 0,
 			   oa->o_valid & OBD_MD_FLFID ? oa->o_parent_ver : 0,
-			   POSTID(&oa->o_oi), aa->aa_ppga[0]->bp_off,
-			   aa->aa_ppga[aa->aa_page_count - 1]->bp_off +
-				aa->aa_ppga[aa->aa_page_count-1]->bp_count - 1,
+			   POSTID(&oa->o_oi), pga[0]->bp_off,
+			   pga[page_count - 1]->bp_off +
+				pga[page_count - 1]->bp_count - 1,
 			   client_cksum,
 			   obd_cksum_type_unpack(aa->aa_oa->o_flags),
 			   server_cksum, cksum_type, new_cksum);
@@ -2122,12 +2312,21 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 	const struct lnet_processid *peer =
 		&req->rq_import->imp_connection->c_peer;
 	struct ost_body *body;
+	struct ost_body *bodies = NULL;
 	u32 client_cksum = 0;
 	struct inode *inode = NULL;
 	unsigned int blockbits = 0, blocksize = 0;
 	struct cl_page *clpage;
+	int j;
+	/* pages on the wire */
+	struct brw_page **pga = aa->aa_ppga;
+	u32 page_count = aa->aa_page_count;
 
 	ENTRY;
+	if (aa->aa_compr) {
+		pga = aa->aa_compr->ocr_pga;
+		page_count = aa->aa_compr->ocr_page_count;
+	}
 
 	if (rc < 0 && rc != -EDQUOT) {
 		DEBUG_REQ(D_INFO, req, "Failed request: rc = %d", rc);
@@ -2141,18 +2340,34 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 		RETURN(-EPROTO);
 	}
 
+	/* each object of a multi-object write returns its own attributes */
+	if (aa->aa_objs != NULL) {
+		bodies = req_capsule_server_sized_get(&req->rq_pill,
+						      &RMF_IOOBJ_BODY,
+						      aa->aa_objs->ob_count *
+						      sizeof(*bodies));
+		if (bodies == NULL) {
+			DEBUG_REQ(D_INFO, req, "cannot unpack ioobj bodies");
+			RETURN(-EPROTO);
+		}
+	}
+
 	/* set/clear over quota flag for a uid/gid/projid */
-	if (lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE &&
-	    body->oa.o_valid & (OBD_MD_FLALLQUOTA)) {
+	for (j = 0; lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE &&
+	     j < (bodies ? aa->aa_objs->ob_count : 1); j++) {
+		struct obdo *qoa = bodies ? &bodies[j].oa : &body->oa;
 		unsigned qid[LL_MAXQUOTAS] = {
-					 body->oa.o_uid, body->oa.o_gid,
-					 body->oa.o_projid };
+					 qoa->o_uid, qoa->o_gid,
+					 qoa->o_projid };
+
+		if (!(qoa->o_valid & OBD_MD_FLALLQUOTA))
+			continue;
 		CDEBUG(D_QUOTA,
 		       "setdq for [%u %u %u] with valid %#llx, flags %x\n",
-		       body->oa.o_uid, body->oa.o_gid, body->oa.o_projid,
-		       body->oa.o_valid, body->oa.o_flags);
-		osc_quota_setdq(cli, req->rq_xid, qid, body->oa.o_valid,
-				body->oa.o_flags);
+		       qoa->o_uid, qoa->o_gid, qoa->o_projid,
+		       qoa->o_valid, qoa->o_flags);
+		osc_quota_setdq(cli, req->rq_xid, qid, qoa->o_valid,
+				qoa->o_flags);
 	}
 
 	osc_update_grant(cli, body);
@@ -2180,8 +2395,15 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 			RETURN(-EAGAIN);
 
 		rc = check_write_rcs(req, aa->aa_requested_nob,
-				     aa->aa_nio_count, aa->aa_page_count,
-				     aa->aa_ppga);
+				     aa->aa_nio_count, page_count, pga);
+		if (rc == 0 && aa->aa_compr && aa->aa_compr->ocr_zero_bytes) {
+			struct osc_stats *stats =
+				&obd2osc_dev(cli->cl_import->imp_obd)->osc_stats;
+
+			spin_lock(&cli->cl_loi_list_lock);
+			stats->os_zero_writes += aa->aa_compr->ocr_zero_bytes;
+			spin_unlock(&cli->cl_loi_list_lock);
+		}
 		GOTO(out, rc);
 	}
 
@@ -2216,19 +2438,19 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 		unsigned char *buf;
 
 		CDEBUG(D_CACHE, "Using short io read, size %d\n", rc);
-		pg_count = aa->aa_page_count;
+		pg_count = page_count;
 		buf = req_capsule_server_sized_get(&req->rq_pill, &RMF_SHORT_IO,
 						   rc);
 		nob = rc;
 		while (nob > 0 && pg_count > 0) {
 			unsigned char *ptr;
-			int count = aa->aa_ppga[i]->bp_count > nob ?
-				    nob : aa->aa_ppga[i]->bp_count;
+			int count = pga[i]->bp_count > nob ?
+				    nob : pga[i]->bp_count;
 
 			CDEBUG(D_CACHE, "page %p count %d\n",
-			       aa->aa_ppga[i]->bp_page, count);
-			ptr = kmap_atomic(aa->aa_ppga[i]->bp_page);
-			memcpy(ptr + (aa->aa_ppga[i]->bp_off & ~PAGE_MASK), buf,
+			       pga[i]->bp_page, count);
+			ptr = kmap_atomic(pga[i]->bp_page);
+			memcpy(ptr + (pga[i]->bp_off & ~PAGE_MASK), buf,
 			       count);
 			kunmap_atomic((void *) ptr);
 
@@ -2240,7 +2462,7 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 	}
 
 	if (rc < aa->aa_requested_nob)
-		handle_short_read(rc, aa->aa_page_count, aa->aa_ppga);
+		handle_short_read(rc, page_count, pga);
 
 	if (body->oa.o_valid & OBD_MD_FLCKSUM) {
 		static int cksum_counter;
@@ -2254,8 +2476,9 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 
 		cksum_type = obd_cksum_type_unpack(o_flags);
 		rc = osc_checksum_bulk_rw(obd_name, cksum_type, nob,
-					  aa->aa_page_count, aa->aa_ppga,
-					  OST_READ, &client_cksum, false);
+					  page_count, pga,
+					  OST_READ, &client_cksum, false,
+					  false);
 		if (rc < 0)
 			GOTO(out, rc);
 
@@ -2268,16 +2491,16 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 		if (server_cksum != client_cksum) {
 			struct ost_body *clbody;
 			__u32 client_cksum2;
-			u32 page_count = aa->aa_page_count;
 
 			osc_checksum_bulk_rw(obd_name, cksum_type, nob,
-					     page_count, aa->aa_ppga,
-					     OST_READ, &client_cksum2, true);
+					     page_count, pga,
+					     OST_READ, &client_cksum2, true,
+					     false);
 			clbody = req_capsule_client_get(&req->rq_pill,
 							&RMF_OST_BODY);
 			if (cli->cl_checksum_dump)
 				dump_all_bulk_pages(&clbody->oa, page_count,
-						    aa->aa_ppga, server_cksum,
+						    pga, server_cksum,
 						    client_cksum);
 
 			LCONSOLE_ERROR_MSG(0x133, "%s: BAD READ CHECKSUM: from "
@@ -2294,9 +2517,9 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 					   clbody->oa.o_valid & OBD_MD_FLFID ?
 						clbody->oa.o_parent_ver : 0,
 					   POSTID(&body->oa.o_oi),
-					   aa->aa_ppga[0]->bp_off,
-					   aa->aa_ppga[page_count-1]->bp_off +
-					   aa->aa_ppga[page_count-1]->bp_count - 1,
+					   pga[0]->bp_off,
+					   pga[page_count - 1]->bp_off +
+					   pga[page_count - 1]->bp_count - 1,
 					   client_cksum, client_cksum2,
 					   server_cksum, cksum_type);
 			cksum_counter = 0;
@@ -2319,6 +2542,13 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 		rc = 0;
 	}
 
+	if (rc >= 0 && aa->aa_compr) {
+		int rc2 = osc_compr_rpc_fini(aa->aa_compr);
+
+		if (rc2)
+			GOTO(out, rc = rc2);
+	}
+
 	/* get the inode from the first cl_page */
 	clpage = oap2cl_page(brw_page2oap(aa->aa_ppga[0]));
 	inode = clpage->cp_inode;
@@ -2395,6 +2625,11 @@ out:
 	if (rc >= 0)
 		lustre_get_wire_obdo(&req->rq_import->imp_connect_data,
 				     aa->aa_oa, &body->oa);
+	for (j = 0; rc >= 0 && bodies != NULL && j < aa->aa_objs->ob_count;
+	     j++)
+		lustre_get_wire_obdo(&req->rq_import->imp_connect_data,
+				     &aa->aa_objs->ob_objs[j].obo_oa,
+				     &bodies[j].oa);
 
 	RETURN(rc);
 }
@@ -2405,6 +2640,9 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 	struct ptlrpc_request *new_req;
 	struct osc_brw_async_args *new_aa;
 	struct osc_async_page *oap;
+	struct osc_compr_rpc *compr;
+	int requested_nob;
+	int nio_count;
 	ENTRY;
 
 	/* The below message is checked in replay-ost-single.sh test_8ae*/
@@ -2414,7 +2652,7 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 	rc = osc_brw_prep_request(lustre_msg_get_opc(request->rq_reqmsg) ==
 				OST_WRITE ? OBD_BRW_WRITE : OBD_BRW_READ,
 				  aa->aa_cli, aa->aa_oa, aa->aa_page_count,
-				  aa->aa_ppga, &new_req, 1);
+				  aa->aa_ppga, aa->aa_objs, &new_req, 1);
         if (rc)
                 RETURN(rc);
 
@@ -2430,8 +2668,18 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 	 * Note that copying a list_head doesn't work, need to move it...
 	 */
 	aa->aa_resends++;
+	/* the wire pages are rebuilt by osc_brw_prep_request() and may not
+	 * match the ones of the old request
+	 */
+	new_aa = ptlrpc_req_async_args(new_aa, new_req);
+	compr = new_aa->aa_compr;
+	requested_nob = new_aa->aa_requested_nob;
+	nio_count = new_aa->aa_nio_count;
 	new_req->rq_interpret_reply = request->rq_interpret_reply;
 	new_req->rq_async_args = request->rq_async_args;
+	new_aa->aa_compr = compr;
+	new_aa->aa_requested_nob = requested_nob;
+	new_aa->aa_nio_count = nio_count;
 	new_req->rq_commit_cb = request->rq_commit_cb;
 	/* cap resend delay to the current request timeout, this is similar to
 	 * what ptlrpc does (see after_reply()) */
@@ -2442,8 +2690,6 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
         new_req->rq_generation_set = 1;
         new_req->rq_import_generation = request->rq_import_generation;
 
-	new_aa = ptlrpc_req_async_args(new_aa, new_req);
-
 	INIT_LIST_HEAD(&new_aa->aa_oaps);
 	list_splice_init(&aa->aa_oaps, &new_aa->aa_oaps);
 	INIT_LIST_HEAD(&new_aa->aa_exts);
@@ -2504,6 +2750,236 @@ static void osc_release_ppga(struct brw_page **ppga, size_t count)
 	OBD_FREE_PTR_ARRAY_LARGE(ppga, count);
 }
 
+/* RPC autotuning: a window is at least this many RPCs and one second */
+#define OSC_RPC_TUNE_WINDOW_RPCS	16
+#define OSC_RPC_TUNE_WINDOW_NS		NSEC_PER_SEC
+/* windows spanning idle time say nothing about the OST load */
+#define OSC_RPC_TUNE_IDLE_NS		(10 * NSEC_PER_SEC)
+/* windows without growing after a step that did not help */
+#define OSC_RPC_TUNE_HOLD		8
+
+enum osc_rpc_tune_step {
+	OSC_RPC_TUNE_SHRUNK	= -1,
+	OSC_RPC_TUNE_KEPT	= 0,
+	OSC_RPC_TUNE_GREW_SIZE	= 1,
+	OSC_RPC_TUNE_GREW_DEPTH	= 2,
+};
+
+void osc_rpc_tune_enable(struct client_obd *cli, u32 target_us)
+__must_hold(&cli->cl_loi_list_lock)
+{
+	struct cl_rpc_tune *crt = &cli->cl_rpc_tune;
+
+	if (target_us && !crt->crt_target_us) {
+		/* start from the static setting */
+		crt->crt_rpcs = cli->cl_max_rpcs_in_flight;
+		crt->crt_pages = cli->cl_max_pages_per_rpc;
+		crt->crt_start = ktime_get();
+		crt->crt_nr = 0;
+		crt->crt_bytes = 0;
+		crt->crt_latency_us = 0;
+		crt->crt_last_rate = 0;
+		crt->crt_last_step = OSC_RPC_TUNE_KEPT;
+		crt->crt_hold = 0;
+	}
+	WRITE_ONCE(crt->crt_target_us, target_us);
+}
+
+static void osc_rpc_tune_trace(struct client_obd *cli, u32 latency, u64 rate,
+			       const char *action, bool changed)
+__must_hold(&cli->cl_loi_list_lock)
+{
+	struct cl_rpc_tune *crt = &cli->cl_rpc_tune;
+	struct cl_rpc_tune_event *crte;
+
+	CDEBUG(D_CACHE,
+	       "%s: rpc autotune %s: latency %uus rate %lluKB/s, %u RPCs of %u pages\n",
+	       cli_name(cli), action, latency, rate >> 10, crt->crt_rpcs,
+	       crt->crt_pages);
+
+	/* keep the trace for changes, not for a steady state */
+	if (!changed && crt->crt_trace_nr &&
+	    crt->crt_trace[(crt->crt_trace_nr - 1) %
+			   CL_RPC_TUNE_TRACE].crte_action == action)
+		return;
+
+	crte = &crt->crt_trace[crt->crt_trace_nr++ % CL_RPC_TUNE_TRACE];
+	crte->crte_time = ktime_get_real_seconds();
+	crte->crte_latency_us = latency;
+	crte->crte_rate_kbps = min_t(u64, rate >> 10, U32_MAX);
+	crte->crte_rpcs = crt->crt_rpcs;
+	crte->crte_pages = crt->crt_pages;
+	crte->crte_action = action;
+}
+
+/*
+ * Account a completed BRW RPC of \a bytes to the autotuning of \a cli.
+ *
+ * Adaptive timeouts only track whole seconds, so the round trip of each RPC
+ * is measured from its send time.  At the end of each window the average
+ * latency is compared with the target: above it, the number of RPCs in
+ * flight and then the RPC size are lowered, below it the RPC size and then
+ * the number of RPCs in flight are raised by one step.  A step up that did
+ * not raise the throughput is undone, and growing is held for a while.
+ * Both stay within the rpc_autotune_min_* tunables and the configured
+ * max_pages_per_rpc and max_rpcs_in_flight.
+ */
+static void osc_rpc_tune_update(struct client_obd *cli,
+				struct ptlrpc_request *req, unsigned long bytes)
+__must_hold(&cli->cl_loi_list_lock)
+{
+	struct cl_rpc_tune *crt = &cli->cl_rpc_tune;
+	u32 ppc = 1 << (cli->cl_chunkbits - PAGE_SHIFT);
+	u32 max_rpcs = cli->cl_max_rpcs_in_flight;
+	u32 max_pages = cli->cl_max_pages_per_rpc;
+	u32 min_rpcs = clamp_t(u32, crt->crt_min_rpcs, 1, max_rpcs);
+	u32 min_pages = clamp_t(u32, round_up(crt->crt_min_pages, ppc), ppc,
+				max_pages);
+	enum osc_rpc_tune_step step = OSC_RPC_TUNE_KEPT;
+	const char *action;
+	u64 elapsed;
+	u32 latency;
+	u64 rate;
+
+	if (!crt->crt_target_us)
+		return;
+
+	crt->crt_nr++;
+	crt->crt_bytes += bytes;
+	crt->crt_latency_us += max_t(s64, 0, ktime_us_delta(ktime_get_real(),
+							   req->rq_sent_ns));
+
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), crt->crt_start));
+	if (crt->crt_nr < OSC_RPC_TUNE_WINDOW_RPCS ||
+	    elapsed < OSC_RPC_TUNE_WINDOW_NS)
+		return;
+
+	if (elapsed > OSC_RPC_TUNE_IDLE_NS) {
+		crt->crt_last_step = OSC_RPC_TUNE_KEPT;
+		goto out_window;
+	}
+
+	latency = div_u64(crt->crt_latency_us, crt->crt_nr);
+	rate = div64_u64(crt->crt_bytes * USEC_PER_SEC,
+			 div_u64(elapsed, NSEC_PER_USEC));
+
+	/* the bounds may have changed since the last window */
+	crt->crt_rpcs = clamp(crt->crt_rpcs, min_rpcs, max_rpcs);
+	crt->crt_pages = clamp(round_down(crt->crt_pages, ppc), min_pages,
+			       max_pages);
+
+	if (latency > crt->crt_target_us) {
+		if (crt->crt_rpcs > min_rpcs) {
+			crt->crt_rpcs -= max(crt->crt_rpcs / 4, 1U);
+			crt->crt_rpcs = max(crt->crt_rpcs, min_rpcs);
+			action = "shrink depth";
+			step = OSC_RPC_TUNE_SHRUNK;
+		} else if (crt->crt_pages > min_pages) {
+			crt->crt_pages = max(round_down(crt->crt_pages / 2,
+							ppc), min_pages);
+			action = "shrink size";
+			step = OSC_RPC_TUNE_SHRUNK;
+		} else {
+			action = "at minimum";
+		}
+	} else if (crt->crt_last_step > OSC_RPC_TUNE_KEPT &&
+		   rate < crt->crt_last_rate + crt->crt_last_rate / 16) {
+		if (crt->crt_last_step == OSC_RPC_TUNE_GREW_DEPTH)
+			crt->crt_rpcs = clamp(crt->crt_undo, min_rpcs,
+					      crt->crt_rpcs);
+		else
+			crt->crt_pages = clamp(crt->crt_undo, min_pages,
+					       crt->crt_pages);
+		crt->crt_hold = OSC_RPC_TUNE_HOLD;
+		action = "undo";
+		step = OSC_RPC_TUNE_SHRUNK;
+	} else if (crt->crt_hold) {
+		crt->crt_hold--;
+		action = "hold";
+	} else if (crt->crt_pages < max_pages) {
+		crt->crt_undo = crt->crt_pages;
+		crt->crt_pages = min(crt->crt_pages * 2, max_pages);
+		action = "grow size";
+		step = OSC_RPC_TUNE_GREW_SIZE;
+	} else if (crt->crt_rpcs < max_rpcs) {
+		crt->crt_undo = crt->crt_rpcs;
+		crt->crt_rpcs++;
+		action = "grow depth";
+		step = OSC_RPC_TUNE_GREW_DEPTH;
+	} else {
+		action = "at maximum";
+	}
+
+	osc_rpc_tune_trace(cli, latency, rate, action,
+			   step != OSC_RPC_TUNE_KEPT);
+	crt->crt_last_rate = rate;
+	crt->crt_last_step = step;
+
+out_window:
+	crt->crt_start = ktime_get();
+	crt->crt_nr = 0;
+	crt->crt_bytes = 0;
+	crt->crt_latency_us = 0;
+}
+
+/*
+ * Update the attributes of the object of @last, the page with the highest
+ * offset of that object in a BRW, from the attributes @oa the OST returned.
+ */
+static struct cl_object *osc_brw_attr_update(const struct lu_env *env,
+					     struct ptlrpc_request *req,
+					     struct obdo *oa,
+					     struct osc_async_page *last)
+{
+	struct cl_object *obj = osc2cl(last->oap_obj);
+	struct cl_attr *attr = &osc_env_info(env)->oti_attr;
+	unsigned long valid = 0;
+
+	cl_object_attr_lock(obj);
+	if (oa->o_valid & OBD_MD_FLBLOCKS) {
+		attr->cat_blocks = oa->o_blocks;
+		valid |= CAT_BLOCKS;
+	}
+	if (oa->o_valid & OBD_MD_FLMTIME) {
+		attr->cat_mtime = oa->o_mtime;
+		valid |= CAT_MTIME;
+	}
+	if (oa->o_valid & OBD_MD_FLATIME) {
+		attr->cat_atime = oa->o_atime;
+		valid |= CAT_ATIME;
+	}
+	if (oa->o_valid & OBD_MD_FLCTIME) {
+		attr->cat_ctime = oa->o_ctime;
+		valid |= CAT_CTIME;
+	}
+
+	if (lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE) {
+		struct lov_oinfo *loi = cl2osc(obj)->oo_oinfo;
+		loff_t last_off = last->oap_count + last->oap_obj_off +
+			last->oap_page_off;
+
+		/* Change file size if this is an out of quota or
+		 * direct IO write and it extends the file size */
+		if (loi->loi_lvb.lvb_size < last_off) {
+			attr->cat_size = last_off;
+			valid |= CAT_SIZE;
+		}
+		/* Extend KMS if it's not a lockless write */
+		if (loi->loi_kms < last_off &&
+		    osc_cl_page_osc(oap2cl_page(last),
+				    last->oap_obj)->ops_srvlock == 0) {
+			attr->cat_kms = last_off;
+			valid |= CAT_KMS;
+		}
+	}
+
+	if (valid != 0)
+		cl_object_attr_update(env, obj, attr, valid);
+	cl_object_attr_unlock(obj);
+
+	return obj;
+}
+
 static int brw_interpret(const struct lu_env *env,
 			 struct ptlrpc_request *req, void *args, int rc)
 {
@@ -2511,8 +2987,10 @@ static int brw_interpret(const struct lu_env *env,
 	struct osc_extent *ext;
 	struct osc_extent *tmp;
 	struct client_obd *cli = aa->aa_cli;
+	struct osc_brw_objs *objs = aa->aa_objs;
 	unsigned long transferred = 0;
 	struct cl_object *obj = NULL;
+	int i;
 
 	ENTRY;
 
@@ -2521,6 +2999,8 @@ static int brw_interpret(const struct lu_env *env,
 
 	/* restore clear text pages */
 	osc_release_bounce_pages(aa->aa_ppga, aa->aa_page_count);
+	osc_compr_rpc_free(aa->aa_compr);
+	aa->aa_compr = NULL;
 
 	/*
 	 * When server returns -EINPROGRESS, client should always retry
@@ -2549,55 +3029,17 @@ static int brw_interpret(const struct lu_env *env,
 			rc = -EIO;
 	}
 
-	if (rc == 0) {
-		struct obdo *oa = aa->aa_oa;
-		struct cl_attr *attr = &osc_env_info(env)->oti_attr;
-		unsigned long valid = 0;
-		struct osc_async_page *last;
-
-		last = brw_page2oap(aa->aa_ppga[aa->aa_page_count - 1]);
-		obj = osc2cl(last->oap_obj);
-
-		cl_object_attr_lock(obj);
-		if (oa->o_valid & OBD_MD_FLBLOCKS) {
-			attr->cat_blocks = oa->o_blocks;
-			valid |= CAT_BLOCKS;
-		}
-		if (oa->o_valid & OBD_MD_FLMTIME) {
-			attr->cat_mtime = oa->o_mtime;
-			valid |= CAT_MTIME;
-		}
-		if (oa->o_valid & OBD_MD_FLATIME) {
-			attr->cat_atime = oa->o_atime;
-			valid |= CAT_ATIME;
-		}
-		if (oa->o_valid & OBD_MD_FLCTIME) {
-			attr->cat_ctime = oa->o_ctime;
-			valid |= CAT_CTIME;
-		}
-
-		if (lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE) {
-			struct lov_oinfo *loi = cl2osc(obj)->oo_oinfo;
-			loff_t last_off = last->oap_count + last->oap_obj_off +
-				last->oap_page_off;
-
-			/* Change file size if this is an out of quota or
-			 * direct IO write and it extends the file size */
-			if (loi->loi_lvb.lvb_size < last_off) {
-				attr->cat_size = last_off;
-				valid |= CAT_SIZE;
-			}
-			/* Extend KMS if it's not a lockless write */
-			if (loi->loi_kms < last_off &&
-			    oap2osc_page(last)->ops_srvlock == 0) {
-				attr->cat_kms = last_off;
-				valid |= CAT_KMS;
-			}
-		}
+	if (rc == 0 && objs != NULL) {
+		for (i = 0; i < objs->ob_count; i++) {
+			struct osc_brw_obj *ob = &objs->ob_objs[i];
 
-		if (valid != 0)
-			cl_object_attr_update(env, obj, attr, valid);
-		cl_object_attr_unlock(obj);
+			osc_brw_attr_update(env, req, &ob->obo_oa,
+				brw_page2oap(aa->aa_ppga[ob->obo_first +
+							 ob->obo_count - 1]));
+		}
+	} else if (rc == 0) {
+		obj = osc_brw_attr_update(env, req, aa->aa_oa,
+			brw_page2oap(aa->aa_ppga[aa->aa_page_count - 1]));
 	}
 	OBD_SLAB_FREE_PTR(aa->aa_oa, osc_obdo_kmem);
 	aa->aa_oa = NULL;
@@ -2609,9 +3051,17 @@ static int brw_interpret(const struct lu_env *env,
 		 * have already committed into the stable storage on OSTs
 		 * (i.e. Direct I/O).
 		 */
-		if (!req->rq_committed)
+		for (i = 0; !req->rq_committed && objs != NULL &&
+		     i < objs->ob_count; i++)
+			cl_object_dirty_for_sync(env,
+				cl_object_top(osc2cl(objs->ob_objs[i].obo_obj)));
+		if (!req->rq_committed && objs == NULL)
 			cl_object_dirty_for_sync(env, cl_object_top(obj));
 	}
+	if (objs != NULL) {
+		OBD_FREE_LARGE(objs, sizeof(*objs));
+		aa->aa_objs = NULL;
+	}
 
 	list_for_each_entry_safe(ext, tmp, &aa->aa_exts, oe_link) {
 		list_del_init(&ext->oe_link);
@@ -2629,6 +3079,8 @@ static int brw_interpret(const struct lu_env *env,
 	ptlrpc_lprocfs_brw(req, transferred);
 
 	spin_lock(&cli->cl_loi_list_lock);
+	if (rc == 0)
+		osc_rpc_tune_update(cli, req, transferred);
 	/* We need to decrement before osc_ap_completion->osc_wake_cache_waiters
 	 * is called so we know whether to go to sync BRWs or wait for more
 	 * RPCs to complete */
@@ -2661,6 +3113,63 @@ static void brw_commit(struct ptlrpc_request *req)
 	}
 }
 
+/* Number of PAGE_SIZE pages of @oap covered by its transfer */
+static inline unsigned int osc_oap_brw_count(struct osc_async_page *oap)
+{
+	return ((oap->oap_page_off + oap->oap_count - 1) >> PAGE_SHIFT) -
+	       (oap->oap_page_off >> PAGE_SHIFT) + 1;
+}
+
+/*
+ * Describe the transfer of @oap with one brw_page per PAGE_SIZE page, the
+ * tail pages of a large page get theirs from osc_page::ops_tails.
+ * Return the number of entries stored into @pga.
+ */
+static unsigned int osc_oap_brw_pages(struct osc_async_page *oap,
+				      struct brw_page **pga)
+{
+	struct osc_page *opg = oap2osc_page(oap);
+	unsigned int end = oap->oap_page_off + oap->oap_count;
+	unsigned int first = oap->oap_page_off >> PAGE_SHIFT;
+	unsigned int last = (end - 1) >> PAGE_SHIFT;
+	unsigned int i;
+
+	for (i = first; i <= last; i++) {
+		unsigned int from = i == first ?
+				    oap->oap_page_off & ~PAGE_MASK : 0;
+		unsigned int to = i == last ?
+				  ((end - 1) & ~PAGE_MASK) + 1 : PAGE_SIZE;
+		struct osc_async_page *sub = oap;
+
+		if (i > 0) {
+			struct osc_page_tail *tail = &opg->ops_tails[i - 1];
+
+			LASSERT(i < osc_page_nr(opg));
+			tail->opt_cl = opg->ops_cl;
+			sub = &tail->opt_oap;
+			INIT_LIST_HEAD(&sub->oap_pending_item);
+			INIT_LIST_HEAD(&sub->oap_rpc_item);
+			sub->oap_cmd = oap->oap_cmd;
+			sub->oap_async_flags = oap->oap_async_flags;
+			sub->oap_obj = oap->oap_obj;
+			sub->oap_obj_off = oap->oap_obj_off +
+					   ((loff_t)i << PAGE_SHIFT);
+			sub->oap_page_off = from;
+			sub->oap_count = to - from;
+			sub->oap_page = nth_page(oap->oap_page, i);
+			sub->oap_brw_flags = oap->oap_brw_flags;
+			sub->oap_brw_page.bp_off_diff = 0;
+			sub->oap_brw_page.bp_count_diff = 0;
+		}
+		sub->oap_brw_page.bp_off = oap->oap_obj_off +
+					   ((loff_t)i << PAGE_SHIFT) + from;
+		sub->oap_brw_page.bp_count = to - from;
+		*pga++ = &sub->oap_brw_page;
+	}
+
+	return last - first + 1;
+}
+
 /**
  * Build an RPC by the list of extent @ext_list. The caller must ensure
  * that the total pages in this list are NOT over max pages per RPC.
@@ -2676,6 +3185,9 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	struct obdo			*oa = NULL;
 	struct osc_async_page		*oap;
 	struct osc_object		*obj = NULL;
+	struct osc_object		*prev = NULL;
+	struct osc_brw_objs		*objs = NULL;
+	struct osc_brw_obj		*ob = NULL;
 	struct cl_req_attr		*crattr = NULL;
 	loff_t				starting_offset = OBD_OBJECT_EOF;
 	loff_t				ending_offset = 0;
@@ -2683,6 +3195,7 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	int mpflag = 1;
 	int				mem_tight = 0;
 	int				page_count = 0;
+	int				objcount = 1;
 	bool				soft_sync = false;
 	bool				ndelay = false;
 	int				i;
@@ -2699,11 +3212,23 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		LASSERT(ext->oe_state == OES_RPC);
 		mem_tight |= ext->oe_memalloc;
 		grant += ext->oe_grants;
-		page_count += ext->oe_nr_pages;
-		layout_version = max(layout_version, ext->oe_layout_version);
+		/* a large page is only sent for the part it has data in */
+		list_for_each_entry(oap, &ext->oe_pages, oap_pending_item)
+			page_count += osc_oap_brw_count(oap);
 		if (obj == NULL)
 			obj = ext->oe_obj;
+		/* the extents of each object of a multi-object write follow
+		 * each other, see osc_send_write_rpc()
+		 */
+		if (ext->oe_obj == obj)
+			layout_version = max(layout_version,
+					     ext->oe_layout_version);
+		else if (ext->oe_obj != prev)
+			objcount++;
+		prev = ext->oe_obj;
 	}
+	LASSERT(objcount == 1 || cmd == OBD_BRW_WRITE);
+	LASSERT(objcount <= PTLRPC_MAX_BRW_OBJS);
 
 	soft_sync = osc_over_unstable_soft_limit(cli);
 	if (mem_tight)
@@ -2717,16 +3242,40 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	if (oa == NULL)
 		GOTO(out, rc = -ENOMEM);
 
+	if (objcount > 1) {
+		OBD_ALLOC_LARGE(objs, sizeof(*objs));
+		if (objs == NULL)
+			GOTO(out, rc = -ENOMEM);
+	}
+
 	i = 0;
+	prev = NULL;
 	list_for_each_entry(ext, ext_list, oe_link) {
+		if (objs != NULL && ext->oe_obj != prev) {
+			ob = &objs->ob_objs[objs->ob_count++];
+			ob->obo_obj = ext->oe_obj;
+			ob->obo_page = oap2cl_page(list_first_entry(
+						&ext->oe_pages,
+						struct osc_async_page,
+						oap_pending_item));
+			ob->obo_first = i;
+			/* the offsets are those of each object */
+			starting_offset = OBD_OBJECT_EOF;
+			ending_offset = 0;
+			prev = ext->oe_obj;
+		}
+		if (ob != NULL && ext->oe_layout_version > 0) {
+			ob->obo_oa.o_layout_version =
+				max(ob->obo_oa.o_layout_version,
+				    ext->oe_layout_version);
+			ob->obo_oa.o_valid |= OBD_MD_LAYOUT_VERSION;
+		}
 		list_for_each_entry(oap, &ext->oe_pages, oap_pending_item) {
 			if (mem_tight)
 				oap->oap_brw_flags |= OBD_BRW_MEMALLOC;
 			if (soft_sync)
 				oap->oap_brw_flags |= OBD_BRW_SOFT_SYNC;
-			pga[i] = &oap->oap_brw_page;
-			pga[i]->bp_off = oap->oap_obj_off + oap->oap_page_off;
-			i++;
+			i += osc_oap_brw_pages(oap, pga + i);
 
 			list_add_tail(&oap->oap_rpc_item, &rpc_list);
 			if (starting_offset == OBD_OBJECT_EOF ||
@@ -2742,12 +3291,15 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 						oap->oap_count;
 			} else {
 				LASSERT(oap->oap_page_off + oap->oap_count ==
-					PAGE_SIZE);
+					osc_page_nr(oap2osc(oap)) << PAGE_SHIFT);
 			}
 		}
 		if (ext->oe_ndelay)
 			ndelay = true;
+		if (ob != NULL)
+			ob->obo_count = i - ob->obo_first;
 	}
+	LASSERT(i == page_count);
 
 	/* first page in the list */
 	oap = list_first_entry(&rpc_list, typeof(*oap), oap_rpc_item);
@@ -2771,8 +3323,24 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		}
 	}
 
-	sort_brw_pages(pga, page_count);
-	rc = osc_brw_prep_request(cmd, cli, oa, page_count, pga, &req, 0);
+	if (objs != NULL) {
+		/* object 0 is the one of the request body */
+		objs->ob_objs[0].obo_oa = *oa;
+		for (i = 1; i < objs->ob_count; i++) {
+			ob = &objs->ob_objs[i];
+			crattr->cra_flags = ~0ULL;
+			crattr->cra_page = ob->obo_page;
+			crattr->cra_oa = &ob->obo_oa;
+			cl_req_attr_set(env, osc2cl(ob->obo_obj), crattr);
+		}
+		for (i = 0; i < objs->ob_count; i++)
+			sort_brw_pages(pga + objs->ob_objs[i].obo_first,
+				       objs->ob_objs[i].obo_count);
+	} else {
+		sort_brw_pages(pga, page_count);
+	}
+	rc = osc_brw_prep_request(cmd, cli, oa, page_count, pga, objs, &req,
+				  0);
 	if (rc != 0) {
 		CERROR("prep_req failed: %d\n", rc);
 		GOTO(out, rc);
@@ -2794,6 +3362,18 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	 * later setattr before earlier BRW (as determined by the request xid),
 	 * the OST will not use BRW timestamps.  Sadly, there is no obvious
 	 * way to do this in a single call.  bug 10150 */
+	if (objs != NULL) {
+		body = req_capsule_client_get(&req->rq_pill, &RMF_IOOBJ_BODY);
+		crattr->cra_flags = OBD_MD_FLMTIME | OBD_MD_FLCTIME |
+				    OBD_MD_FLATIME;
+		for (i = 0; i < objs->ob_count; i++) {
+			crattr->cra_page = objs->ob_objs[i].obo_page;
+			crattr->cra_oa = &body[i].oa;
+			cl_req_attr_set(env, osc2cl(objs->ob_objs[i].obo_obj),
+					crattr);
+		}
+		crattr->cra_page = oap2cl_page(oap);
+	}
 	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
 	crattr->cra_oa = &body->oa;
 	crattr->cra_flags = OBD_MD_FLMTIME | OBD_MD_FLCTIME | OBD_MD_FLATIME;
@@ -2819,6 +3399,13 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 				      starting_offset + 1);
 	} else {
 		cli->cl_w_in_flight++;
+		if (objs != NULL) {
+			struct osc_stats *stats =
+				&obd2osc_dev(cli->cl_import->imp_obd)->osc_stats;
+
+			stats->os_multi_obj_writes++;
+			stats->os_multi_obj_objs += objs->ob_count;
+		}
 		lprocfs_oh_tally_log2(&cli->cl_write_page_hist, page_count);
 		lprocfs_oh_tally(&cli->cl_write_rpc_hist, cli->cl_w_in_flight);
 		lprocfs_oh_tally_log2(&cli->cl_write_offset_hist,
@@ -2855,6 +3442,8 @@ out:
 
 		if (oa)
 			OBD_SLAB_FREE_PTR(oa, osc_obdo_kmem);
+		if (objs)
+			OBD_FREE_LARGE(objs, sizeof(*objs));
 		if (pga) {
 			osc_release_bounce_pages(pga, page_count);
 			osc_release_ppga(pga, page_count);
@@ -2888,7 +3477,7 @@ void osc_send_empty_rpc(struct osc_object *osc, pgoff_t start)
 	oa.o_flags = OBD_FL_NORPC;
 
 	rc = osc_brw_prep_request(OBD_BRW_READ, osc_cli(osc), &oa, 1, &pga,
-				  &req, 0);
+				  NULL, &req, 0);
 
 	/* If we succeeded we ship it off, if not there's no point in doing
 	 * anything. Also no resends.
@@ -3518,6 +4107,26 @@ int osc_set_info_async(const struct lu_env *env, struct obd_export *exp,
 }
 EXPORT_SYMBOL(osc_set_info_async);
 
+static int osc_get_info(const struct lu_env *env, struct obd_export *exp,
+			u32 keylen, void *key, u32 *vallen, void *val)
+{
+	struct client_obd *cli = &exp->exp_obd->u.cli;
+
+	ENTRY;
+
+	if (KEY_IS(KEY_CHECKSUM_TYPE)) {
+		if (*vallen < sizeof(enum cksum_types))
+			RETURN(-EOVERFLOW);
+		/* 0 when bulk writes are sent without checksum */
+		*(enum cksum_types *)val = cli->cl_checksum ?
+					   cli->cl_cksum_type : 0;
+		*vallen = sizeof(enum cksum_types);
+		RETURN(0);
+	}
+
+	RETURN(-EINVAL);
+}
+
 int osc_reconnect(const struct lu_env *env, struct obd_export *exp,
 		  struct obd_device *obd, struct obd_uuid *cluuid,
 		  struct obd_connect_data *data, void *localdata)
@@ -3577,11 +4186,9 @@ int osc_disconnect(struct obd_export *exp)
 }
 EXPORT_SYMBOL(osc_disconnect);
 
-int osc_ldlm_resource_invalidate(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				 struct hlist_node *hnode, void *arg)
+int osc_ldlm_resource_invalidate(struct ldlm_resource *res, void *arg)
 {
 	struct lu_env *env = arg;
-	struct ldlm_resource *res = cfs_hash_object(hs, hnode);
 	struct ldlm_lock *lock;
 	struct osc_object *osc = NULL;
 	ENTRY;
@@ -3645,9 +4252,9 @@ static int osc_import_event(struct obd_device *obd, struct obd_import *imp,
 		if (!IS_ERR(env)) {
 			osc_io_unplug(env, &obd->u.cli, NULL);
 
-			cfs_hash_for_each_nolock(ns->ns_rs_hash,
-						 osc_ldlm_resource_invalidate,
-						 env, 0);
+			ldlm_namespace_res_foreach(ns,
+						   osc_ldlm_resource_invalidate,
+						   env);
 			cl_env_put(env, &refcheck);
 
 			ldlm_namespace_cleanup(ns, LDLM_FL_LOCAL_ONLY);
@@ -3753,6 +4360,8 @@ int osc_setup_common(struct obd_device *obd, struct lustre_cfg *lcfg)
 
 	cli->cl_grant_shrink_interval = GRANT_SHRINK_INTERVAL;
 	cli->cl_root_squash = 0;
+	cli->cl_rpc_tune.crt_min_rpcs = 1;
+	cli->cl_rpc_tune.crt_min_pages = ONE_MB_BRW_SIZE >> PAGE_SHIFT;
 	osc_update_next_shrink(cli);
 
 	RETURN(rc);
@@ -3907,6 +4516,7 @@ static const struct obd_ops osc_obd_ops = {
         .o_setattr              = osc_setattr,
         .o_iocontrol            = osc_iocontrol,
         .o_set_info_async       = osc_set_info_async,
+        .o_get_info             = osc_get_info,
         .o_import_event         = osc_import_event,
         .o_quotactl             = osc_quotactl,
 };
@@ -662,7 +662,8 @@ static const struct req_msg_field *ost_brw_client[] = {
 	&RMF_OBD_IOOBJ,
 	&RMF_NIOBUF_REMOTE,
 	&RMF_CAPA1,
-	&RMF_SHORT_IO
+	&RMF_SHORT_IO,
+	&RMF_IOOBJ_BODY
 };
 
 static const struct req_msg_field *ost_brw_read_server[] = {
@@ -674,7 +675,8 @@ static const struct req_msg_field *ost_brw_read_server[] = {
 static const struct req_msg_field *ost_brw_write_server[] = {
 	&RMF_PTLRPC_BODY,
 	&RMF_OST_BODY,
-	&RMF_RCS
+	&RMF_RCS,
+	&RMF_IOOBJ_BODY
 };
 
 static const struct req_msg_field *ost_get_info_generic_server[] = {
@@ -1219,6 +1221,13 @@ struct req_msg_field RMF_OBD_IOOBJ =
 		    sizeof(struct obd_ioobj), lustre_swab_obd_ioobj, dump_ioo);
 EXPORT_SYMBOL(RMF_OBD_IOOBJ);
 
+/* attributes of each object of a multi-object OST_WRITE */
+struct req_msg_field RMF_IOOBJ_BODY =
+	DEFINE_MSGF("ioobj_body", RMF_F_STRUCT_ARRAY,
+		    sizeof(struct ost_body), lustre_swab_ost_body,
+		    dump_ost_body);
+EXPORT_SYMBOL(RMF_IOOBJ_BODY);
+
 struct req_msg_field RMF_NIOBUF_REMOTE =
 	DEFINE_MSGF("niobuf_remote", RMF_F_STRUCT_ARRAY,
 		    sizeof(struct niobuf_remote), lustre_swab_niobuf_remote,
@@ -182,12 +182,80 @@ out:
 }
 EXPORT_SYMBOL(tgt_validate_obdo);
 
+/*
+ * Check the per-object bodies of a multi-object OST_WRITE and fill the
+ * object IDs of @ioo from them, the first one must be the object of the
+ * ost_body of the request.
+ */
+static int tgt_ioobj_body_unpack(struct tgt_session_info *tsi,
+				 struct obd_ioobj *ioo, int obj_count)
+{
+	struct req_capsule	*pill = tsi->tsi_pill;
+	struct ost_body		*bodies;
+	struct lu_nodemap	*nodemap;
+	int			 rc = 0;
+	int			 i;
+
+	ENTRY;
+
+	if (!exp_connect_multi_obj_brw(tsi->tsi_exp) ||
+	    lustre_msg_get_opc(tgt_ses_req(tsi)->rq_reqmsg) != OST_WRITE ||
+	    obj_count > PTLRPC_MAX_BRW_OBJS) {
+		CERROR("%s: too many ioobjs (%d)\n", tgt_name(tsi->tsi_tgt),
+		       obj_count);
+		RETURN(-EPROTO);
+	}
+
+	if (req_capsule_get_size(pill, &RMF_IOOBJ_BODY, RCL_CLIENT) !=
+	    obj_count * sizeof(*bodies)) {
+		CERROR("%s: %d ioobjs without their bodies\n",
+		       tgt_name(tsi->tsi_tgt), obj_count);
+		RETURN(-EPROTO);
+	}
+
+	bodies = req_capsule_client_get(pill, &RMF_IOOBJ_BODY);
+	if (bodies == NULL)
+		RETURN(-EPROTO);
+
+	nodemap = nodemap_get_from_exp(tsi->tsi_exp);
+	if (IS_ERR(nodemap))
+		RETURN(PTR_ERR(nodemap));
+
+	for (i = 0; i < obj_count; i++) {
+		struct obdo *oa = &bodies[i].oa;
+
+		if (!(oa->o_valid & OBD_MD_FLID))
+			GOTO(out, rc = -EPROTO);
+
+		rc = tgt_validate_obdo(tsi, oa);
+		if (rc)
+			GOTO(out, rc);
+
+		oa->o_uid = nodemap_map_id(nodemap, NODEMAP_UID,
+					   NODEMAP_CLIENT_TO_FS, oa->o_uid);
+		oa->o_gid = nodemap_map_id(nodemap, NODEMAP_GID,
+					   NODEMAP_CLIENT_TO_FS, oa->o_gid);
+		oa->o_projid = nodemap_map_id(nodemap, NODEMAP_PROJID,
+					      NODEMAP_CLIENT_TO_FS,
+					      oa->o_projid);
+		ioo[i].ioo_oid = oa->o_oi;
+	}
+
+	if (!lu_fid_eq(&bodies[0].oa.o_oi.oi_fid, &tsi->tsi_fid))
+		rc = -EPROTO;
+out:
+	nodemap_putref(nodemap);
+	RETURN(rc);
+}
+
 static int tgt_io_data_unpack(struct tgt_session_info *tsi, struct ost_id *oi)
 {
 	unsigned		 max_brw;
 	struct niobuf_remote	*rnb;
 	struct obd_ioobj	*ioo;
 	int			 obj_count;
+	int			 rc;
+	int			 i;
 
 	ENTRY;
 
@@ -215,21 +283,24 @@ static int tgt_io_data_unpack(struct tgt_session_info *tsi, struct ost_id *oi)
 		CERROR("%s: short ioobj\n", tgt_name(tsi->tsi_tgt));
 		RETURN(-EPROTO);
 	} else if (obj_count > 1) {
-		CERROR("%s: too many ioobjs (%d)\n", tgt_name(tsi->tsi_tgt),
-		       obj_count);
-		RETURN(-EPROTO);
+		rc = tgt_ioobj_body_unpack(tsi, ioo, obj_count);
+		if (rc)
+			RETURN(rc);
 	}
 
-	if (ioo->ioo_bufcnt == 0) {
-		CERROR("%s: ioo has zero bufcnt\n", tgt_name(tsi->tsi_tgt));
-		RETURN(-EPROTO);
-	}
+	for (i = 0; i < obj_count; i++) {
+		if (ioo[i].ioo_bufcnt == 0) {
+			CERROR("%s: ioo has zero bufcnt\n",
+			       tgt_name(tsi->tsi_tgt));
+			RETURN(-EPROTO);
+		}
 
-	if (ioo->ioo_bufcnt > PTLRPC_MAX_BRW_PAGES) {
-		DEBUG_REQ(D_RPCTRACE, tgt_ses_req(tsi),
-			  "bulk has too many pages (%d)",
-			  ioo->ioo_bufcnt);
-		RETURN(-EPROTO);
+		if (ioo[i].ioo_bufcnt > PTLRPC_MAX_BRW_PAGES) {
+			DEBUG_REQ(D_RPCTRACE, tgt_ses_req(tsi),
+				  "bulk has too many pages (%d)",
+				  ioo[i].ioo_bufcnt);
+			RETURN(-EPROTO);
+		}
 	}
 
 	RETURN(0);
@@ -1829,25 +1900,58 @@ static void tgt_brw_unlock(struct obd_export *exp, struct obd_ioobj *obj,
 	EXIT;
 }
 
+/* state of one bulk checksum, through the shash or the CRC32C engine */
+struct tgt_cksum_state {
+	struct ahash_request	*tcs_req;	/* NULL for the engine */
+	struct cfs_crypto_mb_buf tcs_bufs[CFS_CRYPTO_MB_BATCH];
+	int			 tcs_nr;
+	u32			 tcs_crc;
+};
+
+static void tgt_checksum_page(struct tgt_cksum_state *tcs, struct page *page,
+			      unsigned int off, unsigned int len)
+{
+	if (tcs->tcs_req) {
+		cfs_crypto_hash_update_page(tcs->tcs_req, page, off, len);
+		return;
+	}
+
+	tcs->tcs_bufs[tcs->tcs_nr].cmb_page = page;
+	tcs->tcs_bufs[tcs->tcs_nr].cmb_offset = off;
+	tcs->tcs_bufs[tcs->tcs_nr].cmb_len = len;
+	if (++tcs->tcs_nr == CFS_CRYPTO_MB_BATCH) {
+		cfs_crypto_crc32c_mb(&tcs->tcs_crc, tcs->tcs_bufs, tcs->tcs_nr);
+		tcs->tcs_nr = 0;
+	}
+}
+
 static int tgt_checksum_niobuf(struct lu_target *tgt,
 				 struct niobuf_local *local_nb, int npages,
 				 int opc, enum cksum_types cksum_type,
 				 __u32 *cksum)
 {
-	struct ahash_request	       *req;
+	struct tgt_cksum_state		tcs = { NULL };
 	unsigned int			bufsize;
 	int				i, err;
 	unsigned char			cfs_alg = cksum_obd2cfs(cksum_type);
 
-	req = cfs_crypto_hash_init(cfs_alg, NULL, 0);
-	if (IS_ERR(req)) {
-		CERROR("%s: unable to initialize checksum hash %s\n",
-		       tgt_name(tgt), cfs_crypto_hash_name(cfs_alg));
-		return PTR_ERR(req);
+	/* CRC32C pages are checksummed several at a time in parallel */
+	if (cfs_alg != CFS_HASH_ALG_CRC32C ||
+	    !cfs_crypto_crc32c_mb_enabled()) {
+		tcs.tcs_req = cfs_crypto_hash_init(cfs_alg, NULL, 0);
+		if (IS_ERR(tcs.tcs_req)) {
+			CERROR("%s: unable to initialize checksum hash %s\n",
+			       tgt_name(tgt), cfs_crypto_hash_name(cfs_alg));
+			return PTR_ERR(tcs.tcs_req);
+		}
 	}
 
 	CDEBUG(D_INFO, "Checksum for algo %s\n", cfs_crypto_hash_name(cfs_alg));
 	for (i = 0; i < npages; i++) {
+		/* not in the bulk, so not in the checksum either */
+		if (local_nb[i].lnb_flags & OBD_BRW_ZERO)
+			continue;
+
 		/* corrupt the data before we compute the checksum, to
 		 * simulate a client->OST data error */
 		if (i == 0 && opc == OST_WRITE &&
@@ -1868,15 +1972,14 @@ static int tgt_checksum_niobuf(struct lu_target *tgt,
 				 * display in dump_all_bulk_pages() */
 				np->index = i;
 
-				cfs_crypto_hash_update_page(req, np, off,
-							    len);
+				tgt_checksum_page(&tcs, np, off, len);
 				continue;
 			} else {
 				CERROR("%s: can't alloc page for corruption\n",
 				       tgt_name(tgt));
 			}
 		}
-		cfs_crypto_hash_update_page(req, local_nb[i].lnb_page,
+		tgt_checksum_page(&tcs, local_nb[i].lnb_page,
 				  local_nb[i].lnb_page_offset & ~PAGE_MASK,
 				  local_nb[i].lnb_len);
 
@@ -1900,8 +2003,7 @@ static int tgt_checksum_niobuf(struct lu_target *tgt,
 				 * display in dump_all_bulk_pages() */
 				np->index = i;
 
-				cfs_crypto_hash_update_page(req, np, off,
-							    len);
+				tgt_checksum_page(&tcs, np, off, len);
 				continue;
 			} else {
 				CERROR("%s: can't alloc page for corruption\n",
@@ -1910,8 +2012,18 @@ static int tgt_checksum_niobuf(struct lu_target *tgt,
 		}
 	}
 
+	if (!tcs.tcs_req) {
+		if (tcs.tcs_nr > 0)
+			cfs_crypto_crc32c_mb(&tcs.tcs_crc, tcs.tcs_bufs,
+					     tcs.tcs_nr);
+		/* same byte order as the "crc32c" shash digest */
+		*cksum = (__force u32)cpu_to_le32(tcs.tcs_crc);
+		return 0;
+	}
+
 	bufsize = sizeof(*cksum);
-	err = cfs_crypto_hash_final(req, (unsigned char *)cksum, &bufsize);
+	err = cfs_crypto_hash_final(tcs.tcs_req, (unsigned char *)cksum,
+				    &bufsize);
 
 	return 0;
 }
@@ -2101,6 +2213,10 @@ static int tgt_checksum_niobuf_t10pi(struct lu_target *tgt,
 		int guards_needed = DIV_ROUND_UP(off + len, sector_size) -
 					(off / sector_size);
 
+		/* not in the bulk, so not in the checksum either */
+		if (local_nb[i].lnb_flags & OBD_BRW_ZERO)
+			continue;
+
 		if (guards_needed > guard_number - used_number) {
 			cfs_crypto_hash_update_page(req, __page, 0,
 				used_number * sizeof(*guard_start));
@@ -2297,6 +2413,34 @@ static int tgt_checksum_niobuf_rw(struct lu_target *tgt,
 	RETURN(rc);
 }
 
+/*
+ * OBD_BRW_ZERO ranges are left out of the bulk and zero filled by
+ * ofd_preprw_write(), so the flag is only taken for writes to an OST from
+ * clients which negotiated OBD_CONNECT2_ZERO_WRITE. The MDT would write
+ * whatever its DoM pages held.
+ */
+static int tgt_brw_zero_check(struct ptlrpc_request *req, int opc,
+			      struct niobuf_remote *rnb, int niocount)
+{
+	int i;
+
+	for (i = 0; i < niocount; i++) {
+		if (!(rnb[i].rnb_flags & OBD_BRW_ZERO))
+			continue;
+		if (opc == OST_WRITE && exp_connect_zero_write(req->rq_export) &&
+		    ptlrpc_req2svc(req)->srv_req_portal == OST_IO_PORTAL)
+			return 0;
+
+		CERROR("%s: unexpected zero range in %s from %s: rc = %d\n",
+		       req->rq_export->exp_obd->obd_name,
+		       opc == OST_WRITE ? "write" : "read",
+		       obd_export_nid2str(req->rq_export), -EPROTO);
+		return -EPROTO;
+	}
+
+	return 0;
+}
+
 int tgt_brw_read(struct tgt_session_info *tsi)
 {
 	struct ptlrpc_request	*req = tgt_ses_req(tsi);
@@ -2365,6 +2509,10 @@ int tgt_brw_read(struct tgt_session_info *tsi)
 	remote_nb = req_capsule_client_get(&req->rq_pill, &RMF_NIOBUF_REMOTE);
 	LASSERT(remote_nb != NULL); /* must exists after tgt_ost_body_unpack */
 
+	rc = tgt_brw_zero_check(req, OST_READ, remote_nb, ioo->ioo_bufcnt);
+	if (rc != 0)
+		RETURN(err_serious(rc));
+
 	local_nb = tbc->local;
 
 	rc = tgt_brw_lock(tsi->tsi_env, exp, &tsi->tsi_resid, ioo, remote_nb,
@@ -2740,12 +2888,22 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 			sizeof(*remote_nb))
 		RETURN(err_serious(-EPROTO));
 
+	rc = tgt_brw_zero_check(req, OST_WRITE, remote_nb, niocount);
+	if (rc != 0)
+		RETURN(err_serious(rc));
+
+	/* only the first object could be locked for a lockless write */
+	if (objcount > 1 && remote_nb[0].rnb_flags & OBD_BRW_SRVLOCK)
+		RETURN(err_serious(-EPROTO));
+
 	if ((remote_nb[0].rnb_flags & OBD_BRW_MEMALLOC) &&
 	    ptlrpc_connection_is_local(exp->exp_connection))
 		mpflags = memalloc_noreclaim_save();
 
 	req_capsule_set_size(&req->rq_pill, &RMF_RCS, RCL_SERVER,
 			     niocount * sizeof(*rcs));
+	req_capsule_set_size(&req->rq_pill, &RMF_IOOBJ_BODY, RCL_SERVER,
+			     objcount > 1 ? objcount * sizeof(*body) : 0);
 	rc = req_capsule_server_pack(&req->rq_pill);
 	if (rc != 0)
 		GOTO(out, rc = err_serious(rc));
@@ -2788,6 +2946,19 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 		GOTO(out_lock, rc = -ENOMEM);
 	repbody->oa = body->oa;
 
+	/* the OFD takes the attributes of each object from the reply bodies
+	 * and returns the new ones there
+	 */
+	if (objcount > 1) {
+		tsi->tsi_ioobj_bodies = req_capsule_server_get(&req->rq_pill,
+							       &RMF_IOOBJ_BODY);
+		if (tsi->tsi_ioobj_bodies == NULL)
+			GOTO(out_lock, rc = -ENOMEM);
+		memcpy(tsi->tsi_ioobj_bodies,
+		       req_capsule_client_get(&req->rq_pill, &RMF_IOOBJ_BODY),
+		       objcount * sizeof(*body));
+	}
+
 	npages = PTLRPC_MAX_BRW_PAGES;
 	kstart = ktime_get();
 	rc = obd_preprw(tsi->tsi_env, OBD_BRW_WRITE, exp, &repbody->oa,
@@ -2820,11 +2991,15 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 			GOTO(skip_transfer, rc = -ENOMEM);
 
 		/* NB Having prepped, we must commit... */
-		for (i = 0; i < npages; i++)
+		for (i = 0; i < npages; i++) {
+			/* zero filled by obd_preprw(), see OBD_BRW_ZERO */
+			if (local_nb[i].lnb_flags & OBD_BRW_ZERO)
+				continue;
 			desc->bd_frag_ops->add_kiov_frag(desc,
 					local_nb[i].lnb_page,
 					local_nb[i].lnb_page_offset & ~PAGE_MASK,
 					local_nb[i].lnb_len);
+		}
 
 		rc = sptlrpc_svc_prep_bulk(req, desc);
 		if (rc != 0)
@@ -2910,6 +3085,11 @@ out_commitrw:
 	 * otherwise it will have to glimpse anyway (see bug 21489, comment 32)
 	 */
 	repbody->oa.o_valid &= ~(OBD_MD_FLMTIME | OBD_MD_FLATIME);
+	if (objcount > 1) {
+		for (i = 0; i < objcount; i++)
+			tsi->tsi_ioobj_bodies[i].oa.o_valid &=
+				~(OBD_MD_FLMTIME | OBD_MD_FLATIME);
+	}
 
 	if (rc == 0) {
 		/* set per-requested niobuf return codes */
@@ -2917,6 +3097,13 @@ out_commitrw:
 			int len = remote_nb[i].rnb_len;
 
 			rcs[i] = 0;
+			/* zero ranges past EOF have no local buffers */
+			if (j == npages ||
+			    local_nb[j].lnb_file_offset !=
+			    remote_nb[i].rnb_offset) {
+				LASSERT(remote_nb[i].rnb_flags & OBD_BRW_ZERO);
+				continue;
+			}
 			do {
 				LASSERT(j < npages);
 				if (local_nb[j].lnb_rc < 0)
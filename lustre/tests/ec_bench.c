@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/tests/ec_bench.c
+ *
+ * Userspace benchmark for the lustre/ec erasure code library.  For every
+ * combination of k+m geometry, fragment size and erasure count it encodes
+ * and rebuilds stripes of random data, checks the rebuilt fragments and
+ * prints throughput and per-stripe latency.  The cost of refreshing parity
+ * after rewriting one data fragment with ec_encode_data_update() is
+ * reported as well.
+ *
+ * The library sources are built into this program directly, see
+ * lustre/ec/ec_internal.h.  Only integer arithmetic is used here because
+ * on x86_64 the vector kernels are built with -mgeneral-regs-only.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "erasure_code.h"
+
+#define EC_BENCH_MAX_LIST	16
+
+struct ec_geometry {
+	int	eg_k;
+	int	eg_m;
+};
+
+static void usage(const char *prog)
+{
+	printf("usage: %s [-g k+m[,k+m...]] [-s size[,size...]] [-e erasures] [-t msec]\n",
+	       prog);
+	printf("\t-g\tstripe geometries (default 4+2,8+2,8+3,10+4,16+4)\n"
+	       "\t-s\tfragment sizes, k/m suffix allowed (default 4k,64k,1m)\n"
+	       "\t-e\tlargest erasure count to test (default m)\n"
+	       "\t-t\ttime spent on each measurement (default 200)\n");
+
+	exit(EXIT_FAILURE);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* data throughput in MB/s for \a bytes processed in \a ns */
+static uint64_t mb_per_sec(uint64_t bytes, uint64_t ns)
+{
+	return ns ? (bytes / 1024) * 1000000000ULL / ns / 1024 : 0;
+}
+
+static int parse_geometry(char *arg, struct ec_geometry *geom)
+{
+	char *tok;
+	int n = 0;
+
+	for (tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+		if (n == EC_BENCH_MAX_LIST ||
+		    sscanf(tok, "%d+%d", &geom[n].eg_k, &geom[n].eg_m) != 2 ||
+		    geom[n].eg_k <= 0 || geom[n].eg_m <= 0 ||
+		    geom[n].eg_k + geom[n].eg_m > EC_MAX_FRAGS) {
+			fprintf(stderr, "invalid geometry '%s'\n", tok);
+			return -EINVAL;
+		}
+		n++;
+	}
+
+	return n;
+}
+
+static int parse_sizes(char *arg, int *sizes)
+{
+	unsigned long size;
+	char *tok;
+	char *end;
+	int n = 0;
+
+	for (tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+		size = strtoul(tok, &end, 0);
+		if (*end == 'k' || *end == 'K')
+			size <<= 10, end++;
+		else if (*end == 'm' || *end == 'M')
+			size <<= 20, end++;
+		if (n == EC_BENCH_MAX_LIST || *end != '\0' || size == 0 ||
+		    size > (1UL << 30)) {
+			fprintf(stderr, "invalid fragment size '%s'\n", tok);
+			return -EINVAL;
+		}
+		sizes[n++] = size;
+	}
+
+	return n;
+}
+
+/*
+ * Encode one stripe repeatedly for \a msec and report the result, then
+ * rebuild 1..\a max_err erased data fragments the same way.  The first
+ * decode of a pattern is timed separately since it includes the matrix
+ * inversion, later ones hit the decode table cache.  Finally apply the
+ * delta of a rewritten first fragment to the parity.
+ */
+static int bench_one(const struct ec_geometry *geom, int len, int max_err,
+		     int msec)
+{
+	int k = geom->eg_k;
+	int m = geom->eg_m;
+	int nfrags = k + m;
+	unsigned char err_list[EC_MAX_FRAGS];
+	unsigned char *frags[EC_MAX_FRAGS];
+	unsigned char *saved[EC_MAX_FRAGS];
+	unsigned char *matrix;
+	unsigned char *tbls;
+	unsigned char *delta;
+	unsigned char *mem;
+	struct ec_decoder *dec;
+	uint64_t deadline;
+	uint64_t start;
+	uint64_t cold;
+	uint64_t ns;
+	long count;
+	int nerrs;
+	int rc = 0;
+	int i;
+
+	mem = malloc((size_t)(2 * nfrags + 1) * len);
+	matrix = malloc(nfrags * k);
+	tbls = malloc(32 * k * m);
+	if (!mem || !matrix || !tbls) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < nfrags; i++) {
+		frags[i] = mem + (size_t)i * len;
+		saved[i] = mem + (size_t)(nfrags + i) * len;
+	}
+	delta = mem + (size_t)2 * nfrags * len;
+	for (i = 0; i < k * len; i++)
+		mem[i] = random();
+
+	gf_gen_cauchy1_matrix(matrix, nfrags, k);
+	ec_init_tables(k, m, &matrix[k * k], tbls);
+
+	count = 0;
+	start = now_ns();
+	deadline = start + msec * 1000000ULL;
+	do {
+		ec_encode_data(len, k, m, tbls, frags, frags + k);
+		count++;
+	} while (now_ns() < deadline);
+	ns = now_ns() - start;
+	printf("%3d+%-3d %8d %8s %7s %8llu %12llu %12s\n", k, m, len, "-",
+	       "encode", (unsigned long long)mb_per_sec(count * k * len, ns),
+	       (unsigned long long)(ns / count), "-");
+	for (i = 0; i < nfrags; i++)
+		memcpy(saved[i], frags[i], len);
+
+	dec = ec_decoder_create(k, m, matrix);
+	if (!dec) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (nerrs = 1; nerrs <= max_err && nerrs <= m; nerrs++) {
+		/* losing data fragments is the expensive case */
+		for (i = 0; i < nerrs; i++) {
+			err_list[i] = i;
+			memset(frags[i], 0, len);
+		}
+
+		start = now_ns();
+		rc = ec_decode_data(dec, len, err_list, nerrs, frags);
+		cold = now_ns() - start;
+		if (rc) {
+			fprintf(stderr, "%d+%d: decode of %d erasures failed: rc = %d\n",
+				k, m, nerrs, rc);
+			break;
+		}
+		for (i = 0; i < nerrs; i++) {
+			if (memcmp(frags[i], saved[i], len) != 0) {
+				fprintf(stderr, "%d+%d: fragment %d rebuilt incorrectly\n",
+					k, m, i);
+				rc = -EIO;
+				goto out_dec;
+			}
+		}
+
+		count = 0;
+		start = now_ns();
+		deadline = start + msec * 1000000ULL;
+		do {
+			ec_decode_data(dec, len, err_list, nerrs, frags);
+			count++;
+		} while (now_ns() < deadline);
+		ns = now_ns() - start;
+		printf("%3d+%-3d %8d %8d %7s %8llu %12llu %12llu\n", k, m, len,
+		       nerrs, "decode",
+		       (unsigned long long)mb_per_sec(count * k * len, ns),
+		       (unsigned long long)(ns / count),
+		       (unsigned long long)cold);
+	}
+	if (rc)
+		goto out_dec;
+
+	/* rewrite fragment 0 and patch the parity with the delta only */
+	for (i = 0; i < len; i++) {
+		delta[i] = random();
+		frags[0][i] ^= delta[i];
+	}
+	ec_encode_data_update(len, k, m, 0, tbls, delta, frags + k);
+	ec_encode_data(len, k, m, tbls, frags, saved + k);
+	for (i = k; i < nfrags; i++) {
+		if (memcmp(frags[i], saved[i], len) != 0) {
+			fprintf(stderr, "%d+%d: parity %d updated incorrectly\n",
+				k, m, i);
+			rc = -EIO;
+			goto out_dec;
+		}
+	}
+
+	count = 0;
+	start = now_ns();
+	deadline = start + msec * 1000000ULL;
+	do {
+		ec_encode_data_update(len, k, m, 0, tbls, delta, frags + k);
+		count++;
+	} while (now_ns() < deadline);
+	ns = now_ns() - start;
+	printf("%3d+%-3d %8d %8s %7s %8llu %12llu %12s\n", k, m, len, "-",
+	       "update", (unsigned long long)mb_per_sec(count * len, ns),
+	       (unsigned long long)(ns / count), "-");
+out_dec:
+	ec_decoder_destroy(dec);
+out:
+	free(tbls);
+	free(matrix);
+	free(mem);
+
+	return rc;
+}
+
+int main(int argc, char **argv)
+{
+	char default_geom[] = "4+2,8+2,8+3,10+4,16+4";
+	char default_sizes[] = "4k,64k,1m";
+	struct ec_geometry geom[EC_BENCH_MAX_LIST];
+	int sizes[EC_BENCH_MAX_LIST];
+	char *geom_arg = default_geom;
+	char *sizes_arg = default_sizes;
+	int max_err = EC_MAX_FRAGS;
+	int msec = 200;
+	int ngeom;
+	int nsizes;
+	int rc = 0;
+	int c;
+	int g;
+	int s;
+
+	while ((c = getopt(argc, argv, "e:g:hs:t:")) != -1) {
+		switch (c) {
+		case 'e':
+			max_err = atoi(optarg);
+			if (max_err <= 0)
+				usage(argv[0]);
+			break;
+		case 'g':
+			geom_arg = optarg;
+			break;
+		case 's':
+			sizes_arg = optarg;
+			break;
+		case 't':
+			msec = atoi(optarg);
+			if (msec <= 0)
+				usage(argv[0]);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	ngeom = parse_geometry(geom_arg, geom);
+	nsizes = parse_sizes(sizes_arg, sizes);
+	if (ngeom <= 0 || nsizes <= 0)
+		usage(argv[0]);
+
+	printf("encode implementation: %s, %d MB/s at load\n",
+	       ec_encode_name(), ec_encode_speed());
+	printf("%-7s %8s %8s %7s %8s %12s %12s\n", "geom", "fragsize",
+	       "erasures", "op", "MB/s", "stripe_ns", "cold_ns");
+
+	for (g = 0; g < ngeom && rc == 0; g++)
+		for (s = 0; s < nsizes && rc == 0; s++)
+			rc = bench_one(&geom[g], sizes[s], max_err, msec);
+
+	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
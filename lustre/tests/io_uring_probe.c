@@ -25,22 +25,261 @@
 /*
  * Probe whether OS supports io_uring.
  *
+ * With a file argument, read it through io_uring and report the throughput:
+ *   io_uring_probe [-b bufsize] [-q depth] [-n passes] file
+ * Reads are submitted without IOSQE_ASYNC, so cache-hot reads are served in
+ * the submitting thread if the filesystem supports IOCB_NOWAIT.
+ *
  * Author: Qian Yingjin <qian@ddn.com>
  */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
+#include <sys/uio.h>
 
 #ifdef __NR_io_uring_register
 #include <linux/io_uring.h>
 
+struct uring {
+	int			 ur_fd;
+	unsigned int		*ur_sq_tail;
+	unsigned int		*ur_sq_mask;
+	unsigned int		*ur_sq_array;
+	struct io_uring_sqe	*ur_sqes;
+	unsigned int		*ur_cq_head;
+	unsigned int		*ur_cq_tail;
+	unsigned int		*ur_cq_mask;
+	struct io_uring_cqe	*ur_cqes;
+};
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-b bufsize] [-q depth] [-n passes] file\n", prog);
+	exit(EINVAL);
+}
+
+static int uring_init(struct uring *ur, unsigned int depth)
+{
+	struct io_uring_params p;
+	void *sq;
+	void *cq;
+
+	memset(&p, 0, sizeof(p));
+	ur->ur_fd = syscall(__NR_io_uring_setup, depth, &p);
+	if (ur->ur_fd < 0)
+		return -errno;
+
+	sq = mmap(NULL, p.sq_off.array + p.sq_entries * sizeof(unsigned int),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  ur->ur_fd, IORING_OFF_SQ_RING);
+	cq = mmap(NULL, p.cq_off.cqes + p.cq_entries *
+		  sizeof(struct io_uring_cqe),
+		  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		  ur->ur_fd, IORING_OFF_CQ_RING);
+	ur->ur_sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+			   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			   ur->ur_fd, IORING_OFF_SQES);
+	if (sq == MAP_FAILED || cq == MAP_FAILED || ur->ur_sqes == MAP_FAILED)
+		return -errno;
+
+	ur->ur_sq_tail = sq + p.sq_off.tail;
+	ur->ur_sq_mask = sq + p.sq_off.ring_mask;
+	ur->ur_sq_array = sq + p.sq_off.array;
+	ur->ur_cq_head = cq + p.cq_off.head;
+	ur->ur_cq_tail = cq + p.cq_off.tail;
+	ur->ur_cq_mask = cq + p.cq_off.ring_mask;
+	ur->ur_cqes = cq + p.cq_off.cqes;
+
+	return 0;
+}
+
+/* queue a read of @iov at @offset, it is submitted by uring_enter() */
+static void uring_queue_read(struct uring *ur, int fd, struct iovec *iov,
+			     off_t offset, unsigned int slot)
+{
+	unsigned int tail = *ur->ur_sq_tail;
+	unsigned int idx = tail & *ur->ur_sq_mask;
+	struct io_uring_sqe *sqe = &ur->ur_sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->off = offset;
+	sqe->addr = (unsigned long)iov;
+	sqe->len = 1;
+	sqe->user_data = slot;
+	ur->ur_sq_array[idx] = idx;
+	__atomic_store_n(ur->ur_sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static int uring_enter(struct uring *ur, unsigned int submit)
+{
+	int rc;
+
+	rc = syscall(__NR_io_uring_enter, ur->ur_fd, submit, 1,
+		     IORING_ENTER_GETEVENTS, NULL, 0);
+
+	return rc < 0 ? -errno : rc;
+}
+
+/*
+ * Offset of the read number \a next / \a bufsize, aligned to \a bufsize and
+ * wrapped within the file, so that no read straddles EOF and is short.
+ */
+static unsigned long long bench_offset(unsigned long long next,
+				       size_t bufsize, off_t size)
+{
+	unsigned long long last = (size - bufsize) / bufsize * bufsize;
+	unsigned long long off = next % size / bufsize * bufsize;
+
+	return off > last ? last : off;
+}
+
+static int bench(const char *path, size_t bufsize, unsigned int depth,
+		 unsigned int passes)
+{
+	unsigned long long total = 0;
+	unsigned long long ios = 0;
+	unsigned long long end;
+	unsigned long long next = 0;
+	unsigned int inflight = 0;
+	unsigned int submit = 0;
+	unsigned int i;
+	struct timespec start;
+	struct timespec stop;
+	struct iovec *iovs;
+	struct uring ur;
+	struct stat st;
+	double secs;
+	int fd;
+	int rc;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		rc = -errno;
+		fprintf(stderr, "cannot open '%s': %s\n", path, strerror(-rc));
+		return rc;
+	}
+	if (st.st_size < bufsize) {
+		fprintf(stderr, "'%s' is smaller than %zu bytes\n", path,
+			bufsize);
+		return -EINVAL;
+	}
+	end = (unsigned long long)st.st_size * passes;
+
+	rc = uring_init(&ur, depth);
+	if (rc < 0) {
+		fprintf(stderr, "io_uring setup failed: %s\n", strerror(-rc));
+		return rc;
+	}
+
+	iovs = calloc(depth, sizeof(*iovs));
+	if (iovs == NULL)
+		return -ENOMEM;
+	for (i = 0; i < depth; i++) {
+		iovs[i].iov_base = malloc(bufsize);
+		if (iovs[i].iov_base == NULL)
+			return -ENOMEM;
+		iovs[i].iov_len = bufsize;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < depth && next < end; i++, next += bufsize) {
+		uring_queue_read(&ur, fd, &iovs[i],
+				 bench_offset(next, bufsize, st.st_size), i);
+		submit++;
+	}
+
+	while (submit > 0 || inflight > 0) {
+		unsigned int head;
+
+		rc = uring_enter(&ur, submit);
+		if (rc < 0) {
+			fprintf(stderr, "io_uring_enter failed: %s\n",
+				strerror(-rc));
+			return rc;
+		}
+		inflight += submit;
+		submit = 0;
+
+		head = *ur.ur_cq_head;
+		while (head != __atomic_load_n(ur.ur_cq_tail,
+					       __ATOMIC_ACQUIRE)) {
+			struct io_uring_cqe *cqe;
+
+			cqe = &ur.ur_cqes[head & *ur.ur_cq_mask];
+			if (cqe->res < 0) {
+				fprintf(stderr, "read failed: %s\n",
+					strerror(-cqe->res));
+				return cqe->res;
+			}
+			total += cqe->res;
+			ios++;
+			inflight--;
+			if (next < end) {
+				/* the buffer of this read is reused */
+				uring_queue_read(&ur, fd, &iovs[cqe->user_data],
+						 bench_offset(next, bufsize,
+							      st.st_size),
+						 cqe->user_data);
+				next += bufsize;
+				submit++;
+			}
+			head++;
+		}
+		__atomic_store_n(ur.ur_cq_head, head, __ATOMIC_RELEASE);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	secs = (stop.tv_sec - start.tv_sec) +
+	       (stop.tv_nsec - start.tv_nsec) / 1e9;
+	printf("read %llu bytes in %llu reads of %zu bytes, depth %u: %.3f s, %.1f MiB/s, %.0f IOPS\n",
+	       total, ios, bufsize, depth, secs,
+	       total / secs / (1 << 20), ios / secs);
+
+	close(fd);
+	return 0;
+}
+
 int main(int argc, char **argv)
 {
+	unsigned int passes = 1;
+	unsigned int depth = 32;
+	size_t bufsize = 4096;
 	int rc;
+	int c;
+
+	while ((c = getopt(argc, argv, "b:n:q:")) != -1) {
+		switch (c) {
+		case 'b':
+			bufsize = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			passes = strtoul(optarg, NULL, 0);
+			break;
+		case 'q':
+			depth = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (bufsize == 0 || depth == 0 || passes == 0)
+		usage(argv[0]);
+
+	if (optind < argc)
+		return bench(argv[optind], bufsize, depth, passes);
 
 	rc = syscall(__NR_io_uring_register, 0, IORING_UNREGISTER_BUFFERS,
 		     NULL, 0);
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/tests/ldlm_enqueue_bench.c
+ *
+ * Benchmark of the LDLM enqueue path.  Every thread creates its own files in
+ * a directory of a Lustre mount and requests asynchronous lockahead locks on
+ * distinct extents of them, round-robin, for a fixed time.  Each request
+ * looks the resource of the file up in the namespace of the client and of
+ * the OST, so with many files and threads the enqueue rate printed at the
+ * end mostly depends on the resource lookup.  With -S all threads share the
+ * same files instead, which stresses lookups of the same resources.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <lustre/lustreapi.h>
+
+struct bench_thread {
+	pthread_t	 bt_thread;
+	int		 bt_index;
+	int		*bt_fds;
+	int		 bt_nfds;
+	uint64_t	 bt_enqueued;
+	uint64_t	 bt_failed;
+	int		 bt_rc;
+};
+
+static const char *bench_dir;
+static int bench_files = 64;
+static int bench_threads = 4;
+static int bench_seconds = 10;
+static size_t bench_extent = 4096;
+static bool bench_shared;
+static volatile bool bench_stop;
+
+static void usage(const char *prog)
+{
+	printf("usage: %s [-f files] [-t threads] [-s seconds] [-x extent] [-S] dir\n",
+	       prog);
+	printf("\t-f\tfiles per thread, or in total with -S (default 64)\n"
+	       "\t-t\tnumber of threads (default 4)\n"
+	       "\t-s\tduration of the run in seconds (default 10)\n"
+	       "\t-x\tsize of each locked extent, k/m suffix allowed (default 4k)\n"
+	       "\t-S\tall threads lock the same files\n");
+
+	exit(EXIT_FAILURE);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int open_files(int *fds, int nfds, int owner)
+{
+	char path[PATH_MAX];
+	int i;
+
+	for (i = 0; i < nfds; i++) {
+		snprintf(path, sizeof(path), "%s/enq_bench.%d.%d", bench_dir,
+			 owner, i);
+		fds[i] = open(path, O_CREAT | O_RDWR, 0644);
+		if (fds[i] < 0) {
+			fprintf(stderr, "cannot create '%s': %s\n", path,
+				strerror(errno));
+			while (i-- > 0)
+				close(fds[i]);
+			return -errno;
+		}
+	}
+
+	return 0;
+}
+
+static void close_files(int *fds, int nfds, int owner)
+{
+	char path[PATH_MAX];
+	int i;
+
+	for (i = 0; i < nfds; i++) {
+		close(fds[i]);
+		snprintf(path, sizeof(path), "%s/enq_bench.%d.%d", bench_dir,
+			 owner, i);
+		unlink(path);
+	}
+}
+
+static void *bench_thread_main(void *arg)
+{
+	struct bench_thread *bt = arg;
+	struct llapi_lu_ladvise advice;
+	uint64_t offset;
+	int i;
+	int rc;
+
+	/* keep the extents of the threads apart when sharing the files */
+	offset = (uint64_t)bt->bt_index << 40;
+
+	while (!bench_stop) {
+		for (i = 0; i < bt->bt_nfds && !bench_stop; i++) {
+			memset(&advice, 0, sizeof(advice));
+			advice.lla_advice = LU_LADVISE_LOCKAHEAD;
+			advice.lla_lockahead_mode = MODE_WRITE_USER;
+			advice.lla_peradvice_flags = LF_ASYNC;
+			advice.lla_start = offset;
+			advice.lla_end = offset + bench_extent - 1;
+
+			rc = llapi_ladvise(bt->bt_fds[i], 0, 1, &advice);
+			if (rc < 0) {
+				bt->bt_rc = -errno;
+				fprintf(stderr, "thread %d: ladvise failed: %s\n",
+					bt->bt_index, strerror(errno));
+				return NULL;
+			}
+			if (advice.lla_lockahead_result < 0)
+				bt->bt_failed++;
+			else
+				bt->bt_enqueued++;
+		}
+		offset += bench_extent;
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	struct bench_thread *threads;
+	uint64_t enqueued = 0;
+	uint64_t failed = 0;
+	uint64_t start;
+	uint64_t elapsed;
+	int *fds;
+	int nfds;
+	int started;
+	char *end;
+	int rc = 0;
+	int c;
+	int i;
+
+	while ((c = getopt(argc, argv, "f:hSs:t:x:")) != -1) {
+		switch (c) {
+		case 'f':
+			bench_files = atoi(optarg);
+			break;
+		case 'S':
+			bench_shared = true;
+			break;
+		case 's':
+			bench_seconds = atoi(optarg);
+			break;
+		case 't':
+			bench_threads = atoi(optarg);
+			break;
+		case 'x':
+			bench_extent = strtoul(optarg, &end, 0);
+			if (*end == 'k' || *end == 'K')
+				bench_extent <<= 10;
+			else if (*end == 'm' || *end == 'M')
+				bench_extent <<= 20;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (optind != argc - 1 || bench_files <= 0 || bench_threads <= 0 ||
+	    bench_seconds <= 0 || bench_extent == 0)
+		usage(argv[0]);
+	bench_dir = argv[optind];
+
+	nfds = bench_shared ? bench_files : bench_files * bench_threads;
+	fds = calloc(nfds, sizeof(*fds));
+	threads = calloc(bench_threads, sizeof(*threads));
+	if (!fds || !threads) {
+		fprintf(stderr, "cannot allocate %d files\n", nfds);
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < bench_threads; i++) {
+		threads[i].bt_index = i;
+		threads[i].bt_nfds = bench_files;
+		threads[i].bt_fds = bench_shared ? fds : fds + i * bench_files;
+		if (bench_shared && i > 0)
+			continue;
+		rc = open_files(threads[i].bt_fds, bench_files, i);
+		if (rc < 0) {
+			while (i-- > 0)
+				close_files(threads[i].bt_fds, bench_files, i);
+			return EXIT_FAILURE;
+		}
+	}
+
+	start = now_ns();
+	for (started = 0; started < bench_threads; started++) {
+		i = started;
+		rc = pthread_create(&threads[i].bt_thread, NULL,
+				    bench_thread_main, &threads[i]);
+		if (rc) {
+			fprintf(stderr, "cannot start thread %d: %s\n", i,
+				strerror(rc));
+			bench_stop = true;
+			break;
+		}
+	}
+
+	if (!rc)
+		sleep(bench_seconds);
+	bench_stop = true;
+
+	for (i = 0; i < started; i++) {
+		pthread_join(threads[i].bt_thread, NULL);
+		enqueued += threads[i].bt_enqueued;
+		failed += threads[i].bt_failed;
+		if (threads[i].bt_rc)
+			rc = threads[i].bt_rc;
+	}
+	elapsed = now_ns() - start;
+
+	for (i = 0; i < (bench_shared ? 1 : bench_threads); i++)
+		close_files(threads[i].bt_fds, bench_files, i);
+
+	printf("%d threads, %d files%s: %llu enqueues (%llu failed) in %.2fs, %llu enqueues/s\n",
+	       started, nfds, bench_shared ? " shared" : "",
+	       (unsigned long long)enqueued, (unsigned long long)failed,
+	       elapsed / 1e9,
+	       (unsigned long long)(enqueued * 1000000000ULL / elapsed));
+
+	free(threads);
+	free(fds);
+
+	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
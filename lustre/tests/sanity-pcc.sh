@@ -1491,6 +1491,127 @@ test_20() {
 }
 run_test 20 "Auto attach works after the inode was once evicted from cache"
 
+ro_stat() {
+	do_facet $SINGLEAGT $LCTL pcc list $MOUNT |
+		awk "/$1:/ { print \$NF }"
+}
+
+test_21() {
+	local loopfile="$TMP/$tfile"
+	local mntpt="/mnt/pcc.$tdir"
+	local hsm_root="$mntpt/$tdir"
+	local file=$DIR/$tfile
+	local file_heat_sav
+	local hits
+
+	file_heat_sav=$(do_facet $SINGLEAGT $LCTL get_param -n \
+			llite.*.file_heat 2>/dev/null | head -n 1)
+	[[ -n "$file_heat_sav" ]] || skip "no file heat support"
+
+	setup_loopdev $SINGLEAGT $loopfile $mntpt 50
+	do_facet $SINGLEAGT mkdir $hsm_root || error "mkdir $hsm_root failed"
+	setup_pcc_mapping $SINGLEAGT \
+		"heat={10}\ roid=$HSM_ARCHIVE_NUMBER\ ropcc=1"
+	do_facet $SINGLEAGT $LCTL set_param -n llite.*.file_heat=1
+	stack_trap "do_facet $SINGLEAGT $LCTL set_param -n \
+		llite.*.file_heat=$file_heat_sav"
+
+	do_facet $SINGLEAGT "echo -n heat_origin > $file" ||
+		error "echo $file failed"
+	# read heat is checked at most once a second
+	for i in {1..3}; do
+		do_facet $SINGLEAGT dd if=$file of=/dev/null bs=1 ||
+			error "read $file failed"
+		sleep 1
+	done
+	wait_update_facet $SINGLEAGT "$LCTL pcc list $MOUNT |
+		awk '/ro_attached:/ { print \\\$NF }'" 1 30 ||
+		error "$file was not attached into $hsm_root"
+	check_lpcc_state $file "readonly"
+	do_facet $SINGLEAGT $LCTL pcc list $MOUNT
+
+	# a new open reads the copy
+	hits=$(ro_stat ro_hits)
+	check_lpcc_data $SINGLEAGT $(lpcc_fid2path $hsm_root $file) $file \
+		"heat_origin"
+	(( $(ro_stat ro_hits) > hits )) ||
+		error "reads of $file not served from the RO-PCC copy"
+
+	# a write from another client is found by the data version check
+	do_facet $SINGLEAGT "echo -n heat_update > $DIR2/$tfile" ||
+		error "echo $DIR2/$tfile failed"
+	check_file_data $SINGLEAGT $file "heat_update"
+	do_facet $SINGLEAGT $LCTL pcc list $MOUNT
+	(( $(ro_stat ro_stale) == 1 )) ||
+		error "stale RO-PCC copy of $file not detected"
+}
+run_test 21 "Heat-driven RO-PCC attach checks the data version at open"
+
+test_22() {
+	local loopfile="$TMP/$tfile"
+	local mntpt="/mnt/pcc.$tdir"
+	local hsm_root="$mntpt/$tdir"
+	local file=$DIR/$tfile
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	# not a multiple of the page size, the tail is padded and truncated
+	local size=$((16 * 1048576 + 1234))
+	local mbps=4
+	local copied
+	local start
+	local dump
+	local pid
+	local sum
+
+	do_facet $SINGLEAGT $LCTL get_param -n llite.*.pcc_attach_max_mbps \
+		&> /dev/null || skip "no PCC attach throttle"
+
+	setup_loopdev $SINGLEAGT $loopfile $mntpt 100
+	copytool setup -m "$MOUNT" -a "$HSM_ARCHIVE_NUMBER"
+	setup_pcc_mapping
+
+	save_lustre_params $SINGLEAGT "llite.*.pcc_attach_max_*" > $p
+	stack_trap "restore_lustre_params < $p; rm -f $p"
+	do_facet $SINGLEAGT $LCTL set_param llite.*.pcc_attach_max_active=0 &&
+		error "pcc_attach_max_active=0 was accepted"
+	do_facet $SINGLEAGT $LCTL set_param llite.*.pcc_attach_max_active=1 \
+		llite.*.pcc_attach_max_mbps=$mbps ||
+		error "cannot set the PCC attach tunables"
+
+	head -c $size /dev/urandom > $file || error "write $file failed"
+	sum=$(md5sum < $file)
+
+	start=$SECONDS
+	do_facet $SINGLEAGT $LFS pcc attach -i $HSM_ARCHIVE_NUMBER $file &
+	pid=$!
+	sleep 2
+	dump=$(do_facet $SINGLEAGT $LCTL get_param -n llite.*.pcc_attach)
+	echo "$dump"
+	grep -q "^max_active: 1$" <<< "$dump" || error "max_active not dumped"
+	grep -q "^max_mbps: $mbps$" <<< "$dump" || error "max_mbps not dumped"
+	grep -qF "fid: $(path2fid $file)" <<< "$dump" ||
+		error "attach of $file not listed"
+	copied=$(awk '/copied:/ { print $2 }' <<< "$dump")
+	(( copied < size )) || error "$copied bytes copied after 2s"
+
+	wait $pid || error "attach of $file failed"
+	(( SECONDS - start >= size / 1048576 / mbps - 1 )) ||
+		error "$size bytes attached in $((SECONDS - start))s"
+	check_lpcc_state $file "readwrite"
+
+	dump=$(do_facet $SINGLEAGT $LCTL get_param -n llite.*.pcc_attach)
+	echo "$dump"
+	(( $(awk '/^attached:/ { print $2 }' <<< "$dump") >= 1 )) ||
+		error "attach of $file not counted"
+	grep -qF "fid: $(path2fid $file)" <<< "$dump" &&
+		error "attach of $file still listed"
+
+	[[ $(do_facet $SINGLEAGT stat -c %s $(lpcc_fid2path $hsm_root $file)) \
+	   == $size ]] || error "PCC copy of $file has the wrong size"
+	[[ $(do_facet $SINGLEAGT "md5sum < $file") == "$sum" ]] ||
+		error "$file changed by the attach"
+}
+run_test 22 "PCC attach throttle and progress dump"
+
 #test 101: containers and PCC
 #LU-15170: Test mount namespaces with PCC
 #This tests the cases where the PCC mount is not present in the container by
@@ -1497,6 +1497,45 @@ test_24H() {
 }
 run_test 24H "repeat FLD_QUERY rpc"
 
+test_24I() {
+	local dir=$DIR/$tdir
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local count=32
+	local plain
+	local plus
+
+	$LCTL get_param -n llite.*.readdir_plus &> /dev/null ||
+		skip "no readdir_plus support"
+	(( $($LCTL get_param -n llite.*.readdir_plus | head -n 1) == 0 )) ||
+		error "readdir_plus is enabled by default"
+
+	save_lustre_params client "llite.*.readdir_plus" > $p
+	save_lustre_params client "llite.*.statahead_max" >> $p
+	stack_trap "restore_lustre_params < $p; rm -f $p"
+	# one getattr per entry, not a statahead batch
+	$LCTL set_param llite.*.statahead_max=0
+
+	test_mkdir -i 0 -c 1 $dir || error "test_mkdir $dir failed"
+	createmany -o $dir/$tfile $count || error "createmany failed"
+
+	for val in 0 1; do
+		$LCTL set_param llite.*.readdir_plus=$val
+		cancel_lru_locks mdc
+		$LCTL set_param mdc.*.stats=clear
+		ls -l $dir > /dev/null || error "ls -l $dir failed"
+		$LCTL get_param mdc.*.stats | grep -E "getattr|ibits_enqueue"
+		plus=$(( $(calc_stats mdc.*.stats ldlm_ibits_enqueue) +
+			 $(calc_stats mdc.*.stats mds_getattr) ))
+		(( val == 1 )) || plain=$plus
+	done
+	echo "getattr RPCs: $plain without readdir_plus, $plus with it"
+
+	(( plain >= count )) || error "only $plain getattr RPCs for $count files"
+	# the attributes in the pages only refresh inodes already cached
+	(( plus <= plain )) || error "readdir_plus added getattr RPCs"
+}
+run_test 24I "readdir_plus is off by default and adds no getattr RPC"
+
 test_25a() {
 	echo '== symlink sanity ============================================='
 
@@ -5614,6 +5653,41 @@ test_42e() { # bug22074
 }
 run_test 42e "verify sub-RPC writes are not done synchronously"
 
+test_42f() {
+	local file=$DIR/$tfile
+	local ref=$TMP/$tfile.ref
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local order
+
+	$LCTL get_param -n llite.*.max_folio_order &> /dev/null ||
+		skip "no large folio support"
+
+	save_lustre_params client "llite.*.max_folio_order" > $p
+	stack_trap "restore_lustre_params < $p; rm -f $p"
+	# 64KiB folios with 4KiB pages, ERANGE on kernels without them
+	for ((order = 0; (PAGE_SIZE << order) < 65536; order++)); do :; done
+	(( order > 0 )) || skip "PAGE_SIZE $PAGE_SIZE is large already"
+	$LCTL set_param llite.*.max_folio_order=$order ||
+		skip "client cannot cache large folios"
+	stack_trap "rm -f $file $ref"
+
+	dd if=/dev/urandom of=$ref bs=1M count=4 || error "dd $ref failed"
+
+	# full folios, then partial overwrites and a truncate into a folio
+	dd if=$ref of=$file bs=1M count=4 || error "write $file failed"
+	dd if=$ref of=$file bs=3000 skip=7 seek=7 count=50 conv=notrunc ||
+		error "overwrite $file failed"
+	cmp $ref $file || error "$file differs in cache"
+	cancel_lru_locks osc
+	cmp $ref $file || error "$file differs after lock cancel"
+
+	$TRUNCATE $file 100000 || error "truncate $file failed"
+	$TRUNCATE $ref 100000
+	cancel_lru_locks osc
+	cmp $ref $file || error "$file differs after truncate"
+}
+run_test 42f "buffered writes through large page cache folios"
+
 test_43A() { # was test_43
 	test_mkdir $DIR/$tdir
 	cp -p /bin/ls $DIR/$tdir/$tfile
@@ -11762,6 +11836,47 @@ test_101m()
 }
 run_test 101m "read ahead for small file and last stripe of the file"
 
+test_101n() {
+	local file=$DIR/$tfile
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local size=$((64 * 1048576))
+	local created
+	local misses
+	local hits
+
+	$LCTL get_param -n llite.*.read_ahead_streams &> /dev/null ||
+		skip "no read-ahead streams support"
+
+	save_lustre_params client "llite.*.read_ahead_streams" > $p
+	stack_trap "restore_lustre_params < $p; rm -f $p"
+	stack_trap "rm -f $file"
+
+	$LFS setstripe -c 1 -i 0 $file || error "setstripe $file failed"
+	dd if=/dev/zero of=$file bs=1M count=64 || error "dd $file failed"
+
+	# 64KiB every 1MiB, a gap far beyond a loose sequential read
+	for streams in 1 4; do
+		$LCTL set_param llite.*.read_ahead_streams=$streams
+		cancel_lru_locks osc
+		$LCTL set_param -n llite.*.read_ahead_stats=0
+		$READS -f $file -s $size -b 65536 -a 1 -l 16 -n 64 ||
+			error "stride read of $file failed"
+		$LCTL get_param llite.*.read_ahead_stats
+		hits=$($LCTL get_param -n llite.*.read_ahead_stats |
+		       get_named_value 'hits' | calc_sum)
+		misses=$($LCTL get_param -n llite.*.read_ahead_stats |
+			 get_named_value 'misses' | calc_sum)
+		(( hits > misses )) ||
+			error "$streams streams: $hits hits, $misses misses"
+	done
+
+	# the stride stays in the stream it was started in
+	created=$($LCTL get_param -n llite.*.read_ahead_stats |
+		  get_named_value 'streams_created' | calc_sum)
+	(( created <= 2 )) || error "$created streams for one stride read"
+}
+run_test 101n "stride read-ahead with several read-ahead streams"
+
 setup_test102() {
 	test_mkdir $DIR/$tdir
 	chown $RUNAS_ID $DIR/$tdir
@@ -12352,6 +12467,57 @@ test_102t() {
 }
 run_test 102t "zero length xattr values handled correctly"
 
+test_102u() {
+	local max_mb=$($LCTL get_param -n llite.*.xattr_cache_max_mb \
+		       2>/dev/null | head -n 1)
+	local save="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local value=$(printf "%04000d" 0)
+	local stats="llite.*.xattr_cache_stats"
+	local bytes
+	local hits
+	local misses
+	local evicted
+
+	[[ -n "$max_mb" ]] || skip "no xattr cache memory bound"
+
+	save_lustre_params client "llite.*.xattr_cache" > $save
+	save_lustre_params client "llite.*.xattr_cache_max_mb" >> $save
+	stack_trap "restore_lustre_params < $save; rm -f $save"
+	$LCTL set_param llite.*.xattr_cache=1
+
+	test_mkdir $DIR/$tdir || error "test_mkdir $DIR/$tdir failed"
+	createmany -o $DIR/$tdir/f 512 || error "createmany failed"
+	for i in {0..511}; do
+		setfattr -n user.u102 -v $value $DIR/$tdir/f$i ||
+			error "setfattr $DIR/$tdir/f$i failed"
+	done
+
+	# 512 caches of at least 4000 bytes do not fit in 1 MiB
+	$LCTL set_param llite.*.xattr_cache_max_mb=1
+	cancel_lru_locks mdc
+	$LCTL set_param $stats=clear
+	for i in {0..511}; do
+		getfattr -n user.u102 $DIR/$tdir/f$i > /dev/null ||
+			error "getfattr $DIR/$tdir/f$i failed"
+	done
+	$LCTL get_param $stats
+	misses=$($LCTL get_param -n $stats | awk '/^miss_total:/ { print $NF }')
+	evicted=$($LCTL get_param -n $stats | awk '/^evict_total:/ { print $NF }')
+	bytes=$($LCTL get_param -n $stats | awk '/^cache_bytes:/ { print $NF }')
+	(( misses >= 512 )) || error "only $misses misses for 512 files"
+	(( evicted > 0 )) || error "no cache evicted above xattr_cache_max_mb"
+	# unbounded, the caches would use about 2 MiB
+	(( bytes <= 3 << 19 )) ||
+		error "$bytes bytes cached above xattr_cache_max_mb=1"
+
+	# the most recently used cache is kept
+	getfattr -n user.u102 $DIR/$tdir/f511 > /dev/null ||
+		error "getfattr $DIR/$tdir/f511 failed"
+	hits=$($LCTL get_param -n $stats | awk '/^hit_total:/ { print $NF }')
+	(( hits > 0 )) || error "getfattr of $DIR/$tdir/f511 missed the cache"
+}
+run_test 102u "xattr cache memory is bounded by xattr_cache_max_mb"
+
 run_acl_subtest()
 {
 	local test=$LUSTRE/tests/acl/$1.test
@@ -14443,6 +14609,55 @@ test_123f() {
 }
 run_test 123f "Retry mechanism with large wide striping files"
 
+test_123g() {
+	local window=$($LCTL get_param -n llite.*.statahead_tree_window \
+		       2>/dev/null | head -n 1)
+	local dir=$DIR/$tdir
+	local total
+	local hits
+	local misses
+
+	[[ -n "$window" ]] || skip "no statahead tree walk support"
+	stack_trap "$LCTL set_param llite.*.statahead_tree_window=$window"
+
+	test_mkdir $dir || error "test_mkdir $dir failed"
+	for i in {1..16}; do
+		mkdir $dir/d$i || error "mkdir $dir/d$i failed"
+		createmany -o $dir/d$i/f 32 > /dev/null ||
+			error "createmany in $dir/d$i failed"
+	done
+
+	# every subdirectory fits in the window, descending into them hits
+	$LCTL set_param llite.*.statahead_tree_window=32
+	cancel_lru_locks mdc
+	$LCTL set_param llite.*.statahead_stats=clear
+	ls -lR $dir > /dev/null || error "ls -lR $dir failed"
+	# wait for statahead threads to quit and update statahead stats
+	sleep 2
+	$LCTL get_param -n llite.*.statahead_stats
+	total=$($LCTL get_param -n llite.*.statahead_stats |
+		awk '/^tree_walks:/ { print $NF }')
+	hits=$($LCTL get_param -n llite.*.statahead_stats |
+	       awk '/^tree_hits:/ { print $NF }')
+	(( hits > 0 )) || error "no descent into $dir was predicted"
+	(( total > 0 )) || error "statahead was not started at opendir"
+
+	# predictions pushed out of a small window, and not descended, miss
+	$LCTL set_param llite.*.statahead_tree_window=2
+	cancel_lru_locks mdc
+	$LCTL set_param llite.*.statahead_stats=clear
+	ls -l $dir > /dev/null || error "ls -l $dir failed"
+	sleep 2
+	$LCTL get_param -n llite.*.statahead_stats
+	hits=$($LCTL get_param -n llite.*.statahead_stats |
+	       awk '/^tree_hits:/ { print $NF }')
+	misses=$($LCTL get_param -n llite.*.statahead_stats |
+		 awk '/^tree_misses:/ { print $NF }')
+	(( misses > 0 )) || error "no prediction dropped out of the window"
+	(( hits == 0 )) || error "$hits hits without descending into $dir"
+}
+run_test 123g "statahead predicts the descent of a tree walk"
+
 test_124a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	$LCTL get_param -n mdc.*.connect_flags | grep -q lru_resize ||
@@ -29660,6 +29875,141 @@ test_440() {
 }
 run_test 440 "bash completion for lfs, lctl"
 
+test_442() {
+	local max=$($LCTL get_param -n llite.*.neg_cache_max_entries \
+		    2>/dev/null | head -n 1)
+	local dir=$DIR/$tdir
+	local inserted
+	local purged
+
+	[[ -n "$max" ]] || skip "no negative lookup cache support"
+	(( max > 0 )) || skip "negative lookup cache is disabled"
+
+	test_mkdir -i 0 -c 1 $dir || error "test_mkdir $dir failed"
+	mount_client $MOUNT2 || error "mount_client $MOUNT2 failed"
+	stack_trap "umount_client $MOUNT2"
+
+	cancel_lru_locks mdc
+	$LCTL set_param llite.*.neg_cache_stats=clear
+	# the UPDATE lock of $dir is fetched after a few names are missing
+	for i in {1..8}; do
+		stat $dir/$tfile.$i &> /dev/null && error "$dir/$tfile.$i exists"
+	done
+	$LCTL get_param llite.*.neg_cache_stats
+	inserted=$($LCTL get_param -n llite.*.neg_cache_stats |
+		   awk '/^insert_total:/ { sum += $NF } END { print sum }')
+	(( inserted > 0 )) || error "no missing name of $dir was cached"
+
+	# a create from another client cancels the lock and purges the names
+	touch $MOUNT2/$tdir/$tfile.8 || error "touch $MOUNT2/$tdir/$tfile.8 failed"
+	$LCTL get_param llite.*.neg_cache_stats
+	purged=$($LCTL get_param -n llite.*.neg_cache_stats |
+		 awk '/^purge_total:/ { sum += $NF } END { print sum }')
+	(( purged > 0 )) || error "negative names of $dir were not purged"
+	stat $dir/$tfile.8 || error "$dir/$tfile.8 created remotely is missing"
+}
+run_test 442 "negative lookup cache is purged by a remote create"
+
+test_443() {
+	local src=$TMP/$tfile
+	local file=$DIR/$tfile
+	local zero
+	local kb
+
+	$LCTL get_param osc.$FSNAME-OST0000-osc-[^M]*.import |
+		grep -q 'connect_flags:.*zero_write' ||
+		skip "OST does not support zero_write"
+
+	# checkpoint-like: data, a large run of zeroes, then a short trailer
+	dd if=/dev/urandom of=$src bs=1M count=1 || error "dd $src failed"
+	dd if=/dev/urandom of=$src bs=4k count=1 seek=1280 conv=notrunc ||
+		error "dd $src trailer failed"
+	stack_trap "rm -f $src"
+
+	$LFS setstripe -E eof -c 1 -i 0 --comp-flags=sparse $file ||
+		error "setstripe $file failed"
+	$LFS getstripe $file | grep -q "lcme_flags:.*sparse" ||
+		error "$file has no sparse component"
+
+	$LCTL set_param osc.*.stats=0
+	# one write of everything, zeroes included
+	dd if=$src of=$file bs=8M count=1 || error "dd $file failed"
+	sync
+	$LCTL get_param osc.$FSNAME-OST0000-osc-[^M]*.stats
+	zero=$($LCTL get_param -n osc.$FSNAME-OST0000-osc-[^M]*.stats |
+	       awk '/^zero_write_bytes/ { sum += $2 } END { print sum }')
+	(( zero >= 3 * 1048576 )) ||
+		error "only $zero bytes of zeroes were left out of the bulk"
+
+	cancel_lru_locks osc
+	cmp $src $file || error "$file differs from $src"
+	(( $(stat -c %s $file) == $(stat -c %s $src) )) ||
+		error "size of $file is $(stat -c %s $file)"
+
+	# zeroes past the object size at write time are holes
+	kb=$(du -k $file | awk '{ print $1 }')
+	(( kb < 2048 )) || error "$kb KiB allocated for $file"
+}
+run_test 443 "sparse component writes zero pages as holes"
+
+test_444() {
+	local osc=osc.$FSNAME-OST0000-osc-[^M]*
+	local dir=$DIR/$tdir
+	local rpcs
+	local objs
+	local i
+
+	$LCTL get_param $osc.import |
+		grep -q 'connect_flags:.*multi_obj_brw' ||
+		skip "OST does not support multi_obj_brw"
+
+	test_mkdir $dir
+	$LFS setstripe -c 1 -i 0 $dir || error "setstripe $dir failed"
+
+	local max=$($LCTL get_param -n $osc.max_objs_per_rpc | head -n1)
+
+	stack_trap "$LCTL set_param $osc.max_objs_per_rpc=$max"
+	$LCTL set_param $osc.max_objs_per_rpc=16
+
+	# many small shards, flushed together
+	$LCTL set_param $osc.stats=0
+	for ((i = 0; i < 64; i++)); do
+		dd if=/dev/urandom of=$dir/$tfile.$i bs=4k count=1 \
+			2>/dev/null || error "dd $tfile.$i failed"
+		cp $dir/$tfile.$i $TMP/$tfile.$i
+	done
+	stack_trap "rm -f $TMP/$tfile.*"
+	sync
+	$LCTL get_param $osc.stats
+	rpcs=$($LCTL get_param -n $osc.stats |
+	       awk '/^multi_obj_write_rpcs/ { sum += $2 } END { print sum }')
+	objs=$($LCTL get_param -n $osc.stats |
+	       awk '/^multi_obj_write_objs/ { sum += $2 } END { print sum }')
+	(( rpcs > 0 )) || error "no multi-object write RPC was sent"
+	(( objs > rpcs )) || error "$objs objects in $rpcs RPCs"
+
+	cancel_lru_locks osc
+	for ((i = 0; i < 64; i++)); do
+		cmp $TMP/$tfile.$i $dir/$tfile.$i ||
+			error "$tfile.$i differs"
+		(( $(stat -c %s $dir/$tfile.$i) == 4096 )) ||
+			error "size of $tfile.$i is wrong"
+	done
+
+	# disabled, every object has its own RPC
+	$LCTL set_param $osc.max_objs_per_rpc=1
+	$LCTL set_param $osc.stats=0
+	for ((i = 0; i < 16; i++)); do
+		dd if=/dev/zero of=$dir/$tfile.$i bs=4k count=1 \
+			2>/dev/null || error "rewrite $tfile.$i failed"
+	done
+	sync
+	rpcs=$($LCTL get_param -n $osc.stats |
+	       awk '/^multi_obj_write_rpcs/ { sum += $2 } END { print sum }')
+	(( rpcs == 0 )) || error "$rpcs multi-object RPCs with the limit at 1"
+}
+run_test 444 "small files of one OST share write RPCs"
+
 prep_801() {
 	[[ $MDS1_VERSION -lt $(version_code 2.9.55) ]] ||
 	[[ $OST1_VERSION -lt $(version_code 2.9.55) ]] &&
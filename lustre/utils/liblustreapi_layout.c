@@ -3347,7 +3347,7 @@ struct llapi_layout_sanity_args {
 
 /* The component flags can be set by users at creation/modification time. */
 #define LCME_USER_COMP_FLAGS	(LCME_FL_PREF_RW | LCME_FL_NOSYNC | \
-				 LCME_FL_EXTENSION)
+				 LCME_FL_EXTENSION | LCME_FL_SPARSE)
 
 /**
  * When modified, adjust llapi_stripe_param_verify() if needed as well.
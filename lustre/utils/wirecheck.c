@@ -351,6 +351,7 @@ check_lu_dirent(void)
 	CHECK_VALUE_X(LUDA_FID);
 	CHECK_VALUE_X(LUDA_TYPE);
 	CHECK_VALUE_X(LUDA_64BITHASH);
+	CHECK_VALUE_X(LUDA_ATTR);
 }
 
 static void
@@ -361,6 +362,25 @@ check_luda_type(void)
 	CHECK_MEMBER(luda_type, lt_type);
 }
 
+static void
+check_luda_attr(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(luda_attr);
+	CHECK_MEMBER(luda_attr, lda_valid);
+	CHECK_MEMBER(luda_attr, lda_size);
+	CHECK_MEMBER(luda_attr, lda_blocks);
+	CHECK_MEMBER(luda_attr, lda_mtime);
+	CHECK_MEMBER(luda_attr, lda_atime);
+	CHECK_MEMBER(luda_attr, lda_ctime);
+	CHECK_MEMBER(luda_attr, lda_mode);
+	CHECK_MEMBER(luda_attr, lda_uid);
+	CHECK_MEMBER(luda_attr, lda_gid);
+	CHECK_MEMBER(luda_attr, lda_nlink);
+	CHECK_MEMBER(luda_attr, lda_flags);
+	CHECK_MEMBER(luda_attr, lda_padding);
+}
+
 static void
 check_lu_dirpage(void)
 {
@@ -683,6 +703,9 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT2_LARGE_NID);
 	CHECK_DEFINE_64X(OBD_CONNECT2_COMPRESS);
 	CHECK_DEFINE_64X(OBD_CONNECT2_UNALIGNED_DIO);
+	CHECK_DEFINE_64X(OBD_CONNECT2_READDIR_PLUS);
+	CHECK_DEFINE_64X(OBD_CONNECT2_ZERO_WRITE);
+	CHECK_DEFINE_64X(OBD_CONNECT2_MULTI_OBJ_BRW);
 
 	BLANK_LINE();
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
@@ -939,6 +962,7 @@ check_lov_comp_md_entry_v1(void)
 	CHECK_CVALUE_X(LCME_FL_COMPRESS);
 	CHECK_CVALUE_X(LCME_FL_PARTIAL);
 	CHECK_CVALUE_X(LCME_FL_NOCOMPR);
+	CHECK_CVALUE_X(LCME_FL_SPARSE);
 	CHECK_CVALUE_X(LCME_FL_NEG);
 }
 
@@ -1179,6 +1203,35 @@ check_niobuf_remote(void)
 	CHECK_DEFINE_X(OBD_BRW_RDMA_ONLY);
 	CHECK_DEFINE_X(OBD_BRW_SYS_RESOURCE);
 	CHECK_DEFINE_X(OBD_BRW_COMPRESSED);
+	CHECK_DEFINE_X(OBD_BRW_ZERO);
+}
+
+static void
+check_ll_compr_hdr(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(ll_compr_hdr);
+	CHECK_MEMBER(ll_compr_hdr, llch_magic);
+	CHECK_MEMBER(ll_compr_hdr, llch_header_size);
+	CHECK_MEMBER(ll_compr_hdr, llch_compr_type);
+	CHECK_BITFIELD(ll_compr_hdr, llch_compr_level);
+	CHECK_BITFIELD(ll_compr_hdr, llch_chunk_log_bits);
+	CHECK_MEMBER(ll_compr_hdr, llch_flags);
+	CHECK_MEMBER(ll_compr_hdr, llch_compr_size);
+	CHECK_MEMBER(ll_compr_hdr, llch_hdr_csum);
+	CHECK_MEMBER(ll_compr_hdr, llch_reserved);
+	CHECK_DEFINE_X(LLCH_MAGIC);
+}
+
+static void
+check_ll_compr_attr(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(ll_compr_attr);
+	CHECK_MEMBER(ll_compr_attr, lca_types);
+	CHECK_MEMBER(ll_compr_attr, lca_chunk_log_bits);
+	CHECK_MEMBER(ll_compr_attr, lca_padding1);
+	CHECK_MEMBER(ll_compr_attr, lca_padding2);
 }
 
 static void
@@ -3505,6 +3558,7 @@ main(int argc, char **argv)
 	check_ost_id();
 	check_lu_dirent();
 	check_luda_type();
+	check_luda_attr();
 	check_lu_dirpage();
 	check_lu_ladvise();
 	check_ladvise_hdr();
@@ -3532,6 +3586,8 @@ main(int argc, char **argv)
 	CHECK_COND_FINISH(HAVE_SERVER_SUPPORT);
 #endif /* !HAVE_NATIVE_LINUX_CLIENT */
 	check_niobuf_remote();
+	check_ll_compr_hdr();
+	check_ll_compr_attr();
 	check_ost_body();
 	check_ll_fid();
 	check_mds_op_bias();
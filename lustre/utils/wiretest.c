@@ -726,6 +726,8 @@ void lustre_assert_wire_constants(void)
 		(unsigned)LUDA_TYPE);
 	LASSERTF(LUDA_64BITHASH == 0x00000004UL, "found 0x%.8xUL\n",
 		(unsigned)LUDA_64BITHASH);
+	LASSERTF(LUDA_ATTR == 0x00000008UL, "found 0x%.8xUL\n",
+		(unsigned)LUDA_ATTR);
 
 	/* Checks for struct luda_type */
 	LASSERTF((int)sizeof(struct luda_type) == 2, "found %lld\n",
@@ -735,6 +737,58 @@ void lustre_assert_wire_constants(void)
 	LASSERTF((int)sizeof(((struct luda_type *)0)->lt_type) == 2, "found %lld\n",
 		 (long long)(int)sizeof(((struct luda_type *)0)->lt_type));
 
+	/* Checks for struct luda_attr */
+	LASSERTF((int)sizeof(struct luda_attr) == 72, "found %lld\n",
+		 (long long)(int)sizeof(struct luda_attr));
+	LASSERTF((int)offsetof(struct luda_attr, lda_valid) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_valid));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_valid) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_valid));
+	LASSERTF((int)offsetof(struct luda_attr, lda_size) == 8, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_size));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_size) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_size));
+	LASSERTF((int)offsetof(struct luda_attr, lda_blocks) == 16, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_blocks));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_blocks) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_blocks));
+	LASSERTF((int)offsetof(struct luda_attr, lda_mtime) == 24, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_mtime));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_mtime) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_mtime));
+	LASSERTF((int)offsetof(struct luda_attr, lda_atime) == 32, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_atime));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_atime) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_atime));
+	LASSERTF((int)offsetof(struct luda_attr, lda_ctime) == 40, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_ctime));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_ctime) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_ctime));
+	LASSERTF((int)offsetof(struct luda_attr, lda_mode) == 48, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_mode));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_mode) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_mode));
+	LASSERTF((int)offsetof(struct luda_attr, lda_uid) == 52, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_uid));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_uid) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_uid));
+	LASSERTF((int)offsetof(struct luda_attr, lda_gid) == 56, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_gid));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_gid) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_gid));
+	LASSERTF((int)offsetof(struct luda_attr, lda_nlink) == 60, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_nlink));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_nlink) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_nlink));
+	LASSERTF((int)offsetof(struct luda_attr, lda_flags) == 64, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_flags));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_flags) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_flags));
+	LASSERTF((int)offsetof(struct luda_attr, lda_padding) == 68, "found %lld\n",
+		 (long long)(int)offsetof(struct luda_attr, lda_padding));
+	LASSERTF((int)sizeof(((struct luda_attr *)0)->lda_padding) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct luda_attr *)0)->lda_padding));
+
 	/* Checks for struct lu_dirpage */
 	LASSERTF((int)sizeof(struct lu_dirpage) == 24, "found %lld\n",
 		 (long long)(int)sizeof(struct lu_dirpage));
@@ -1483,6 +1537,12 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT2_COMPRESS);
 	LASSERTF(OBD_CONNECT2_UNALIGNED_DIO == 0x400000000ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT2_UNALIGNED_DIO);
+	LASSERTF(OBD_CONNECT2_READDIR_PLUS == 0x800000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_READDIR_PLUS);
+	LASSERTF(OBD_CONNECT2_ZERO_WRITE == 0x1000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_ZERO_WRITE);
+	LASSERTF(OBD_CONNECT2_MULTI_OBJ_BRW == 0x2000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_MULTI_OBJ_BRW);
 
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
@@ -1938,6 +1998,7 @@ void lustre_assert_wire_constants(void)
 	BUILD_BUG_ON(LCME_FL_COMPRESS != 0x00000100);
 	BUILD_BUG_ON(LCME_FL_PARTIAL != 0x00000200);
 	BUILD_BUG_ON(LCME_FL_NOCOMPR != 0x00000400);
+	BUILD_BUG_ON(LCME_FL_SPARSE != 0x00000800);
 	BUILD_BUG_ON(LCME_FL_NEG != 0x80000000);
 
 	/* Checks for struct lov_comp_md_v1 */
@@ -2471,6 +2532,64 @@ void lustre_assert_wire_constants(void)
 		OBD_BRW_SYS_RESOURCE);
 	LASSERTF(OBD_BRW_COMPRESSED == 0x80000, "found 0x%.8x\n",
 		OBD_BRW_COMPRESSED);
+	LASSERTF(OBD_BRW_ZERO == 0x100000, "found 0x%.8x\n",
+		OBD_BRW_ZERO);
+
+	/* Checks for struct ll_compr_hdr */
+	LASSERTF((int)sizeof(struct ll_compr_hdr) == 24, "found %lld\n",
+		 (long long)(int)sizeof(struct ll_compr_hdr));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_magic) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_magic));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_magic) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_magic));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_header_size) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_header_size));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_header_size) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_header_size));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_compr_type) == 5, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_compr_type));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_type) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_type));
+	/* ll_compr_hdr.llch_compr_level is a bitfield and cannot be checked */
+	/* ll_compr_hdr.llch_chunk_log_bits is a bitfield and cannot be checked */
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_flags) == 7, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_flags));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_flags) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_flags));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_compr_size) == 8, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_compr_size));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_size) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_size));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_hdr_csum) == 12, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_hdr_csum));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_hdr_csum) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_hdr_csum));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_reserved) == 16, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_reserved));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_reserved) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_reserved));
+	LASSERTF(LLCH_MAGIC == 0x4C4C4348, "found 0x%.8x\n",
+		LLCH_MAGIC);
+
+	/* Checks for struct ll_compr_attr */
+	LASSERTF((int)sizeof(struct ll_compr_attr) == 8, "found %lld\n",
+		 (long long)(int)sizeof(struct ll_compr_attr));
+	LASSERTF((int)offsetof(struct ll_compr_attr, lca_types) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_attr, lca_types));
+	LASSERTF((int)sizeof(((struct ll_compr_attr *)0)->lca_types) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_attr *)0)->lca_types));
+	LASSERTF((int)offsetof(struct ll_compr_attr, lca_chunk_log_bits) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_attr, lca_chunk_log_bits));
+	LASSERTF((int)sizeof(((struct ll_compr_attr *)0)->lca_chunk_log_bits) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_attr *)0)->lca_chunk_log_bits));
+	LASSERTF((int)offsetof(struct ll_compr_attr, lca_padding1) == 5, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_attr, lca_padding1));
+	LASSERTF((int)sizeof(((struct ll_compr_attr *)0)->lca_padding1) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_attr *)0)->lca_padding1));
+	LASSERTF((int)offsetof(struct ll_compr_attr, lca_padding2) == 6, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_attr, lca_padding2));
+	LASSERTF((int)sizeof(((struct ll_compr_attr *)0)->lca_padding2) == 2, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_attr *)0)->lca_padding2));
 
 	/* Checks for struct ost_body */
 	LASSERTF((int)sizeof(struct ost_body) == 208, "found %lld\n",